@@ -0,0 +1,351 @@
+/** ExaTN:: Approximate boundary-MPS contraction of 2D PEPS tensor networks
+REVISION: 2020/10/06
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+#include "boundary_mps.hpp"
+#include "talshxx.hpp"
+#include "timers.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include <cassert>
+
+namespace exatn{
+
+BoundaryMPS::BoundaryMPS(std::shared_ptr<TensorNetwork> peps,
+                         unsigned int num_rows,
+                         std::size_t max_bond_dim):
+ peps_(peps), num_rows_(num_rows), num_cols_(0), max_bond_dim_(max_bond_dim), applicable_(false),
+ element_type_(TensorElementType::VOID), num_intermediates_(0), metrics_{{0.0,0.0},0.0,0,0.0,0.0}
+{
+ assert(peps_ && max_bond_dim_ > 0);
+ const unsigned int num_sites = peps_->getRank();
+ if(num_rows_ == 0 || num_sites == 0 || num_sites % num_rows_ != 0 || peps_->getNumTensors() != num_sites) return;
+ num_cols_ = num_sites / num_rows_;
+ //Each site tensor must carry its own output leg and may only be connected to its nearest neighbors:
+ for(unsigned int site = 0; site < num_sites; ++site){
+  const auto * legs = peps_->getTensorConnections(site + 1);
+  if(legs == nullptr) return;
+  const unsigned int row = site / num_cols_, col = site % num_cols_;
+  unsigned int num_output_legs = 0;
+  for(const auto & leg: *legs){
+   if(leg.getTensorId() == 0){
+    if(leg.getDimensionId() != site) return;
+    ++num_output_legs;
+   }else{
+    const unsigned int other = leg.getTensorId() - 1;
+    const unsigned int other_row = other / num_cols_, other_col = other % num_cols_;
+    const bool neighbor = (row == other_row && (col + 1 == other_col || other_col + 1 == col)) ||
+                          (col == other_col && (row + 1 == other_row || other_row + 1 == row));
+    if(!neighbor) return;
+   }
+  }
+  if(num_output_legs != 1) return;
+ }
+ applicable_ = true;
+}
+
+
+bool BoundaryMPS::isApplicable() const
+{
+ return applicable_;
+}
+
+
+void BoundaryMPS::resetMaxBondDim(std::size_t max_bond_dim)
+{
+ assert(max_bond_dim > 0);
+ max_bond_dim_ = max_bond_dim;
+ return;
+}
+
+
+bool BoundaryMPS::evaluateNorm(std::complex<double> * norm, bool exact)
+{
+ return evaluate(std::map<unsigned int, std::string>{},norm,exact);
+}
+
+
+bool BoundaryMPS::evaluateExpectation(const std::map<unsigned int, std::string> & site_operators,
+                                      std::complex<double> * value,
+                                      bool exact)
+{
+ return evaluate(site_operators,value,exact);
+}
+
+
+const BoundaryMPS::Metrics & BoundaryMPS::getMetrics() const
+{
+ return metrics_;
+}
+
+
+std::string BoundaryMPS::operand(const std::string & name,
+                                 const std::vector<std::string> & labels)
+{
+ std::string spec = name + "(";
+ for(std::size_t i = 0; i < labels.size(); ++i){
+  if(i > 0) spec += ",";
+  spec += labels[i];
+ }
+ return spec + ")";
+}
+
+
+std::string BoundaryMPS::intermediateName()
+{
+ return ("_bm" + std::to_string(num_intermediates_++));
+}
+
+
+bool BoundaryMPS::destroyIntermediate(const std::string & name)
+{
+ auto iter = std::find(intermediates_.begin(),intermediates_.end(),name);
+ assert(iter != intermediates_.end());
+ intermediates_.erase(iter);
+ return destroyTensorSync(name);
+}
+
+
+bool BoundaryMPS::contract(const std::string & output,
+                           const std::vector<std::string> & labels,
+                           const std::vector<std::string> & operands)
+{
+ std::vector<DimExtent> dim_extents(labels.size());
+ for(std::size_t i = 0; i < labels.size(); ++i){
+  auto iter = extents_.find(labels[i]);
+  assert(iter != extents_.end());
+  dim_extents[i] = iter->second;
+ }
+ auto output_tensor = makeSharedTensor(output,dim_extents);
+ bool done = createTensorSync(output_tensor,element_type_);
+ if(done){
+  intermediates_.emplace_back(output);
+  std::map<std::string,std::shared_ptr<Tensor>> tensors{{output,output_tensor}};
+  std::string spec = operand(output,labels) + "+=";
+  for(std::size_t i = 0; i < operands.size(); ++i){
+   if(i > 0) spec += "*";
+   spec += operands[i];
+   auto name = operands[i].substr(0,operands[i].find('('));
+   if(name.back() == '+') name.pop_back(); //complex conjugation
+   tensors.emplace(name,getTensor(name));
+  }
+  TensorNetwork network(output,spec,tensors);
+  done = evaluateSync(network);
+  if(done) metrics_.fma_flops += network.getFMAFlops();
+ }
+ return done;
+}
+
+
+bool BoundaryMPS::buildDoubleLayer(const std::map<unsigned int, std::string> & site_operators)
+{
+ const unsigned int num_sites = num_rows_ * num_cols_;
+ for(const auto & site_operator: site_operators){
+  if(site_operator.first >= num_sites){
+   std::cout << "#ERROR(exatn::BoundaryMPS::buildDoubleLayer): Invalid site of operator "
+             << site_operator.second << ": " << site_operator.first << std::endl;
+   return false;
+  }
+ }
+ sites_.clear();
+ extents_.clear();
+ element_type_ = getTensorElementType(peps_->getTensor(1)->getName());
+ if(element_type_ == TensorElementType::VOID){
+  std::cout << "#ERROR(exatn::BoundaryMPS::buildDoubleLayer): PEPS tensors do not exist!" << std::endl;
+  return false;
+ }
+ bool done = true;
+ for(unsigned int site = 0; site < num_sites && done; ++site){
+  bool conjugated;
+  auto tensor = peps_->getTensor(site + 1,&conjugated);
+  const auto & legs = *(peps_->getTensorConnections(site + 1));
+  const auto site_operator = site_operators.find(site);
+  const bool acted_upon = (site_operator != site_operators.end());
+  //Ket and bra bonds to the same neighbor are distinct legs of the double-layer site tensor:
+  SiteTensor site_tensor;
+  std::vector<std::string> ket_labels(legs.size()), bra_labels(legs.size()), bra_bonds;
+  for(unsigned int i = 0; i < legs.size(); ++i){
+   const auto other_id = legs[i].getTensorId();
+   if(other_id == 0){
+    ket_labels[i] = "p";
+    bra_labels[i] = (acted_upon ? "q" : "p");
+   }else{
+    const unsigned int other = other_id - 1;
+    const auto bond = (site < other) ? (std::to_string(site) + "x" + std::to_string(i)) //bond is labeled by its first endpoint
+                                     : (std::to_string(other) + "x" + std::to_string(legs[i].getDimensionId()));
+    ket_labels[i] = "k" + bond;
+    bra_labels[i] = "b" + bond;
+    extents_[ket_labels[i]] = tensor->getDimExtent(i);
+    extents_[bra_labels[i]] = tensor->getDimExtent(i);
+    site_tensor.labels.emplace_back(ket_labels[i]);
+    bra_bonds.emplace_back(bra_labels[i]);
+    if(other == site + num_cols_){
+     site_tensor.down_labels.emplace_back(ket_labels[i]);
+     site_tensor.down_labels.emplace_back(bra_labels[i]);
+    }else if(other == site + 1){
+     site_tensor.right_labels.emplace_back(ket_labels[i]);
+     site_tensor.right_labels.emplace_back(bra_labels[i]);
+    }
+   }
+  }
+  site_tensor.labels.insert(site_tensor.labels.end(),bra_bonds.cbegin(),bra_bonds.cend());
+  site_tensor.name = intermediateName();
+  std::vector<std::string> operands{operand(tensor->getName() + (conjugated ? "+" : ""),ket_labels),
+                                    operand(tensor->getName() + (conjugated ? "" : "+"),bra_labels)};
+  if(acted_upon) operands.emplace_back(operand(site_operator->second,{"q","p"}));
+  done = contract(site_tensor.name,site_tensor.labels,operands);
+  sites_.emplace_back(site_tensor);
+ }
+ return done;
+}
+
+
+bool BoundaryMPS::contractBoundary(std::string & result)
+{
+ SVDTruncation truncation;
+ truncation.max_rank = max_bond_dim_;
+ truncation.absorb = SVDAbsorb::RIGHT; //boundary MPS tensors are left-isometric
+ std::vector<std::string> boundary(num_cols_), next_boundary(num_cols_);
+ std::vector<std::vector<std::string>> boundary_labels(num_cols_), next_boundary_labels(num_cols_);
+ std::string carry; //right factor carried over to the next column
+ std::vector<std::string> carry_labels;
+ bool done = true;
+ for(unsigned int row = 0; row < num_rows_ && done; ++row){
+  const bool last_row = (row + 1 == num_rows_);
+  for(unsigned int col = 0; col < num_cols_ && done; ++col){
+   const auto & site = sites_[row * num_cols_ + col];
+   //Contract the carried right factor, the boundary MPS tensor and the double-layer site tensor:
+   std::vector<std::string> operands, labels;
+   auto append_operand = [&operands,&labels](const std::string & name, const std::vector<std::string> & tensor_labels){
+    operands.emplace_back(operand(name,tensor_labels));
+    labels.insert(labels.end(),tensor_labels.cbegin(),tensor_labels.cend());
+   };
+   if(!carry.empty()) append_operand(carry,carry_labels);
+   if(row > 0) append_operand(boundary[col],boundary_labels[col]);
+   append_operand(site.name,site.labels);
+   std::vector<std::string> open_labels;
+   for(const auto & label: labels){
+    if(std::count(labels.cbegin(),labels.cend(),label) == 1) open_labels.emplace_back(label);
+   }
+   const auto product = intermediateName();
+   done = contract(product,open_labels,operands); if(!done) break;
+   const std::string left_bond = (carry.empty() ? std::string() : carry_labels[0]);
+   if(!carry.empty()) done = destroyIntermediate(carry) && done;
+   if(row > 0) done = destroyIntermediate(boundary[col]) && done;
+   done = destroyIntermediate(site.name) && done;
+   if(!done) break;
+   if(last_row){ //the last row is contracted exactly
+    carry = product;
+    carry_labels = open_labels;
+   }else if(site.right_labels.empty()){ //last column
+    carry.clear();
+    carry_labels.clear();
+    next_boundary[col] = product;
+    next_boundary_labels[col] = open_labels;
+   }else{ //split off the new boundary MPS tensor by the truncated SVD
+    const std::string bond = "m" + std::to_string(row) + "x" + std::to_string(col);
+    std::vector<std::string> left_labels, right_labels{bond};
+    for(const auto & label: open_labels){
+     if(label == left_bond || std::find(site.down_labels.cbegin(),site.down_labels.cend(),label) != site.down_labels.cend()){
+      left_labels.emplace_back(label);
+     }else{
+      right_labels.emplace_back(label);
+     }
+    }
+    left_labels.emplace_back(bond);
+    const auto left = intermediateName();
+    const auto right = intermediateName();
+    std::size_t rank = 0;
+    double discarded_weight = 0.0;
+    done = decomposeTensorSVDTruncSync(operand(product,open_labels) + "=" + operand(left,left_labels)
+                                       + "*" + operand(right,right_labels),truncation,&rank,&discarded_weight);
+    if(!done) break;
+    intermediates_.emplace_back(left);
+    intermediates_.emplace_back(right);
+    done = destroyIntermediate(product); if(!done) break;
+    extents_[bond] = rank;
+    metrics_.max_bond_dim = std::max(metrics_.max_bond_dim,rank);
+    metrics_.discarded_weight += discarded_weight;
+    next_boundary[col] = left;
+    next_boundary_labels[col] = left_labels;
+    carry = right;
+    carry_labels = right_labels;
+   }
+  }
+  if(!last_row){
+   boundary.swap(next_boundary);
+   boundary_labels.swap(next_boundary_labels);
+  }
+ }
+ if(done) result = carry;
+ return done;
+}
+
+
+bool BoundaryMPS::contractExact(std::string & result)
+{
+ std::vector<std::string> operands;
+ for(const auto & site: sites_) operands.emplace_back(operand(site.name,site.labels));
+ result = intermediateName();
+ return contract(result,std::vector<std::string>{},operands);
+}
+
+
+bool BoundaryMPS::getScalar(const std::string & name,
+                            std::complex<double> * value) const
+{
+ auto local_tensor = getLocalTensor(name);
+ if(!local_tensor) return false;
+ bool done = true;
+ switch(element_type_){
+  case TensorElementType::REAL32:
+   {const float * body; done = local_tensor->getDataAccessHostConst(&body); if(done) *value = body[0];}
+   break;
+  case TensorElementType::REAL64:
+   {const double * body; done = local_tensor->getDataAccessHostConst(&body); if(done) *value = body[0];}
+   break;
+  case TensorElementType::COMPLEX32:
+   {const std::complex<float> * body; done = local_tensor->getDataAccessHostConst(&body); if(done) *value = body[0];}
+   break;
+  case TensorElementType::COMPLEX64:
+   {const std::complex<double> * body; done = local_tensor->getDataAccessHostConst(&body); if(done) *value = body[0];}
+   break;
+  default:
+   done = false;
+ }
+ return done;
+}
+
+
+bool BoundaryMPS::evaluate(const std::map<unsigned int, std::string> & site_operators,
+                           std::complex<double> * value,
+                           bool exact)
+{
+ metrics_ = Metrics{{0.0,0.0},0.0,0,0.0,0.0};
+ if(!applicable_){
+  std::cout << "#ERROR(exatn::BoundaryMPS::evaluate): PEPS tensor network " << peps_->getName()
+            << " does not have the expected grid structure!" << std::endl;
+  return false;
+ }
+ const auto time_start = Timer::timeInSecHR();
+ std::string result;
+ bool done = buildDoubleLayer(site_operators);
+ if(done) done = (exact ? contractExact(result) : contractBoundary(result));
+ if(done) done = getScalar(result,value);
+ //Destroy the remaining intermediate tensors:
+ for(const auto & name: intermediates_){
+  bool destroyed = destroyTensorSync(name);
+  done = done && destroyed;
+ }
+ intermediates_.clear();
+ sites_.clear();
+ if(done) metrics_.value = *value;
+ metrics_.time = Timer::timeInSecHR(time_start);
+ return done;
+}
+
+} //namespace exatn
@@ -0,0 +1,149 @@
+/** ExaTN:: Approximate boundary-MPS contraction of 2D PEPS tensor networks
+REVISION: 2020/10/06
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+/** Rationale:
+ (a) The boundary-MPS contractor evaluates the norm <psi|psi> and the (unnormalized)
+     expectation values <psi|O|psi> of a product of one-site operators O for a PEPS |psi>
+     on a rectangular grid of num_rows x num_cols sites, site (r,c) being the output tensor
+     mode r * num_cols + c represented by the tensor with id r * num_cols + c + 1 which is
+     connected to its nearest neighbors only (see NetworkBuilderPEPS). The PEPS tensors must exist.
+ (b) The exact contraction cost of the closed double-layer grid grows exponentially with
+     the grid width, whatever contraction sequence is used. Instead, the first row of the
+     double-layer grid is taken as the boundary matrix product state (MPS) and the following
+     rows are absorbed into it one at a time, such that the cost only grows polynomially:
+     O(num_rows * num_cols * chi^3 * D^8) for the PEPS bond dimension D and the boundary bond
+     dimension chi. Each row is absorbed by the zip-up procedure: Going from left to right,
+     the carried right factor of the previous column, the boundary MPS tensor and the
+     double-layer site tensor are contracted, followed by the truncated SVD splitting off
+     the new (left-isometric) boundary MPS tensor, the singular values being absorbed into
+     the right factor carried over to the next column. The last row is contracted exactly.
+ (c) The double-layer site tensors A(p,...) * A+(q,...) * O(q,p) keep the ket and bra bonds
+     as separate legs (no reshaping is needed), thus every step is an ordinary tensor network
+     evaluation or a truncated SVD decomposition performed by the numerical server.
+ (d) The same double-layer grid can also be contracted exactly (with the contraction sequence
+     optimizer), providing the reference value and cost for small grids. The metrics of the last
+     evaluation (value, FMA flop count, achieved boundary bond dimension, total discarded weight,
+     and time) allow assessing the accuracy/cost tradeoff of the boundary bond dimension.
+**/
+
+#ifndef EXATN_BOUNDARY_MPS_HPP_
+#define EXATN_BOUNDARY_MPS_HPP_
+
+#include "exatn_numerics.hpp"
+
+#include <unordered_map>
+#include <map>
+#include <vector>
+#include <complex>
+#include <memory>
+#include <string>
+
+namespace exatn{
+
+class BoundaryMPS{
+
+public:
+
+ //Metrics of a single evaluation:
+ struct Metrics{
+  std::complex<double> value;   //evaluated scalar
+  double fma_flops;             //total FMA flop count of all tensor contractions
+  std::size_t max_bond_dim;     //max achieved bond dimension of the boundary MPS (0 for the exact contraction)
+  double discarded_weight;      //total discarded weight of all SVD truncations
+  double time;                  //wall clock time (sec)
+ };
+
+ BoundaryMPS(std::shared_ptr<TensorNetwork> peps, //in: PEPS tensor network (its tensors must exist)
+             unsigned int num_rows,               //in: number of grid rows (must divide the PEPS rank)
+             std::size_t max_bond_dim);           //in: max bond dimension of the boundary MPS
+
+ BoundaryMPS(const BoundaryMPS &) = default;
+ BoundaryMPS & operator=(const BoundaryMPS &) = default;
+ BoundaryMPS(BoundaryMPS &&) noexcept = default;
+ BoundaryMPS & operator=(BoundaryMPS &&) noexcept = default;
+ ~BoundaryMPS() = default;
+
+ /** Returns TRUE if the PEPS tensor network has the expected grid structure. **/
+ bool isApplicable() const;
+
+ /** Resets the max bond dimension of the boundary MPS. **/
+ void resetMaxBondDim(std::size_t max_bond_dim);
+
+ /** Evaluates the norm <psi|psi>, either approximately by the boundary MPS
+     or by the exact contraction of the double-layer grid. **/
+ bool evaluateNorm(std::complex<double> * norm, //out: norm <psi|psi>
+                   bool exact = false);         //in: whether or not to contract the double-layer grid exactly
+
+ /** Evaluates the (unnormalized) expectation value <psi|O|psi> of a product of one-site
+     operators O(q,p), given as the names of existing tensors (q: bra leg, p: ket leg),
+     either approximately by the boundary MPS or by the exact contraction of the double-layer grid. **/
+ bool evaluateExpectation(const std::map<unsigned int, std::string> & site_operators, //in: site --> one-site operator tensor
+                          std::complex<double> * value,                               //out: expectation value <psi|O|psi>
+                          bool exact = false);                                        //in: whether or not to contract the double-layer grid exactly
+
+ /** Returns the metrics of the last evaluation. **/
+ const Metrics & getMetrics() const;
+
+private:
+
+ //Double-layer site tensor:
+ struct SiteTensor{
+  std::string name;                        //tensor name
+  std::vector<std::string> labels;         //index label of each leg
+  std::vector<std::string> down_labels;    //index labels of the bonds to the site below
+  std::vector<std::string> right_labels;   //index labels of the bonds to the site on the right
+ };
+
+ /** Returns the symbolic operand of a tensor with given index labels: name(label0,label1,...). **/
+ static std::string operand(const std::string & name,                 //in: tensor name
+                            const std::vector<std::string> & labels); //in: index labels
+
+ /** Creates the output tensor over the given index labels and evaluates the tensor network
+     output += operand0 * operand1 * ..., accumulating the FMA flop count. **/
+ bool contract(const std::string & output,                   //in: output tensor name (created by this call)
+               const std::vector<std::string> & labels,      //in: index labels of the output tensor
+               const std::vector<std::string> & operands);   //in: symbolic operands
+
+ /** Creates the double-layer site tensors A(p,...) * A+(q,...) * O(q,p). **/
+ bool buildDoubleLayer(const std::map<unsigned int, std::string> & site_operators);
+
+ /** Contracts the double-layer grid row by row via the boundary MPS. **/
+ bool contractBoundary(std::string & result); //out: name of the resulting scalar tensor
+
+ /** Contracts the double-layer grid exactly. **/
+ bool contractExact(std::string & result);    //out: name of the resulting scalar tensor
+
+ /** Retrieves the value of a scalar tensor. **/
+ bool getScalar(const std::string & name,
+                std::complex<double> * value) const;
+
+ /** Evaluates the double-layer grid and destroys all intermediate tensors. **/
+ bool evaluate(const std::map<unsigned int, std::string> & site_operators,
+               std::complex<double> * value,
+               bool exact);
+
+ /** Returns a new name for an intermediate tensor. **/
+ std::string intermediateName();
+
+ /** Destroys an intermediate tensor. **/
+ bool destroyIntermediate(const std::string & name);
+
+ std::shared_ptr<TensorNetwork> peps_;                      //PEPS tensor network
+ unsigned int num_rows_;                                    //number of grid rows
+ unsigned int num_cols_;                                    //number of grid columns
+ std::size_t max_bond_dim_;                                 //max bond dimension of the boundary MPS
+ bool applicable_;                                          //whether or not the PEPS has the expected grid structure
+ TensorElementType element_type_;                           //tensor element type
+ std::vector<SiteTensor> sites_;                            //double-layer site tensors
+ std::unordered_map<std::string,DimExtent> extents_;        //index label --> dimension extent
+ std::vector<std::string> intermediates_;                   //names of the existing intermediate tensors
+ std::size_t num_intermediates_;                            //number of intermediate tensors created so far
+ Metrics metrics_;                                          //metrics of the last evaluation
+};
+
+} //namespace exatn
+
+#endif //EXATN_BOUNDARY_MPS_HPP_
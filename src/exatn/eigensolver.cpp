@@ -1,10 +1,20 @@
 /** ExaTN:: Extreme eigenvalue/eigenvector solver over tensor networks
-REVISION: 2020/01/24
+REVISION: 2020/10/07
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 
 #include "eigensolver.hpp"
+#include "talshxx.hpp"
+#include "timers.hpp"
+
+#include <Eigen/Dense>
+
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <cmath>
 
 #include <cassert>
 
@@ -13,8 +23,17 @@ namespace exatn{
 TensorNetworkEigenSolver::TensorNetworkEigenSolver(std::shared_ptr<TensorOperator> tensor_operator,
                                                    std::shared_ptr<TensorExpansion> tensor_expansion,
                                                    double tolerance):
- tensor_operator_(tensor_operator), tensor_expansion_(tensor_expansion), tolerance_(tolerance), num_roots_(0)
+ tensor_operator_(tensor_operator), tensor_expansion_(tensor_expansion), tolerance_(tolerance), num_roots_(0),
+ element_type_(TensorElementType::VOID)
+{
+ assert(tensor_expansion_->isKet());
+ name_tag_ = tensor_hex_name("e",reinterpret_cast<std::size_t>(static_cast<void*>(this)));
+}
+
+
+TensorNetworkEigenSolver::~TensorNetworkEigenSolver()
 {
+ if(numericalServer) destroyBasis(); //the basis tensors are gone together with the numerical server
 }
 
 
@@ -31,15 +50,293 @@ std::shared_ptr<TensorExpansion> TensorNetworkEigenSolver::getEigenRoot(unsigned
 }
 
 
+const std::vector<TensorNetworkEigenSolver::IterationMetrics> & TensorNetworkEigenSolver::getIterationMetrics() const
+{
+ return metrics_;
+}
+
+
+std::string TensorNetworkEigenSolver::basisTensorName(std::size_t vector_id,
+                                                     const std::string & tensor_name)
+{
+ return (name_tag_ + "b" + std::to_string(vector_id) + "_" + tensor_name);
+}
+
+
+std::shared_ptr<TensorExpansion> TensorNetworkEigenSolver::createBasisVector()
+{
+ const auto vector_id = basis_.size();
+ auto vec = std::make_shared<TensorExpansion>(*tensor_expansion_,true,name_tag_+"b"+std::to_string(vector_id));
+ std::unordered_map<std::string,std::shared_ptr<Tensor>> new_tensors; //original tensor name --> new tensor
+ for(auto component = vec->begin(); component != vec->end(); ++component){
+  auto & network = *(component->network_);
+  std::vector<unsigned int> tensor_ids;
+  for(auto tensor_conn = network.cbegin(); tensor_conn != network.cend(); ++tensor_conn){
+   if(tensor_conn->first != 0 && tensor_conn->second.isOptimizable()) tensor_ids.emplace_back(tensor_conn->first);
+  }
+  for(const auto & tensor_id: tensor_ids){
+   const auto & name = network.getTensor(tensor_id)->getName();
+   auto iter = new_tensors.find(name);
+   if(iter == new_tensors.end()){
+    auto tensor = std::make_shared<Tensor>(*(network.getTensor(tensor_id)));
+    tensor->rename(basisTensorName(vector_id,name));
+    bool created = createTensorSync(tensor,element_type_);
+    if(!created) return std::shared_ptr<TensorExpansion>(nullptr);
+    basis_tensors_.emplace_back(tensor);
+    iter = new_tensors.emplace(std::make_pair(name,tensor)).first;
+   }
+   auto substituted = network.substituteTensor(tensor_id,iter->second); assert(substituted);
+  }
+ }
+ return vec;
+}
+
+
+bool TensorNetworkEigenSolver::evaluateScalars(std::vector<TensorExpansion> & expansions,
+                                               std::vector<std::complex<double>> & values)
+{
+ //Create and zero the scalar accumulators:
+ std::vector<std::shared_ptr<Tensor>> scalars;
+ bool done = true;
+ for(std::size_t i = 0; i < expansions.size() && done; ++i){
+  scalars.emplace_back(makeSharedTensor(name_tag_ + "s" + std::to_string(i)));
+  done = createTensorSync(scalars.back(),element_type_);
+  if(done) done = initTensorSync(scalars.back()->getName(),0.0);
+ }
+ //Evaluate all closed tensor network expansions as a single batch:
+ if(done) done = evaluateBatchSync(expansions,scalars);
+ //Retrieve the values:
+ values.assign(expansions.size(),std::complex<double>{0.0,0.0});
+ for(std::size_t i = 0; i < scalars.size() && done; ++i){
+  auto local_tensor = getLocalTensor(scalars[i]->getName());
+  if(!local_tensor){done = false; break;}
+  switch(element_type_){
+   case TensorElementType::REAL32:
+    {const float * body; done = local_tensor->getDataAccessHostConst(&body); if(done) values[i] = body[0];}
+    break;
+   case TensorElementType::REAL64:
+    {const double * body; done = local_tensor->getDataAccessHostConst(&body); if(done) values[i] = body[0];}
+    break;
+   case TensorElementType::COMPLEX32:
+    {const std::complex<float> * body; done = local_tensor->getDataAccessHostConst(&body); if(done) values[i] = body[0];}
+    break;
+   case TensorElementType::COMPLEX64:
+    {const std::complex<double> * body; done = local_tensor->getDataAccessHostConst(&body); if(done) values[i] = body[0];}
+    break;
+   default:
+    done = false;
+  }
+ }
+ for(const auto & scalar: scalars){
+  bool destroyed = destroyTensorSync(scalar->getName());
+  done = done && destroyed;
+ }
+ return done;
+}
+
+
+bool TensorNetworkEigenSolver::destroyBasis()
+{
+ bool done = true;
+ for(const auto & tensor: basis_tensors_){
+  bool destroyed = destroyTensorSync(tensor->getName());
+  done = done && destroyed;
+ }
+ basis_tensors_.clear();
+ basis_.clear();
+ eigenvector_.clear();
+ eigenvalue_.clear();
+ accuracy_.clear();
+ metrics_.clear();
+ return done;
+}
+
+
 bool TensorNetworkEigenSolver::solve(unsigned int num_roots, const std::vector<double> ** accuracy)
 {
  assert(accuracy != nullptr);
- if(num_roots == 0) return false;
+ if(num_roots == 0 || num_roots > MAX_SUBSPACE_DIM / 2) return false;
+ if(!destroyBasis()) return false;
  num_roots_ = num_roots;
  for(unsigned int i = 0; i < num_roots; ++i) accuracy_.emplace_back(-1.0);
- //`Finish
  *accuracy = &accuracy_;
- return true;
+
+ //Determine the optimizable tensors of the given tensor network expansion form:
+ std::vector<std::string> guess_tensors;
+ for(auto component = tensor_expansion_->cbegin(); component != tensor_expansion_->cend(); ++component){
+  for(auto tensor_conn = component->network_->cbegin(); tensor_conn != component->network_->cend(); ++tensor_conn){
+   if(tensor_conn->first != 0 && tensor_conn->second.isOptimizable()){
+    if(std::find(guess_tensors.begin(),guess_tensors.end(),tensor_conn->second.getName()) == guess_tensors.end())
+     guess_tensors.emplace_back(tensor_conn->second.getName());
+   }
+  }
+ }
+ if(guess_tensors.empty()){
+  std::cout << "#ERROR(exatn::TensorNetworkEigenSolver::solve): The tensor network expansion form has no optimizable tensors!"
+            << std::endl;
+  return false;
+ }
+ element_type_ = getTensorElementType(guess_tensors[0]);
+
+ //Initial block of basis vectors: The given tensor network expansion followed by random ones:
+ bool done = true;
+ for(unsigned int root = 0; root < num_roots && done; ++root){
+  auto vec = createBasisVector();
+  done = static_cast<bool>(vec);
+  for(const auto & tensor: guess_tensors){
+   if(!done) break;
+   const auto name = basisTensorName(basis_.size(),tensor);
+   if(root == 0){
+    std::string add_pattern;
+    done = initTensorSync(name,0.0);
+    if(done) done = generate_addition_pattern(getTensor(tensor)->getRank(),add_pattern,false,name,tensor);
+    if(done) done = addTensorsSync(add_pattern,1.0);
+   }else{
+    done = initTensorRndSync(name);
+   }
+  }
+  if(done) basis_.emplace_back(vec);
+ }
+
+ //Block Davidson iterations:
+ Eigen::MatrixXcd h_mat, s_mat, h2_mat; //subspace matrices: <b_j|H|b_k>, <b_j|b_k>, <Hb_j|Hb_k>
+ Eigen::MatrixXcd coefs;                //Ritz vector coefficients (one column per eigenroot)
+ std::vector<std::complex<double>> eigenvalues(num_roots,std::complex<double>{0.0,0.0});
+ std::vector<double> residual_norms(num_roots,-1.0);
+ unsigned int dim = 0;
+ bool finished = false, converged = false, dependent = false;
+ while(done && !finished){
+  const auto time_start = Timer::timeInSecHR();
+  const unsigned int new_dim = basis_.size();
+  //Evaluate the new elements of the subspace matrices as a single batch:
+  std::vector<TensorExpansion> expansions;
+  std::vector<std::pair<unsigned int, unsigned int>> elements;
+  for(unsigned int k = dim; k < new_dim; ++k){
+   TensorExpansion ket_sigma(*(basis_[k]),*tensor_operator_); // H|b_k>
+   for(unsigned int j = 0; j <= k; ++j){
+    TensorExpansion bra(*(basis_[j]),false); // |b_j>
+    bra.conjugate(); // <b_j|
+    TensorExpansion bra_sigma(*(basis_[j]),*tensor_operator_); // H|b_j>
+    bra_sigma.conjugate(); // <b_j|H
+    expansions.emplace_back(TensorExpansion(bra,*(basis_[k]),*tensor_operator_)); // <b_j|H|b_k>
+    expansions.emplace_back(TensorExpansion(bra,*(basis_[k]))); // <b_j|b_k>
+    expansions.emplace_back(TensorExpansion(bra_sigma,ket_sigma)); // <b_j|H*H|b_k>
+    elements.emplace_back(std::make_pair(j,k));
+   }
+  }
+  std::vector<std::complex<double>> values;
+  done = evaluateScalars(expansions,values);
+  if(!done) break;
+  const double evaluation_time = Timer::timeInSecHR(time_start);
+  h_mat.conservativeResize(new_dim,new_dim);
+  s_mat.conservativeResize(new_dim,new_dim);
+  h2_mat.conservativeResize(new_dim,new_dim);
+  for(std::size_t i = 0; i < elements.size(); ++i){
+   const auto j = elements[i].first, k = elements[i].second;
+   h_mat(j,k) = values[i*3]; h_mat(k,j) = std::conj(values[i*3]);
+   s_mat(j,k) = values[i*3+1]; s_mat(k,j) = std::conj(values[i*3+1]);
+   h2_mat(j,k) = values[i*3+2]; h2_mat(k,j) = std::conj(values[i*3+2]);
+  }
+  dim = new_dim;
+  //Canonical orthogonalization of the Krylov basis:
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXcd> metric_solver(s_mat);
+  if(metric_solver.info() != Eigen::Success){
+   std::cout << "#ERROR(exatn::TensorNetworkEigenSolver::solve): Subspace metric eigensolver failed!" << std::endl;
+   done = false;
+   break;
+  }
+  const double max_metric = metric_solver.eigenvalues().maxCoeff();
+  std::vector<unsigned int> independent;
+  for(unsigned int i = 0; i < dim; ++i){
+   if(metric_solver.eigenvalues()(i) > max_metric * LINEAR_DEPENDENCE_THRESHOLD) independent.emplace_back(i);
+  }
+  Eigen::MatrixXcd transform(dim,independent.size());
+  for(unsigned int i = 0; i < independent.size(); ++i){
+   transform.col(i) = metric_solver.eigenvectors().col(independent[i])
+                      / std::sqrt(metric_solver.eigenvalues()(independent[i]));
+  }
+  //Rayleigh-Ritz procedure in the orthonormalized subspace:
+  Eigen::MatrixXcd projected = transform.adjoint() * h_mat * transform;
+  projected = (projected + projected.adjoint()) * 0.5;
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXcd> eigen_solver(projected);
+  if(eigen_solver.info() != Eigen::Success){
+   std::cout << "#ERROR(exatn::TensorNetworkEigenSolver::solve): Subspace eigensolver failed!" << std::endl;
+   done = false;
+   break;
+  }
+  const unsigned int num_ritz = std::min(num_roots,static_cast<unsigned int>(independent.size()));
+  dependent = (num_ritz < num_roots); //fewer linearly independent basis vectors than eigenroots
+  coefs = transform * eigen_solver.eigenvectors().leftCols(num_ritz);
+  //Residual norms of the Ritz vectors:
+  unsigned int num_converged = 0;
+  for(unsigned int root = 0; root < num_ritz; ++root){
+   const double theta = eigen_solver.eigenvalues()(root);
+   const Eigen::VectorXcd c = coefs.col(root);
+   const double residual_sqr = (c.adjoint() * (h2_mat - (2.0 * theta) * h_mat + (theta * theta) * s_mat) * c)(0,0).real();
+   eigenvalues[root] = std::complex<double>{theta,0.0};
+   residual_norms[root] = std::sqrt(std::max(residual_sqr,0.0));
+   if(residual_norms[root] <= tolerance_) ++num_converged;
+  }
+  converged = (num_converged == num_roots);
+  finished = converged;
+  //Expand the Krylov subspace by the compressed residuals of the unconverged eigenroots:
+  if(!finished && num_ritz == num_roots && dim + (num_roots - num_converged) <= MAX_SUBSPACE_DIM){
+   for(unsigned int root = 0; root < num_roots && done; ++root){
+    if(residual_norms[root] > tolerance_){
+     auto residual = std::make_shared<TensorExpansion>();
+     for(unsigned int k = 0; k < dim && done; ++k){
+      done = residual->appendExpansion(TensorExpansion(*(basis_[k]),*tensor_operator_),coefs(k,root));
+      if(done) done = residual->appendExpansion(*(basis_[k]),-eigenvalues[root]*coefs(k,root));
+     }
+     const auto vector_id = basis_.size();
+     auto vec = (done ? createBasisVector() : std::shared_ptr<TensorExpansion>(nullptr));
+     done = static_cast<bool>(vec);
+     for(const auto & tensor: guess_tensors){
+      if(!done) break;
+      done = initTensorRndSync(basisTensorName(vector_id,tensor));
+     }
+     if(done){
+      auto approximant = std::make_shared<TensorExpansion>(*vec,false); // |b_new>
+      approximant->conjugate(); // <b_new|
+      TensorNetworkReconstructor reconstructor(residual,approximant,tolerance_);
+      double fidelity = 0.0;
+      done = reconstructor.reconstruct(&fidelity);
+     }
+     if(done) basis_.emplace_back(vec);
+    }
+   }
+  }else{
+   finished = true; //converged or the max dimension of the Krylov subspace has been reached
+  }
+  metrics_.emplace_back(IterationMetrics{dim,eigenvalues,residual_norms,num_converged,
+                                         evaluation_time,Timer::timeInSecHR(time_start)});
+ }
+
+ //Eigenvectors (Ritz vectors) as linear combinations of the basis vectors:
+ if(done){
+  for(unsigned int root = 0; root < num_roots; ++root){
+   auto eigenvector = std::make_shared<TensorExpansion>();
+   eigenvector->rename("_ev" + std::to_string(root));
+   if(root < static_cast<unsigned int>(coefs.cols())){
+    for(unsigned int k = 0; k < dim && done; ++k) done = eigenvector->appendExpansion(*(basis_[k]),coefs(k,root));
+    accuracy_[root] = residual_norms[root];
+   }
+   eigenvector_.emplace_back(eigenvector);
+   eigenvalue_.emplace_back(eigenvalues[root]);
+  }
+ }
+ if(!done) std::cout << "#ERROR(exatn::TensorNetworkEigenSolver::solve): Eigensolver failed!" << std::endl;
+ if(done && !converged){
+  if(dependent){
+   std::cout << "#WARNING(exatn::TensorNetworkEigenSolver::solve): Krylov subspace has become linearly dependent "
+             << "(fewer independent basis vectors than eigenroots) before all eigenroots converged!" << std::endl;
+  }else{
+   std::cout << "#WARNING(exatn::TensorNetworkEigenSolver::solve): Max dimension of the Krylov subspace has been reached "
+             << "before all eigenroots converged!" << std::endl;
+  }
+  return false;
+ }
+ return done;
 }
 
 } //namespace exatn
@@ -1,5 +1,5 @@
 /** ExaTN:: Extreme eigenvalue/eigenvector solver over tensor networks
-REVISION: 2020/01/24
+REVISION: 2020/10/07
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
@@ -10,6 +10,21 @@ Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
      subspace spanned by tensor network expansions. The procedure is derived
      from the Davidson-Nakatsuji-Hirao algorithm for non-Hermitian matrices,
      which in turn is based on the Arnoldi algorithm.
+ (b) The block Davidson procedure (for a hermitian tensor operator) expands the Krylov
+     subspace by a block of basis vectors per iteration, each basis vector being a tensor
+     network expansion of the given form with its own optimizable tensors. The tensor operator
+     is never applied explicitly: The subspace matrices <b_j|H|b_k>, <b_j|b_k> and <Hb_j|Hb_k>
+     for the whole new block of basis vectors are evaluated as a single batch of closed tensor
+     network expansions, thus computing the intermediates shared among the basis vectors and
+     operator components only once while the independent contractions proceed concurrently.
+ (c) The projected eigenvalue problem in the (non-orthogonal) Krylov basis is solved on Host
+     by the canonical orthogonalization (linearly dependent basis vectors are projected out),
+     followed by the Rayleigh-Ritz procedure. The residual norms |H*x - E*x| of the Ritz vectors
+     are computed directly from the subspace matrices.
+ (d) The residual of each unconverged eigenroot (correction vector with the identity preconditioner)
+     is compressed into a new basis vector of the given form by the tensor network reconstructor.
+     Each eigenvector is then the linear combination of the basis vectors (Ritz vector), that is,
+     a tensor network expansion exactly represented in the Krylov subspace.
 **/
 
 #ifndef EXATN_EIGENSOLVER_HPP_
@@ -22,6 +37,7 @@ Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 #include <vector>
 #include <complex>
 #include <memory>
+#include <string>
 
 namespace exatn{
 
@@ -29,19 +45,37 @@ class TensorNetworkEigenSolver{
 
 public:
 
+ //Convergence metrics of a single iteration of the eigensolver:
+ struct IterationMetrics{
+  unsigned int subspace_dim;                      //dimension of the Krylov subspace
+  std::vector<std::complex<double>> eigenvalues;  //current eigenvalues of the requested eigenroots
+  std::vector<double> residual_norms;             //current residual norms of the requested eigenroots
+  unsigned int num_converged;                     //number of converged eigenroots
+  double evaluation_time;                         //time spent in the batched evaluation of the subspace matrices (sec)
+  double iteration_time;                          //total time of the iteration (sec)
+ };
+
  TensorNetworkEigenSolver(std::shared_ptr<TensorOperator> tensor_operator,   //in: tensor operator the extreme eigenroots of which are to be found
                           std::shared_ptr<TensorExpansion> tensor_expansion, //in: tensor network expansion form that will be used for each eigenvector
                           double tolerance);                                 //in: desired numerical covergence tolerance
 
- TensorNetworkEigenSolver(const TensorNetworkEigenSolver &) = default;
- TensorNetworkEigenSolver & operator=(const TensorNetworkEigenSolver &) = default;
- TensorNetworkEigenSolver(TensorNetworkEigenSolver &&) noexcept = default;
- TensorNetworkEigenSolver & operator=(TensorNetworkEigenSolver &&) noexcept = default;
- ~TensorNetworkEigenSolver() = default;
-
- /** Runs the tensor network eigensolver for one or more extreme eigenroots
-     of the underlying tensor operator. Upon success, returns the achieved
-     accuracy for each eigenroot. **/
+ //The eigensolver owns its basis tensors (see destroyBasis):
+ TensorNetworkEigenSolver(const TensorNetworkEigenSolver &) = delete;
+ TensorNetworkEigenSolver & operator=(const TensorNetworkEigenSolver &) = delete;
+ TensorNetworkEigenSolver(TensorNetworkEigenSolver &&) = delete;
+ TensorNetworkEigenSolver & operator=(TensorNetworkEigenSolver &&) = delete;
+ ~TensorNetworkEigenSolver();
+
+ /** Runs the tensor network eigensolver for one or more extreme (lowest) eigenroots
+     of the underlying (hermitian) tensor operator. Upon success, returns the achieved
+     accuracy (residual norm) for each eigenroot. The tensors of the given tensor network
+     expansion must exist: Its optimizable tensors provide the initial guess for the first
+     eigenroot and are not modified. The basis tensors created by the eigensolver (constituting
+     the eigenvectors) persist until the next call to this method or destroyBasis().
+     Returns FALSE if not all eigenroots have converged to the desired tolerance by the time
+     the max dimension of the Krylov subspace has been reached or the Krylov subspace has become
+     linearly dependent (fewer independent basis vectors than eigenroots): The achieved accuracy
+     and the eigenroots computed so far are still available in this case. **/
  bool solve(unsigned int num_roots,                 //in: number of extreme eigenroots to find
             const std::vector<double> ** accuracy); //out: achieved accuracy for each root: accuracy[num_roots]
 
@@ -50,8 +84,30 @@ public:
                                                std::complex<double> * eigenvalue, //out: eigenvalue
                                                double * accuracy = nullptr);      //out: achieved accuracy
 
+ /** Returns the convergence metrics of each performed iteration of the last run. **/
+ const std::vector<IterationMetrics> & getIterationMetrics() const;
+
+ /** Destroys all basis tensors (and thus the computed eigenvectors). It should be invoked
+     before exatn::finalize(): The eigensolver destructor only destroys the remaining
+     basis tensors while the numerical server is still alive. **/
+ bool destroyBasis();
+
 private:
 
+ static constexpr unsigned int MAX_SUBSPACE_DIM = 32;              //max dimension of the Krylov subspace
+ static constexpr double LINEAR_DEPENDENCE_THRESHOLD = 1e-10;      //relative threshold on the eigenvalues of the subspace metric
+
+ /** Returns the name of the copy of an optimizable tensor of the given form in a given basis vector. **/
+ std::string basisTensorName(std::size_t vector_id,           //in: basis vector id
+                                    const std::string & tensor_name); //in: name of the optimizable tensor of the given form
+
+ /** Creates a new basis vector of the given form with its own (allocated, uninitialized) optimizable tensors. **/
+ std::shared_ptr<TensorExpansion> createBasisVector();
+
+ /** Evaluates a batch of closed tensor network expansions (scalars). **/
+ bool evaluateScalars(std::vector<TensorExpansion> & expansions,    //in: closed tensor network expansions
+                      std::vector<std::complex<double>> & values);  //out: their values
+
  std::shared_ptr<TensorOperator> tensor_operator_;           //tensor operator the extreme eigenroots of which are to be found
  std::shared_ptr<TensorExpansion> tensor_expansion_;         //desired form of the eigenvector as a tensor network expansion
  std::vector<std::shared_ptr<TensorExpansion>> eigenvector_; //tensor network expansion approximating each requested eigenvector
@@ -59,6 +115,11 @@ private:
  std::vector<double> accuracy_;                              //actually achieved accuracy for each eigenroot
  double tolerance_;                                          //desired numerical convergence tolerance for each eigenroot
  unsigned int num_roots_;                                    //number of extreme eigenroots requested
+ std::vector<std::shared_ptr<TensorExpansion>> basis_;       //basis vectors of the Krylov subspace
+ std::vector<std::shared_ptr<Tensor>> basis_tensors_;        //optimizable tensors of all basis vectors
+ std::vector<IterationMetrics> metrics_;                     //convergence metrics of each iteration
+ TensorElementType element_type_;                            //tensor element type of the basis tensors
+ std::string name_tag_;                                      //unique name prefix of all tensors created by this eigensolver
 };
 
 } //namespace exatn
@@ -233,6 +233,13 @@ inline bool registerTensorIsometry(const std::string & name,
                                    const std::vector<unsigned int> & iso_dims1) //in: tensor dimensions forming the isometry (group 1)
  {return numericalServer->registerTensorIsometry(name,iso_dims0,iso_dims1);}
 
+/** Registers a rank-1 tensor as a basis vector (one-hot vector) with the unit element
+    in a given position (tensors initialized with one-hot external data are detected
+    automatically). Returns TRUE on success, FALSE on failure. **/
+inline bool registerTensorBasisVector(const std::string & name, //in: tensor name
+                                      DimOffset position)       //in: position of the unit element
+ {return numericalServer->registerTensorBasisVector(name,position);}
+
 
 /** Destroys a tensor, including its backend representation. **/
 inline bool destroyTensor(const std::string & name) //in: tensor name
@@ -493,6 +500,36 @@ inline bool decomposeTensorSVDLRSync(const std::string & contraction) //in: two-
  {return numericalServer->decomposeTensorSVDLRSync(contraction);}
 
 
+/** Decomposes a tensor via a truncated SVD into two or three tensor factors
+    which are created by this call with the achieved (truncated) rank, for example:
+     D(a,b,c,d) = L(c,i,a) * S(i,j) * R(b,j,d)
+     D(a,b,c,d) = L(c,i,a) * R(b,i,d)
+    In the latter case the singular values are absorbed as specified by the truncation
+    parameters (SVDAbsorb::NONE is rejected), which also set the max rank, the discarded weight tolerance, and
+    whether or not the randomized range finder is used. **/
+inline bool decomposeTensorSVDTruncSync(const std::string & contraction,       //in: two- or three-factor symbolic tensor contraction specification
+                                        const SVDTruncation & truncation,      //in: truncation parameters
+                                        std::size_t * achieved_rank = nullptr, //out: achieved (retained) rank
+                                        double * truncation_error = nullptr)   //out: discarded weight (relative)
+ {return numericalServer->decomposeTensorSVDTruncSync(contraction,truncation,achieved_rank,truncation_error);}
+
+
+/** Applies a two-site gate to two neighboring tensors connected by a single bond
+    as a single fused tensor operation (contraction into the two-site tensor, truncated SVD,
+    in-place update of both tensors with the singular values absorbed as specified), for example:
+     T(a,k,l,c) = L(a,i,b) * R(b,j,c) * G(i,j,k,l)
+    replaces L(a,i,b) and R(b,j,c) with L(a,k,b) and R(b,l,c) (no complex conjugation). **/
+inline bool applyTwoSiteGateSVD(const std::string & pattern,      //in: symbolic specification of the two-site tensor
+                                const SVDTruncation & truncation) //in: truncation parameters
+ {return numericalServer->applyTwoSiteGateSVD(pattern,truncation);}
+
+inline bool applyTwoSiteGateSVDSync(const std::string & pattern,           //in: symbolic specification of the two-site tensor
+                                    const SVDTruncation & truncation,      //in: truncation parameters
+                                    std::size_t * achieved_rank = nullptr, //out: achieved (retained) rank
+                                    double * truncation_error = nullptr)   //out: discarded weight (relative)
+ {return numericalServer->applyTwoSiteGateSVDSync(pattern,truncation,achieved_rank,truncation_error);}
+
+
 /** Orthogonalizes a tensor by decomposing it via SVD while discarding
     the middle tensor factor with singular values. The symbolic tensor contraction
     specification specifies the decomposition. It must contain strictly one contracted index. **/
@@ -532,6 +569,44 @@ inline bool evaluateTensorNetworkSync(const ProcessGroup & process_group, //in:
  {return numericalServer->evaluateTensorNetworkSync(process_group,name,network);}
 
 
+/** Evaluates a batch of amplitudes (elements) of the output tensor of a tensor network
+    given the values of its output legs (bitstrings). The bitstring-independent intermediate
+    is computed once whereas the individual amplitudes are extracted from it. For each bitstring,
+    the returned amplitudes cover all values of the open output legs (column-major). **/
+inline bool evaluateAmplitudesSync(TensorNetwork & network,                                //in: tensor network
+                                   const std::vector<std::vector<DimOffset>> & bitstrings, //in: values of the output tensor legs for each amplitude
+                                   std::vector<std::complex<double>> & amplitudes,         //out: amplitudes (for each bitstring: all values of the open legs)
+                                   const std::vector<unsigned int> & open_legs = std::vector<unsigned int>{}) //in: output tensor legs left open
+ {return numericalServer->evaluateAmplitudesSync(numericalServer->getDefaultProcessGroup(),
+                                                 network,bitstrings,amplitudes,open_legs);}
+
+inline bool evaluateAmplitudesSync(const ProcessGroup & process_group,                     //in: chosen group of MPI processes
+                                   TensorNetwork & network,                                //in: tensor network
+                                   const std::vector<std::vector<DimOffset>> & bitstrings, //in: values of the output tensor legs for each amplitude
+                                   std::vector<std::complex<double>> & amplitudes,         //out: amplitudes (for each bitstring: all values of the open legs)
+                                   const std::vector<unsigned int> & open_legs = std::vector<unsigned int>{}) //in: output tensor legs left open
+ {return numericalServer->evaluateAmplitudesSync(process_group,network,bitstrings,amplitudes,open_legs);}
+
+
+/** Evaluates the gradients of a closed (scalar) tensor network expansion with respect
+    to the given tensors in a single forward/backward pass (reverse-mode differentiation).
+    The intermediates of the forward pass are kept within the given checkpoint volume
+    (zero means no limit) and recomputed otherwise. The gradient tensors must exist. **/
+inline bool evaluateGradientsSync(TensorExpansion & expansion,                         //in: closed (scalar) tensor network expansion
+                                  const std::map<std::string,std::string> & gradients, //in: differentiated tensor name --> gradient tensor name
+                                  bool conjugated = false,                             //in: whether or not to differentiate the conjugated tensors
+                                  std::size_t max_checkpoint_volume = 0)               //in: max total volume of the kept intermediates (0: no limit)
+ {return numericalServer->evaluateGradientsSync(numericalServer->getDefaultProcessGroup(),
+                                                expansion,gradients,conjugated,max_checkpoint_volume);}
+
+inline bool evaluateGradientsSync(const ProcessGroup & process_group,                  //in: chosen group of MPI processes
+                                  TensorExpansion & expansion,                         //in: closed (scalar) tensor network expansion
+                                  const std::map<std::string,std::string> & gradients, //in: differentiated tensor name --> gradient tensor name
+                                  bool conjugated = false,                             //in: whether or not to differentiate the conjugated tensors
+                                  std::size_t max_checkpoint_volume = 0)               //in: max total volume of the kept intermediates (0: no limit)
+ {return numericalServer->evaluateGradientsSync(process_group,expansion,gradients,conjugated,max_checkpoint_volume);}
+
+
 /** Synchronizes all outstanding update operations on a given tensor specified by
     its symbolic name. If ProcessGroup is not provided, defaults to the local process.**/
 inline bool sync(const std::string & name, //in: tensor name
@@ -602,6 +677,74 @@ inline bool evaluateSync(const ProcessGroup & process_group,  //in: chosen group
   return success;}
 
 
+/** Evaluates a batch of tensor network expansions, each into its own explicitly provided tensor accumulator.
+    The intermediates shared by different tensor network expansions of the batch are computed only once. **/
+inline bool evaluateBatch(std::vector<TensorExpansion> & expansions,                   //in: tensor network expansions
+                          const std::vector<std::shared_ptr<Tensor>> & accumulators)  //inout: tensor accumulators
+ {return numericalServer->submitBatch(expansions,accumulators);}
+
+inline bool evaluateBatchSync(std::vector<TensorExpansion> & expansions,                   //in: tensor network expansions
+                              const std::vector<std::shared_ptr<Tensor>> & accumulators)  //inout: tensor accumulators
+ {bool success = numericalServer->submitBatch(expansions,accumulators);
+  for(const auto & accumulator: accumulators) if(success) success = numericalServer->sync(*accumulator);
+  return success;}
+
+inline bool evaluateBatch(const ProcessGroup & process_group,                          //in: chosen group of MPI processes
+                          std::vector<TensorExpansion> & expansions,                   //in: tensor network expansions
+                          const std::vector<std::shared_ptr<Tensor>> & accumulators)  //inout: tensor accumulators
+ {return numericalServer->submitBatch(process_group,expansions,accumulators);}
+
+inline bool evaluateBatchSync(const ProcessGroup & process_group,                          //in: chosen group of MPI processes
+                              std::vector<TensorExpansion> & expansions,                   //in: tensor network expansions
+                              const std::vector<std::shared_ptr<Tensor>> & accumulators)  //inout: tensor accumulators
+ {bool success = numericalServer->submitBatch(process_group,expansions,accumulators);
+  for(const auto & accumulator: accumulators) if(success) success = numericalServer->sync(process_group,*accumulator);
+  return success;}
+
+
+/** Evaluates the expectation value <bra|operator|ket> into the explicitly provided (scalar) tensor accumulator.
+    MPS-MPO-MPS sandwiches are contracted in the zipper order with the environments shared by all operator components. **/
+inline bool evaluateExpectation(TensorExpansion & bra,                  //in: bra tensor network expansion (conjugated)
+                                TensorExpansion & ket,                  //in: ket tensor network expansion
+                                const TensorOperator & tensor_operator, //in: tensor network operator
+                                std::shared_ptr<Tensor> accumulator)    //inout: tensor accumulator
+ {return numericalServer->submitExpectation(bra,ket,tensor_operator,accumulator);}
+
+inline bool evaluateExpectationSync(TensorExpansion & bra,                  //in: bra tensor network expansion (conjugated)
+                                    TensorExpansion & ket,                  //in: ket tensor network expansion
+                                    const TensorOperator & tensor_operator, //in: tensor network operator
+                                    std::shared_ptr<Tensor> accumulator)    //inout: tensor accumulator
+ {if(!accumulator) return false;
+  bool success = numericalServer->submitExpectation(bra,ket,tensor_operator,accumulator);
+  if(success) success = numericalServer->sync(*accumulator);
+  return success;}
+
+inline bool evaluateExpectation(const ProcessGroup & process_group,     //in: chosen group of MPI processes
+                                TensorExpansion & bra,                  //in: bra tensor network expansion (conjugated)
+                                TensorExpansion & ket,                  //in: ket tensor network expansion
+                                const TensorOperator & tensor_operator, //in: tensor network operator
+                                std::shared_ptr<Tensor> accumulator)    //inout: tensor accumulator
+ {return numericalServer->submitExpectation(process_group,bra,ket,tensor_operator,accumulator);}
+
+inline bool evaluateExpectationSync(const ProcessGroup & process_group,     //in: chosen group of MPI processes
+                                    TensorExpansion & bra,                  //in: bra tensor network expansion (conjugated)
+                                    TensorExpansion & ket,                  //in: ket tensor network expansion
+                                    const TensorOperator & tensor_operator, //in: tensor network operator
+                                    std::shared_ptr<Tensor> accumulator)    //inout: tensor accumulator
+ {if(!accumulator) return false;
+  bool success = numericalServer->submitExpectation(process_group,bra,ket,tensor_operator,accumulator);
+  if(success) success = numericalServer->sync(process_group,*accumulator);
+  return success;}
+
+
+/** Groups the components of a tensor operator acting on the same global modes (same sites)
+    by summing their tensors into new group tensors (to be destroyed when no longer needed). **/
+inline bool groupTensorOperatorSync(const TensorOperator & tensor_operator,               //in: tensor operator
+                                    TensorOperator & grouped_operator,                    //out: grouped tensor operator
+                                    std::vector<std::string> * group_tensors = nullptr)  //out: names of the created group tensors
+ {return numericalServer->groupTensorOperatorSync(tensor_operator,grouped_operator,group_tensors);}
+
+
 /** Synchronizes all outstanding operations on a given tensor.
     If ProcessGroup is not provided, defaults to the local process. **/
 inline bool sync(const Tensor & tensor, //in: tensor
@@ -655,6 +798,99 @@ inline void deactivateContrSeqCaching()
  {return numericalServer->deactivateContrSeqCaching();}
 
 
+/** Activates the local refinement of optimized tensor contraction sequences. **/
+inline void activateContrSeqRefinement()
+ {return numericalServer->activateContrSeqRefinement();}
+
+
+/** Deactivates the local refinement of optimized tensor contraction sequences. **/
+inline void deactivateContrSeqRefinement()
+ {return numericalServer->deactivateContrSeqRefinement();}
+
+
+/** Activates persistent caching of tensor network contraction plans in a given file.
+    Returns FALSE if the file could not be opened. **/
+inline bool activateContrPlanCaching(const std::string & file_name)
+ {return numericalServer->activateContrPlanCaching(file_name);}
+
+
+/** Deactivates persistent caching of tensor network contraction plans. **/
+inline void deactivateContrPlanCaching()
+ {return numericalServer->deactivateContrPlanCaching();}
+
+
+/** Calibrates the tensor contraction cost model by benchmarking the active
+    node executor (performed by process 0 only), saves it into a file and
+    activates it in all processes. **/
+inline bool calibrateContractionCostModel(const std::string & file_name,
+                                          TensorElementType element_type = TensorElementType::COMPLEX64)
+ {return numericalServer->calibrateContractionCostModel(file_name,element_type);}
+
+
+/** Loads and activates the calibrated tensor contraction cost model such that
+    tensor contraction planning minimizes the predicted time instead of flops. **/
+inline bool activateContractionCostModel(const std::string & file_name)
+ {return numericalServer->activateContractionCostModel(file_name);}
+
+
+/** Deactivates the calibrated tensor contraction cost model. **/
+inline void deactivateContractionCostModel()
+ {return numericalServer->deactivateContractionCostModel();}
+
+
+/** Activates dynamic distribution of tensor sub-networks (slices) among processes. **/
+inline void activateDynamicLoadBalancing()
+ {return numericalServer->activateDynamicLoadBalancing();}
+
+
+/** Deactivates dynamic distribution of tensor sub-networks (slices) among processes. **/
+inline void deactivateDynamicLoadBalancing()
+ {return numericalServer->deactivateDynamicLoadBalancing();}
+
+
+/** Activates concurrent evaluation of tensor expansion components by process subgroups. **/
+inline void activateParallelExpansionEvaluation(unsigned int num_subgroups = 0)
+ {return numericalServer->activateParallelExpansionEvaluation(num_subgroups);}
+
+
+/** Deactivates concurrent evaluation of tensor expansion components by process subgroups. **/
+inline void deactivateParallelExpansionEvaluation()
+ {return numericalServer->deactivateParallelExpansionEvaluation();}
+
+
+/** Activates common subexpression elimination across tensor expansion components. **/
+inline void activateExpansionCSE()
+ {return numericalServer->activateExpansionCSE();}
+
+
+/** Deactivates common subexpression elimination across tensor expansion components. **/
+inline void deactivateExpansionCSE()
+ {return numericalServer->deactivateExpansionCSE();}
+
+
+/** Activates index fixing (default): Rank-1 basis vector tensors (one-hot vectors)
+    are removed from tensor networks before planning while the corresponding indices
+    of the connected tensors are fixed by slicing. **/
+inline void activateIndexFixing()
+ {return numericalServer->activateIndexFixing();}
+
+
+/** Deactivates index fixing. **/
+inline void deactivateIndexFixing()
+ {return numericalServer->deactivateIndexFixing();}
+
+
+/** Activates tensor network simplification before the contraction sequence optimization
+    (merging of input tensors that does not increase the tensor volume). **/
+inline void activateNetworkSimplification()
+ {return numericalServer->activateNetworkSimplification();}
+
+
+/** Deactivates tensor network simplification (default). **/
+inline void deactivateNetworkSimplification()
+ {return numericalServer->deactivateNetworkSimplification();}
+
+
 /** Resets client logging level (0:none). **/
 inline void resetClientLoggingLevel(int level = 0)
  {return numericalServer->resetClientLoggingLevel(level);}
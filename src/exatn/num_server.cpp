@@ -6,13 +6,20 @@ Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 
 #include "num_server.hpp"
 #include "tensor_range.hpp"
+#include "sliced_execution_template.hpp"
 #include "timers.hpp"
+#include "talshxx.hpp"
 
+#include <unordered_map>
+#include <functional>
 #include <vector>
 #include <list>
 #include <map>
 #include <future>
 #include <algorithm>
+#include <type_traits>
+#include <complex>
+#include <cmath>
 
 #ifdef MPI_ENABLED
 #include "mpi.h"
@@ -32,7 +39,8 @@ NumServer::NumServer(const MPICommProxy & communicator,
                      const ParamConf & parameters,
                      const std::string & graph_executor_name,
                      const std::string & node_executor_name):
- contr_seq_optimizer_("metis"), contr_seq_caching_(false), logging_(0), intra_comm_(communicator)
+ contr_seq_optimizer_("metis"), contr_seq_caching_(false), contr_seq_refinement_(false), dynamic_load_balancing_(false),
+ parallel_expansion_(false), expansion_subgroups_(0), expansion_cse_(false), index_fixing_(true), network_simplification_(false), last_exec_stats_(), logging_(0), intra_comm_(communicator)
 {
  int mpi_error = MPI_Comm_size(*(communicator.get<MPI_Comm>()),&num_processes_); assert(mpi_error == MPI_SUCCESS);
  mpi_error = MPI_Comm_rank(*(communicator.get<MPI_Comm>()),&process_rank_); assert(mpi_error == MPI_SUCCESS);
@@ -56,7 +64,8 @@ NumServer::NumServer(const MPICommProxy & communicator,
 NumServer::NumServer(const ParamConf & parameters,
                      const std::string & graph_executor_name,
                      const std::string & node_executor_name):
- contr_seq_optimizer_("metis"), contr_seq_caching_(false), logging_(0)
+ contr_seq_optimizer_("metis"), contr_seq_caching_(false), contr_seq_refinement_(false), dynamic_load_balancing_(false),
+ parallel_expansion_(false), expansion_subgroups_(0), expansion_cse_(false), index_fixing_(true), network_simplification_(false), last_exec_stats_(), logging_(0)
 {
  num_processes_ = 1; process_rank_ = 0;
  process_world_ = std::make_shared<ProcessGroup>(intra_comm_,num_processes_); //intra-communicator is empty here
@@ -138,6 +147,227 @@ void NumServer::deactivateContrSeqCaching()
  return;
 }
 
+void NumServer::activateContrSeqRefinement()
+{
+ contr_seq_refinement_ = true;
+ return;
+}
+
+void NumServer::deactivateContrSeqRefinement()
+{
+ contr_seq_refinement_ = false;
+ return;
+}
+
+bool NumServer::activateContrPlanCaching(const std::string & file_name)
+{
+ contr_plan_cache_ = std::make_shared<numerics::ContractionPlanCache>(file_name);
+ if(!(contr_plan_cache_->isOpen())) contr_plan_cache_.reset();
+ return static_cast<bool>(contr_plan_cache_);
+}
+
+void NumServer::deactivateContrPlanCaching()
+{
+ contr_plan_cache_.reset();
+ return;
+}
+
+bool NumServer::calibrateContractionCostModel(const std::string & file_name, TensorElementType element_type)
+{
+ bool success = true;
+ std::vector<double> samples; //measured samples of the cost model
+ if(process_rank_ == 0){ //only the process with global rank 0 benchmarks the node executor
+  numerics::ContractionCostModel cost_model;
+  success = measureContractionCostModel(cost_model,element_type);
+  if(success) success = cost_model.saveToFile(file_name);
+  if(success) cost_model.packSamples(samples);
+ }
+#ifdef MPI_ENABLED
+ //Broadcast the measured samples to all processes:
+ if(num_processes_ > 1){
+  auto & mpicomm = process_world_->getMPICommProxy().getRef<MPI_Comm>();
+  long long int num_samples = (success ? static_cast<long long int>(samples.size()) : -1LL); //-1: calibration failed
+  auto errc = MPI_Bcast(&num_samples,1,MPI_LONG_LONG_INT,0,mpicomm); assert(errc == MPI_SUCCESS);
+  success = (num_samples >= 0);
+  if(success){
+   samples.resize(num_samples);
+   errc = MPI_Bcast(samples.data(),num_samples,MPI_DOUBLE,0,mpicomm); assert(errc == MPI_SUCCESS);
+  }
+ }
+#endif
+ //Activate the calibrated cost model in all processes:
+ if(success){
+  auto calibrated_model = std::make_shared<numerics::ContractionCostModel>();
+  success = calibrated_model->unpackSamples(samples);
+  if(success) numerics::ContractionCostModel::activate(calibrated_model);
+ }
+ if(logging_ > 0) logfile_ << "[" << std::fixed << std::setprecision(6) << exatn::Timer::timeInSecHR(getTimeStampStart())
+                           << "]: Tensor contraction cost model calibration finished with status " << success
+                           << std::endl << std::flush;
+ return success;
+}
+
+bool NumServer::measureContractionCostModel(numerics::ContractionCostModel & cost_model, TensorElementType element_type)
+{
+ const unsigned int MAX_LOG_GEMM_DIM = 12;        //max log2 of a GEMM dimension
+ const unsigned int LOG_GEMM_DIM_STEP = 2;        //log2 step for GEMM dimensions
+ const unsigned int MAX_PERM_RANK = 8;            //max tensor rank in permutation benchmarks
+ const unsigned int MIN_LOG_PERM_VOLUME = 10;     //min log2 of a tensor volume in permutation benchmarks
+ const unsigned int LOG_PERM_VOLUME_STEP = 4;     //log2 step for tensor volumes in permutation benchmarks
+ const double MAX_FMA_FLOPS = std::pow(2.0,33.0); //max FMA flop count in a GEMM benchmark
+ const unsigned int NUM_REPEATS = 3;              //number of timed repetitions (min time is taken)
+
+ const auto & process_group = *process_self_;
+ //Max tensor volume (three tensors of the largest element size must fit in memory):
+ const double max_volume = std::min(std::pow(2.0,24.0),
+  static_cast<double>(process_group.getMemoryLimitPerProcess()) / static_cast<double>(sizeof(std::complex<double>) * 3 * 2));
+ bool success = true;
+ //Times a given tensor operation (min over several repetitions after a warm-up):
+ auto time_operation = [&](const std::function<bool ()> & operation){
+  double min_time = -1.0;
+  for(unsigned int repeat = 0; repeat <= NUM_REPEATS; ++repeat){
+   const double time_start = exatn::Timer::timeInSecHR();
+   success = operation() && success;
+   success = sync(process_group,true) && success;
+   const double time = exatn::Timer::timeInSecHR(time_start);
+   if(repeat > 0 && (min_time < 0.0 || time < min_time)) min_time = time; //repetition 0 is a warm-up
+  }
+  return std::max(min_time,1e-9);
+ };
+ if(logging_ > 0) logfile_ << "[" << std::fixed << std::setprecision(6) << exatn::Timer::timeInSecHR(getTimeStampStart())
+                           << "]: Calibrating tensor contraction cost model:" << std::endl << std::flush;
+ //GEMM benchmarks: D(m,n) += L(k,m) * R(k,n):
+ for(unsigned int lm = 0; lm <= MAX_LOG_GEMM_DIM && success; lm += LOG_GEMM_DIM_STEP){
+  for(unsigned int ln = 0; ln <= MAX_LOG_GEMM_DIM && success; ln += LOG_GEMM_DIM_STEP){
+   for(unsigned int lk = 0; lk <= MAX_LOG_GEMM_DIM && success; lk += LOG_GEMM_DIM_STEP){
+    const DimExtent m = (1UL << lm), n = (1UL << ln), k = (1UL << lk);
+    const double flops = static_cast<double>(m) * static_cast<double>(n) * static_cast<double>(k);
+    if(flops > MAX_FMA_FLOPS || static_cast<double>(m*n) > max_volume ||
+       static_cast<double>(k*m) > max_volume || static_cast<double>(k*n) > max_volume) continue;
+    success = createTensorSync(process_group,"_calD",element_type,TensorShape{m,n}) && success;
+    success = createTensorSync(process_group,"_calL",element_type,TensorShape{k,m}) && success;
+    success = createTensorSync(process_group,"_calR",element_type,TensorShape{k,n}) && success;
+    success = initTensorSync("_calD",0.0) && success;
+    success = initTensorSync("_calL",1e-3) && success;
+    success = initTensorSync("_calR",1e-3) && success;
+    if(success){
+     const double time = time_operation([this](){return contractTensors("_calD(m,n)+=_calL(k,m)*_calR(k,n)",1.0);});
+     cost_model.appendGemmSample(m,n,k,time);
+     if(logging_ > 0) logfile_ << " GEMM " << m << " x " << n << " x " << k << ": " << std::scientific
+                               << (flops / time) << " FMA/s" << std::endl << std::flush;
+    }
+    success = destroyTensorSync("_calR") && success;
+    success = destroyTensorSync("_calL") && success;
+    success = destroyTensorSync("_calD") && success;
+   }
+  }
+ }
+ //Tensor permutation benchmarks: D(i0,i1,...) += L(...,i1,i0):
+ for(unsigned int rank = 2; rank <= MAX_PERM_RANK && success; ++rank){
+  for(unsigned int lv = std::max(MIN_LOG_PERM_VOLUME,rank); std::pow(2.0,lv) <= max_volume && success; lv += LOG_PERM_VOLUME_STEP){
+   std::vector<DimExtent> extents(rank), reversed_extents(rank);
+   std::string pattern_out, pattern_in;
+   for(unsigned int i = 0; i < rank; ++i){
+    extents[i] = (1UL << (lv / rank + ((i < lv % rank) ? 1 : 0)));
+    reversed_extents[rank - 1 - i] = extents[i];
+    pattern_out += ((i == 0) ? "" : ",") + std::string("i") + std::to_string(i);
+    pattern_in += ((i == 0) ? "" : ",") + std::string("i") + std::to_string(rank - 1 - i);
+   }
+   success = createTensorSync(process_group,"_calD",element_type,TensorShape(extents)) && success;
+   success = createTensorSync(process_group,"_calL",element_type,TensorShape(reversed_extents)) && success;
+   success = initTensorSync("_calD",0.0) && success;
+   success = initTensorSync("_calL",1e-3) && success;
+   if(success){
+    const std::string addition = "_calD(" + pattern_out + ")+=_calL(" + pattern_in + ")";
+    const double time = time_operation([this,&addition](){return addTensors(addition,1.0);});
+    const double volume = std::pow(2.0,lv);
+    cost_model.appendPermutationSample(rank,volume,time);
+    if(logging_ > 0) logfile_ << " PERM rank " << rank << " volume " << volume << ": " << std::scientific
+                              << (volume / time) << " elements/s" << std::endl << std::flush;
+   }
+   success = destroyTensorSync("_calL") && success;
+   success = destroyTensorSync("_calD") && success;
+  }
+ }
+ return success;
+}
+
+bool NumServer::activateContractionCostModel(const std::string & file_name)
+{
+ auto cost_model = std::make_shared<numerics::ContractionCostModel>();
+ bool success = cost_model->loadFromFile(file_name);
+ if(success) numerics::ContractionCostModel::activate(cost_model);
+ return success;
+}
+
+void NumServer::deactivateContractionCostModel()
+{
+ numerics::ContractionCostModel::deactivate();
+ return;
+}
+
+void NumServer::activateDynamicLoadBalancing()
+{
+ dynamic_load_balancing_ = true;
+ return;
+}
+
+void NumServer::deactivateDynamicLoadBalancing()
+{
+ dynamic_load_balancing_ = false;
+ return;
+}
+
+void NumServer::activateParallelExpansionEvaluation(unsigned int num_subgroups)
+{
+ parallel_expansion_ = true;
+ expansion_subgroups_ = num_subgroups;
+ return;
+}
+
+void NumServer::deactivateParallelExpansionEvaluation()
+{
+ parallel_expansion_ = false;
+ expansion_subgroups_ = 0;
+ return;
+}
+
+void NumServer::activateExpansionCSE()
+{
+ expansion_cse_ = true;
+ return;
+}
+
+void NumServer::deactivateExpansionCSE()
+{
+ expansion_cse_ = false;
+ return;
+}
+
+void NumServer::activateIndexFixing()
+{
+ index_fixing_ = true;
+ return;
+}
+
+void NumServer::deactivateIndexFixing()
+{
+ index_fixing_ = false;
+ return;
+}
+
+void NumServer::activateNetworkSimplification()
+{
+ network_simplification_ = true;
+ return;
+}
+
+void NumServer::deactivateNetworkSimplification()
+{
+ network_simplification_ = false;
+ return;
+}
+
 void NumServer::resetClientLoggingLevel(int level){
  if(logging_ == 0){
   if(level != 0) logfile_.open("exatn_main_thread."+std::to_string(process_rank_)+".log", std::ios::out | std::ios::trunc);
@@ -328,7 +558,15 @@ bool NumServer::submit(std::shared_ptr<TensorOperation> operation)
     submitted = false;
    }
   }
-  if(submitted) tensor_rt_->submit(operation);
+  if(submitted){
+   //Updated tensors are no longer registered basis vectors:
+   if(!basis_vectors_.empty()){
+    const auto num_out_operands = (operation->getOpcode() == TensorOpCode::CREATE ||
+                                   operation->getOpcode() == TensorOpCode::DESTROY) ? 1 : operation->getNumOperandsOut();
+    for(unsigned int i = 0; i < num_out_operands; ++i) basis_vectors_.erase(operation->getTensorOperand(i)->getName());
+   }
+   tensor_rt_->submit(operation);
+  }
  }
  return submitted;
 }
@@ -353,6 +591,24 @@ bool NumServer::submit(const ProcessGroup & process_group,
  unsigned int local_rank; //local process rank within the process group
  if(!process_group.rankIsIn(process_rank_,&local_rank)) return true; //process is not in the group: Do nothing
  assert(network.isValid()); //debug
+ //Fix the indices projected by basis vector tensors before planning (in a copy of the tensor network):
+ if(index_fixing_ && !basis_vectors_.empty() && network.exportContractionSequence().empty()){
+  bool basis_vectors_present = false;
+  for(auto iter = network.cbegin(); iter != network.cend(); ++iter){
+   if(iter->first != 0 && iter->second.getRank() == 1){
+    if(basis_vectors_.find(iter->second.getName()) != basis_vectors_.end()){
+     basis_vectors_present = true;
+     break;
+    }
+   }
+  }
+  if(basis_vectors_present){
+   TensorNetwork simplified(network);
+   auto num_projected = fixBasisVectorIndices(simplified);
+   if(num_projected < 0) return false;
+   if(num_projected > 0) return submit(process_group,simplified); //the output tensor is shared with the original tensor network
+  }
+ }
  unsigned int num_procs = process_group.getSize(); //number of executing processes
  assert(local_rank < num_procs);
  if(logging_ > 0) logfile_ << "[" << std::fixed << std::setprecision(6) << exatn::Timer::timeInSecHR(getTimeStampStart())
@@ -370,8 +626,28 @@ bool NumServer::submit(const ProcessGroup & process_group,
    new_contr_seq = false;
   }
  }
+ bool cached_plan = false; //whether or not the contraction plan has been retrieved from the persistent contraction plan cache
+ double cached_plan_flops = 0.0;
+ std::size_t cached_plan_volume = 0;
+ std::vector<std::pair<std::string,std::size_t>> cached_split_plan;
+ if(contr_plan_cache_ && new_contr_seq){ //check whether the contraction plan is available from the persistent cache
+  cached_plan = contr_plan_cache_->retrievePlan(network,&cached_split_plan,&cached_plan_volume);
+  if(cached_plan){
+   network.exportContractionSequence(&cached_plan_flops);
+   new_contr_seq = false;
+  }
+ }
  if(new_contr_seq){
-  double flops = network.determineContractionSequence(contr_seq_optimizer_);
+  numerics::ContrSeqRefinementInfo refinement_info;
+  unsigned int num_removed = 0;
+  double flops = network.determineContractionSequence(contr_seq_optimizer_,contr_seq_refinement_,&refinement_info,
+                                                      network_simplification_,&num_removed);
+  if(logging_ > 0 && network_simplification_) logfile_ << "[" << std::fixed << std::setprecision(6) << exatn::Timer::timeInSecHR(getTimeStampStart())
+   << "]: Tensor network simplification removed " << num_removed << " of " << num_input_tensors << " input tensors" << std::endl << std::flush;
+  if(logging_ > 0 && contr_seq_refinement_) logfile_ << "[" << std::fixed << std::setprecision(6) << exatn::Timer::timeInSecHR(getTimeStampStart())
+   << "]: Contraction sequence refinement: FMA flop count " << std::scientific << refinement_info.original_flops
+   << " -> " << refinement_info.refined_flops << " (" << refinement_info.num_refined << " of " << refinement_info.num_windows
+   << " subtrees re-optimized) in " << std::fixed << refinement_info.time << " sec" << std::endl << std::flush;
  }
 
 #ifdef MPI_ENABLED
@@ -394,6 +670,11 @@ bool NumServer::submit(const ProcessGroup & process_group,
                    root_id,process_group.getMPICommProxy().getRef<MPI_Comm>());
   assert(errc == MPI_SUCCESS);
   network.importContractionSequence(contr_seq_content,flops);
+  //The cached index splitting plan can only be reused by all processes consistently:
+  int plan_reusable = (cached_plan && flops == cached_plan_flops) ? 1 : 0;
+  errc = MPI_Allreduce(MPI_IN_PLACE,&plan_reusable,1,MPI_INT,MPI_MIN,process_group.getMPICommProxy().getRef<MPI_Comm>());
+  assert(errc == MPI_SUCCESS);
+  cached_plan = (plan_reusable != 0);
  }
 #endif
 
@@ -417,7 +698,14 @@ bool NumServer::submit(const ProcessGroup & process_group,
  }
  if(logging_ > 0) logfile_ << max_intermediate_volume << " (after slicing)" << std::endl << std::flush;
  //if(max_intermediate_presence_volume > 0.0 && max_intermediate_volume > 0.0)
- network.splitIndices(static_cast<std::size_t>(max_intermediate_volume));
+ bool plan_reused = false;
+ if(cached_plan && cached_plan_volume == static_cast<std::size_t>(max_intermediate_volume)){
+  plan_reused = network.splitIndices(cached_split_plan);
+ }
+ if(!plan_reused) network.splitIndices(static_cast<std::size_t>(max_intermediate_volume));
+ if(contr_plan_cache_ && !plan_reused && local_rank == 0){
+  contr_plan_cache_->storePlan(network,static_cast<std::size_t>(max_intermediate_volume));
+ }
  if(logging_ > 0) network.printSplitIndexInfo(logfile_,logging_ > 1);
 
  //Create the output tensor of the tensor network if needed:
@@ -443,137 +731,141 @@ bool NumServer::submit(const ProcessGroup & process_group,
  //Submit all tensor operations for tensor network evaluation:
  const auto num_split_indices = network.getNumSplitIndices(); //total number of indices that were split
  if(logging_ > 0) logfile_ << "Number of split indices = " << num_split_indices << std::endl << std::flush;
+ last_exec_stats_ = NetworkExecStats();
+ last_exec_stats_.num_split_indices = num_split_indices;
  std::size_t num_items_executed = 0; //number of tensor sub-networks executed
  if(num_split_indices > 0){ //multiple tensor sub-networks need to be executed by all processes ditributively
   //Distribute tensor sub-networks among processes:
   std::vector<DimExtent> work_extents(num_split_indices);
   for(int i = 0; i < num_split_indices; ++i) work_extents[i] = network.getSplitIndexInfo(i).second.size(); //number of segments per split index
   numerics::TensorRange work_range(work_extents); //each range dimension refers to the number of segments per the corresponding split index
+  const DimExtent num_work_items = work_range.localVolume(); //total number of tensor sub-networks
+  bool dynamic_distribution = (num_procs > 1 && dynamic_load_balancing_);
+  std::size_t num_chunks_claimed = 0; //number of chunks of tensor sub-networks claimed by the current process
+#ifdef MPI_ENABLED
+  MPI_Win work_counter_win; //RMA window exposing the shared counter of claimed tensor sub-networks (stored by process 0)
+  long long int * work_counter = nullptr;
+  DimExtent work_claimed = 0; //last observed value of the shared counter
+  if(dynamic_distribution){
+   auto & mpicomm = process_group.getMPICommProxy().getRef<MPI_Comm>();
+   MPI_Aint win_size = 0; if(local_rank == 0) win_size = sizeof(long long int);
+   auto errc = MPI_Win_allocate(win_size,sizeof(long long int),MPI_INFO_NULL,mpicomm,&work_counter,&work_counter_win);
+   assert(errc == MPI_SUCCESS);
+   if(local_rank == 0){
+    errc = MPI_Win_lock(MPI_LOCK_EXCLUSIVE,0,0,work_counter_win); assert(errc == MPI_SUCCESS);
+    *work_counter = 0;
+    errc = MPI_Win_unlock(0,work_counter_win); assert(errc == MPI_SUCCESS);
+   }
+   errc = MPI_Barrier(mpicomm); assert(errc == MPI_SUCCESS);
+   errc = MPI_Win_lock_all(MPI_MODE_NOCHECK,work_counter_win); assert(errc == MPI_SUCCESS);
+  }
+#else
+  dynamic_distribution = false;
+#endif
+  //Claims the next chunk of tensor sub-networks via an atomic update of the shared counter (guided self-scheduling):
+  auto claim_work_chunk = [&]() -> bool {
+   bool claimed = false;
+#ifdef MPI_ENABLED
+   const DimExtent remaining = (num_work_items > work_claimed) ? (num_work_items - work_claimed) : 0;
+   long long int chunk = std::max(static_cast<long long int>(1),
+                                  static_cast<long long int>(remaining / (2 * num_procs))); //chunk size decreases over time
+   long long int chunk_begin = 0;
+   auto errc = MPI_Fetch_and_op(&chunk,&chunk_begin,MPI_LONG_LONG_INT,0,0,MPI_SUM,work_counter_win);
+   assert(errc == MPI_SUCCESS);
+   errc = MPI_Win_flush(0,work_counter_win); assert(errc == MPI_SUCCESS);
+   work_claimed = static_cast<DimExtent>(chunk_begin + chunk);
+   claimed = work_range.resetSubrange(static_cast<DimOffset>(chunk_begin),static_cast<DimOffset>(chunk_begin + chunk));
+   if(claimed){
+    ++num_chunks_claimed;
+    if(logging_ > 1) logfile_ << "Claimed sub-networks [" << chunk_begin << ":" << (chunk_begin + chunk) << ")" << std::endl;
+   }
+#endif
+   return claimed;
+  };
   bool not_done = true;
-  if(num_procs > 1) not_done = work_range.reset(num_procs,local_rank); //work subrange for the current local process rank (may be empty)
-  if(logging_ > 0) logfile_ << "Total number of sub-networks = " << work_range.localVolume()
-                            << "; Current process has a share (0/1) = " << not_done << std::endl << std::flush;
+  if(dynamic_distribution){
+   not_done = claim_work_chunk(); //first chunk of tensor sub-networks for the current process (may be empty)
+  }else{
+   if(num_procs > 1) not_done = work_range.reset(num_procs,local_rank); //work subrange for the current local process rank (may be empty)
+  }
+  if(logging_ > 0) logfile_ << "Total number of sub-networks = " << num_work_items
+                            << "; Current process has a share (0/1) = " << not_done
+                            << "; Dynamic distribution (0/1) = " << dynamic_distribution << std::endl << std::flush;
+  std::shared_ptr<TensorOperation> last_chunk_op, prev_chunk_op; //last tensor operations of the current and previous chunks
+  bool failed = false; //submission failure (the RMA window still needs to be released collectively)
+  //Execute slice-invariant tensor operations only once if the retained intermediates fit in memory:
+  bool hoist_invariants = false;
+  if(not_done && network.getSliceInvariantFMAFlops() > 0.0){
+   const double hoisted_presence_volume = network.getMaxSlicedIntermediatePresenceVolume(true);
+   hoist_invariants = (hoisted_presence_volume * 1.5 * 2.0 <= static_cast<double>(proc_mem_volume) ||
+                       hoisted_presence_volume <= network.getMaxSlicedIntermediatePresenceVolume(false));
+   if(logging_ > 0) logfile_ << "Slice-invariant FMA flop count = " << std::scientific << network.getSliceInvariantFMAFlops()
+                             << " out of total FMA flop count = " << network.getFMAFlops()
+                             << "; Retained slice-invariant volume = " << network.getSliceInvariantVolume()
+                             << "; Hoisted (0/1) = " << hoist_invariants << std::endl << std::flush;
+  }
+  if(hoist_invariants){
+   for(auto op = op_list.begin(); op != op_list.end(); ++op){
+    if(network.getSliceDependence(**op) == numerics::SliceDependence::INVARIANT){
+     submitted = submit(*op); if(!submitted){failed = true; break;}
+     ++(last_exec_stats_.num_hoisted_ops);
+    }
+   }
+  }
+  //Compile the sliced execution template (tensor operation list with rebindable sliced operands):
+  numerics::SlicedExecutionTemplate sliced_template(network,op_list,hoist_invariants);
+  last_exec_stats_.num_template_ops = sliced_template.getNumOperations();
+  if(logging_ > 1) sliced_template.printItFile(logfile_);
+  std::vector<std::shared_ptr<TensorOperation>> sliced_ops; //tensor operations for the current tensor sub-network
   //Each process executes its share of tensor sub-networks:
-  while(not_done){
+  while(not_done && !failed){
    if(logging_ > 1){
     logfile_ << "Submitting sub-network ";
     work_range.printCurrent(logfile_);
     logfile_ << std::endl;
    }
-   std::unordered_map<numerics::TensorHashType,std::shared_ptr<numerics::Tensor>> intermediate_slices; //temporary slices of intermediates
-   std::unordered_map<numerics::TensorHashType,std::shared_ptr<numerics::Tensor>> input_slices; //temporary slices of input tensors
-   //Execute all tensor operations for the current tensor sub-network:
-   for(auto op = op_list.begin(); op != op_list.end(); ++op){
-    if(debugging && serialize) (*op)->printIt(); //debug
-    const auto num_operands = (*op)->getNumOperands();
-    std::shared_ptr<TensorOperation> tens_op = (*op)->clone();
-    //Substitute sliced tensor operands with their respective slices from the current tensor sub-network:
-    std::shared_ptr<numerics::Tensor> output_tensor_slice;
-    for(unsigned int op_num = 0; op_num < num_operands; ++op_num){
-     auto tensor = (*op)->getTensorOperand(op_num);
-     const auto tensor_rank = tensor->getRank();
-     bool tensor_is_output;
-     bool tensor_is_intermediate = tensorNameIsIntermediate(*tensor,&tensor_is_output);
-     tensor_is_output = (tensor == output_tensor);
-     //Look up the tensor operand in the table of sliced tensor operands:
-     std::pair<numerics::TensorHashType,numerics::TensorHashType> key;
-     if(tensor_is_intermediate || tensor_is_output){ //intermediate tensor (including output tensor)
-      numerics::TensorHashType zero = 0;
-      key = std::make_pair(zero,tensor->getTensorHash());
-     }else{ //input tensor
-      numerics::TensorHashType pos = op_num;
-      key = std::make_pair((*op)->getTensorOpHash(),pos);
-     }
-     const auto * tensor_info = network.getSplitTensorInfo(key);
-     //Replace the full tensor operand with its respective slice (if found):
-     if(tensor_info != nullptr){ //tensor has splitted indices
-      std::shared_ptr<numerics::Tensor> tensor_slice;
-      //Look up the tensor slice in case it has already been created:
-      if(tensor_is_intermediate && (!tensor_is_output)){ //pure intermediate tensor
-       auto slice_iter = intermediate_slices.find(tensor->getTensorHash()); //look up by the hash of the parental tensor
-       if(slice_iter != intermediate_slices.end()) tensor_slice = slice_iter->second;
-      }else{ //input/output tensor
-       auto slice_iter = input_slices.find(tensor->getTensorHash()); //look up by the hash of the parental tensor
-       if(slice_iter != input_slices.end()) tensor_slice = slice_iter->second;
-      }
-      //Create the tensor slice upon first encounter:
-      if(!tensor_slice){
-       //Import original subspaces and dimension extents from the parental tensor:
-       std::vector<SubspaceId> subspaces(tensor_rank);
-       for(unsigned int i = 0; i < tensor_rank; ++i) subspaces[i] = tensor->getDimSubspaceId(i);
-       std::vector<DimExtent> dim_extents(tensor_rank);
-       for(unsigned int i = 0; i < tensor_rank; ++i) dim_extents[i] = tensor->getDimExtent(i);
-       //Replace the sliced dimensions with their updated subspaces and dimension extents:
-       for(const auto & index_desc: *tensor_info){
-        const auto gl_index_id = index_desc.first;
-        const auto index_pos = index_desc.second;
-        const auto & index_info = network.getSplitIndexInfo(gl_index_id);
-        const auto segment_selector = work_range.getIndex(gl_index_id);
-        subspaces[index_pos] = index_info.second[segment_selector].first;
-        dim_extents[index_pos] = index_info.second[segment_selector].second;
-        if(logging_ > 1) logfile_ << "Index replacement in tensor " << tensor->getName()
-         << ": " << index_info.first << " in position " << index_pos << std::endl;
-       }
-       //Construct the tensor slice from the parental tensor:
-       tensor_slice = tensor->createSubtensor(subspaces,dim_extents);
-       tensor_slice->rename(); //unique automatic name will be generated
-       //Store the tensor in the table for subsequent referencing:
-       if(tensor_is_intermediate && (!tensor_is_output)){ //pure intermediate tensor
-        auto res = intermediate_slices.emplace(std::make_pair(tensor->getTensorHash(),tensor_slice));
-        assert(res.second);
-       }else{ //input tensor
-        auto res = input_slices.emplace(std::make_pair(tensor->getTensorHash(),tensor_slice));
-        assert(res.second);
-       }
-      }
-      //Replace the sliced tensor operand with its current slice in the primary tensor operation:
-      bool replaced = tens_op->resetTensorOperand(op_num,tensor_slice); assert(replaced);
-      //Allocate the input/output tensor slice and extract its contents (not for intermediates):
-      if(!tensor_is_intermediate || tensor_is_output){ //input/output tensor: create slice and extract its contents
-       //Create an empty slice of the input/output tensor:
-       std::shared_ptr<TensorOperation> create_slice = tensor_op_factory_->createTensorOp(TensorOpCode::CREATE);
-       create_slice->setTensorOperand(tensor_slice);
-       std::dynamic_pointer_cast<numerics::TensorOpCreate>(create_slice)->
-        resetTensorElementType(tensor->getElementType());
-       submitted = submit(create_slice); if(!submitted) return false;
-       //Extract the slice contents from the input/output tensor:
-       if(tensor_is_output){ //make sure the output tensor slice only shows up once
-        //assert(tensor == output_tensor);
-        assert(!output_tensor_slice);
-        output_tensor_slice = tensor_slice;
-       }
-       std::shared_ptr<TensorOperation> extract_slice = tensor_op_factory_->createTensorOp(TensorOpCode::SLICE);
-       extract_slice->setTensorOperand(tensor_slice);
-       extract_slice->setTensorOperand(tensor);
-       submitted = submit(extract_slice); if(!submitted) return false;
-      }
-     }
-    } //loop over tensor operands
-    //Submit the primary tensor operation with the current slices:
-    submitted = submit(tens_op); if(!submitted) return false;
-    //Insert the output tensor slice back into the output tensor:
-    if(output_tensor_slice){
-     std::shared_ptr<TensorOperation> insert_slice = tensor_op_factory_->createTensorOp(TensorOpCode::INSERT);
-     insert_slice->setTensorOperand(output_tensor);
-     insert_slice->setTensorOperand(output_tensor_slice);
-     submitted = submit(insert_slice); if(!submitted) return false;
-     output_tensor_slice.reset();
-    }
-    //Destroy temporary input tensor slices:
-    for(auto & input_slice: input_slices){
-     std::shared_ptr<TensorOperation> destroy_slice = tensor_op_factory_->createTensorOp(TensorOpCode::DESTROY);
-     destroy_slice->setTensorOperand(input_slice.second);
-     submitted = submit(destroy_slice); if(!submitted) return false;
-    }
+   //The tensor operations of the reused template instance must have completed:
+   for(const auto & op: sliced_template.getPendingOperations()){
+    if(!sync(*op)){failed = true; break;}
+   }
+   if(failed) break;
+   //Instantiate and submit all tensor operations for the current tensor sub-network:
+   const auto last_op = sliced_template.instantiate(work_range,sliced_ops);
+   for(auto & op: sliced_ops){
+    if(debugging && serialize) op->printIt(); //debug
+    submitted = submit(op); if(!submitted){failed = true; break;}
     if(serialize) sync(); //debug
-    input_slices.clear();
-   } //loop over tensor operations
-   //Erase intermediate tensor slices once all tensor operations have been executed:
-   intermediate_slices.clear();
+   }
+   if(failed) break;
+   if(!sliced_ops.empty()) last_chunk_op = sliced_ops[last_op];
    ++num_items_executed;
    //Proceed to the next tensor sub-network:
    not_done = work_range.next();
+   if(!not_done && dynamic_distribution){
+    //Keep at most two chunks in flight before claiming the next one:
+    if(prev_chunk_op){
+     auto synced = sync(*prev_chunk_op); assert(synced);
+    }
+    prev_chunk_op = last_chunk_op;
+    not_done = claim_work_chunk();
+   }
   } //loop over tensor sub-networks
+#ifdef MPI_ENABLED
+  if(dynamic_distribution){
+   auto errc = MPI_Win_unlock_all(work_counter_win); assert(errc == MPI_SUCCESS);
+   errc = MPI_Win_free(&work_counter_win); assert(errc == MPI_SUCCESS);
+   if(logging_ > 0) logfile_ << "Number of claimed chunks of sub-networks = " << num_chunks_claimed << std::endl << std::flush;
+  }
+#endif
+  if(failed) return false;
+  //Destroy the retained slice-invariant intermediates:
+  if(hoist_invariants){
+   for(auto op = op_list.begin(); op != op_list.end(); ++op){
+    if(network.getSliceDependence(**op) == numerics::SliceDependence::RETAINED){
+     submitted = submit(*op); if(!submitted) return false;
+    }
+   }
+  }
   //Allreduce the tensor network output tensor within the executing process group:
   if(num_procs > 1){
    std::shared_ptr<TensorOperation> allreduce = tensor_op_factory_->createTensorOp(TensorOpCode::ALLREDUCE);
@@ -585,8 +877,10 @@ bool NumServer::submit(const ProcessGroup & process_group,
   for(auto op = op_list.begin(); op != op_list.end(); ++op){
    submitted = submit(*op); if(!submitted) return false;
   }
+  last_exec_stats_.num_template_ops = op_list.size();
   ++num_items_executed;
  }
+ last_exec_stats_.num_subnetworks = num_items_executed;
  if(logging_ > 0) logfile_ << "Number of submitted sub-networks = " << num_items_executed << std::endl << std::flush;
  return true;
 }
@@ -614,23 +908,294 @@ bool NumServer::submit(const ProcessGroup & process_group,
                        TensorExpansion & expansion,
                        std::shared_ptr<Tensor> accumulator)
 {
- if(!process_group.rankIsIn(process_rank_)) return true; //process is not in the group: Do nothing
+ unsigned int local_rank; //local process rank within the process group
+ if(!process_group.rankIsIn(process_rank_,&local_rank)) return true; //process is not in the group: Do nothing
+ assert(accumulator);
+#ifdef MPI_ENABLED
+ const unsigned int num_procs = process_group.getSize();
+ const unsigned int num_components = expansion.getNumComponents();
+ if(parallel_expansion_ && num_procs > 1 && num_components > 1){
+  auto & mpicomm = process_group.getMPICommProxy().getRef<MPI_Comm>();
+  //Estimate the FMA flop count of each tensor network component (each process estimates its round-robin share):
+  std::vector<double> component_flops(num_components,0.0);
+  unsigned int i = 0;
+  for(auto component = expansion.begin(); component != expansion.end(); ++component){
+   if(i % num_procs == local_rank){
+    auto & network = *(component->network_);
+    double flops = 0.0;
+    if(network.exportContractionSequence(&flops).empty())
+     flops = network.determineContractionSequence(contr_seq_optimizer_,contr_seq_refinement_);
+    component_flops[i] = flops;
+   }
+   ++i;
+  }
+  auto errc = MPI_Allreduce(MPI_IN_PLACE,component_flops.data(),num_components,MPI_DOUBLE,MPI_SUM,mpicomm);
+  assert(errc == MPI_SUCCESS);
+  //Split the process group into contiguous process subgroups:
+  unsigned int num_subgroups = std::min(num_procs,num_components);
+  if(expansion_subgroups_ > 0) num_subgroups = std::min(num_subgroups,expansion_subgroups_);
+  std::vector<unsigned int> subgroup_size(num_subgroups,0);
+  for(unsigned int rank = 0; rank < num_procs; ++rank) ++subgroup_size[(rank * num_subgroups) / num_procs];
+  const unsigned int my_subgroup = (local_rank * num_subgroups) / num_procs;
+  auto subgroup = process_group.split(static_cast<int>(my_subgroup)); assert(subgroup);
+  unsigned int subgroup_rank;
+  auto in_subgroup = subgroup->rankIsIn(process_rank_,&subgroup_rank); assert(in_subgroup);
+  //Assign the tensor network components to the process subgroups (longest processing time first):
+  std::vector<unsigned int> component_order(num_components);
+  for(i = 0; i < num_components; ++i) component_order[i] = i;
+  std::stable_sort(component_order.begin(),component_order.end(),
+                   [&component_flops](unsigned int i0, unsigned int i1){return component_flops[i0] > component_flops[i1];});
+  std::vector<double> subgroup_load(num_subgroups,0.0);
+  std::vector<unsigned int> assignment(num_components);
+  for(const auto & comp: component_order){
+   unsigned int best = 0;
+   for(unsigned int grp = 1; grp < num_subgroups; ++grp){
+    if((subgroup_load[grp] + component_flops[comp]) / subgroup_size[grp] <
+       (subgroup_load[best] + component_flops[comp]) / subgroup_size[best]) best = grp;
+   }
+   subgroup_load[best] += component_flops[comp];
+   assignment[comp] = best;
+  }
+  if(logging_ > 0) logfile_ << "[" << std::fixed << std::setprecision(6) << exatn::Timer::timeInSecHR(getTimeStampStart())
+                            << "]: Evaluating " << num_components << " tensor expansion components by " << num_subgroups
+                            << " process subgroups: Process subgroup " << my_subgroup << " of size " << subgroup->getSize()
+                            << " is assigned FMA flop count " << std::scientific << subgroup_load[my_subgroup]
+                            << std::endl << std::flush;
+  //Evaluate the tensor network components assigned to the process subgroup:
+  auto partial_sum = std::make_shared<Tensor>(*accumulator);
+  partial_sum->rename(tensor_hex_name("ps",partial_sum->getTensorHash())); //unique name (not an intermediate of any tensor network)
+  bool success = createTensorSync(process_group,partial_sum,getTensorElementType(accumulator->getName()));
+  if(success) success = initTensorSync(partial_sum->getName(),0.0);
+  IndexModeMap add_pattern;
+  auto generated = generate_addition_pattern(accumulator->getRank(),add_pattern); assert(generated);
+  std::list<std::shared_ptr<Tensor>> output_tensors;
+  i = 0;
+  for(auto component = expansion.begin(); component != expansion.end() && success; ++component){
+   if(assignment[i++] == my_subgroup){
+    auto & network = *(component->network_);
+    success = submit(*subgroup,network);
+    if(success && subgroup_rank == 0){ //only the subgroup root accumulates the scaled output tensor
+     bool conjugated;
+     auto output_tensor = network.getTensor(0,&conjugated); assert(!conjugated); //output tensor cannot be conjugated
+     std::shared_ptr<TensorOperation> op = tensor_op_factory_->createTensorOp(TensorOpCode::ADD);
+     op->setTensorOperand(partial_sum);
+     op->setTensorOperand(output_tensor,conjugated);
+     op->setScalar(0,component->coefficient_);
+     op->setIndexPattern(add_pattern);
+     success = submit(op);
+    }
+    output_tensors.emplace_back(network.getTensor(0));
+   }
+  }
+  //Complete the evaluation within the process subgroup before it is released:
+  for(const auto & output_tensor: output_tensors) success = sync(*subgroup,*output_tensor) && success;
+  //Reduce the partial sums of all process subgroups into the accumulator:
+  success = allreduceTensorSync(process_group,partial_sum->getName()) && success;
+  if(success){
+   std::shared_ptr<TensorOperation> op = tensor_op_factory_->createTensorOp(TensorOpCode::ADD);
+   op->setTensorOperand(accumulator);
+   op->setTensorOperand(partial_sum);
+   op->setScalar(0,std::complex<double>{1.0,0.0});
+   op->setIndexPattern(add_pattern);
+   success = submit(op);
+   if(success) success = sync(*op);
+  }
+  success = destroyTensorSync(partial_sum->getName()) && success;
+  return success;
+ }
+#endif
+ //Evaluate all tensor network components with shared intermediates computed only once:
+ if(expansion_cse_ && process_group.getSize() == 1 && expansion.getNumComponents() > 1){
+  numerics::TensorExpansionPlan plan(expansion,contr_seq_optimizer_,contr_seq_refinement_);
+  const std::size_t proc_mem_volume = process_group.getMemoryLimitPerProcess() / sizeof(std::complex<double>);
+  const bool combined = (plan.getMaxIntermediatePresenceVolume() * 1.5 * 2.0 <= static_cast<double>(proc_mem_volume)); //{1.5:memory fragmentation}; {2.0:tensor transpose}
+  if(logging_ > 0) logfile_ << "[" << std::fixed << std::setprecision(6) << exatn::Timer::timeInSecHR(getTimeStampStart())
+                            << "]: Common subexpression elimination in tensor expansion <" << expansion.getName()
+                            << ">: FMA flop count = " << std::scientific << plan.getFMAFlops() << "; Saved FMA flop count = "
+                            << plan.getSavedFMAFlops() << " (" << plan.getNumSharedIntermediates() << " shared intermediates)"
+                            << "; Max intermediate presence volume = " << plan.getMaxIntermediatePresenceVolume()
+                            << "; Applied (0/1) = " << combined << std::endl << std::flush;
+  if(combined) return submitComponents(process_group,expansion,accumulator,&plan);
+ }
+ return submitComponents(process_group,expansion,accumulator,nullptr);
+}
+
+bool NumServer::submit(const ProcessGroup & process_group,
+                       std::shared_ptr<TensorExpansion> expansion,
+                       std::shared_ptr<Tensor> accumulator)
+{
+ if(expansion) return submit(process_group,*expansion,accumulator);
+ return false;
+}
+
+bool NumServer::submitExpectation(TensorExpansion & bra,
+                                  TensorExpansion & ket,
+                                  const TensorOperator & tensor_operator,
+                                  std::shared_ptr<Tensor> accumulator)
+{
+ return submitExpectation(getDefaultProcessGroup(),bra,ket,tensor_operator,accumulator);
+}
+
+bool NumServer::submitExpectation(const ProcessGroup & process_group,
+                                  TensorExpansion & bra,
+                                  TensorExpansion & ket,
+                                  const TensorOperator & tensor_operator,
+                                  std::shared_ptr<Tensor> accumulator)
+{
+ unsigned int local_rank; //local process rank within the process group
+ if(!process_group.rankIsIn(process_rank_,&local_rank)) return true; //process is not in the group: Do nothing
  assert(accumulator);
+ //Build the closed tensor network expansion <bra|operator|ket> with the zipper contraction sequences:
+ numerics::MPSZipper zipper(bra,ket,tensor_operator);
+ auto & expansion = zipper.getExpansion();
+ if(logging_ > 0) logfile_ << "[" << std::fixed << std::setprecision(6) << exatn::Timer::timeInSecHR(getTimeStampStart())
+                           << "]: MPS zipper for <" << bra.getName() << "|" << tensor_operator.getName() << "|" << ket.getName()
+                           << ">: Applicable (0/1) = " << zipper.isApplicable() << "; Number of sites = " << zipper.getNumSites()
+                           << "; FMA flop count = " << std::scientific << zipper.getFMAFlops() << std::endl << std::flush;
+ //Compute the environments shared by the operator components only once:
+ if(zipper.isApplicable() && process_group.getSize() == 1 && expansion.getNumComponents() > 1){
+  numerics::TensorExpansionPlan plan(expansion); //all tensor contraction sequences have already been imported
+  const std::size_t proc_mem_volume = process_group.getMemoryLimitPerProcess() / sizeof(std::complex<double>);
+  const bool combined = (plan.getMaxIntermediatePresenceVolume() * 1.5 * 2.0 <= static_cast<double>(proc_mem_volume)); //{1.5:memory fragmentation}; {2.0:tensor transpose}
+  if(logging_ > 0) logfile_ << "[" << std::fixed << std::setprecision(6) << exatn::Timer::timeInSecHR(getTimeStampStart())
+                            << "]: MPS zipper environments shared by " << expansion.getNumComponents()
+                            << " operator components: FMA flop count = " << std::scientific << plan.getFMAFlops()
+                            << "; Saved FMA flop count = " << plan.getSavedFMAFlops()
+                            << "; Applied (0/1) = " << combined << std::endl << std::flush;
+  if(combined) return submitComponents(process_group,expansion,accumulator,&plan);
+ }
+ return submit(process_group,expansion,accumulator);
+}
+
+bool NumServer::submitBatch(std::vector<TensorExpansion> & expansions,
+                            const std::vector<std::shared_ptr<Tensor>> & accumulators)
+{
+ return submitBatch(getDefaultProcessGroup(),expansions,accumulators);
+}
+
+bool NumServer::submitBatch(const ProcessGroup & process_group,
+                            std::vector<TensorExpansion> & expansions,
+                            const std::vector<std::shared_ptr<Tensor>> & accumulators)
+{
+ unsigned int local_rank; //local process rank within the process group
+ if(!process_group.rankIsIn(process_rank_,&local_rank)) return true; //process is not in the group: Do nothing
+ if(expansions.size() != accumulators.size()){
+  std::cout << "#ERROR(exatn::NumServer::submitBatch): The number of accumulators does not match the number of tensor expansions: "
+            << accumulators.size() << " versus " << expansions.size() << std::endl;
+  return false;
+ }
+ //Collect all tensor network components of the batch into a single tensor network expansion:
+ bool combined = (expansion_cse_ && process_group.getSize() == 1 && expansions.size() > 1);
+ TensorExpansion batch;
+ for(auto expansion = expansions.begin(); expansion != expansions.end() && combined; ++expansion){
+  assert(accumulators[expansion - expansions.begin()]);
+  for(auto component = expansion->cbegin(); component != expansion->cend() && combined; ++component){
+   if(batch.getNumComponents() > 0){
+    auto first_network = batch.cbegin()->network_;
+    combined = component->network_->getTensor(0)->isCongruentTo(*(first_network->getTensor(0)))
+            && tensorLegsAreCongruent(component->network_->getTensorConnections(0),first_network->getTensorConnections(0));
+   }
+   if(combined) combined = batch.appendComponent(component->network_,component->coefficient_);
+  }
+ }
+ //Evaluate all tensor network components of the batch with shared intermediates computed only once:
+ if(combined && batch.getNumComponents() > 1){
+  numerics::TensorExpansionPlan plan(batch,contr_seq_optimizer_,contr_seq_refinement_);
+  const std::size_t proc_mem_volume = process_group.getMemoryLimitPerProcess() / sizeof(std::complex<double>);
+  combined = (plan.getMaxIntermediatePresenceVolume() * 1.5 * 2.0 <= static_cast<double>(proc_mem_volume)); //{1.5:memory fragmentation}; {2.0:tensor transpose}
+  if(logging_ > 0) logfile_ << "[" << std::fixed << std::setprecision(6) << exatn::Timer::timeInSecHR(getTimeStampStart())
+                            << "]: Batch of " << expansions.size() << " tensor expansions (" << batch.getNumComponents()
+                            << " components): FMA flop count = " << std::scientific << plan.getFMAFlops() << "; Saved FMA flop count = "
+                            << plan.getSavedFMAFlops() << " (" << plan.getNumSharedIntermediates() << " shared intermediates)"
+                            << "; Applied (0/1) = " << combined << std::endl << std::flush;
+  if(combined){
+   auto submitted = submitPlan(batch,plan); if(!submitted) return false;
+   for(std::size_t i = 0; i < expansions.size(); ++i){
+    submitted = submitAccumulations(expansions[i],accumulators[i]);
+    if(!submitted) return false;
+   }
+   return true;
+  }
+ }
+ //Evaluate the tensor network expansions one by one:
+ for(std::size_t i = 0; i < expansions.size(); ++i){
+  auto submitted = submit(process_group,expansions[i],accumulators[i]); if(!submitted) return false;
+ }
+ return true;
+}
+
+bool NumServer::groupTensorOperatorSync(const TensorOperator & tensor_operator,
+                                        TensorOperator & grouped_operator,
+                                        std::vector<std::string> * group_tensors)
+{
+ std::vector<TensorOperator::ComponentGroup> groups;
+ grouped_operator = tensor_operator.groupComponents(groups);
+ if(group_tensors != nullptr) group_tensors->clear();
+ if(logging_ > 0) logfile_ << "[" << std::fixed << std::setprecision(6) << exatn::Timer::timeInSecHR(getTimeStampStart())
+                           << "]: Grouping tensor operator <" << tensor_operator.getName() << ">: "
+                           << tensor_operator.getNumComponents() << " -> " << grouped_operator.getNumComponents()
+                           << " components (" << groups.size() << " groups)" << std::endl << std::flush;
+ bool success = true;
+ for(const auto & group: groups){
+  const auto & group_name = group.tensor->getName();
+  success = createTensorSync(group.tensor,getTensorElementType(group.members[0].tensor->getName()));
+  if(success) success = initTensorSync(group_name,0.0);
+  if(!success){
+   std::cout << "#ERROR(exatn::NumServer::groupTensorOperatorSync): Unable to create group tensor "
+             << group_name << std::endl;
+   break;
+  }
+  if(group_tensors != nullptr) group_tensors->emplace_back(group_name);
+  //Accumulate the scaled member tensors:
+  const unsigned int rank = group.tensor->getRank();
+  std::string group_indices;
+  for(unsigned int i = 0; i < rank; ++i) group_indices += ((i == 0) ? "i" : ",i") + std::to_string(i);
+  for(const auto & member: group.members){
+   std::vector<std::string> member_indices(rank);
+   for(unsigned int i = 0; i < rank; ++i) member_indices[member.dims[i]] = "i" + std::to_string(i);
+   std::string addition = group_name + "(" + group_indices + ")+=" + member.tensor->getName() + "(";
+   for(unsigned int i = 0; i < rank; ++i) addition += ((i == 0) ? "" : ",") + member_indices[i];
+   addition += ")";
+   success = addTensors(addition,member.coefficient);
+   if(!success) break;
+  }
+  if(success) success = sync(*(group.tensor));
+  if(!success) break;
+ }
+ return success;
+}
+
+bool NumServer::submitComponents(const ProcessGroup & process_group,
+                                 TensorExpansion & expansion,
+                                 std::shared_ptr<Tensor> accumulator,
+                                 const numerics::TensorExpansionPlan * plan)
+{
+ if(plan != nullptr){
+  auto submitted = submitPlan(expansion,*plan); if(!submitted) return false;
+ }else{
+  for(auto component = expansion.begin(); component != expansion.end(); ++component){
+   //Evaluate the tensor network component (compute its output tensor):
+   auto submitted = submit(process_group,*(component->network_)); if(!submitted) return false;
+  }
+ }
+ return submitAccumulations(expansion,accumulator);
+}
+
+bool NumServer::submitAccumulations(TensorExpansion & expansion,
+                                    std::shared_ptr<Tensor> accumulator)
+{
  std::list<std::shared_ptr<TensorOperation>> accumulations;
  for(auto component = expansion.begin(); component != expansion.end(); ++component){
-  //Evaluate the tensor network component (compute its output tensor):
-  auto & network = *(component->network_);
-  auto submitted = submit(process_group,network); if(!submitted) return false;
   //Create accumulation operation for the scaled computed output tensor:
   bool conjugated;
-  auto output_tensor = network.getTensor(0,&conjugated); assert(!conjugated); //output tensor cannot be conjugated
+  auto output_tensor = component->network_->getTensor(0,&conjugated); assert(!conjugated); //output tensor cannot be conjugated
   std::shared_ptr<TensorOperation> op = tensor_op_factory_->createTensorOp(TensorOpCode::ADD);
   op->setTensorOperand(accumulator);
   op->setTensorOperand(output_tensor,conjugated);
   op->setScalar(0,component->coefficient_);
-  std::string add_pattern;
+  IndexModeMap add_pattern;
   auto generated = generate_addition_pattern(accumulator->getRank(),add_pattern); assert(generated);
-  op->setIndexPattern(add_pattern);
+  op->setIndexPattern(std::move(add_pattern));
   accumulations.emplace_back(op);
  }
  //Submit all previously created accumulation operations:
@@ -640,12 +1205,31 @@ bool NumServer::submit(const ProcessGroup & process_group,
  return true;
 }
 
-bool NumServer::submit(const ProcessGroup & process_group,
-                       std::shared_ptr<TensorExpansion> expansion,
-                       std::shared_ptr<Tensor> accumulator)
+bool NumServer::submitPlan(TensorExpansion & expansion,
+                           const numerics::TensorExpansionPlan & plan)
 {
- if(expansion) return submit(process_group,*expansion,accumulator);
- return false;
+ //Create the output tensors of all tensor network components if needed and initialize them to zero:
+ for(auto component = expansion.begin(); component != expansion.end(); ++component){
+  auto output_tensor = component->network_->getTensor(0);
+  if(tensors_.find(output_tensor->getName()) == tensors_.end()){ //output tensor does not exist and needs to be created
+   implicit_tensors_.emplace_back(output_tensor); //list of implicitly created tensors (for garbage collection)
+   std::shared_ptr<TensorOperation> op0 = tensor_op_factory_->createTensorOp(TensorOpCode::CREATE);
+   op0->setTensorOperand(output_tensor);
+   std::dynamic_pointer_cast<numerics::TensorOpCreate>(op0)->
+    resetTensorElementType(output_tensor->getElementType());
+   auto submitted = submit(op0); if(!submitted) return false; //this CREATE operation will also register the output tensor
+  }
+  std::shared_ptr<TensorOperation> op1 = tensor_op_factory_->createTensorOp(TensorOpCode::TRANSFORM);
+  op1->setTensorOperand(output_tensor);
+  std::dynamic_pointer_cast<numerics::TensorOpTransform>(op1)->
+   resetFunctor(std::shared_ptr<TensorMethod>(new numerics::FunctorInitVal(0.0)));
+  auto submitted = submit(op1); if(!submitted) return false;
+ }
+ //Submit the combined list of tensor operations:
+ for(const auto & op: plan.getOperationList()){
+  auto submitted = submit(op); if(!submitted) return false;
+ }
+ return true;
 }
 
 bool NumServer::sync(const Tensor & tensor, bool wait)
@@ -770,6 +1354,23 @@ bool NumServer::registerTensorIsometry(const std::string & name,
  return registered;
 }
 
+bool NumServer::registerTensorBasisVector(const std::string & name,
+                                          DimOffset position)
+{
+ auto iter = tensors_.find(name);
+ if(iter == tensors_.end()){
+  std::cout << "#ERROR(exatn::NumServer::registerTensorBasisVector): Tensor " << name << " not found!" << std::endl;
+  return false;
+ }
+ if(iter->second->getRank() != 1 || position >= iter->second->getDimExtent(0)){
+  std::cout << "#ERROR(exatn::NumServer::registerTensorBasisVector): Tensor " << name
+            << " cannot be a basis vector with the unit element in position " << position << std::endl;
+  return false;
+ }
+ basis_vectors_[name] = position;
+ return true;
+}
+
 bool NumServer::createTensor(const std::string & name,
                              const TensorSignature & signature,
                              TensorElementType element_type)
@@ -1606,6 +2207,302 @@ bool NumServer::decomposeTensorSVDLRSync(const std::string & contraction)
  return parsed;
 }
 
+bool NumServer::decomposeTensorSVDTruncSync(const std::string & contraction,
+                                            const SVDTruncation & truncation,
+                                            std::size_t * achieved_rank,
+                                            double * truncation_error)
+{
+ //Parse the symbolic tensor decomposition specification:
+ std::vector<std::string> tensors;
+ bool parsed = parse_tensor_network(contraction,tensors);
+ if(!parsed){
+  std::cout << "#ERROR(exatn::NumServer::decomposeTensorSVDTruncSync): Invalid tensor contraction: " << contraction << std::endl;
+  return false;
+ }
+ if(tensors.size() != 3 && tensors.size() != 4){
+  std::cout << "#ERROR(exatn::NumServer::decomposeTensorSVDTruncSync): Invalid number of arguments in tensor contraction: "
+            << contraction << std::endl;
+  return false;
+ }
+ const bool three_factors = (tensors.size() == 4);
+ if(!three_factors && truncation.absorb == SVDAbsorb::NONE){
+  std::cout << "#ERROR(exatn::NumServer::decomposeTensorSVDTruncSync): Singular values must be absorbed into the tensor factors "
+            << "(SVDAbsorb::NONE is invalid) in two-factor tensor contraction: " << contraction << std::endl;
+  return false;
+ }
+ std::vector<std::string> names(tensors.size());
+ std::vector<std::vector<IndexLabel>> indices(tensors.size());
+ for(unsigned int i = 0; i < tensors.size(); ++i){
+  bool complex_conj = false;
+  parsed = parse_tensor(tensors[i],names[i],indices[i],complex_conj);
+  if(!parsed || complex_conj){
+   std::cout << "#ERROR(exatn::NumServer::decomposeTensorSVDTruncSync): Invalid argument#" << i << " in tensor contraction: "
+             << contraction << std::endl;
+   return false;
+  }
+  if((tensors_.find(names[i]) != tensors_.end()) != (i == 0)){
+   std::cout << "#ERROR(exatn::NumServer::decomposeTensorSVDTruncSync): Tensor " << names[i]
+             << ((i == 0) ? " not found" : " already exists") << " in tensor contraction: " << contraction << std::endl;
+   return false;
+  }
+ }
+ auto tensor0 = tensors_[names[0]];
+ const auto elem_type = tensor0->getElementType();
+ const auto & left_indices = indices[1];
+ const auto & right_indices = indices[three_factors ? 3 : 2];
+
+ //Map the indices of the decomposed tensor onto the matrix rows (left factor) and columns (right factor):
+ const auto num_dims = tensor0->getRank();
+ if(indices[0].size() != num_dims){
+  std::cout << "#ERROR(exatn::NumServer::decomposeTensorSVDTruncSync): Rank mismatch for tensor " << names[0]
+            << " in tensor contraction: " << contraction << std::endl;
+  return false;
+ }
+ std::map<std::string,unsigned int> dims; //index label --> dimension of the decomposed tensor
+ for(unsigned int i = 0; i < num_dims; ++i) dims.emplace(indices[0][i].label,i);
+ std::vector<std::size_t> row_strides(num_dims,0), col_strides(num_dims,0);
+ std::vector<DimExtent> left_extents(left_indices.size()), right_extents(right_indices.size());
+ int left_bond = -1, right_bond = -1;
+ std::size_t num_rows = 1, num_cols = 1, num_assigned = 0;
+ auto map_factor = [&](const std::vector<IndexLabel> & factor_indices,
+                       std::vector<DimExtent> & factor_extents,
+                       std::vector<std::size_t> & strides,
+                       std::size_t & matrix_dim,
+                       int & bond){
+  for(unsigned int i = 0; i < factor_indices.size(); ++i){
+   auto pos = dims.find(factor_indices[i].label);
+   if(pos != dims.end()){
+    if(strides[pos->second] > 0) return false;
+    factor_extents[i] = tensor0->getDimExtent(pos->second);
+    strides[pos->second] = matrix_dim;
+    matrix_dim *= factor_extents[i];
+    ++num_assigned;
+   }else{
+    if(bond >= 0) return false;
+    bond = i;
+   }
+  }
+  return (bond >= 0);
+ };
+ bool valid = map_factor(left_indices,left_extents,row_strides,num_rows,left_bond)
+           && map_factor(right_indices,right_extents,col_strides,num_cols,right_bond)
+           && (num_assigned == num_dims);
+ if(valid){
+  for(unsigned int i = 0; i < num_dims; ++i) valid = valid && (row_strides[i] == 0 || col_strides[i] == 0);
+  const auto & left_label = left_indices[left_bond].label;
+  const auto & right_label = right_indices[right_bond].label;
+  if(three_factors){
+   valid = valid && (left_label != right_label) && (indices[2].size() == 2)
+                 && (indices[2][0].label == left_label) && (indices[2][1].label == right_label);
+  }else{
+   valid = valid && (left_label == right_label);
+  }
+ }
+ if(!valid){
+  std::cout << "#ERROR(exatn::NumServer::decomposeTensorSVDTruncSync): Invalid index pattern (strictly one bond index per tensor factor expected): "
+            << contraction << std::endl;
+  return false;
+ }
+
+ //Compute the truncated SVD of the matricized tensor on the host:
+ auto local_tensor = getLocalTensor(tensor0);
+ if(!local_tensor){
+  std::cout << "#ERROR(exatn::NumServer::decomposeTensorSVDTruncSync): Unable to retrieve tensor " << names[0] << std::endl;
+  return false;
+ }
+ std::size_t rank = 0;
+ auto decompose = [&](const auto * body){
+  using NumericType = std::remove_const_t<std::remove_pointer_t<decltype(body)>>;
+  //Matricize the decomposed tensor:
+  std::vector<NumericType> matrix(num_rows * num_cols);
+  std::vector<DimExtent> mlndx(num_dims,0);
+  const std::size_t volume = num_rows * num_cols;
+  std::size_t row = 0, col = 0;
+  for(std::size_t offset = 0; offset < volume; ++offset){
+   matrix[col * num_rows + row] = body[offset];
+   for(unsigned int i = 0; i < num_dims; ++i){ //next multi-index (the first index is the fastest)
+    row += row_strides[i]; col += col_strides[i];
+    if(++mlndx[i] < tensor0->getDimExtent(i)) break;
+    row -= row_strides[i] * mlndx[i]; col -= col_strides[i] * mlndx[i];
+    mlndx[i] = 0;
+   }
+  }
+  std::vector<NumericType> u, vh;
+  std::vector<double> s;
+  bool done = numerics::computeTruncatedSVD(num_rows,num_cols,matrix.data(),truncation,u,s,vh,truncation_error);
+  if(!done) return false;
+  rank = s.size();
+  //Absorb the singular values:
+  if(!three_factors){
+   for(std::size_t k = 0; k < rank; ++k){
+    const double sv = (truncation.absorb == SVDAbsorb::BOTH) ? std::sqrt(s[k]) : s[k];
+    if(truncation.absorb == SVDAbsorb::LEFT || truncation.absorb == SVDAbsorb::BOTH){
+     for(std::size_t i = 0; i < num_rows; ++i) u[k * num_rows + i] *= sv;
+    }
+    if(truncation.absorb == SVDAbsorb::RIGHT || truncation.absorb == SVDAbsorb::BOTH){
+     for(std::size_t j = 0; j < num_cols; ++j) vh[j * rank + k] *= sv;
+    }
+   }
+  }
+  //Reshape a matrix factor into a tensor factor whose bond index runs over the matrix rank:
+  auto tensorize = [rank](const std::vector<NumericType> & factor,       //in: matrix factor
+                          std::vector<DimExtent> & extents,              //inout: tensor factor extents
+                          int bond,                                      //in: bond dimension
+                          bool bond_is_column){                          //in: whether the bond runs over the matrix columns
+   extents[bond] = rank;
+   const std::size_t other_dim = factor.size() / rank;
+   std::vector<NumericType> data(factor.size());
+   std::vector<DimExtent> mlndx(extents.size(),0);
+   for(std::size_t offset = 0; offset < data.size(); ++offset){
+    std::size_t other = 0, stride = 1;
+    for(unsigned int i = 0; i < extents.size(); ++i){
+     if(static_cast<int>(i) != bond){other += mlndx[i] * stride; stride *= extents[i];}
+    }
+    const std::size_t k = mlndx[bond];
+    data[offset] = bond_is_column ? factor[k * other_dim + other] : factor[other * rank + k];
+    for(unsigned int i = 0; i < extents.size(); ++i){ //next multi-index (the first index is the fastest)
+     if(++mlndx[i] < extents[i]) break;
+     mlndx[i] = 0;
+    }
+   }
+   return data;
+  };
+  //Create and initialize the tensor factors:
+  auto left_data = tensorize(u,left_extents,left_bond,true);
+  auto right_data = tensorize(vh,right_extents,right_bond,false);
+  done = createTensorSync(names[1],elem_type,TensorShape(left_extents))
+      && initTensorDataSync(names[1],left_data);
+  if(done && three_factors){
+   std::vector<NumericType> middle_data(rank * rank,NumericType(0.0));
+   for(std::size_t k = 0; k < rank; ++k) middle_data[k * rank + k] = NumericType(s[k]);
+   done = createTensorSync(names[2],elem_type,TensorShape{rank,rank})
+       && initTensorDataSync(names[2],middle_data);
+  }
+  if(done){
+   const auto & name = names[three_factors ? 3 : 2];
+   done = createTensorSync(name,elem_type,TensorShape(right_extents))
+       && initTensorDataSync(name,right_data);
+  }
+  return done;
+ };
+ bool success = false;
+ switch(elem_type){
+  case TensorElementType::REAL32:
+   {const float * body; if(local_tensor->getDataAccessHostConst(&body)) success = decompose(body);}
+   break;
+  case TensorElementType::REAL64:
+   {const double * body; if(local_tensor->getDataAccessHostConst(&body)) success = decompose(body);}
+   break;
+  case TensorElementType::COMPLEX32:
+   {const std::complex<float> * body; if(local_tensor->getDataAccessHostConst(&body)) success = decompose(body);}
+   break;
+  case TensorElementType::COMPLEX64:
+   {const std::complex<double> * body; if(local_tensor->getDataAccessHostConst(&body)) success = decompose(body);}
+   break;
+  default:
+   std::cout << "#ERROR(exatn::NumServer::decomposeTensorSVDTruncSync): Unsupported tensor element type!" << std::endl;
+ }
+ if(success){
+  if(achieved_rank != nullptr) *achieved_rank = rank;
+ }else{
+  std::cout << "#ERROR(exatn::NumServer::decomposeTensorSVDTruncSync): Truncated SVD failed for tensor contraction: "
+            << contraction << std::endl;
+ }
+ return success;
+}
+
+std::shared_ptr<TensorOperation> NumServer::createTwoSiteGateSVDOp(const std::string & pattern,
+                                                                   const SVDTruncation & truncation)
+{
+ std::shared_ptr<TensorOperation> op(nullptr);
+ std::vector<std::string> tensors;
+ auto parsed = parse_tensor_network(pattern,tensors);
+ if(parsed){
+  if(tensors.size() == 4){
+   op = tensor_op_factory_->createTensorOp(TensorOpCode::APPLY_GATE_SVD2);
+   std::vector<IndexLabel> output_indices;
+   std::map<std::string,unsigned int> input_labels; //index label --> number of occurrences in the input tensors
+   for(unsigned int i = 0; i < tensors.size(); ++i){
+    std::string tensor_name;
+    std::vector<IndexLabel> indices;
+    bool complex_conj = false;
+    parsed = parse_tensor(tensors[i],tensor_name,indices,complex_conj);
+    if(parsed && complex_conj){ //the fused operation updates the tensors in place and does not conjugate the gate
+     std::cout << "#ERROR(exatn::NumServer::applyTwoSiteGateSVD): Complex conjugation is not supported for argument#" << i
+               << " in tensor contraction: " << pattern << std::endl;
+     return std::shared_ptr<TensorOperation>(nullptr);
+    }
+    if(parsed){
+     if(i == 0){ //two-site tensor (virtual)
+      output_indices = indices;
+      continue;
+     }
+     for(const auto & index: indices) ++input_labels[index.label];
+     auto iter = tensors_.find(tensor_name);
+     if(iter != tensors_.end()){
+      op->setTensorOperand(iter->second);
+     }else{
+      std::cout << "#ERROR(exatn::NumServer::applyTwoSiteGateSVD): Tensor " << tensor_name << " not found in tensor contraction: "
+                << pattern << std::endl;
+      return std::shared_ptr<TensorOperation>(nullptr);
+     }
+    }else{
+     std::cout << "#ERROR(exatn::NumServer::applyTwoSiteGateSVD): Invalid argument#" << i << " in tensor contraction: "
+               << pattern << std::endl;
+     return std::shared_ptr<TensorOperation>(nullptr);
+    }
+   }
+   //The two-site tensor must carry each open index of the input tensors exactly once:
+   unsigned int num_open = 0;
+   for(const auto & label: input_labels) if(label.second == 1) ++num_open;
+   bool valid = (output_indices.size() == num_open);
+   std::map<std::string,unsigned int> output_labels; //index label --> position in the two-site tensor
+   for(const auto & index: output_indices){
+    auto iter = input_labels.find(index.label);
+    valid = valid && (iter != input_labels.end()) && (iter->second == 1) && output_labels.emplace(index.label,output_labels.size()).second;
+   }
+   if(!valid){
+    std::cout << "#ERROR(exatn::NumServer::applyTwoSiteGateSVD): Two-site tensor indices do not match the open indices "
+              << "of the input tensors in tensor contraction: " << pattern << std::endl;
+    return std::shared_ptr<TensorOperation>(nullptr);
+   }
+   op->setIndexPattern(pattern);
+   std::dynamic_pointer_cast<numerics::TensorOpApplyGateSVD2>(op)->resetTruncation(truncation);
+  }else{
+   std::cout << "#ERROR(exatn::NumServer::applyTwoSiteGateSVD): Invalid number of arguments in tensor contraction: "
+             << pattern << std::endl;
+  }
+ }else{
+  std::cout << "#ERROR(exatn::NumServer::applyTwoSiteGateSVD): Invalid tensor contraction: " << pattern << std::endl;
+ }
+ return op;
+}
+
+bool NumServer::applyTwoSiteGateSVD(const std::string & pattern,
+                                    const SVDTruncation & truncation)
+{
+ auto op = createTwoSiteGateSVDOp(pattern,truncation);
+ if(!op) return false;
+ return submit(op);
+}
+
+bool NumServer::applyTwoSiteGateSVDSync(const std::string & pattern,
+                                        const SVDTruncation & truncation,
+                                        std::size_t * achieved_rank,
+                                        double * truncation_error)
+{
+ auto op = createTwoSiteGateSVDOp(pattern,truncation);
+ if(!op) return false;
+ bool success = submit(op);
+ if(success) success = sync(*op);
+ if(success){
+  const auto & gate_op = *(std::dynamic_pointer_cast<numerics::TensorOpApplyGateSVD2>(op));
+  if(achieved_rank != nullptr) *achieved_rank = gate_op.getAchievedRank();
+  if(truncation_error != nullptr) *truncation_error = gate_op.getDiscardedWeight();
+ }
+ return success;
+}
+
 bool NumServer::orthogonalizeTensorSVD(const std::string & contraction)
 {
  std::vector<std::string> tensors;
@@ -1869,6 +2766,457 @@ bool NumServer::evaluateTensorNetworkSync(const ProcessGroup & process_group,
  return parsed;
 }
 
+bool NumServer::evaluateAmplitudesSync(const ProcessGroup & process_group,
+                                       TensorNetwork & network,
+                                       const std::vector<std::vector<DimOffset>> & bitstrings,
+                                       std::vector<std::complex<double>> & amplitudes,
+                                       const std::vector<unsigned int> & open_legs)
+{
+ amplitudes.clear();
+ if(!process_group.rankIsIn(process_rank_)) return true; //process is not in the group: Do nothing
+ //Check arguments:
+ const auto output_rank = network.getRank();
+ const auto output_tensor = network.getTensor(0);
+ std::vector<bool> leg_open(output_rank,false);
+ std::vector<DimExtent> open_extents;
+ std::size_t open_volume = 1;
+ for(const auto & leg: open_legs){
+  if(leg >= output_rank || leg_open[leg]){
+   std::cout << "#ERROR(exatn::NumServer::evaluateAmplitudesSync): Invalid open output leg: " << leg << std::endl;
+   return false;
+  }
+  leg_open[leg] = true;
+ }
+ for(unsigned int leg = 0; leg < output_rank; ++leg){
+  if(leg_open[leg]){
+   open_extents.emplace_back(output_tensor->getDimExtent(leg));
+   open_volume *= open_extents.back();
+  }
+ }
+ for(const auto & bitstring: bitstrings){
+  bool valid = (bitstring.size() == output_rank);
+  for(unsigned int leg = 0; valid && leg < output_rank; ++leg){
+   if(!leg_open[leg]) valid = (bitstring[leg] < output_tensor->getDimExtent(leg));
+  }
+  if(!valid){
+   std::cout << "#ERROR(exatn::NumServer::evaluateAmplitudesSync): Invalid bitstring for tensor network <"
+             << network.getName() << ">!" << std::endl;
+   return false;
+  }
+ }
+ if(bitstrings.empty()) return true;
+ //Determine the element type of the tensor network:
+ TensorElementType elem_type = TensorElementType::VOID;
+ for(auto iter = network.cbegin(); iter != network.cend() && elem_type == TensorElementType::VOID; ++iter){
+  if(iter->first != 0){
+   auto registered = tensors_.find(iter->second.getName());
+   if(registered != tensors_.end()) elem_type = registered->second->getElementType();
+  }
+ }
+ if(elem_type == TensorElementType::VOID) elem_type = TensorElementType::COMPLEX64;
+ //Classify the projected output legs into fixed (same value in all bitstrings) and varying:
+ std::vector<unsigned int> fixed_legs, varying_legs;
+ for(unsigned int leg = 0; leg < output_rank; ++leg){
+  if(!leg_open[leg]){
+   bool fixed = true;
+   for(const auto & bitstring: bitstrings){
+    if(bitstring[leg] != bitstrings[0][leg]){fixed = false; break;}
+   }
+   if(fixed){
+    fixed_legs.emplace_back(leg);
+   }else{
+    varying_legs.emplace_back(leg);
+   }
+  }
+ }
+ //Group the bitstrings by the values of the leading varying legs until the extracted tensor fits in memory:
+ const double max_volume = static_cast<double>(process_group.getMemoryLimitPerProcess())
+                         / static_cast<double>(sizeof(std::complex<double>) * 8); //{8: intermediates and tensor transposes}
+ const double max_cached_volume = static_cast<double>(process_group.getMemoryLimitPerProcess())
+                                / static_cast<double>(sizeof(std::complex<double>) * 2); //{2: cached intermediate and its transpose}
+ double intermediate_volume = static_cast<double>(open_volume);
+ for(const auto & leg: varying_legs) intermediate_volume *= static_cast<double>(output_tensor->getDimExtent(leg));
+ double volume = intermediate_volume;
+ unsigned int num_grouped = 0;
+ while(volume > max_volume && num_grouped < varying_legs.size()){
+  volume /= static_cast<double>(output_tensor->getDimExtent(varying_legs[num_grouped++]));
+ }
+ const std::vector<unsigned int> grouped_legs(varying_legs.cbegin(),varying_legs.cbegin()+num_grouped);
+ std::map<std::vector<DimOffset>,std::vector<std::size_t>> groups; //values of the grouped legs --> bitstrings
+ for(std::size_t i = 0; i < bitstrings.size(); ++i){
+  std::vector<DimOffset> key(num_grouped);
+  for(unsigned int j = 0; j < num_grouped; ++j) key[j] = bitstrings[i][grouped_legs[j]];
+  groups[key].emplace_back(i);
+ }
+ //The bitstring-independent intermediate is kept unless it does not fit in memory:
+ const bool cache_intermediate = (num_grouped == 0 || intermediate_volume <= max_cached_volume);
+ if(logging_ > 0) logfile_ << "[" << std::fixed << std::setprecision(6) << exatn::Timer::timeInSecHR(getTimeStampStart())
+                           << "]: Evaluating " << bitstrings.size() << " amplitudes of tensor network <" << network.getName()
+                           << ">: Projected legs = " << fixed_legs.size() << "; Grouped legs = " << num_grouped
+                           << "; Open legs = " << open_legs.size() << "; Intermediate volume = " << std::scientific
+                           << intermediate_volume << (cache_intermediate ? " (kept)" : " (not kept)")
+                           << "; Number of groups = " << groups.size() << std::endl << std::flush;
+ bool success = true;
+ amplitudes.assign(bitstrings.size() * open_volume,std::complex<double>{0.0,0.0});
+ std::vector<std::string> basis_tensors; //basis vector tensors created here
+ //Projects the given output legs of a tensor network by the basis vectors (in reverse order to preserve leg numeration):
+ auto project_legs = [&](TensorNetwork & net,
+                         const std::vector<std::pair<unsigned int,DimOffset>> & projections){ //{output leg, value}
+  for(auto proj = projections.crbegin(); proj != projections.crend(); ++proj){
+   const auto extent = net.getTensor(0)->getDimExtent(proj->first);
+   const std::string basis_name = "_e" + std::to_string(static_cast<int>(elem_type)) + "_"
+                                + std::to_string(extent) + "_" + std::to_string(proj->second);
+   if(tensors_.find(basis_name) == tensors_.end()){
+    if(!createTensorSync(process_group,basis_name,elem_type,TensorShape{extent})) return false;
+    basis_tensors.emplace_back(basis_name);
+    std::vector<double> basis_vector(extent,0.0);
+    basis_vector[proj->second] = 1.0;
+    if(!initTensorDataSync(basis_name,basis_vector)) return false;
+   }
+   if(!net.appendTensor(net.getMaxTensorId()+1,tensors_[basis_name],
+                        std::vector<std::pair<unsigned int, unsigned int>>{{proj->first,0}})) return false;
+  }
+  return true;
+ };
+ //Extracts the amplitudes of the given bitstrings from the output tensor of a projected tensor network:
+ auto extract_amplitudes = [&](std::shared_ptr<Tensor> result,           //in: output tensor of the projected tensor network
+                               const std::vector<bool> & leg_projected,  //in: projected legs of the original output tensor
+                               const std::vector<std::size_t> & selected){ //in: selected bitstrings
+  auto local_copy = getLocalTensor(result);
+  if(!local_copy) return false;
+  std::vector<std::size_t> open_strides; //strides of the open legs in the result
+  std::vector<std::pair<unsigned int,std::size_t>> varying_strides; //varying legs and their strides in the result
+  std::size_t stride = 1;
+  for(unsigned int leg = 0, mode = 0; leg < output_rank; ++leg){
+   if(leg_projected[leg]) continue;
+   if(leg_open[leg]){
+    open_strides.emplace_back(stride);
+   }else{
+    varying_strides.emplace_back(std::make_pair(leg,stride));
+   }
+   stride *= result->getDimExtent(mode++);
+  }
+  auto extract = [&](const auto * body){
+   for(const auto & i: selected){
+    std::size_t base = 0;
+    for(const auto & leg_stride: varying_strides) base += bitstrings[i][leg_stride.first] * leg_stride.second;
+    for(std::size_t j = 0; j < open_volume; ++j){
+     std::size_t offset = base, rem = j;
+     for(unsigned int k = 0; k < open_extents.size(); ++k){
+      offset += (rem % open_extents[k]) * open_strides[k];
+      rem /= open_extents[k];
+     }
+     amplitudes[i * open_volume + j] = std::complex<double>(body[offset]);
+    }
+   }
+  };
+  bool extracted = false;
+  switch(result->getElementType()){
+   case TensorElementType::REAL32:
+    {const float * body; extracted = local_copy->getDataAccessHostConst(&body); if(extracted) extract(body);}
+    break;
+   case TensorElementType::REAL64:
+    {const double * body; extracted = local_copy->getDataAccessHostConst(&body); if(extracted) extract(body);}
+    break;
+   case TensorElementType::COMPLEX32:
+    {const std::complex<float> * body; extracted = local_copy->getDataAccessHostConst(&body); if(extracted) extract(body);}
+    break;
+   case TensorElementType::COMPLEX64:
+    {const std::complex<double> * body; extracted = local_copy->getDataAccessHostConst(&body); if(extracted) extract(body);}
+    break;
+   default:
+    extracted = false;
+  }
+  return extracted;
+ };
+ //Project the fixed output legs by the basis vectors (the output legs of the projected tensor network are the remaining ones):
+ std::vector<bool> leg_projected(output_rank,false);
+ std::vector<std::pair<unsigned int,DimOffset>> fixed_projections;
+ for(const auto & leg: fixed_legs){
+  leg_projected[leg] = true;
+  fixed_projections.emplace_back(std::make_pair(leg,bitstrings[0][leg]));
+ }
+ TensorNetwork projected(network);
+ projected.rename(network.getName()); //new output tensor: the output tensor of the original tensor network is not affected
+ success = project_legs(projected,fixed_projections);
+ //Evaluate the bitstring-independent intermediate once (the basis vectors projecting the grouped legs
+ //are bitstring-dependent and thus constrained to be the final contractions, performed for each group):
+ bool intermediate_created = false;
+ auto intermediate = projected.getTensor(0);
+ if(success && cache_intermediate){
+  success = createTensorSync(process_group,intermediate,elem_type); //destroyed explicitly once all groups are done
+  intermediate_created = success;
+  if(success) success = submit(process_group,projected);
+  if(success) success = sync(process_group,projected);
+ }
+ if(success && num_grouped == 0){ //extract all amplitudes from the intermediate directly
+  success = extract_amplitudes(intermediate,leg_projected,groups.begin()->second);
+ }else if(success){
+  //Positions of the grouped legs among the output legs of the projected tensor network:
+  std::vector<unsigned int> grouped_modes(num_grouped);
+  for(unsigned int j = 0; j < num_grouped; ++j){
+   grouped_modes[j] = grouped_legs[j] - std::count(leg_projected.cbegin(),leg_projected.cbegin()+grouped_legs[j],true);
+  }
+  std::vector<bool> leg_projected_group(leg_projected);
+  for(const auto & leg: grouped_legs) leg_projected_group[leg] = true;
+  std::list<numerics::ContrTriple> contr_seq; //tensor contraction sequence shared by all groups (if the intermediate is not kept)
+  double contr_seq_flops = 0.0;
+  for(const auto & group: groups){
+   std::vector<std::pair<unsigned int,DimOffset>> group_projections(num_grouped);
+   for(unsigned int j = 0; j < num_grouped; ++j) group_projections[j] = std::make_pair(grouped_modes[j],group.first[j]);
+   if(cache_intermediate){ //contract the kept intermediate with the basis vectors projecting the grouped legs
+    TensorNetwork tail(network.getName());
+    success = tail.appendTensor(1,intermediate,{}); if(!success) break;
+    success = project_legs(tail,group_projections); if(!success) break;
+    tail.rename(network.getName()); //new output tensor for each group
+    success = submit(process_group,tail); if(!success) break;
+    success = sync(process_group,tail); if(!success) break;
+    success = extract_amplitudes(tail.getTensor(0),leg_projected_group,group.second); if(!success) break;
+   }else{ //evaluate the entire projected tensor network for each group with the same contraction sequence
+    TensorNetwork net(projected);
+    net.rename(network.getName());
+    success = project_legs(net,group_projections); if(!success) break;
+    if(fixBasisVectorIndices(net) < 0){success = false; break;}
+    if(!contr_seq.empty()) net.importContractionSequence(contr_seq,contr_seq_flops);
+    success = submit(process_group,net); if(!success) break;
+    success = sync(process_group,net); if(!success) break;
+    if(contr_seq.empty()) contr_seq = net.exportContractionSequence(&contr_seq_flops);
+    success = extract_amplitudes(net.getTensor(0),leg_projected_group,group.second); if(!success) break;
+   }
+  }
+ }
+ //Destroy the intermediate and the basis vector tensors:
+ if(intermediate_created) success = destroyTensorSync(intermediate->getName()) && success;
+ for(const auto & basis_name: basis_tensors) success = destroyTensorSync(basis_name) && success;
+ if(!success) std::cout << "#ERROR(exatn::NumServer::evaluateAmplitudesSync): Evaluation failed for tensor network <"
+                        << network.getName() << ">!" << std::endl;
+ return success;
+}
+
+bool NumServer::evaluateGradientsSync(const ProcessGroup & process_group,
+                                      TensorExpansion & expansion,
+                                      const std::map<std::string,std::string> & gradients,
+                                      bool conjugated,
+                                      std::size_t max_checkpoint_volume)
+{
+ if(!process_group.rankIsIn(process_rank_)) return true; //process is not in the group: Do nothing
+ if(expansion.getRank() != 0){
+  std::cout << "#ERROR(exatn::NumServer::evaluateGradientsSync): Tensor network expansion <"
+            << expansion.getName() << "> is not closed (scalar)!" << std::endl;
+  return false;
+ }
+ //Look up the gradient tensors and initialize them to zero:
+ std::unordered_map<std::string,std::shared_ptr<Tensor>> gradient_tensors; //differentiated tensor name --> gradient tensor
+ for(const auto & gradient: gradients){
+  auto iter = tensors_.find(gradient.second);
+  if(iter == tensors_.end()){
+   std::cout << "#ERROR(exatn::NumServer::evaluateGradientsSync): Gradient tensor " << gradient.second
+             << " does not exist!" << std::endl;
+   return false;
+  }
+  gradient_tensors.emplace(std::make_pair(gradient.first,iter->second));
+  std::shared_ptr<TensorOperation> op = tensor_op_factory_->createTensorOp(TensorOpCode::TRANSFORM);
+  op->setTensorOperand(iter->second);
+  std::dynamic_pointer_cast<numerics::TensorOpTransform>(op)->
+   resetFunctor(std::shared_ptr<TensorMethod>(new numerics::FunctorInitVal(0.0)));
+  auto submitted = submit(op); if(!submitted) return false;
+ }
+ if(gradient_tensors.empty()) return true;
+ const auto element_type = gradient_tensors.cbegin()->second->getElementType();
+
+ //Tensor operation helpers:
+ auto create_tensor = [&](std::shared_ptr<Tensor> tensor){
+  std::shared_ptr<TensorOperation> op0 = tensor_op_factory_->createTensorOp(TensorOpCode::CREATE);
+  op0->setTensorOperand(tensor);
+  std::dynamic_pointer_cast<numerics::TensorOpCreate>(op0)->resetTensorElementType(element_type);
+  std::shared_ptr<TensorOperation> op1 = tensor_op_factory_->createTensorOp(TensorOpCode::TRANSFORM);
+  op1->setTensorOperand(tensor);
+  std::dynamic_pointer_cast<numerics::TensorOpTransform>(op1)->
+   resetFunctor(std::shared_ptr<TensorMethod>(new numerics::FunctorInitVal(0.0)));
+  return (submit(op0) && submit(op1));
+ };
+ auto destroy_tensor = [&](std::shared_ptr<Tensor> tensor){
+  std::shared_ptr<TensorOperation> op = tensor_op_factory_->createTensorOp(TensorOpCode::DESTROY);
+  op->setTensorOperand(tensor);
+  return submit(op);
+ };
+ //Assembles the index pattern of a backward tensor operation from the operands of a forward tensor contraction:
+ auto backward_pattern = [](const IndexModeMap & forward,
+                            const std::vector<std::pair<unsigned int,bool>> & operands){ //forward operand position, conjugation
+  IndexModeMap mode_map;
+  std::unordered_map<unsigned int,unsigned int> relabel;
+  const char * names[] = {"D","L","R"};
+  for(unsigned int i = 0; i < operands.size(); ++i){
+   const auto & operand = forward.operands[operands[i].first];
+   mode_map.operands.emplace_back(IndexModeMap::Operand{names[i],operands[i].second,-1,{}});
+   for(const auto & label: operand.modes){
+    auto res = relabel.emplace(std::make_pair(label,static_cast<unsigned int>(mode_map.label_names.size())));
+    if(res.second) mode_map.label_names.emplace_back(forward.getLabelName(label));
+    mode_map.operands.back().modes.emplace_back(res.first->second);
+   }
+  }
+  return mode_map;
+ };
+
+ //Process the tensor networks of the tensor network expansion one by one:
+ bool success = true;
+ for(auto component = expansion.begin(); success && component != expansion.end(); ++component){
+  auto & network = *(component->network_);
+  if(network.exportContractionSequence().empty())
+   network.determineContractionSequence(contr_seq_optimizer_,contr_seq_refinement_);
+  const auto & op_list = network.getOperationList(contr_seq_optimizer_,false);
+  //Collect the tensor contractions (nodes of the contraction tree in the forward order):
+  struct Node{
+   std::shared_ptr<TensorOperation> op; //forward tensor contraction
+   bool needed;                         //whether or not the subtree contains differentiated tensors
+   bool kept;                           //whether or not the output tensor is checkpointed in the forward pass
+   bool alive;                          //whether or not the output tensor currently exists
+   std::shared_ptr<Tensor> adjoint;     //adjoint (gradient w.r.t. the output tensor)
+  };
+  std::vector<Node> nodes;
+  std::unordered_map<const Tensor*,unsigned int> producer; //intermediate tensor --> node
+  auto is_target = [&](const TensorOperation & op, unsigned int op_num){
+   bool conj;
+   auto tensor = op.getTensorOperand(op_num,&conj);
+   return (producer.find(tensor.get()) == producer.end() && conj == conjugated &&
+           gradient_tensors.find(tensor->getName()) != gradient_tensors.end());
+  };
+  for(const auto & op: op_list){
+   const auto opcode = op->getOpcode();
+   if(opcode == TensorOpCode::CONTRACT || opcode == TensorOpCode::ADD){
+    bool needed = false;
+    for(unsigned int op_num = 1; op_num < op->getNumOperands(); ++op_num){
+     auto iter = producer.find(op->getTensorOperand(op_num).get());
+     needed = needed || (iter != producer.end() ? nodes[iter->second].needed : is_target(*op,op_num));
+    }
+    producer.emplace(std::make_pair(op->getTensorOperand(0).get(),static_cast<unsigned int>(nodes.size())));
+    nodes.emplace_back(Node{op,needed,false,false,std::shared_ptr<Tensor>(nullptr)});
+   }
+  }
+  if(nodes.empty() || !(nodes.back().needed)) continue; //no differentiated tensors in this tensor network
+  const unsigned int root = nodes.size() - 1;
+  if(nodes[root].op->getOpcode() != TensorOpCode::CONTRACT){
+   std::cout << "#ERROR(exatn::NumServer::evaluateGradientsSync): Tensor network <" << network.getName()
+             << "> without tensor contractions is not supported!" << std::endl;
+   success = false; break;
+  }
+  auto producer_of = [&](const Tensor & tensor){
+   auto iter = producer.find(&tensor);
+   return ((iter != producer.end() && iter->second != root) ? static_cast<int>(iter->second) : -1);
+  };
+  //Computes the output tensor of a node, recomputing the destroyed input intermediates (not checkpointed):
+  std::function<bool (unsigned int)> materialize = [&](unsigned int node){
+   const auto & op = *(nodes[node].op);
+   std::vector<unsigned int> temporary;
+   bool done = true;
+   for(unsigned int op_num = 1; done && op_num < op.getNumOperands(); ++op_num){
+    const auto input = producer_of(*(op.getTensorOperand(op_num)));
+    if(input >= 0 && !(nodes[input].alive)){
+     done = materialize(input);
+     temporary.emplace_back(input);
+    }
+   }
+   if(done) done = create_tensor(op.getTensorOperand(0));
+   if(done){
+    std::shared_ptr<TensorOperation> tens_op(std::move(op.clone()));
+    done = submit(tens_op);
+   }
+   nodes[node].alive = done;
+   for(const auto & input: temporary){
+    if(done) done = destroy_tensor(nodes[input].op->getTensorOperand(0));
+    nodes[input].alive = false;
+   }
+   return done;
+  };
+  //Forward pass (the output tensor of the tensor network is not needed):
+  std::size_t kept_volume = 0;
+  for(unsigned int node = 0; success && node < root; ++node){
+   success = materialize(node); if(!success) break;
+   const auto volume = nodes[node].op->getTensorOperand(0)->getVolume();
+   nodes[node].kept = (max_checkpoint_volume == 0 || kept_volume + volume <= max_checkpoint_volume);
+   if(nodes[node].kept) kept_volume += volume;
+   const auto & op = *(nodes[node].op);
+   for(unsigned int op_num = 1; success && op_num < op.getNumOperands(); ++op_num){
+    const auto input = producer_of(*(op.getTensorOperand(op_num)));
+    if(input >= 0 && !(nodes[input].kept)){ //destroy the input intermediate which is not checkpointed
+     success = destroy_tensor(nodes[input].op->getTensorOperand(0));
+     nodes[input].alive = false;
+    }
+   }
+  }
+  //Backward pass (reverse order of the tensor contractions):
+  for(int node = root; success && node >= 0; --node){
+   const auto & op = *(nodes[node].op);
+   const auto & mode_map = op.getIndexModeMap();
+   if(nodes[node].needed){
+    for(unsigned int op_num = 1; success && op_num < 3; ++op_num){
+     const unsigned int other = 3 - op_num;
+     //Determine the adjoint of the tensor operand:
+     std::shared_ptr<Tensor> target(nullptr);
+     const auto input = producer_of(*(op.getTensorOperand(op_num)));
+     if(input >= 0){
+      if(nodes[input].needed){
+       auto intermediate = op.getTensorOperand(op_num);
+       target = std::make_shared<Tensor>(*intermediate);
+       target->rename("_d" + intermediate->getName());
+       success = create_tensor(target); if(!success) break;
+       nodes[input].adjoint = target;
+      }
+     }else if(is_target(op,op_num)){
+      target = gradient_tensors[op.getTensorOperand(op_num)->getName()];
+     }
+     if(!target) continue;
+     //Make sure the other tensor operand exists:
+     const auto sibling = producer_of(*(op.getTensorOperand(other)));
+     bool temporary = false;
+     if(sibling >= 0 && !(nodes[sibling].alive)){
+      success = materialize(sibling); if(!success) break;
+      temporary = true;
+     }
+     //Accumulate the adjoint of the tensor operand:
+     std::shared_ptr<TensorOperation> tens_op(nullptr);
+     const bool other_conj = op.operandIsConjugated(other);
+     if(node == static_cast<int>(root)){ //adjoint of the scalar output is the expansion coefficient
+      tens_op = tensor_op_factory_->createTensorOp(TensorOpCode::ADD);
+      tens_op->setTensorOperand(target);
+      tens_op->setTensorOperand(op.getTensorOperand(other),other_conj);
+      tens_op->setScalar(0,component->coefficient_);
+      tens_op->setIndexPattern(backward_pattern(mode_map,{{op_num,false},{other,other_conj}}));
+     }else{
+      tens_op = tensor_op_factory_->createTensorOp(TensorOpCode::CONTRACT);
+      tens_op->setTensorOperand(target);
+      tens_op->setTensorOperand(nodes[node].adjoint);
+      tens_op->setTensorOperand(op.getTensorOperand(other),other_conj);
+      tens_op->setIndexPattern(backward_pattern(mode_map,{{op_num,false},{0,false},{other,other_conj}}));
+     }
+     success = submit(tens_op); if(!success) break;
+     if(temporary){
+      success = destroy_tensor(nodes[sibling].op->getTensorOperand(0));
+      nodes[sibling].alive = false;
+     }
+    }
+   }
+   //Destroy the adjoint of the output tensor and the input intermediates (no longer needed):
+   if(success && nodes[node].adjoint){
+    success = destroy_tensor(nodes[node].adjoint);
+    nodes[node].adjoint.reset();
+   }
+   for(unsigned int op_num = 1; success && op_num < op.getNumOperands(); ++op_num){
+    const auto input = producer_of(*(op.getTensorOperand(op_num)));
+    if(input >= 0 && nodes[input].alive){
+     success = destroy_tensor(nodes[input].op->getTensorOperand(0));
+     nodes[input].alive = false;
+    }
+   }
+  }
+ }
+ //Synchronize on the gradient tensors:
+ for(const auto & gradient: gradient_tensors) success = sync(process_group,*(gradient.second)) && success;
+ if(!success) std::cout << "#ERROR(exatn::NumServer::evaluateGradientsSync): Gradient evaluation failed for tensor network expansion <"
+                        << expansion.getName() << ">!" << std::endl;
+ return success;
+}
+
 std::shared_ptr<talsh::Tensor> NumServer::getLocalTensor(std::shared_ptr<Tensor> tensor, //in: exatn::numerics::Tensor to get slice of (by copy)
                          const std::vector<std::pair<DimOffset,DimExtent>> & slice_spec) //in: tensor slice specification
 {
@@ -1898,6 +3246,90 @@ std::shared_ptr<talsh::Tensor> NumServer::getLocalTensor(const std::string & nam
  return getLocalTensor(iter->second);
 }
 
+int NumServer::fixBasisVectorIndices(TensorNetwork & network)
+{
+ if(!index_fixing_ || basis_vectors_.empty()) return 0;
+ auto projections = network.fixBasisVectorIndices(
+  [this](const Tensor & tensor, DimOffset * position){
+   auto iter = basis_vectors_.find(tensor.getName());
+   if(iter == basis_vectors_.end()) return false;
+   *position = iter->second;
+   return true;
+  }
+ );
+ for(const auto & projection: projections){
+  auto registered = tensors_.find(projection.original->getName());
+  if(registered == tensors_.end()){
+   std::cout << "#ERROR(exatn::NumServer::fixBasisVectorIndices): Tensor " << projection.original->getName()
+             << " not found!" << std::endl;
+   return -1;
+  }
+  const auto elem_type = registered->second->getElementType();
+  const auto & original = *(registered->second);
+  //Create the projected tensor:
+  implicit_tensors_.emplace_back(projection.projected); //list of implicitly created tensors (for garbage collection)
+  std::shared_ptr<TensorOperation> op_create = tensor_op_factory_->createTensorOp(TensorOpCode::CREATE);
+  op_create->setTensorOperand(projection.projected);
+  std::dynamic_pointer_cast<numerics::TensorOpCreate>(op_create)->resetTensorElementType(elem_type);
+  auto submitted = submit(op_create); if(!submitted) return -1;
+  //Initialize the projected tensor to zero (the slice is accumulated into it):
+  std::shared_ptr<TensorOperation> op_init = tensor_op_factory_->createTensorOp(TensorOpCode::TRANSFORM);
+  op_init->setTensorOperand(projection.projected);
+  std::dynamic_pointer_cast<numerics::TensorOpTransform>(op_init)->
+   resetFunctor(std::shared_ptr<TensorMethod>(new numerics::FunctorInitVal(0.0)));
+  submitted = submit(op_init); if(!submitted) return -1;
+  //Extract the slice of the original tensor with the fixed dimensions of extent 1:
+  const auto tensor_rank = original.getRank();
+  std::vector<SubspaceId> subspaces(tensor_rank);
+  std::vector<DimExtent> dim_extents(tensor_rank);
+  for(unsigned int i = 0; i < tensor_rank; ++i){
+   subspaces[i] = original.getDimSubspaceId(i);
+   dim_extents[i] = original.getDimExtent(i);
+  }
+  for(const auto & fixed: projection.fixed_dims){
+   subspaces[fixed.first] += fixed.second; //base offset of the fixed dimension
+   dim_extents[fixed.first] = 1;
+  }
+  auto tensor_slice = original.createSubtensor(subspaces,dim_extents);
+  tensor_slice->rename(); //unique automatic name will be generated
+  std::shared_ptr<TensorOperation> create_slice = tensor_op_factory_->createTensorOp(TensorOpCode::CREATE);
+  create_slice->setTensorOperand(tensor_slice);
+  std::dynamic_pointer_cast<numerics::TensorOpCreate>(create_slice)->resetTensorElementType(elem_type);
+  submitted = submit(create_slice); if(!submitted) return -1;
+  std::shared_ptr<TensorOperation> extract_slice = tensor_op_factory_->createTensorOp(TensorOpCode::SLICE);
+  extract_slice->setTensorOperand(tensor_slice);
+  extract_slice->setTensorOperand(registered->second);
+  submitted = submit(extract_slice); if(!submitted) return -1;
+  //Copy the slice into the projected tensor (extent-1 dimensions are dropped by the backend):
+  std::string dest_indices, slice_indices;
+  unsigned int fixed_pos = 0;
+  for(unsigned int i = 0; i < tensor_rank; ++i){
+   std::string index;
+   if(fixed_pos < projection.fixed_dims.size() && projection.fixed_dims[fixed_pos].first == i){
+    index = "c" + std::to_string(fixed_pos++);
+   }else{
+    index = "u" + std::to_string(i - fixed_pos);
+    if(!dest_indices.empty()) dest_indices += ",";
+    dest_indices += index;
+   }
+   if(!slice_indices.empty()) slice_indices += ",";
+   slice_indices += index;
+  }
+  std::shared_ptr<TensorOperation> op_copy = tensor_op_factory_->createTensorOp(TensorOpCode::ADD);
+  op_copy->setTensorOperand(projection.projected);
+  op_copy->setTensorOperand(tensor_slice);
+  op_copy->setIndexPattern("D(" + dest_indices + ")+=L(" + slice_indices + ")");
+  submitted = submit(op_copy); if(!submitted) return -1;
+  std::shared_ptr<TensorOperation> destroy_slice = tensor_op_factory_->createTensorOp(TensorOpCode::DESTROY);
+  destroy_slice->setTensorOperand(tensor_slice);
+  submitted = submit(destroy_slice); if(!submitted) return -1;
+ }
+ if(logging_ > 0 && !projections.empty()) logfile_ << "[" << std::fixed << std::setprecision(6)
+  << exatn::Timer::timeInSecHR(getTimeStampStart()) << "]: Index fixing in tensor network <" << network.getName()
+  << ">: " << projections.size() << " input tensors projected by basis vectors" << std::endl << std::flush;
+ return static_cast<int>(projections.size());
+}
+
 void NumServer::destroyOrphanedTensors()
 {
  auto iter = implicit_tensors_.begin();
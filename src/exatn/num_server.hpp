@@ -46,6 +46,11 @@ Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 #include "tensor_expansion.hpp"
 #include "network_build_factory.hpp"
 #include "contraction_seq_optimizer_factory.hpp"
+#include "contraction_plan_cache.hpp"
+#include "contraction_cost_model.hpp"
+#include "tensor_expansion_plan.hpp"
+#include "mps_zipper.hpp"
+#include "truncated_svd.hpp"
 
 #include "tensor_runtime.hpp"
 
@@ -84,6 +89,8 @@ using numerics::TensorOpFactory;
 using numerics::TensorNetwork;
 using numerics::TensorOperator;
 using numerics::TensorExpansion;
+using numerics::SVDTruncation;
+using numerics::SVDAbsorb;
 
 using numerics::NetworkBuilder;
 using numerics::NetworkBuildFactory;
@@ -105,6 +112,14 @@ class NumServer final {
 
 public:
 
+ //Execution statistics of the last tensor network submitted by the current process:
+ struct NetworkExecStats{
+  unsigned int num_split_indices;  //number of split indices
+  std::size_t num_subnetworks;     //number of tensor sub-networks (slices) submitted by the current process
+  std::size_t num_hoisted_ops;     //number of slice-invariant tensor operations submitted once for all tensor sub-networks
+  std::size_t num_template_ops;    //number of tensor operations of the sliced execution template (per tensor sub-network)
+ };
+
 #ifdef MPI_ENABLED
  NumServer(const MPICommProxy & communicator,                               //MPI communicator proxy
            const ParamConf & parameters,                                    //runtime configuration parameters
@@ -145,6 +160,87 @@ public:
  /** Deactivates optimized tensor contraction sequence caching. **/
  void deactivateContrSeqCaching();
 
+ /** Activates the local refinement post-pass applied to tensor contraction sequences
+     determined by the tensor contraction sequence optimizer, which exactly re-optimizes
+     small subtrees of the contraction tree (the flop reduction is logged). **/
+ void activateContrSeqRefinement();
+
+ /** Deactivates the local refinement of tensor contraction sequences. **/
+ void deactivateContrSeqRefinement();
+
+ /** Activates persistent caching of tensor network contraction plans (contraction
+     sequence and index splitting plan) in a memory-mapped file which can be shared
+     by multiple processes and reused across multiple runs. Tensor networks of the same
+     structure will reuse the stored contraction plan instead of optimizing it again. **/
+ bool activateContrPlanCaching(const std::string & file_name); //in: contraction plan cache file name
+
+ /** Deactivates persistent caching of tensor network contraction plans. **/
+ void deactivateContrPlanCaching();
+
+ /** Calibrates the tensor contraction cost model by benchmarking the active node executor
+     over a grid of GEMM shapes and tensor permutations of different ranks and volumes, and
+     saves it into a file. Only the process with global rank 0 performs the calibration and
+     saves the file, the calibrated cost model being broadcast to and activated in all processes. **/
+ bool calibrateContractionCostModel(const std::string & file_name, //in: cost model file name
+                                    TensorElementType element_type = TensorElementType::COMPLEX64); //in: tensor element type
+
+ /** Loads the calibrated tensor contraction cost model from a file and activates it such that
+     tensor contraction sequence optimizers and the index splitting planner will minimize
+     the predicted execution time instead of the FMA flop count. **/
+ bool activateContractionCostModel(const std::string & file_name); //in: cost model file name
+
+ /** Deactivates the calibrated tensor contraction cost model (back to FMA flop count). **/
+ void deactivateContractionCostModel();
+
+ /** Activates dynamic distribution of tensor sub-networks (slices) among processes
+     when evaluating a sliced tensor network by multiple processes: Each process will
+     claim chunks of tensor sub-networks of adaptively decreasing size from a shared counter
+     until all tensor sub-networks are processed (requires MPI-3 RMA). **/
+ void activateDynamicLoadBalancing();
+
+ /** Deactivates dynamic distribution of tensor sub-networks (slices) among processes,
+     thus returning to the static distribution in equal contiguous blocks. **/
+ void deactivateDynamicLoadBalancing();
+
+ /** Activates concurrent evaluation of tensor expansion components: The process group
+     is split into process subgroups, the tensor network components are assigned to them
+     by their estimated FMA flop count (longest processing time first), and the scaled
+     component results are reduced into the accumulator tensor via a single allreduce.
+     By default, the number of process subgroups is the minimum of the process group size
+     and the number of tensor network components in the tensor expansion. **/
+ void activateParallelExpansionEvaluation(unsigned int num_subgroups = 0); //in: number of process subgroups (0:automatic)
+
+ /** Deactivates concurrent evaluation of tensor expansion components, thus returning to
+     the evaluation of tensor network components one by one by the whole process group. **/
+ void deactivateParallelExpansionEvaluation();
+
+ /** Activates common subexpression elimination across tensor network components
+     of a tensor expansion evaluated by a single process: Intermediate tensors shared
+     by multiple tensor network components will be computed only once (the saved FMA
+     flop count is logged). The combined evaluation is only used if all simultaneously
+     present intermediate tensors fit in memory (no index splitting). **/
+ void activateExpansionCSE();
+
+ /** Deactivates common subexpression elimination across tensor network components. **/
+ void deactivateExpansionCSE();
+
+ /** Activates index fixing (default): Before a tensor network is planned, the rank-1 basis vector
+     tensors (one-hot vectors) connected to other input tensors are removed from it while the
+     corresponding indices of the connected tensors are fixed by slicing. Basis vector tensors are
+     either detected during the tensor initialization with external data or registered explicitly. **/
+ void activateIndexFixing();
+
+ /** Deactivates index fixing, thus contracting basis vector tensors as regular tensors. **/
+ void deactivateIndexFixing();
+
+ /** Activates tensor network simplification before the contraction sequence optimization:
+     Connected input tensors are merged whenever the merged tensor is not larger than the
+     larger of the two, thus absorbing vectors and matrices and fusing consecutive gates. **/
+ void activateNetworkSimplification();
+
+ /** Deactivates tensor network simplification (default). **/
+ void deactivateNetworkSimplification();
+
  /** Resets the client logging level (0:none). **/
  void resetClientLoggingLevel(int level = 0);
 
@@ -250,6 +346,44 @@ public:
              std::shared_ptr<TensorExpansion> expansion,  //in: tensor expansion for numerical evaluation
              std::shared_ptr<Tensor> accumulator);        //inout: tensor accumulator (result)
 
+ /** Submits a batch of tensor network expansions for processing, each expansion being accumulated
+     in its own accumulator tensor. If all tensor network expansions have congruent output tensors
+     and are evaluated by a single process, the tensor network components of the whole batch are
+     evaluated via a single combined evaluation plan, thus computing the intermediates shared by
+     different tensor network expansions only once. Synchronization of the batch evaluation
+     is done via syncing on each accumulator tensor. **/
+ bool submitBatch(std::vector<TensorExpansion> & expansions,                     //in: tensor expansions for numerical evaluation
+                  const std::vector<std::shared_ptr<Tensor>> & accumulators);   //inout: tensor accumulators (results)
+ bool submitBatch(const ProcessGroup & process_group,                            //in: chosen group of MPI processes
+                  std::vector<TensorExpansion> & expansions,                     //in: tensor expansions for numerical evaluation
+                  const std::vector<std::shared_ptr<Tensor>> & accumulators);   //inout: tensor accumulators (results)
+
+ /** Submits the evaluation of the expectation value <bra|operator|ket> of a tensor network operator
+     between two tensor network expansions (the bra expansion is expected to be already conjugated),
+     accumulating it in the provided (scalar) accumulator tensor. If all bra and ket components are
+     matrix product states, the MPS-MPO-MPS sandwiches are contracted in the zipper order without any
+     tensor contraction sequence optimization, the environments of the sites not acted upon by the
+     operator components being computed only once for all operator components (single process).
+     Otherwise, the closed tensor network expansion <bra|operator|ket> is evaluated as usual. **/
+ bool submitExpectation(TensorExpansion & bra,                   //in: bra tensor network expansion (conjugated)
+                        TensorExpansion & ket,                   //in: ket tensor network expansion
+                        const TensorOperator & tensor_operator,  //in: tensor network operator
+                        std::shared_ptr<Tensor> accumulator);    //inout: tensor accumulator (result)
+ bool submitExpectation(const ProcessGroup & process_group,      //in: chosen group of MPI processes
+                        TensorExpansion & bra,                   //in: bra tensor network expansion (conjugated)
+                        TensorExpansion & ket,                   //in: ket tensor network expansion
+                        const TensorOperator & tensor_operator,  //in: tensor network operator
+                        std::shared_ptr<Tensor> accumulator);    //inout: tensor accumulator (result)
+
+ /** Groups the components of a tensor operator given by single tensors acting on the same global modes
+     (same sites): The tensors of the grouped components, scaled by their expansion coefficients, are summed
+     into new group tensors (created and computed here), thus producing the grouped tensor operator with
+     fewer components and, consequently, fewer tensor networks in tensor network expansions built from it.
+     The group tensors are named after the tensor operator and need to be destroyed once no longer needed. **/
+ bool groupTensorOperatorSync(const TensorOperator & tensor_operator,                //in: tensor operator
+                              TensorOperator & grouped_operator,                     //out: grouped tensor operator
+                              std::vector<std::string> * group_tensors = nullptr);  //out: names of the created group tensors
+
  /** Synchronizes all update operations on a given tensor.
      Changing wait to FALSE, only tests for completion.
      If ProcessGroup is not provided, defaults to the local process. **/
@@ -306,6 +440,12 @@ public:
                              const std::vector<unsigned int> & iso_dims0,  //in: tensor dimensions forming the isometry (group 0)
                              const std::vector<unsigned int> & iso_dims1); //in: tensor dimensions forming the isometry (group 1)
 
+ /** Registers a rank-1 tensor as a basis vector (one-hot vector) with the unit element
+     in a given position. The registration is dropped once the tensor is updated.
+     Returns TRUE on success, FALSE on failure. **/
+ bool registerTensorBasisVector(const std::string & name, //in: tensor name
+                                DimOffset position);      //in: position of the unit element
+
  /** Declares, registers, and actually creates a tensor via the processing backend.
      See numerics::Tensor constructors for different creation options. **/
  bool createTensor(const std::string & name,          //in: tensor name
@@ -544,6 +684,43 @@ public:
 
  bool decomposeTensorSVDLRSync(const std::string & contraction); //in: two-factor symbolic tensor contraction specification
 
+ /** Decomposes a tensor via a truncated SVD into two or three tensor factors. The tensor factors
+     must not exist: They are created by this call with the achieved (truncated) rank as the extent
+     of their bond index. The symbolic tensor contraction specification must contain strictly one
+     bond index per tensor factor, for example:
+      D(a,b,c,d) = L(c,i,a) * S(i,j) * R(b,j,d)
+     where S(i,j) is the middle SVD factor (the diagonal with singular values), or
+      D(a,b,c,d) = L(c,i,a) * R(b,i,d)
+     where the singular values are absorbed into the tensor factors as specified by the truncation
+     parameters (SVDAbsorb::NONE is invalid in this case). The truncation retains at most the given max rank and, within it, the smallest number
+     of singular values such that the discarded weight (relative squared Frobenius norm of the truncation
+     error) does not exceed the given tolerance. The randomized range finder reduces the cost from
+     O(MN*min(M,N)) to O(MNK) for a small max rank K. The SVD is computed on the host
+     from a local copy of the decomposed tensor. **/
+ bool decomposeTensorSVDTruncSync(const std::string & contraction,       //in: two- or three-factor symbolic tensor contraction specification
+                                  const SVDTruncation & truncation,      //in: truncation parameters
+                                  std::size_t * achieved_rank = nullptr, //out: achieved (retained) rank
+                                  double * truncation_error = nullptr);  //out: discarded weight (relative)
+
+ /** Applies a two-site gate to two neighboring tensors connected by a single bond (for example,
+     two neighboring MPS tensors) as a single fused tensor operation: The two tensors are contracted
+     with the gate into the two-site tensor (theta), which is decomposed via a truncated SVD,
+     with the singular values absorbed as specified by the truncation parameters (canonical form),
+     and the two updated tensors are written back in place (their shapes are preserved).
+     The symbolic specification defines the two-site tensor (its name is irrelevant), for example:
+      T(a,k,l,c) = L(a,i,b) * R(b,j,c) * G(i,j,k,l)
+     such that L(a,i,b) and R(b,j,c) are replaced by L(a,k,b) and R(b,l,c), respectively.
+     The first half of the gate legs is contracted, the second half replaces the contracted legs.
+     The two-site tensor must carry each open index of the input tensors exactly once.
+     Complex conjugation of the tensors is not supported. **/
+ bool applyTwoSiteGateSVD(const std::string & pattern,       //in: symbolic specification of the two-site tensor
+                          const SVDTruncation & truncation); //in: truncation parameters (max rank is limited by the bond dimension)
+
+ bool applyTwoSiteGateSVDSync(const std::string & pattern,           //in: symbolic specification of the two-site tensor
+                              const SVDTruncation & truncation,      //in: truncation parameters (max rank is limited by the bond dimension)
+                              std::size_t * achieved_rank = nullptr, //out: achieved (retained) rank
+                              double * truncation_error = nullptr);  //out: discarded weight (relative)
+
  /** Orthogonalizes a tensor by decomposing it via SVD while discarding
      the middle tensor factor with singular values. The symbolic tensor contraction
      specification specifies the decomposition. It must contain strictly one contracted index! **/
@@ -570,6 +747,38 @@ public:
                                 const std::string & name,           //in: tensor network name
                                 const std::string & network);       //in: symbolic tensor network specification
 
+ /** Evaluates a batch of amplitudes (elements) of the output tensor of a tensor network, where
+     each bitstring specifies the values of all output tensor legs (values of the open legs are ignored).
+     The output tensor legs having the same value in all bitstrings are projected by basis vectors, whereas
+     the remaining output legs are left open such that the bitstring-independent intermediate (the output
+     tensor of the projected tensor network) is computed once, with its contraction sequence determined once,
+     and the individual amplitudes are then extracted from it. If the amplitudes cannot be extracted from
+     the whole intermediate at once, the bitstrings are grouped by the values of the leading varying output legs,
+     which are then projected by the basis vectors contracted with the kept intermediate as the final contractions
+     for each group. Only if the intermediate itself does not fit in memory, the entire projected tensor network
+     is evaluated for each group (with the same contraction sequence).
+     For each bitstring, the returned amplitudes cover all values of the open legs (column-major). **/
+ bool evaluateAmplitudesSync(const ProcessGroup & process_group,                      //in: chosen group of MPI processes
+                             TensorNetwork & network,                                 //in: tensor network
+                             const std::vector<std::vector<DimOffset>> & bitstrings,  //in: values of the output tensor legs for each amplitude
+                             std::vector<std::complex<double>> & amplitudes,          //out: amplitudes (for each bitstring: all values of the open legs)
+                             const std::vector<unsigned int> & open_legs = std::vector<unsigned int>{}); //in: output tensor legs left open
+
+ /** Evaluates the gradients of a closed (scalar) tensor network expansion with respect to
+     the given tensors (by name) via reverse-mode differentiation over the tensor contraction tree
+     of each tensor network: The forward pass computes the intermediates, the backward pass then
+     contracts the adjoint of each intermediate with the sibling intermediate, thus computing all
+     gradients at the cost of about two forward evaluations. The intermediates are kept for the
+     backward pass as long as their total volume does not exceed the checkpoint volume (zero means
+     no limit), the other intermediates are recomputed during the backward pass. Either conjugated
+     or non-conjugated occurrences of the given tensors are differentiated. The gradient tensors
+     must exist and be congruent to the differentiated tensors, their content will be overwritten. **/
+ bool evaluateGradientsSync(const ProcessGroup & process_group,                  //in: chosen group of MPI processes
+                            TensorExpansion & expansion,                         //in: closed (scalar) tensor network expansion
+                            const std::map<std::string,std::string> & gradients, //in: differentiated tensor name --> gradient tensor name
+                            bool conjugated = false,                             //in: whether or not to differentiate the conjugated tensors
+                            std::size_t max_checkpoint_volume = 0);              //in: max total volume of the kept intermediates (0: no limit)
+
  /** Returns a locally stored tensor slice (talsh::Tensor) providing access to tensor elements.
      This slice will be extracted from the exatn::numerics::Tensor implementation as a copy.
      The returned future becomes ready once the execution thread has retrieved the slice copy. **/
@@ -585,10 +794,48 @@ public:
 
  inline double getTimeStampStart() const {return time_start_;}
 
+ /** Returns the execution statistics of the last tensor network submitted by the current process. **/
+ inline const NetworkExecStats & getLastNetworkExecStats() const {return last_exec_stats_;}
+
 private:
 
  void destroyOrphanedTensors();
 
+ /** Fixes the indices of the input tensors of a tensor network projected by registered basis
+     vector tensors, thus simplifying the tensor network in place, and submits the computation
+     of the projected tensors. Returns the number of projected tensors (negative on failure). **/
+ int fixBasisVectorIndices(TensorNetwork & network);
+
+ /** Submits all tensor network components of a tensor network expansion, either one by one or via
+     the given combined evaluation plan (single process), followed by their accumulation. **/
+ bool submitComponents(const ProcessGroup & process_group,           //in: chosen group of MPI processes
+                       TensorExpansion & expansion,                  //in: tensor expansion for numerical evaluation
+                       std::shared_ptr<Tensor> accumulator,          //inout: tensor accumulator (result)
+                       const numerics::TensorExpansionPlan * plan);  //in: combined evaluation plan (nullptr: none)
+
+ /** Submits the accumulation of the (already computed) output tensors of all tensor
+     network components of a tensor network expansion, scaled by their coefficients. **/
+ bool submitAccumulations(TensorExpansion & expansion,           //in: evaluated tensor expansion
+                          std::shared_ptr<Tensor> accumulator);  //inout: tensor accumulator (result)
+
+ /** Submits the combined evaluation plan of a tensor network expansion, preceded by
+     the creation (if needed) and zero initialization of all component output tensors. **/
+ bool submitPlan(TensorExpansion & expansion,                  //in: tensor expansion for numerical evaluation
+                 const numerics::TensorExpansionPlan & plan);  //in: combined evaluation plan
+
+ /** Benchmarks the active node executor and appends the measured samples to the tensor contraction cost model. **/
+ bool measureContractionCostModel(numerics::ContractionCostModel & cost_model, //inout: tensor contraction cost model
+                                  TensorElementType element_type);             //in: tensor element type
+
+ /** Creates the fused two-site gate application tensor operation (nullptr on failure). **/
+ std::shared_ptr<TensorOperation> createTwoSiteGateSVDOp(const std::string & pattern,       //in: symbolic specification of the two-site tensor
+                                                         const SVDTruncation & truncation); //in: truncation parameters
+
+ /** Registers a tensor initialized with external data as a basis vector if it is one. **/
+ template<typename NumericType>
+ void detectBasisVector(const std::string & name,
+                        const std::vector<NumericType> & ext_data);
+
  std::shared_ptr<numerics::SpaceRegister> space_register_; //register of vector spaces and their named subspaces
  std::unordered_map<std::string,SpaceId> subname2id_; //maps a subspace name to its parental vector space id
 
@@ -597,6 +844,16 @@ private:
 
  std::string contr_seq_optimizer_; //tensor contraction sequence optimizer invoked when evaluating tensor networks
  bool contr_seq_caching_; //regulates whether or not to cache pseudo-optimal tensor contraction orders for later reuse
+ bool contr_seq_refinement_; //regulates whether or not to refine pseudo-optimal tensor contraction orders by re-optimizing small subtrees
+ std::shared_ptr<numerics::ContractionPlanCache> contr_plan_cache_; //persistent cache of tensor network contraction plans (optional)
+ bool dynamic_load_balancing_; //regulates whether or not tensor sub-networks (slices) are distributed among processes dynamically
+ bool parallel_expansion_; //regulates whether or not tensor expansion components are evaluated concurrently by process subgroups
+ unsigned int expansion_subgroups_; //number of process subgroups for the concurrent evaluation of tensor expansion components (0:automatic)
+ bool expansion_cse_; //regulates whether or not intermediates shared by tensor expansion components are computed only once
+ bool index_fixing_; //regulates whether or not indices projected by basis vector tensors are fixed before planning
+ std::unordered_map<std::string,DimOffset> basis_vectors_; //registered basis vector tensors: tensor name --> position of the unit element
+ bool network_simplification_; //regulates whether or not tensor networks are simplified before the contraction sequence optimization
+ NetworkExecStats last_exec_stats_; //execution statistics of the last submitted tensor network
 
  std::map<std::string,std::shared_ptr<TensorMethod>> ext_methods_; //external tensor methods
  std::map<std::string,std::shared_ptr<BytePacket>> ext_data_; //external data
@@ -686,8 +943,10 @@ bool NumServer::initTensorData(const std::string & name,
 {
  auto iter = tensors_.find(name);
  if(iter == tensors_.end()) return false;
- return transformTensor(name,std::shared_ptr<TensorMethod>(
-         new numerics::FunctorInitDat(iter->second->getShape(),ext_data)));
+ auto submitted = transformTensor(name,std::shared_ptr<TensorMethod>(
+                   new numerics::FunctorInitDat(iter->second->getShape(),ext_data)));
+ if(submitted) detectBasisVector(name,ext_data);
+ return submitted;
 }
 
 template<typename NumericType>
@@ -696,8 +955,32 @@ bool NumServer::initTensorDataSync(const std::string & name,
 {
  auto iter = tensors_.find(name);
  if(iter == tensors_.end()) return false;
- return transformTensorSync(name,std::shared_ptr<TensorMethod>(
-         new numerics::FunctorInitDat(iter->second->getShape(),ext_data)));
+ auto submitted = transformTensorSync(name,std::shared_ptr<TensorMethod>(
+                   new numerics::FunctorInitDat(iter->second->getShape(),ext_data)));
+ if(submitted) detectBasisVector(name,ext_data);
+ return submitted;
+}
+
+template<typename NumericType>
+void NumServer::detectBasisVector(const std::string & name,
+                                  const std::vector<NumericType> & ext_data)
+{
+ auto iter = tensors_.find(name);
+ if(iter != tensors_.end()){
+  if(iter->second->getRank() == 1 && ext_data.size() == iter->second->getDimExtent(0)){
+   DimOffset position = 0;
+   unsigned int num_units = 0;
+   for(std::size_t i = 0; i < ext_data.size(); ++i){
+    if(ext_data[i] == NumericType{1}){
+     position = i; ++num_units;
+    }else if(ext_data[i] != NumericType{0}){
+     return; //not a basis vector
+    }
+   }
+   if(num_units == 1) basis_vectors_[name] = position;
+  }
+ }
+ return;
 }
 
 template<typename NumericType>
@@ -1,10 +1,19 @@
 /** ExaTN:: Variational optimizer of a closed symmetric tensor network expansion functional
-REVISION: 2020/01/26
+REVISION: 2020/09/29
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 
 #include "optimizer.hpp"
+#include "talshxx.hpp"
+
+#include <Eigen/Dense>
+
+#include <unordered_set>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <cmath>
 
 #include <cassert>
 
@@ -13,21 +22,280 @@ namespace exatn{
 TensorNetworkOptimizer::TensorNetworkOptimizer(std::shared_ptr<TensorOperator> tensor_operator,
                                                std::shared_ptr<TensorExpansion> vector_expansion,
                                                double tolerance):
- tensor_operator_(tensor_operator), vector_expansion_(vector_expansion), tolerance_(tolerance)
+ tensor_operator_(tensor_operator), vector_expansion_(vector_expansion), tolerance_(tolerance),
+ expectation_value_(0.0)
 {
+ assert(vector_expansion_->isKet());
 }
 
 
-std::shared_ptr<TensorExpansion> TensorNetworkOptimizer::getSolution()
+std::shared_ptr<TensorExpansion> TensorNetworkOptimizer::getSolution(double * expectation_value)
 {
+ if(expectation_value != nullptr) *expectation_value = expectation_value_;
  return vector_expansion_;
 }
 
 
+bool TensorNetworkOptimizer::updateEnvironments(numerics::ExpansionEnvironmentCache & cache,
+                                                unsigned int tensor,
+                                                bool left)
+{
+ bool done = true;
+ const auto networks = left ? cache.getLeftUpdateNetworks(tensor) : cache.getRightUpdateNetworks(tensor);
+ for(const auto & network: networks){
+  done = evaluateSync(*network);
+  if(!done) break;
+ }
+ return done;
+}
+
+
+bool TensorNetworkOptimizer::applyEffective(Environment & environment,
+                                            TensorExpansion & effective,
+                                            const std::vector<std::complex<double>> & vec,
+                                            std::vector<std::complex<double>> & result)
+{
+ //Place the vector into the optimizable tensor:
+ bool done = initTensorDataSync(environment.tensor->getName(),vec);
+ //Evaluate the effective operator (metric) tensor network expansion:
+ if(done) done = initTensorSync(environment.gradient->getName(),0.0);
+ if(done) done = evaluateSync(effective,environment.gradient);
+ if(!done) return false;
+ //Retrieve the result:
+ auto local_tensor = getLocalTensor(environment.gradient->getName());
+ if(!local_tensor) return false;
+ const std::size_t volume = local_tensor->getVolume();
+ result.resize(volume);
+ auto retrieve = [&](const auto * body){
+  for(std::size_t i = 0; i < volume; ++i) result[i] = std::complex<double>(body[i]);
+ };
+ switch(environment.gradient->getElementType()){
+  case TensorElementType::REAL32:
+   {const float * body; done = local_tensor->getDataAccessHostConst(&body); if(done) retrieve(body);}
+   break;
+  case TensorElementType::REAL64:
+   {const double * body; done = local_tensor->getDataAccessHostConst(&body); if(done) retrieve(body);}
+   break;
+  case TensorElementType::COMPLEX32:
+   {const std::complex<float> * body; done = local_tensor->getDataAccessHostConst(&body); if(done) retrieve(body);}
+   break;
+  case TensorElementType::COMPLEX64:
+   {const std::complex<double> * body; done = local_tensor->getDataAccessHostConst(&body); if(done) retrieve(body);}
+   break;
+  default:
+   done = false;
+ }
+ return done;
+}
+
+
+bool TensorNetworkOptimizer::optimizeTensor(Environment & environment,
+                                            double * eigenvalue)
+{
+ using Vector = std::vector<std::complex<double>>;
+ const std::size_t volume = environment.tensor->getVolume();
+ const std::size_t max_dim = std::min(static_cast<std::size_t>(MAX_SUBSPACE_DIM),volume);
+ //Create the gradient tensor:
+ bool done = createTensorSync(environment.gradient,environment.tensor->getElementType());
+ if(!done) return false;
+ //Retrieve the current optimizable tensor (initial guess):
+ Vector x(volume,std::complex<double>{1.0,0.0});
+ auto local_tensor = getLocalTensor(environment.tensor->getName());
+ if(local_tensor){
+  switch(environment.tensor->getElementType()){
+   case TensorElementType::REAL32:
+    {const float * body; if(local_tensor->getDataAccessHostConst(&body)) std::copy(body,body+volume,x.begin());}
+    break;
+   case TensorElementType::REAL64:
+    {const double * body; if(local_tensor->getDataAccessHostConst(&body)) std::copy(body,body+volume,x.begin());}
+    break;
+   case TensorElementType::COMPLEX32:
+    {const std::complex<float> * body; if(local_tensor->getDataAccessHostConst(&body)) std::copy(body,body+volume,x.begin());}
+    break;
+   case TensorElementType::COMPLEX64:
+    {const std::complex<double> * body; if(local_tensor->getDataAccessHostConst(&body)) std::copy(body,body+volume,x.begin());}
+    break;
+   default:
+    break;
+  }
+ }
+ //Davidson subspace (metric-orthonormal basis vectors and their images):
+ std::vector<Vector> basis, h_basis, n_basis;
+ // Metric-orthonormalizes a new vector against the subspace and appends it (unless it is linearly dependent):
+ auto expand = [&](Vector & v){
+  double v_norm = 0.0;
+  for(const auto & elem: v) v_norm += std::norm(elem);
+  if(v_norm == 0.0) return false;
+  for(int pass = 0; pass < 2; ++pass){ //classical Gram-Schmidt with re-orthogonalization
+   for(std::size_t j = 0; j < basis.size(); ++j){
+    std::complex<double> overlap{0.0,0.0};
+    for(std::size_t i = 0; i < volume; ++i) overlap += std::conj(n_basis[j][i]) * v[i];
+    for(std::size_t i = 0; i < volume; ++i) v[i] -= overlap * basis[j][i];
+   }
+  }
+  Vector nv, hv;
+  done = applyEffective(environment,environment.metric_expansion,v,nv); if(!done) return false;
+  std::complex<double> metric_norm{0.0,0.0};
+  for(std::size_t i = 0; i < volume; ++i) metric_norm += std::conj(v[i]) * nv[i];
+  if(metric_norm.real() <= v_norm * 1e-13) return false; //linearly dependent (or null space of the metric)
+  const double factor = 1.0 / std::sqrt(metric_norm.real());
+  for(std::size_t i = 0; i < volume; ++i){v[i] *= factor; nv[i] *= factor;}
+  done = applyEffective(environment,environment.operator_expansion,v,hv); if(!done) return false;
+  basis.emplace_back(v); h_basis.emplace_back(hv); n_basis.emplace_back(nv);
+  return true;
+ };
+ bool expanded = expand(x);
+ if(!expanded && done){ //zero (or degenerate) initial guess: restart from a generic vector
+  for(std::size_t i = 0; i < volume; ++i) x[i] = std::complex<double>(1.0,0.0) / static_cast<double>(i + 1);
+  expanded = expand(x);
+ }
+ if(!expanded){
+  std::cout << "#ERROR(exatn::TensorNetworkOptimizer::optimizeTensor): Unable to initialize the Davidson subspace for tensor "
+            << environment.tensor->getName() << std::endl;
+  destroyTensorSync(environment.gradient->getName());
+  return false;
+ }
+ //Davidson iterations:
+ double theta = 0.0;
+ bool converged = false;
+ while(!converged){
+  //Rayleigh-Ritz procedure in the subspace:
+  const auto dim = basis.size();
+  Eigen::MatrixXcd projected(dim,dim);
+  for(std::size_t k = 0; k < dim; ++k){
+   for(std::size_t l = 0; l <= k; ++l){
+    std::complex<double> elem{0.0,0.0};
+    for(std::size_t i = 0; i < volume; ++i) elem += std::conj(basis[k][i]) * h_basis[l][i];
+    projected(k,l) = elem; projected(l,k) = std::conj(elem);
+   }
+   projected(k,k) = std::complex<double>(projected(k,k).real(),0.0);
+  }
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXcd> eigen_solver(projected);
+  if(eigen_solver.info() != Eigen::Success){
+   std::cout << "#ERROR(exatn::TensorNetworkOptimizer::optimizeTensor): Subspace eigensolver failed!" << std::endl;
+   done = false;
+   break;
+  }
+  theta = eigen_solver.eigenvalues()(0);
+  Eigen::VectorXcd coefs = eigen_solver.eigenvectors().col(0);
+  //Fix the phase of the Ritz vector (keeps real problems real):
+  Eigen::Index max_pos = 0;
+  coefs.cwiseAbs().maxCoeff(&max_pos);
+  coefs *= std::abs(coefs(max_pos)) / coefs(max_pos);
+  //Ritz vector and residual:
+  std::fill(x.begin(),x.end(),std::complex<double>{0.0,0.0});
+  Vector residual(volume,std::complex<double>{0.0,0.0});
+  for(std::size_t k = 0; k < dim; ++k){
+   for(std::size_t i = 0; i < volume; ++i){
+    x[i] += coefs(k) * basis[k][i];
+    residual[i] += coefs(k) * (h_basis[k][i] - theta * n_basis[k][i]);
+   }
+  }
+  double residual_norm = 0.0;
+  for(const auto & elem: residual) residual_norm += std::norm(elem);
+  residual_norm = std::sqrt(residual_norm);
+  converged = (residual_norm <= tolerance_ || dim >= max_dim);
+  if(!converged) converged = !expand(residual);
+  if(!done) break;
+ }
+ //Replace the optimizable tensor with the (normalized) lowest Ritz vector:
+ if(done) done = initTensorDataSync(environment.tensor->getName(),x);
+ bool destroyed = destroyTensorSync(environment.gradient->getName());
+ if(done && eigenvalue != nullptr) *eigenvalue = theta;
+ return (done && destroyed);
+}
+
+
 bool TensorNetworkOptimizer::optimize()
 {
- //`Finish
- return true;
+ //Construct the optimization functional <vector|operator|vector> and the norm <vector|vector>:
+ TensorExpansion vector_bra(*vector_expansion_,false); // |vector>
+ vector_bra.conjugate(); // <vector|
+ TensorExpansion functional(vector_bra,*vector_expansion_,*tensor_operator_); // <vector|operator|vector>
+ TensorExpansion normalization(vector_bra,*vector_expansion_); // <vector|vector>
+
+ //Determine the optimizable tensors in the sweep order (order of their tensor ids):
+ std::vector<std::string> tensor_names;
+ std::unordered_set<std::string> tensor_name_set;
+ environments_.clear();
+ for(auto network = vector_expansion_->cbegin(); network != vector_expansion_->cend(); ++network){
+  std::vector<unsigned int> tensor_ids;
+  for(auto tensor_conn = network->network_->cbegin(); tensor_conn != network->network_->cend(); ++tensor_conn){
+   if(tensor_conn->first != 0 && tensor_conn->second.isOptimizable()) tensor_ids.emplace_back(tensor_conn->first);
+  }
+  std::sort(tensor_ids.begin(),tensor_ids.end());
+  for(const auto & tensor_id: tensor_ids){
+   const auto * tensor = network->network_->getTensorConn(tensor_id);
+   auto res = tensor_name_set.emplace(tensor->getName());
+   if(res.second){
+    tensor_names.emplace_back(tensor->getName());
+    environments_.emplace_back(Environment{tensor->getTensor(),
+                                           std::make_shared<Tensor>("_g"+tensor->getName(),
+                                                                    tensor->getShape(),
+                                                                    tensor->getSignature()),
+                                           TensorExpansion(),
+                                           TensorExpansion()
+                                          });
+   }
+  }
+ }
+ const unsigned int num_tensors = environments_.size();
+ if(num_tensors == 0) return true;
+
+ //Prepare the environment caches of the functional and the norm:
+ operator_cache_ = std::make_shared<numerics::ExpansionEnvironmentCache>(functional,tensor_names);
+ metric_cache_ = std::make_shared<numerics::ExpansionEnvironmentCache>(normalization,tensor_names);
+ if(!(operator_cache_->isSesquilinear() && metric_cache_->isSesquilinear())){
+  std::cout << "#ERROR(exatn::TensorNetworkOptimizer::optimize): The functional is not sesquilinear "
+            << "with respect to the optimizable tensors!" << std::endl;
+  return false;
+ }
+ // Effective operator (metric) tensor network expansions for each optimizable tensor from its cached environments:
+ for(unsigned int i = 0; i < num_tensors; ++i){
+  auto & environment = environments_[i];
+  environment.operator_expansion = operator_cache_->getGradientExpansion(i,true);
+  environment.metric_expansion = metric_cache_->getGradientExpansion(i,true);
+ }
+
+ //Create the environment tensors:
+ const auto element_type = environments_[0].tensor->getElementType();
+ bool done = true;
+ for(auto * cache: {operator_cache_.get(),metric_cache_.get()}){
+  for(auto & env: cache->getEnvironmentTensors()){
+   done = createTensorSync(env,element_type); assert(done);
+  }
+ }
+ //Compute all right environments (the sweep starts from the first optimizable tensor):
+ for(int i = num_tensors - 1; i > 0; --i){
+  done = updateEnvironments(*operator_cache_,i,false); assert(done);
+  done = updateEnvironments(*metric_cache_,i,false); assert(done);
+ }
+ //Sweep over the optimizable tensors back and forth until convergence:
+ unsigned int num_sweeps = 0;
+ double eigenvalue = 0.0;
+ bool converged = false;
+ while(!converged && done){
+  for(unsigned int i = 0; i < num_tensors && done; ++i){
+   done = optimizeTensor(environments_[i],&eigenvalue);
+   if(done) done = updateEnvironments(*operator_cache_,i,true);
+   if(done) done = updateEnvironments(*metric_cache_,i,true);
+  }
+  for(int i = num_tensors - 1; i > 0 && done; --i){
+   done = updateEnvironments(*operator_cache_,i,false);
+   if(done) done = updateEnvironments(*metric_cache_,i,false);
+   if(done) done = optimizeTensor(environments_[i-1],&eigenvalue);
+  }
+  converged = ((num_sweeps > 0 && std::abs(eigenvalue - expectation_value_) <= tolerance_) || ++num_sweeps >= MAX_SWEEPS);
+  expectation_value_ = eigenvalue;
+ }
+ //Destroy the environment tensors:
+ for(auto * cache: {operator_cache_.get(),metric_cache_.get()}){
+  for(auto & env: cache->getEnvironmentTensors()){
+   bool destroyed = destroyTensorSync(env->getName()); assert(destroyed);
+  }
+ }
+ if(!done) std::cout << "#ERROR(exatn::TensorNetworkOptimizer::optimize): Optimization failed!" << std::endl;
+ return done;
 }
 
 } //namespace exatn
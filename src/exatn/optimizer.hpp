@@ -1,5 +1,5 @@
 /** ExaTN:: Variational optimizer of a closed symmetric tensor network expansion functional
-REVISION: 2020/01/26
+REVISION: 2020/09/29
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
@@ -10,14 +10,31 @@ Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
      vectors formed by the same tensor network expansion, this tensor network
      variational optimizer will optimize the tensor factors constituting the
      bra/ket tensor network vectors to arrive at an extremum of that functional.
+ (B) The optimizable tensors are swept back and forth in the order of their appearance
+     (tensor id) in the tensor network expansion. For each optimizable tensor, the local
+     (generalized) eigenvalue problem H * x = E * N * x is solved for its lowest root
+     by the Davidson procedure, where the effective operator H (gradient of the functional)
+     and the effective metric N (gradient of the norm) are never formed explicitly but applied
+     to the trial vectors by evaluating the tensor networks composed of the cached environments
+     of the optimizable tensor (matrix-free). The Rayleigh-Ritz problem in the Davidson subspace
+     is tiny and is solved on Host.
+ (C) The left and right environments of each optimizable tensor in each tensor network
+     of the functional and the norm are cached and incrementally updated as the sweep moves,
+     thus the cost of a sweep scales linearly with the number of optimizable tensors.
+ (D) The closed tensor network expansion functional must be sesquilinear with respect to
+     each optimizable tensor, that is, each tensor network of the functional must contain
+     each optimizable tensor exactly once in the bra and exactly once in the ket.
 **/
 
 #ifndef EXATN_OPTIMIZER_HPP_
 #define EXATN_OPTIMIZER_HPP_
 
 #include "exatn_numerics.hpp"
+#include "environment_cache.hpp"
 
 #include <memory>
+#include <complex>
+#include <vector>
 
 namespace exatn{
 
@@ -35,17 +52,49 @@ public:
  TensorNetworkOptimizer & operator=(TensorNetworkOptimizer &&) noexcept = default;
  ~TensorNetworkOptimizer() = default;
 
- /** Optimizes the given closed symmetric tensor network expansion functional. **/
+ /** Optimizes the given closed symmetric tensor network expansion functional
+     (minimizes the expectation value of the tensor operator). **/
  bool optimize();
 
- /** Returns the optimized tensor network expansion forming the optimal bra/ket vectors. **/
- std::shared_ptr<TensorExpansion> getSolution();
+ /** Returns the optimized tensor network expansion forming the optimal bra/ket vectors.
+     Optionally returns the achieved expectation value of the tensor operator. **/
+ std::shared_ptr<TensorExpansion> getSolution(double * expectation_value = nullptr);
 
 private:
 
+ static constexpr unsigned int MAX_SWEEPS = 1000;      //max number of optimization sweeps
+ static constexpr unsigned int MAX_SUBSPACE_DIM = 32;  //max dimension of the local Davidson subspace
+
+ struct Environment{
+  std::shared_ptr<Tensor> tensor;     //tensor being optimized
+  std::shared_ptr<Tensor> gradient;   //gradient w.r.t. the tensor (result of the effective operator/metric action)
+  TensorExpansion operator_expansion; //effective operator tensor network expansion (from cached environments)
+  TensorExpansion metric_expansion;   //effective metric tensor network expansion (from cached environments)
+ };
+
+ /** Updates the cached left (or right) environments of a given optimizable tensor. **/
+ bool updateEnvironments(numerics::ExpansionEnvironmentCache & cache,
+                         unsigned int tensor,
+                         bool left);
+
+ /** Applies the effective operator (or metric) tensor network expansion to a vector. **/
+ bool applyEffective(Environment & environment,
+                     TensorExpansion & effective,                    //in: effective operator or metric
+                     const std::vector<std::complex<double>> & vec,  //in: vector
+                     std::vector<std::complex<double>> & result);    //out: effective operator (metric) times vector
+
+ /** Solves the local eigenvalue problem for an optimizable tensor by the Davidson procedure,
+     replacing the optimizable tensor with the normalized lowest eigenvector. **/
+ bool optimizeTensor(Environment & environment,
+                     double * eigenvalue); //out: lowest eigenvalue
+
  std::shared_ptr<TensorOperator> tensor_operator_;   //tensor operator
  std::shared_ptr<TensorExpansion> vector_expansion_; //tensor network expansion to optimize (bra/ket vector)
  double tolerance_;                                  //desired numerical optimization convergence tolerance
+ double expectation_value_;                          //achieved expectation value of the tensor operator
+ std::vector<Environment> environments_;             //optimization environments for each optimizable tensor
+ std::shared_ptr<numerics::ExpansionEnvironmentCache> operator_cache_; //cached environments of the functional
+ std::shared_ptr<numerics::ExpansionEnvironmentCache> metric_cache_;   //cached environments of the norm
 };
 
 } //namespace exatn
@@ -1,5 +1,5 @@
 /** ExaTN:: Reconstructor of an approximate tensor network expansion from a given tensor network expansion
-REVISION: 2020/03/17
+REVISION: 2020/09/29
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
@@ -7,7 +7,10 @@ Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 #include "reconstructor.hpp"
 
 #include <unordered_set>
+#include <algorithm>
 #include <string>
+#include <cmath>
+
 #include <cassert>
 
 namespace exatn{
@@ -30,6 +33,20 @@ std::shared_ptr<TensorExpansion> TensorNetworkReconstructor::getSolution(double
 }
 
 
+bool TensorNetworkReconstructor::updateEnvironments(numerics::ExpansionEnvironmentCache & cache,
+                                                    unsigned int tensor,
+                                                    bool left)
+{
+ bool done = true;
+ const auto networks = left ? cache.getLeftUpdateNetworks(tensor) : cache.getRightUpdateNetworks(tensor);
+ for(const auto & network: networks){
+  done = evaluateSync(*network);
+  if(!done) break;
+ }
+ return done;
+}
+
+
 bool TensorNetworkReconstructor::reconstruct(double * fidelity)
 {
  assert(fidelity != nullptr);
@@ -39,57 +56,132 @@ bool TensorNetworkReconstructor::reconstruct(double * fidelity)
  TensorExpansion approximant_ket(*approximant_,false); // <approximant|
  approximant_ket.conjugate(); // |approximant>
  TensorExpansion normalization(*approximant_,approximant_ket); // <approximant|approximant>
+ TensorExpansion expansion_bra(*expansion_,false); // |expansion>
+ expansion_bra.conjugate(); // <expansion|
+ TensorExpansion target_norm(expansion_bra,*expansion_); // <expansion|expansion>
  //lagrangian.appendExpansion(normalization,{1.0,0.0});
 
- //Prepare optimization environments for all optimizable tensors in the approximant:
- std::unordered_set<std::string> tensor_names;
+ //Determine the optimizable tensors in the approximant in the sweep order (order of their tensor ids):
+ std::vector<std::string> tensor_names;
+ std::unordered_set<std::string> tensor_name_set;
+ environments_.clear();
  // Loop over the tensor networks constituting the approximant tensor expansion:
  for(auto network = approximant_->cbegin(); network != approximant_->cend(); ++network){
+  std::vector<unsigned int> tensor_ids;
+  for(auto tensor_conn = network->network_->cbegin(); tensor_conn != network->network_->cend(); ++tensor_conn){
+   if(tensor_conn->first != 0 && tensor_conn->second.isOptimizable()) tensor_ids.emplace_back(tensor_conn->first);
+  }
+  std::sort(tensor_ids.begin(),tensor_ids.end());
   // Loop over the optimizable tensors inside the current tensor network:
-  for(auto tensor_conn = network->network_->begin(); tensor_conn != network->network_->end(); ++tensor_conn){
-   auto tensor = tensor_conn->second;
-   if(tensor.isOptimizable()){ //gradient w.r.t. an optimizable tensor inside the approximant tensor expansion
-    auto res = tensor_names.emplace(tensor.getName());
-    if(res.second){
-     environments_.emplace_back(Environment{tensor.getTensor(),
-                                            std::make_shared<Tensor>("_a"+tensor.getName(),
-                                                                     tensor.getShape(),
-                                                                     tensor.getSignature()),
-                                            TensorExpansion(lagrangian,tensor.getName(),true)
-                                           });
-    }
+  for(const auto & tensor_id: tensor_ids){
+   const auto * tensor = network->network_->getTensorConn(tensor_id);
+   auto res = tensor_name_set.emplace(tensor->getName());
+   if(res.second){ //gradient w.r.t. an optimizable tensor inside the approximant tensor expansion
+    tensor_names.emplace_back(tensor->getName());
+    environments_.emplace_back(Environment{tensor->getTensor(),
+                                           std::make_shared<Tensor>("_a"+tensor->getName(),
+                                                                    tensor->getShape(),
+                                                                    tensor->getSignature()),
+                                           TensorExpansion(),
+                                           TensorExpansion()
+                                          });
    }
   }
  }
+ const unsigned int num_tensors = environments_.size();
+
+ //Prepare the environment caches of the Lagrangian and normalization functionals:
+ lagrangian_cache_ = std::make_shared<numerics::ExpansionEnvironmentCache>(lagrangian,tensor_names);
+ normalization_cache_ = std::make_shared<numerics::ExpansionEnvironmentCache>(normalization,tensor_names);
+ // Gradient (and norm) tensor network expansions for each optimizable tensor from its cached environments:
+ for(unsigned int i = 0; i < num_tensors; ++i){
+  auto & environment = environments_[i];
+  environment.gradient_expansion = lagrangian_cache_->getGradientExpansion(i,true);
+  environment.norm_expansion = normalization_cache_->getClosureExpansion(i);
+ }
+
  //Optimization procedure:
- bool converged = (environments_.size() == 0);
- // Create a scalar tensor:
+ bool converged = (num_tensors == 0);
  if(!converged){
+  const auto element_type = environments_[0].tensor->getElementType();
+  // Create the environment tensors:
+  bool done = true;
+  for(auto * cache: {lagrangian_cache_.get(),normalization_cache_.get()}){
+   for(auto & env: cache->getEnvironmentTensors()){
+    done = createTensorSync(env,element_type); assert(done);
+   }
+  }
+  // Create scalar tensors:
   auto scalar_norm = makeSharedTensor("_scalar_norm");
-  bool done = createTensorSync(scalar_norm,environments_[0].tensor->getElementType()); assert(done);
+  done = createTensorSync(scalar_norm,element_type); assert(done);
+  auto scalar_overlap = makeSharedTensor("_scalar_overlap");
+  done = createTensorSync(scalar_overlap,element_type); assert(done);
+  // Compute the norm of the reconstructed tensor network expansion:
+  double expansion_norm = 0.0;
+  done = initTensorSync("_scalar_norm",0.0); assert(done);
+  done = evaluateSync(target_norm,scalar_norm); assert(done);
+  done = computeNorm1Sync("_scalar_norm",expansion_norm); assert(done);
+  // Compute all right environments (the sweep starts from the first optimizable tensor):
+  for(int i = num_tensors - 1; i > 0; --i){
+   done = updateEnvironments(*lagrangian_cache_,i,false); assert(done);
+   done = updateEnvironments(*normalization_cache_,i,false); assert(done);
+  }
+  // Updates a given optimizable tensor from its cached environments:
+  auto optimize_tensor = [&](Environment & environment){
+   //Create the gradient tensor:
+   done = createTensorSync(environment.gradient,environment.tensor->getElementType()); assert(done);
+   //Initialize the gradient tensor to zero:
+   done = initTensorSync(environment.gradient->getName(),0.0); assert(done);
+   //Evaluate the gradient tensor expansion:
+   done = evaluateSync(environment.gradient_expansion,environment.gradient); assert(done);
+   //Update the optimizable tensor using the computed gradient (conjugated):
+   std::string add_pattern;
+   done = generate_addition_pattern(environment.tensor->getRank(),add_pattern,true,
+                                    environment.tensor->getName(),environment.gradient->getName()); assert(done);
+   done = addTensors(add_pattern,epsilon_); assert(done);
+   //Compute the norm of the approximant:
+   done = initTensorSync("_scalar_norm",0.0); assert(done);
+   done = evaluateSync(environment.norm_expansion,scalar_norm); assert(done);
+   double norm = 0.0;
+   done = computeNorm1Sync("_scalar_norm",norm); assert(done);
+   //Re-normalize the optimizable tensor:
+   if(norm > 0.0){
+    done = scaleTensorSync(environment.tensor->getName(),1.0/std::sqrt(norm)); assert(done);
+   }
+   //Destroy the gradient tensor:
+   done = destroyTensorSync(environment.gradient->getName()); assert(done);
+   return done;
+  };
+  // Sweep over the optimizable tensors back and forth until convergence:
+  unsigned int num_sweeps = 0;
   while(!converged){
-   for(auto & environment: environments_){
-    //Create the gradient tensor:
-    done = createTensorSync(environment.gradient,environment.tensor->getElementType()); assert(done);
-    //Initialize the gradient tensor to zero:
-    done = initTensorSync(environment.gradient->getName(),0.0); assert(done);
-    //Evaluate the gradient tensor expansion:
-    done = evaluateSync(environment.gradient_expansion,environment.gradient); assert(done);
-    //Update the optimizable tensor using the computed gradient (conjugated):
-    std::string add_pattern;
-    done = generate_addition_pattern(environment.tensor->getRank(),add_pattern,true,
-                                     environment.tensor->getName(),environment.gradient->getName()); assert(done);
-    done = addTensors(add_pattern,epsilon_); assert(done);
-    //Compute the norm of the approximant:
-    done = initTensorSync("_scalar_norm",0.0); assert(done);
-    done = evaluateSync(normalization,scalar_norm); assert(done);
-    //Re-normalize the optimizable tensor:
-    
-    //Destroy the gradient tensor:
-    done = destroyTensorSync(environment.gradient->getName()); assert(done);
+   for(unsigned int i = 0; i < num_tensors; ++i){
+    done = optimize_tensor(environments_[i]); assert(done);
+    done = updateEnvironments(*lagrangian_cache_,i,true); assert(done);
+    done = updateEnvironments(*normalization_cache_,i,true); assert(done);
+   }
+   for(int i = num_tensors - 1; i > 0; --i){
+    done = updateEnvironments(*lagrangian_cache_,i,false); assert(done);
+    done = updateEnvironments(*normalization_cache_,i,false); assert(done);
+    done = optimize_tensor(environments_[i-1]); assert(done);
    }
+   //Compute the reconstruction fidelity from the environments of the first optimizable tensor:
+   auto overlap = lagrangian_cache_->getClosureExpansion(0);
+   done = initTensorSync("_scalar_overlap",0.0); assert(done);
+   done = evaluateSync(overlap,scalar_overlap); assert(done);
+   double overlap_abs = 0.0;
+   done = computeNorm1Sync("_scalar_overlap",overlap_abs); assert(done);
+   const double new_fidelity = (expansion_norm > 0.0) ? (overlap_abs * overlap_abs / expansion_norm) : 0.0;
+   converged = (std::abs(new_fidelity - fidelity_) <= tolerance_ || ++num_sweeps >= MAX_SWEEPS);
+   fidelity_ = new_fidelity;
   }
+  done = destroyTensorSync("_scalar_overlap"); assert(done);
   done = destroyTensorSync("_scalar_norm"); assert(done);
+  for(auto * cache: {lagrangian_cache_.get(),normalization_cache_.get()}){
+   for(auto & env: cache->getEnvironmentTensors()){
+    done = destroyTensorSync(env->getName()); assert(done);
+   }
+  }
  }
  *fidelity = fidelity_;
  return true;
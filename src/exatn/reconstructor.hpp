@@ -1,5 +1,5 @@
 /** ExaTN:: Reconstructor of an approximate tensor network expansion from a given tensor network expansion
-REVISION: 2020/03/17
+REVISION: 2020/09/29
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
@@ -13,12 +13,19 @@ Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
      of the underlying linear algebra procedures.
  (B) The reconstructed tensor network expansion must be a Ket (primary space) and
      the reconstructing tensor network expansion must be a Bra (dual space).
+ (C) The optimizable tensors are swept in the order of their appearance (tensor id)
+     in the reconstructing tensor network expansion. The left and right environments
+     of each optimizable tensor in each tensor network of the Lagrangian and normalization
+     functionals are cached and incrementally updated as the sweep moves, such that
+     the gradient w.r.t. each optimizable tensor (and the norm) are computed from
+     the two cached environments plus the local tensors only.
 **/
 
 #ifndef EXATN_RECONSTRUCTOR_HPP_
 #define EXATN_RECONSTRUCTOR_HPP_
 
 #include "exatn_numerics.hpp"
+#include "environment_cache.hpp"
 
 #include <memory>
 #include <vector>
@@ -49,18 +56,28 @@ public:
 
 private:
 
+ static constexpr unsigned int MAX_SWEEPS = 1000; //max number of optimization sweeps
+
  struct Environment{
   std::shared_ptr<Tensor> tensor;     //tensor being optimized
   std::shared_ptr<Tensor> gradient;   //gradient w.r.t. the tensor
-  TensorExpansion gradient_expansion; //gradient tensor network expansion
+  TensorExpansion gradient_expansion; //gradient tensor network expansion (from cached environments)
+  TensorExpansion norm_expansion;     //normalization tensor network expansion (from cached environments)
  };
 
+ /** Updates the cached left (or right) environments of a given optimizable tensor. **/
+ bool updateEnvironments(numerics::ExpansionEnvironmentCache & cache,
+                         unsigned int tensor,
+                         bool left);
+
  std::shared_ptr<TensorExpansion> expansion_;   //tensor expansion to reconstruct
  std::shared_ptr<TensorExpansion> approximant_; //reconstructing tensor expansion
  double epsilon_;                               //epsilon value for gradient descent
  double tolerance_;                             //numerical reconstruction convergence tolerance
  double fidelity_;                              //actually achieved reconstruction fidelity
  std::vector<Environment> environments_;        //optimization environments for each optimizable tensor
+ std::shared_ptr<numerics::ExpansionEnvironmentCache> lagrangian_cache_;    //cached environments of the Lagrangian functional
+ std::shared_ptr<numerics::ExpansionEnvironmentCache> normalization_cache_; //cached environments of the normalization functional
 };
 
 } //namespace exatn
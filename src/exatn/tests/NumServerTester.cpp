@@ -30,6 +30,21 @@
 #define EXATN_TEST15
 #define EXATN_TEST16
 #define EXATN_TEST17
+#define EXATN_TEST18
+#define EXATN_TEST19
+#define EXATN_TEST20
+#define EXATN_TEST21
+#define EXATN_TEST22
+#define EXATN_TEST23
+#define EXATN_TEST24
+#define EXATN_TEST25
+#define EXATN_TEST26
+#define EXATN_TEST27
+#define EXATN_TEST28
+#define EXATN_TEST29
+#define EXATN_TEST30
+#define EXATN_TEST31
+#define EXATN_TEST32
 
 
 #ifdef EXATN_TEST0
@@ -1798,7 +1813,37 @@ TEST(NumServerTester, EigenNumServer)
   initialized = exatn::initTensorDataSync("U22",hamu); assert(initialized);
   initialized = exatn::initTensorDataSync("U33",hamu); assert(initialized);
 
-  //`Finish
+  //Build a 4-site MPS ansatz (exact with bond dimension 4):
+  auto & network_build_factory = *(exatn::NetworkBuildFactory::get());
+  auto builder = network_build_factory.createNetworkBuilderShared("MPS");
+  auto success = builder->setParameter("max_bond_dim",4); assert(success);
+  auto ansatz_net = exatn::makeSharedTensorNetwork("Ansatz",
+                                                   std::make_shared<Tensor>("AnsatzTensor",TensorShape{2,2,2,2}),
+                                                   *builder);
+  ansatz_net->markOptimizableTensors([](const Tensor & tensor){return true;});
+  auto ansatz = std::make_shared<TensorExpansion>();
+  appended = ansatz->appendComponent(ansatz_net,{1.0,0.0}); assert(appended);
+  for(auto iter = ansatz_net->cbegin(); iter != ansatz_net->cend(); ++iter){
+   if(iter->first != 0){
+    created = exatn::createTensorSync(iter->second.getTensor(),TensorElementType::COMPLEX64); assert(created);
+    initialized = exatn::initTensorRndSync(iter->second.getName()); assert(initialized);
+   }
+  }
+
+  //Find the ground state of the Ising Hamiltonian:
+  exatn::TensorNetworkOptimizer optimizer(std::make_shared<TensorOperator>(ham),ansatz,1e-7);
+  success = optimizer.optimize(); assert(success);
+  double energy = 0.0;
+  auto solution = optimizer.getSolution(&energy);
+  std::cout << "Ground state energy = " << energy << std::endl;
+  EXPECT_NEAR(energy,-8.37679863685,1e-5);
+
+  //Destroy the MPS tensors:
+  for(auto iter = ansatz_net->cbegin(); iter != ansatz_net->cend(); ++iter){
+   if(iter->first != 0){
+    auto destroyed = exatn::destroyTensorSync(iter->second.getName()); assert(destroyed);
+   }
+  }
 
   //Destroy all tensors:
   auto destroyed = false;
@@ -1896,6 +1941,1389 @@ TEST(NumServerTester, TestSVD)
 }
 #endif
 
+#ifdef EXATN_TEST18
+TEST(NumServerTester, DynamicParallelExaTN)
+{
+ using exatn::Tensor;
+ using exatn::TensorShape;
+ using exatn::TensorElementType;
+
+ exatn::resetRuntimeLoggingLevel(0); //debug
+
+ bool success = true;
+
+ exatn::ProcessGroup all_processes(exatn::getDefaultProcessGroup()); //group of all processes
+ all_processes.resetMemoryLimitPerProcess(exatn::getMemoryBufferSize()/64);
+
+ //Odd dimension extents produce unequal segments of split indices (imbalanced slices):
+ success = exatn::createTensor("Z0",TensorElementType::REAL64,TensorShape{17,17,17,17}); assert(success);
+ success = exatn::createTensor("T1",TensorElementType::REAL64,TensorShape{33,17,33,31}); assert(success);
+ success = exatn::createTensor("T2",TensorElementType::REAL64,TensorShape{33,17,33,29}); assert(success);
+ success = exatn::createTensor("T3",TensorElementType::REAL64,TensorShape{33,17,33,31}); assert(success);
+ success = exatn::createTensor("T4",TensorElementType::REAL64,TensorShape{33,17,33,29}); assert(success);
+ success = exatn::initTensor("T1",0.01); assert(success);
+ success = exatn::initTensor("T2",0.001); assert(success);
+ success = exatn::initTensor("T3",0.0001); assert(success);
+ success = exatn::initTensor("T4",0.00001); assert(success);
+
+ //Static distribution of tensor sub-networks:
+ exatn::deactivateDynamicLoadBalancing();
+ success = exatn::initTensor("Z0",0.0); assert(success);
+ success = exatn::sync(all_processes); assert(success);
+ auto time_start = exatn::Timer::timeInSecHR();
+ success = exatn::evaluateTensorNetwork(all_processes,"StaticStar",
+           "Z0(i,j,k,l)+=T1(d,i,a,e)*T2(a,j,b,f)*T3(b,k,c,e)*T4(c,l,d,f)"); assert(success);
+ success = exatn::sync("Z0"); assert(success);
+ auto time_static = exatn::Timer::timeInSecHR(time_start);
+ success = exatn::sync(all_processes); assert(success);
+ auto time_static_tail = exatn::Timer::timeInSecHR(time_start);
+ double norm_static = 0.0;
+ success = exatn::computeNorm2Sync("Z0",norm_static); assert(success);
+
+ //Dynamic distribution of tensor sub-networks:
+ exatn::activateDynamicLoadBalancing();
+ success = exatn::initTensor("Z0",0.0); assert(success);
+ success = exatn::sync(all_processes); assert(success);
+ time_start = exatn::Timer::timeInSecHR();
+ success = exatn::evaluateTensorNetwork(all_processes,"DynamicStar",
+           "Z0(i,j,k,l)+=T1(d,i,a,e)*T2(a,j,b,f)*T3(b,k,c,e)*T4(c,l,d,f)"); assert(success);
+ success = exatn::sync("Z0"); assert(success);
+ auto time_dynamic = exatn::Timer::timeInSecHR(time_start);
+ success = exatn::sync(all_processes); assert(success);
+ auto time_dynamic_tail = exatn::Timer::timeInSecHR(time_start);
+ double norm_dynamic = 0.0;
+ success = exatn::computeNorm2Sync("Z0",norm_dynamic); assert(success);
+ exatn::deactivateDynamicLoadBalancing();
+
+ std::cout << "Process " << exatn::getProcessRank() << ": Static distribution: Local time = " << time_static
+           << " s; Tail time = " << time_static_tail << " s" << std::endl;
+ std::cout << "Process " << exatn::getProcessRank() << ": Dynamic distribution: Local time = " << time_dynamic
+           << " s; Tail time = " << time_dynamic_tail << " s" << std::endl;
+ std::cout << "Z0 2-norm (static vs dynamic) = " << norm_static << " vs " << norm_dynamic << std::endl << std::flush;
+ EXPECT_NEAR(norm_static,norm_dynamic,1e-7*norm_static);
+
+ success = exatn::destroyTensor("T4"); assert(success);
+ success = exatn::destroyTensor("T3"); assert(success);
+ success = exatn::destroyTensor("T2"); assert(success);
+ success = exatn::destroyTensor("T1"); assert(success);
+ success = exatn::destroyTensor("Z0"); assert(success);
+
+ success = exatn::sync(all_processes); assert(success);
+}
+#endif
+
+#ifdef EXATN_TEST19
+TEST(NumServerTester, ParallelExpansionNumServer)
+{
+ using exatn::Tensor;
+ using exatn::TensorShape;
+ using exatn::TensorNetwork;
+ using exatn::TensorOperator;
+ using exatn::TensorExpansion;
+ using exatn::TensorElementType;
+
+ exatn::resetRuntimeLoggingLevel(0); //debug
+
+ bool success = true;
+
+ exatn::ProcessGroup all_processes(exatn::getDefaultProcessGroup()); //group of all processes
+
+ //Declare MPS tensors:
+ auto q0 = std::make_shared<Tensor>("Q0",TensorShape{2,8});
+ auto q1 = std::make_shared<Tensor>("Q1",TensorShape{8,2,8});
+ auto q2 = std::make_shared<Tensor>("Q2",TensorShape{8,2,8});
+ auto q3 = std::make_shared<Tensor>("Q3",TensorShape{8,2});
+ auto z0 = std::make_shared<Tensor>("Z0",TensorShape{2,2,2,2});
+
+ //Declare the Hamiltonian operator with components of different cost:
+ auto h01 = std::make_shared<Tensor>("H01",TensorShape{2,2,2,2});
+ auto h12 = std::make_shared<Tensor>("H12",TensorShape{2,2,2,2});
+ auto h23 = std::make_shared<Tensor>("H23",TensorShape{2,2,2,2});
+ auto h03 = std::make_shared<Tensor>("H03",TensorShape{2,2,2,2});
+ auto h0 = std::make_shared<Tensor>("H0",TensorShape{2,2});
+ TensorOperator ham("Hamiltonian");
+ success = ham.appendComponent(h01,{{0,0},{1,1}},{{0,2},{1,3}},{1.0,0.0}); assert(success);
+ success = ham.appendComponent(h12,{{1,0},{2,1}},{{1,2},{2,3}},{0.5,0.0}); assert(success);
+ success = ham.appendComponent(h23,{{2,0},{3,1}},{{2,2},{3,3}},{1.0,0.0}); assert(success);
+ success = ham.appendComponent(h03,{{0,0},{3,1}},{{0,2},{3,3}},{-1.0,0.0}); assert(success);
+ success = ham.appendComponent(h0,{{0,0}},{{0,1}},{2.0,0.0}); assert(success);
+
+ //Declare the ket MPS tensor network:
+ auto mps_ket = std::make_shared<TensorNetwork>("MPS",
+                 "Z0(i0,i1,i2,i3)+=Q0(i0,j0)*Q1(j0,i1,j1)*Q2(j1,i2,j2)*Q3(j2,i3)",
+                 std::map<std::string,std::shared_ptr<Tensor>>{
+                  {"Z0",z0}, {"Q0",q0}, {"Q1",q1}, {"Q2",q2}, {"Q3",q3}});
+ TensorExpansion ket;
+ success = ket.appendComponent(mps_ket,{1.0,0.0}); assert(success);
+ ket.rename("MPSket");
+
+ //Declare two identical operator times ket tensor expansions:
+ TensorExpansion ham_ket_serial(ket,ham);
+ ham_ket_serial.rename("HamMPSketSerial");
+ TensorExpansion ham_ket_parallel(ket,ham);
+ ham_ket_parallel.rename("HamMPSketParallel");
+
+ //Create and initialize tensors:
+ for(auto tensor: {q0,q1,q2,q3,h01,h12,h23,h03,h0}){
+  success = exatn::createTensor(tensor,TensorElementType::REAL64); assert(success);
+  success = exatn::initTensor(tensor->getName(),1e-1); assert(success);
+ }
+ success = exatn::createTensorSync("AS",TensorElementType::REAL64,z0->getShape()); assert(success);
+ success = exatn::createTensorSync("AP",TensorElementType::REAL64,z0->getShape()); assert(success);
+ success = exatn::initTensorSync("AS",0.0); assert(success);
+ success = exatn::initTensorSync("AP",0.0); assert(success);
+
+ //Evaluate tensor expansion components one by one by all processes:
+ exatn::deactivateParallelExpansionEvaluation();
+ success = exatn::evaluateSync(all_processes,ham_ket_serial,exatn::getTensor("AS")); assert(success);
+
+ //Evaluate tensor expansion components concurrently by process subgroups:
+ exatn::activateParallelExpansionEvaluation();
+ success = exatn::evaluateSync(all_processes,ham_ket_parallel,exatn::getTensor("AP")); assert(success);
+ exatn::deactivateParallelExpansionEvaluation();
+
+ //Compare the results:
+ success = exatn::addTensorsSync("AP(i0,i1,i2,i3)+=AS(i0,i1,i2,i3)",-1.0); assert(success);
+ double norm_serial = 0.0, norm_diff = 0.0;
+ success = exatn::computeNorm2Sync("AS",norm_serial); assert(success);
+ success = exatn::computeNorm2Sync("AP",norm_diff); assert(success);
+ std::cout << "Process " << exatn::getProcessRank() << ": Serial result norm = " << norm_serial
+           << "; Difference norm = " << norm_diff << std::endl << std::flush;
+ EXPECT_NEAR(norm_diff,0.0,1e-10*norm_serial);
+
+ //Destroy tensors:
+ success = exatn::destroyTensorSync("AP"); assert(success);
+ success = exatn::destroyTensorSync("AS"); assert(success);
+ for(auto tensor: {h0,h03,h23,h12,h01,q3,q2,q1,q0}){
+  success = exatn::destroyTensorSync(tensor->getName()); assert(success);
+ }
+
+ success = exatn::sync(all_processes); assert(success);
+}
+#endif
+
+#ifdef EXATN_TEST20
+TEST(NumServerTester, ExpansionCSENumServer)
+{
+ using exatn::Tensor;
+ using exatn::TensorShape;
+ using exatn::TensorNetwork;
+ using exatn::TensorOperator;
+ using exatn::TensorExpansion;
+ using exatn::TensorElementType;
+
+ exatn::resetRuntimeLoggingLevel(0); //debug
+
+ bool success = true;
+
+ const auto & my_process = exatn::getCurrentProcessGroup(); //current process only
+
+ //Declare MPS tensors:
+ auto q0 = std::make_shared<Tensor>("Q0",TensorShape{2,16});
+ auto q1 = std::make_shared<Tensor>("Q1",TensorShape{16,2,16});
+ auto q2 = std::make_shared<Tensor>("Q2",TensorShape{16,2,16});
+ auto q3 = std::make_shared<Tensor>("Q3",TensorShape{16,2,16});
+ auto q4 = std::make_shared<Tensor>("Q4",TensorShape{16,2});
+ auto z0 = std::make_shared<Tensor>("Z0",TensorShape{2,2,2,2,2});
+
+ //Declare the Hamiltonian operator:
+ TensorOperator ham("Hamiltonian");
+ std::vector<std::shared_ptr<Tensor>> ham_tensors;
+ for(unsigned int i = 0; i < 4; ++i){
+  ham_tensors.emplace_back(std::make_shared<Tensor>("H"+std::to_string(i),TensorShape{2,2,2,2}));
+  success = ham.appendComponent(ham_tensors.back(),{{i,0},{i+1,1}},{{i,2},{i+1,3}},{1.0,0.0}); assert(success);
+ }
+
+ //Declare the ket MPS tensor network:
+ auto mps_ket = std::make_shared<TensorNetwork>("MPS",
+                 "Z0(i0,i1,i2,i3,i4)+=Q0(i0,j0)*Q1(j0,i1,j1)*Q2(j1,i2,j2)*Q3(j2,i3,j3)*Q4(j3,i4)",
+                 std::map<std::string,std::shared_ptr<Tensor>>{
+                  {"Z0",z0}, {"Q0",q0}, {"Q1",q1}, {"Q2",q2}, {"Q3",q3}, {"Q4",q4}});
+ TensorExpansion ket;
+ success = ket.appendComponent(mps_ket,{1.0,0.0}); assert(success);
+ ket.rename("MPSket");
+ TensorExpansion bra(ket);
+ bra.conjugate();
+ bra.rename("MPSbra");
+ TensorExpansion ham_ket(ket,ham);
+
+ //Declare two identical expectation value tensor expansions:
+ TensorExpansion closed_prod_plain(ham_ket,bra);
+ closed_prod_plain.rename("MPSbraHamMPSketPlain");
+ TensorExpansion closed_prod_cse(ham_ket,bra);
+ closed_prod_cse.rename("MPSbraHamMPSketCSE");
+
+ //Create and initialize tensors:
+ for(auto tensor: {q0,q1,q2,q3,q4}){
+  success = exatn::createTensor(my_process,tensor,TensorElementType::REAL64); assert(success);
+  success = exatn::initTensor(tensor->getName(),1e-1); assert(success);
+ }
+ for(auto tensor: ham_tensors){
+  success = exatn::createTensor(my_process,tensor,TensorElementType::REAL64); assert(success);
+  success = exatn::initTensor(tensor->getName(),1e-2); assert(success);
+ }
+ success = exatn::createTensorSync(my_process,"EP",TensorElementType::REAL64,TensorShape{}); assert(success);
+ success = exatn::createTensorSync(my_process,"EC",TensorElementType::REAL64,TensorShape{}); assert(success);
+ success = exatn::initTensorSync("EP",0.0); assert(success);
+ success = exatn::initTensorSync("EC",0.0); assert(success);
+
+ //Evaluate the expectation value without and with common subexpression elimination:
+ exatn::deactivateExpansionCSE();
+ success = exatn::evaluateSync(my_process,closed_prod_plain,exatn::getTensor("EP")); assert(success);
+ exatn::activateExpansionCSE();
+ success = exatn::evaluateSync(my_process,closed_prod_cse,exatn::getTensor("EC")); assert(success);
+ exatn::deactivateExpansionCSE();
+
+ //Compare the results:
+ double value_plain = 0.0, value_cse = 0.0;
+ success = exatn::computeNorm1Sync("EP",value_plain); assert(success);
+ success = exatn::computeNorm1Sync("EC",value_cse); assert(success);
+ std::cout << "Expectation value without CSE = " << value_plain << "; with CSE = " << value_cse << std::endl;
+ EXPECT_NEAR(value_plain,value_cse,1e-10*value_plain);
+
+ //Repeat with random tensors such that the intermediates of different components differ:
+ for(auto tensor: {q0,q1,q2,q3,q4}){
+  success = exatn::initTensorRnd(tensor->getName()); assert(success);
+ }
+ for(auto tensor: ham_tensors){
+  success = exatn::initTensorRnd(tensor->getName()); assert(success);
+ }
+ success = exatn::initTensorSync("EP",0.0); assert(success);
+ success = exatn::initTensorSync("EC",0.0); assert(success);
+ success = exatn::evaluateSync(my_process,closed_prod_plain,exatn::getTensor("EP")); assert(success);
+ exatn::activateExpansionCSE();
+ success = exatn::evaluateSync(my_process,closed_prod_cse,exatn::getTensor("EC")); assert(success);
+ exatn::deactivateExpansionCSE();
+ success = exatn::computeNorm1Sync("EP",value_plain); assert(success);
+ success = exatn::computeNorm1Sync("EC",value_cse); assert(success);
+ std::cout << "Random expectation value without CSE = " << value_plain << "; with CSE = " << value_cse << std::endl;
+ EXPECT_NEAR(value_plain,value_cse,1e-10*value_plain);
+
+ //Destroy tensors:
+ success = exatn::destroyTensorSync("EC"); assert(success);
+ success = exatn::destroyTensorSync("EP"); assert(success);
+ for(auto tensor: ham_tensors){
+  success = exatn::destroyTensorSync(tensor->getName()); assert(success);
+ }
+ for(auto tensor: {q4,q3,q2,q1,q0}){
+  success = exatn::destroyTensorSync(tensor->getName()); assert(success);
+ }
+
+ exatn::sync();
+}
+#endif
+
+#ifdef EXATN_TEST21
+TEST(NumServerTester, BatchedAmplitudesNumServer)
+{
+ using exatn::Tensor;
+ using exatn::TensorShape;
+ using exatn::TensorNetwork;
+ using exatn::TensorElementType;
+
+ exatn::resetRuntimeLoggingLevel(0); //debug
+
+ bool success = true;
+
+ //Declare MPS tensors:
+ auto q0 = std::make_shared<Tensor>("A0",TensorShape{2,4});
+ auto q1 = std::make_shared<Tensor>("A1",TensorShape{4,2,4});
+ auto q2 = std::make_shared<Tensor>("A2",TensorShape{4,2,4});
+ auto q3 = std::make_shared<Tensor>("A3",TensorShape{4,2,4});
+ auto q4 = std::make_shared<Tensor>("A4",TensorShape{4,2});
+ auto z0 = std::make_shared<Tensor>("Z0",TensorShape{2,2,2,2,2});
+
+ //Declare the MPS tensor network:
+ TensorNetwork mps("MPS",
+                   "Z0(i0,i1,i2,i3,i4)+=A0(i0,j0)*A1(j0,i1,j1)*A2(j1,i2,j2)*A3(j2,i3,j3)*A4(j3,i4)",
+                   std::map<std::string,std::shared_ptr<Tensor>>{
+                    {"Z0",z0}, {"A0",q0}, {"A1",q1}, {"A2",q2}, {"A3",q3}, {"A4",q4}});
+
+ //Create and initialize tensors:
+ for(auto tensor: {q0,q1,q2,q3,q4}){
+  success = exatn::createTensorSync(tensor,TensorElementType::REAL64); assert(success);
+  success = exatn::initTensorRndSync(tensor->getName()); assert(success);
+ }
+ success = exatn::createTensorSync(z0,TensorElementType::REAL64); assert(success);
+
+ //Evaluate the full output tensor for reference:
+ success = exatn::evaluateSync(mps); assert(success);
+ auto local_copy = exatn::getLocalTensor("Z0"); assert(local_copy);
+ const double * body_ptr = nullptr;
+ auto access_granted = local_copy->getDataAccessHostConst(&body_ptr); assert(access_granted);
+ auto reference = [&](const std::vector<exatn::DimOffset> & bits){
+  std::size_t offset = 0;
+  for(int i = bits.size() - 1; i >= 0; --i) offset = offset * 2 + bits[i];
+  return body_ptr[offset];
+ };
+
+ //Evaluate a batch of amplitudes sharing the values of the first two legs:
+ std::vector<std::vector<exatn::DimOffset>> bitstrings{{0,1,0,0,1},{0,1,1,0,1},{0,1,1,1,0},{0,1,0,1,1}};
+ std::vector<std::complex<double>> amplitudes;
+ success = exatn::evaluateAmplitudesSync(mps,bitstrings,amplitudes); assert(success);
+ EXPECT_EQ(amplitudes.size(),bitstrings.size());
+ for(std::size_t i = 0; i < bitstrings.size(); ++i){
+  EXPECT_NEAR(amplitudes[i].real(),reference(bitstrings[i]),1e-10);
+  EXPECT_NEAR(amplitudes[i].imag(),0.0,1e-10);
+ }
+
+ //Evaluate a batch of amplitudes with two open legs:
+ success = exatn::evaluateAmplitudesSync(mps,bitstrings,amplitudes,{1,3}); assert(success);
+ EXPECT_EQ(amplitudes.size(),bitstrings.size()*4);
+ for(std::size_t i = 0; i < bitstrings.size(); ++i){
+  auto bits = bitstrings[i];
+  for(exatn::DimOffset j = 0; j < 4; ++j){
+   bits[1] = j % 2; bits[3] = j / 2;
+   EXPECT_NEAR(amplitudes[i*4+j].real(),reference(bits),1e-10);
+  }
+ }
+
+ //Group the bitstrings by a small memory limit (the intermediate is kept with 1024 bytes, but not with 256 bytes):
+ exatn::ProcessGroup all_processes(exatn::getDefaultProcessGroup());
+ for(std::size_t mem_limit: {1024,256}){
+  all_processes.resetMemoryLimitPerProcess(mem_limit);
+  success = exatn::evaluateAmplitudesSync(all_processes,mps,bitstrings,amplitudes,{1,3}); assert(success);
+  EXPECT_EQ(amplitudes.size(),bitstrings.size()*4);
+  for(std::size_t i = 0; i < bitstrings.size(); ++i){
+   auto bits = bitstrings[i];
+   for(exatn::DimOffset j = 0; j < 4; ++j){
+    bits[1] = j % 2; bits[3] = j / 2;
+    EXPECT_NEAR(amplitudes[i*4+j].real(),reference(bits),1e-10);
+   }
+  }
+ }
+ body_ptr = nullptr;
+ local_copy.reset();
+
+ //Destroy tensors:
+ success = exatn::destroyTensorSync("Z0"); assert(success);
+ for(auto tensor: {q4,q3,q2,q1,q0}){
+  success = exatn::destroyTensorSync(tensor->getName()); assert(success);
+ }
+
+ exatn::sync();
+}
+#endif
+
+#ifdef EXATN_TEST22
+TEST(NumServerTester, IndexFixingNumServer)
+{
+ using exatn::Tensor;
+ using exatn::TensorShape;
+ using exatn::TensorNetwork;
+ using exatn::TensorElementType;
+
+ exatn::resetRuntimeLoggingLevel(0); //debug
+
+ bool success = true;
+
+ //Define the initial qubit state vectors:
+ std::vector<std::complex<double>> qzero {
+  {1.0,0.0}, {0.0,0.0}
+ };
+ std::vector<std::complex<double>> qone {
+  {0.0,0.0}, {1.0,0.0}
+ };
+
+ //Create qubit tensors (basis vectors are detected during initialization):
+ success = exatn::createTensorSync("Q0",TensorElementType::COMPLEX64,TensorShape{2}); assert(success);
+ success = exatn::createTensorSync("Q1",TensorElementType::COMPLEX64,TensorShape{2}); assert(success);
+ success = exatn::createTensorSync("Q2",TensorElementType::COMPLEX64,TensorShape{2}); assert(success);
+ success = exatn::initTensorDataSync("Q0",qzero); assert(success);
+ success = exatn::initTensorDataSync("Q1",qone); assert(success);
+ success = exatn::initTensorDataSync("Q2",qzero); assert(success);
+
+ //Create random two-qubit gates:
+ for(unsigned int i = 0; i < 4; ++i){
+  success = exatn::createTensorSync("G"+std::to_string(i),TensorElementType::COMPLEX64,TensorShape{2,2,2,2}); assert(success);
+  success = exatn::initTensorRndSync("G"+std::to_string(i)); assert(success);
+ }
+
+ //Create the output tensors:
+ success = exatn::createTensorSync("S0",TensorElementType::COMPLEX64,TensorShape{2,2,2}); assert(success);
+ success = exatn::createTensorSync("S1",TensorElementType::COMPLEX64,TensorShape{2,2,2}); assert(success);
+
+ //Evaluate the circuit without and with index fixing:
+ const std::string circuit = "(a,b,c)+=Q0(i)*Q1(j)*Q2(k)*G0(l,m,i,j)*G1(n,p,m,k)*G2(a,q,l,n)*G3(b,c,q,p)";
+ exatn::deactivateIndexFixing();
+ success = exatn::evaluateTensorNetworkSync("CircuitPlain","S0"+circuit); assert(success);
+ exatn::activateIndexFixing();
+ success = exatn::evaluateTensorNetworkSync("CircuitFixed","S1"+circuit); assert(success);
+
+ //Compare the results:
+ double norm0 = 0.0, norm1 = 0.0, diff = 0.0;
+ success = exatn::computeNorm2Sync("S0",norm0); assert(success);
+ success = exatn::computeNorm2Sync("S1",norm1); assert(success);
+ success = exatn::addTensorsSync("S1(a,b,c)+=S0(a,b,c)",-1.0); assert(success);
+ success = exatn::computeNorm2Sync("S1",diff); assert(success);
+ std::cout << "Output norms: " << norm0 << " " << norm1 << "; Difference norm = " << diff << std::endl;
+ EXPECT_NEAR(norm0,norm1,1e-10*norm0);
+ EXPECT_NEAR(diff,0.0,1e-10*norm0);
+
+ //Repeat index fixing on recycled non-zero memory (the projected tensors must not inherit it):
+ for(unsigned int repeat = 0; repeat < 3; ++repeat){
+  for(unsigned int i = 0; i < 8; ++i){
+   success = exatn::createTensorSync("J"+std::to_string(i),TensorElementType::COMPLEX64,TensorShape{2,2,2}); assert(success);
+   success = exatn::initTensorSync("J"+std::to_string(i),1.0); assert(success);
+  }
+  for(unsigned int i = 0; i < 8; ++i){
+   success = exatn::destroyTensorSync("J"+std::to_string(i)); assert(success);
+  }
+  success = exatn::evaluateTensorNetworkSync("CircuitFixed"+std::to_string(repeat),"S1"+circuit); assert(success);
+  success = exatn::addTensorsSync("S1(a,b,c)+=S0(a,b,c)",-1.0); assert(success);
+  success = exatn::computeNorm2Sync("S1",diff); assert(success);
+  std::cout << "Difference norm after recycling non-zero memory = " << diff << std::endl;
+  EXPECT_NEAR(diff,0.0,1e-10*norm0);
+ }
+
+ //Destroy tensors:
+ success = exatn::destroyTensorSync("S1"); assert(success);
+ success = exatn::destroyTensorSync("S0"); assert(success);
+ for(unsigned int i = 0; i < 4; ++i){
+  success = exatn::destroyTensorSync("G"+std::to_string(i)); assert(success);
+ }
+ success = exatn::destroyTensorSync("Q2"); assert(success);
+ success = exatn::destroyTensorSync("Q1"); assert(success);
+ success = exatn::destroyTensorSync("Q0"); assert(success);
+
+ exatn::sync();
+}
+#endif
+
+#ifdef EXATN_TEST23
+TEST(NumServerTester, NetworkSimplificationNumServer)
+{
+ using exatn::Tensor;
+ using exatn::TensorShape;
+ using exatn::TensorNetwork;
+ using exatn::TensorElementType;
+
+ exatn::resetRuntimeLoggingLevel(0); //debug
+
+ bool success = true;
+
+ //Create random qubit state vectors:
+ for(unsigned int i = 0; i < 3; ++i){
+  success = exatn::createTensorSync("V"+std::to_string(i),TensorElementType::COMPLEX64,TensorShape{2}); assert(success);
+  success = exatn::initTensorRndSync("V"+std::to_string(i)); assert(success);
+ }
+
+ //Create random one-qubit and two-qubit gates:
+ for(unsigned int i = 0; i < 2; ++i){
+  success = exatn::createTensorSync("H"+std::to_string(i),TensorElementType::COMPLEX64,TensorShape{2,2}); assert(success);
+  success = exatn::initTensorRndSync("H"+std::to_string(i)); assert(success);
+ }
+ for(unsigned int i = 0; i < 4; ++i){
+  success = exatn::createTensorSync("G"+std::to_string(i),TensorElementType::COMPLEX64,TensorShape{2,2,2,2}); assert(success);
+  success = exatn::initTensorRndSync("G"+std::to_string(i)); assert(success);
+ }
+
+ //Create the output tensors:
+ success = exatn::createTensorSync("S0",TensorElementType::COMPLEX64,TensorShape{2,2,2}); assert(success);
+ success = exatn::createTensorSync("S1",TensorElementType::COMPLEX64,TensorShape{2,2,2}); assert(success);
+
+ //Evaluate the circuit without and with tensor network simplification:
+ const std::string circuit =
+  "(a,b,c)+=V0(i)*V1(j)*V2(k)*H0(r,i)*G0(l,m,r,j)*G1(s,t,l,m)*G2(n,p,t,k)*H1(u,s)*G3(a,b,u,n)*H1(c,p)";
+ exatn::deactivateNetworkSimplification();
+ success = exatn::evaluateTensorNetworkSync("CircuitPlain","S0"+circuit); assert(success);
+ exatn::activateNetworkSimplification();
+ success = exatn::evaluateTensorNetworkSync("CircuitSimple","S1"+circuit); assert(success);
+ exatn::deactivateNetworkSimplification();
+
+ //Compare the results:
+ double norm0 = 0.0, norm1 = 0.0, diff = 0.0;
+ success = exatn::computeNorm2Sync("S0",norm0); assert(success);
+ success = exatn::computeNorm2Sync("S1",norm1); assert(success);
+ success = exatn::addTensorsSync("S1(a,b,c)+=S0(a,b,c)",-1.0); assert(success);
+ success = exatn::computeNorm2Sync("S1",diff); assert(success);
+ std::cout << "Output norms: " << norm0 << " " << norm1 << "; Difference norm = " << diff << std::endl;
+ EXPECT_NEAR(norm0,norm1,1e-10*norm0);
+ EXPECT_NEAR(diff,0.0,1e-10*norm0);
+
+ //Destroy tensors:
+ success = exatn::destroyTensorSync("S1"); assert(success);
+ success = exatn::destroyTensorSync("S0"); assert(success);
+ for(unsigned int i = 0; i < 4; ++i){
+  success = exatn::destroyTensorSync("G"+std::to_string(i)); assert(success);
+ }
+ for(unsigned int i = 0; i < 2; ++i){
+  success = exatn::destroyTensorSync("H"+std::to_string(i)); assert(success);
+ }
+ for(unsigned int i = 0; i < 3; ++i){
+  success = exatn::destroyTensorSync("V"+std::to_string(i)); assert(success);
+ }
+
+ exatn::sync();
+}
+#endif
+
+#ifdef EXATN_TEST24
+TEST(NumServerTester, ReverseGradientNumServer)
+{
+ using exatn::Tensor;
+ using exatn::TensorShape;
+ using exatn::TensorNetwork;
+ using exatn::TensorExpansion;
+ using exatn::TensorElementType;
+
+ exatn::resetRuntimeLoggingLevel(0); //debug
+
+ bool success = true;
+
+ //Declare the MPS tensors of the ket (A) and bra (B):
+ std::vector<std::shared_ptr<Tensor>> ket_tensors{
+  std::make_shared<Tensor>("A0",TensorShape{2,4}),
+  std::make_shared<Tensor>("A1",TensorShape{4,2,4}),
+  std::make_shared<Tensor>("A2",TensorShape{4,2,4}),
+  std::make_shared<Tensor>("A3",TensorShape{4,2})};
+ std::vector<std::shared_ptr<Tensor>> bra_tensors{
+  std::make_shared<Tensor>("B0",TensorShape{2,4}),
+  std::make_shared<Tensor>("B1",TensorShape{4,2,4}),
+  std::make_shared<Tensor>("B2",TensorShape{4,2,4}),
+  std::make_shared<Tensor>("B3",TensorShape{4,2})};
+ auto z0 = std::make_shared<Tensor>("Z0");
+
+ //Declare the closed MPS overlap functional:
+ auto overlap = exatn::makeSharedTensorNetwork("Overlap",
+  "Z0()+=B0+(i0,k0)*B1+(k0,i1,k1)*B2+(k1,i2,k2)*B3+(k2,i3)*A0(i0,j0)*A1(j0,i1,j1)*A2(j1,i2,j2)*A3(j2,i3)",
+  std::map<std::string,std::shared_ptr<Tensor>>{
+   {"Z0",z0}, {"A0",ket_tensors[0]}, {"A1",ket_tensors[1]}, {"A2",ket_tensors[2]}, {"A3",ket_tensors[3]},
+   {"B0",bra_tensors[0]}, {"B1",bra_tensors[1]}, {"B2",bra_tensors[2]}, {"B3",bra_tensors[3]}});
+ TensorExpansion functional;
+ success = functional.appendComponent(overlap,{0.5,0.0}); assert(success);
+
+ //Create and initialize tensors:
+ std::map<std::string,std::string> gradients;
+ for(auto tensor: ket_tensors){
+  success = exatn::createTensorSync(tensor,TensorElementType::REAL64); assert(success);
+  success = exatn::initTensorRndSync(tensor->getName()); assert(success);
+  success = exatn::createTensorSync("G"+tensor->getName(),TensorElementType::REAL64,tensor->getShape()); assert(success);
+  success = exatn::createTensorSync("D"+tensor->getName(),TensorElementType::REAL64,tensor->getShape()); assert(success);
+  gradients.emplace(std::make_pair(tensor->getName(),"G"+tensor->getName()));
+ }
+ for(auto tensor: bra_tensors){
+  success = exatn::createTensorSync(tensor,TensorElementType::REAL64); assert(success);
+  success = exatn::initTensorRndSync(tensor->getName()); assert(success);
+ }
+
+ //Evaluate the reference gradients via the derivative tensor network expansions:
+ for(auto tensor: ket_tensors){
+  TensorExpansion derivative(functional,tensor->getName(),false);
+  success = exatn::initTensorSync("D"+tensor->getName(),0.0); assert(success);
+  success = exatn::evaluateSync(derivative,exatn::getTensor("D"+tensor->getName())); assert(success);
+ }
+
+ //Evaluate all gradients in a single pass without and with checkpointing:
+ for(const std::size_t checkpoint_volume: {std::size_t{0}, std::size_t{16}}){
+  success = exatn::evaluateGradientsSync(functional,gradients,false,checkpoint_volume); assert(success);
+  for(auto tensor: ket_tensors){
+   std::string add_pattern;
+   success = exatn::generate_addition_pattern(tensor->getRank(),add_pattern,false,
+                                              "G"+tensor->getName(),"D"+tensor->getName()); assert(success);
+   success = exatn::addTensorsSync(add_pattern,-1.0); assert(success);
+   double norm = 0.0, diff = 0.0;
+   success = exatn::computeNorm2Sync("D"+tensor->getName(),norm); assert(success);
+   success = exatn::computeNorm2Sync("G"+tensor->getName(),diff); assert(success);
+   std::cout << "Gradient w.r.t. " << tensor->getName() << " (checkpoint volume " << checkpoint_volume
+             << "): Norm = " << norm << "; Difference norm = " << diff << std::endl;
+   EXPECT_NEAR(diff,0.0,1e-10*norm);
+  }
+ }
+
+ //Destroy tensors:
+ for(auto tensor: bra_tensors){
+  success = exatn::destroyTensorSync(tensor->getName()); assert(success);
+ }
+ for(auto tensor: ket_tensors){
+  success = exatn::destroyTensorSync("D"+tensor->getName()); assert(success);
+  success = exatn::destroyTensorSync("G"+tensor->getName()); assert(success);
+  success = exatn::destroyTensorSync(tensor->getName()); assert(success);
+ }
+
+ exatn::sync();
+}
+#endif
+#ifdef EXATN_TEST25
+TEST(NumServerTester, TruncatedSVDNumServer)
+{
+ using exatn::TensorShape;
+ using exatn::TensorElementType;
+ using exatn::SVDTruncation;
+ using exatn::SVDAbsorb;
+
+ exatn::resetRuntimeLoggingLevel(0); //debug
+
+ bool success = true;
+
+ success = exatn::createTensorSync("D",TensorElementType::REAL64,TensorShape{8,8,8,8}); assert(success);
+ success = exatn::createTensorSync("E",TensorElementType::REAL64,TensorShape{8,8,8,8}); assert(success);
+ success = exatn::initTensorRndSync("D"); assert(success);
+ double norm = 0.0;
+ success = exatn::computeNorm2Sync("D",norm); assert(success);
+
+ //Relative squared norm of the difference between the decomposed tensor and its reconstruction:
+ auto residual = [norm](const std::string & reconstruction){
+  bool done = exatn::initTensorSync("E",0.0); assert(done);
+  done = exatn::evaluateTensorNetworkSync("Reconstruction","E(a,b,c,d)=" + reconstruction); assert(done);
+  done = exatn::addTensorsSync("E(a,b,c,d)+=D(a,b,c,d)",-1.0); assert(done);
+  double diff = 0.0;
+  done = exatn::computeNorm2Sync("E",diff); assert(done);
+  return (diff * diff) / (norm * norm);
+ };
+
+ //Full-rank three-factor SVD is exact:
+ SVDTruncation truncation;
+ std::size_t rank = 0;
+ double discarded = 0.0;
+ success = exatn::decomposeTensorSVDTruncSync("D(a,b,c,d)=L(a,b,i)*S(i,j)*R(c,d,j)",truncation,&rank,&discarded); assert(success);
+ EXPECT_EQ(rank,64);
+ EXPECT_NEAR(discarded,0.0,1e-12);
+ EXPECT_NEAR(residual("L(a,b,i)*S(i,j)*R(c,d,j)"),0.0,1e-12);
+ success = exatn::destroyTensorSync("R"); assert(success);
+ success = exatn::destroyTensorSync("S"); assert(success);
+ success = exatn::destroyTensorSync("L"); assert(success);
+
+ //Deterministic and randomized two-factor SVD truncated to rank 16:
+ truncation.max_rank = 16;
+ truncation.absorb = SVDAbsorb::BOTH;
+ for(const bool randomized: {false, true}){
+  truncation.randomized = randomized;
+  success = exatn::decomposeTensorSVDTruncSync("D(a,b,c,d)=L(c,a,i)*R(d,i,b)",truncation,&rank,&discarded); assert(success);
+  std::cout << "Truncated SVD (randomized = " << randomized << "): Rank = " << rank
+            << "; Discarded weight = " << discarded << std::endl;
+  EXPECT_EQ(rank,16);
+  EXPECT_NEAR(residual("L(c,a,i)*R(d,i,b)"),discarded,1e-10);
+  success = exatn::destroyTensorSync("R"); assert(success);
+  success = exatn::destroyTensorSync("L"); assert(success);
+ }
+
+ //Two-factor SVD without absorbing the singular values is rejected:
+ truncation.absorb = SVDAbsorb::NONE;
+ EXPECT_FALSE(exatn::decomposeTensorSVDTruncSync("D(a,b,c,d)=L(c,a,i)*R(d,i,b)",truncation));
+ truncation.absorb = SVDAbsorb::RIGHT; //the rejected call must not have created the tensor factors
+ success = exatn::decomposeTensorSVDTruncSync("D(a,b,c,d)=L(c,a,i)*R(d,i,b)",truncation); assert(success);
+ success = exatn::destroyTensorSync("R"); assert(success);
+ success = exatn::destroyTensorSync("L"); assert(success);
+
+ success = exatn::destroyTensorSync("E"); assert(success);
+ success = exatn::destroyTensorSync("D"); assert(success);
+
+ exatn::sync();
+}
+#endif
+
+
+#ifdef EXATN_TEST26
+TEST(NumServerTester, TEBDGateSVDNumServer)
+{
+ using exatn::TensorShape;
+ using exatn::TensorElementType;
+ using exatn::SVDTruncation;
+ using exatn::SVDAbsorb;
+
+ const unsigned int num_sites = 100; //length of the MPS chain
+ const exatn::DimExtent bond_dim = 16; //max MPS bond dimension
+ const exatn::DimExtent phys_dim = 2;  //site dimension
+
+ exatn::resetRuntimeLoggingLevel(0); //debug
+
+ bool success = true;
+
+ //Create two identical copies of a random MPS (Q: fused gate application, P: unfused):
+ for(unsigned int site = 0; site < num_sites; ++site){
+  const exatn::DimExtent left_dim = (site == 0) ? 1 : bond_dim;
+  const exatn::DimExtent right_dim = (site == num_sites - 1) ? 1 : bond_dim;
+  const auto qname = "Q" + std::to_string(site);
+  const auto pname = "P" + std::to_string(site);
+  success = exatn::createTensorSync(qname,TensorElementType::REAL64,TensorShape{left_dim,phys_dim,right_dim}); assert(success);
+  success = exatn::createTensorSync(pname,TensorElementType::REAL64,TensorShape{left_dim,phys_dim,right_dim}); assert(success);
+  success = exatn::initTensorRndSync(qname); assert(success);
+  success = exatn::initTensorSync(pname,0.0); assert(success);
+  success = exatn::addTensorsSync(pname + "(a,i,b)+=" + qname + "(a,i,b)",1.0); assert(success);
+ }
+ success = exatn::createTensorSync("G",TensorElementType::REAL64,TensorShape{phys_dim,phys_dim,phys_dim,phys_dim}); assert(success);
+ success = exatn::initTensorRndSync("G"); assert(success);
+
+ SVDTruncation truncation;
+ truncation.max_rank = bond_dim;
+ truncation.absorb = SVDAbsorb::RIGHT;
+
+ //One TEBD step (even bonds, then odd bonds) with the fused two-site gate application:
+ std::vector<double> fused_weights;
+ exatn::sync();
+ auto time_start = exatn::Timer::timeInSecHR();
+ for(unsigned int parity = 0; parity < 2; ++parity){
+  for(unsigned int site = parity; site < num_sites - 1; site += 2){
+   const auto left = "Q" + std::to_string(site);
+   const auto right = "Q" + std::to_string(site + 1);
+   double discarded = 0.0;
+   success = exatn::applyTwoSiteGateSVDSync("T(a,k,l,c)=" + left + "(a,i,b)*" + right + "(b,j,c)*G(i,j,k,l)",
+                                            truncation,nullptr,&discarded); assert(success);
+   fused_weights.emplace_back(discarded);
+  }
+ }
+ exatn::sync();
+ auto duration = exatn::Timer::timeInSecHR(time_start);
+ const double fused_time = duration / static_cast<double>(fused_weights.size());
+
+ //The same TEBD step via separate tensor operations (contraction, decomposition, copy back):
+ std::vector<double> unfused_weights;
+ exatn::sync();
+ time_start = exatn::Timer::timeInSecHR();
+ for(unsigned int parity = 0; parity < 2; ++parity){
+  for(unsigned int site = parity; site < num_sites - 1; site += 2){
+   const auto left = "P" + std::to_string(site);
+   const auto right = "P" + std::to_string(site + 1);
+   const exatn::DimExtent left_dim = (site == 0) ? 1 : bond_dim;
+   const exatn::DimExtent right_dim = (site + 1 == num_sites - 1) ? 1 : bond_dim;
+   double discarded = 0.0;
+   success = exatn::createTensorSync("T",TensorElementType::REAL64,TensorShape{left_dim,phys_dim,phys_dim,right_dim}); assert(success);
+   success = exatn::initTensorSync("T",0.0); assert(success);
+   success = exatn::evaluateTensorNetworkSync("Theta","T(a,k,l,c)=" + left + "(a,i,b)*" + right + "(b,j,c)*G(i,j,k,l)"); assert(success);
+   success = exatn::decomposeTensorSVDTruncSync("T(a,k,l,c)=X(a,k,b)*Y(b,l,c)",truncation,nullptr,&discarded); assert(success);
+   success = exatn::initTensorSync(left,0.0); assert(success);
+   success = exatn::initTensorSync(right,0.0); assert(success);
+   success = exatn::insertTensorSliceSync(left,"X"); assert(success);
+   success = exatn::insertTensorSliceSync(right,"Y"); assert(success);
+   success = exatn::destroyTensorSync("Y"); assert(success);
+   success = exatn::destroyTensorSync("X"); assert(success);
+   success = exatn::destroyTensorSync("T"); assert(success);
+   unfused_weights.emplace_back(discarded);
+  }
+ }
+ exatn::sync();
+ duration = exatn::Timer::timeInSecHR(time_start);
+ const double unfused_time = duration / static_cast<double>(unfused_weights.size());
+
+ std::cout << "TEBD step on a " << num_sites << "-site MPS chain (bond dimension " << bond_dim << "): Time per gate (sec): "
+           << "Fused = " << fused_time << "; Unfused = " << unfused_time << std::endl;
+
+ //Both paths must produce the same truncation (the MPS tensors only differ by a gauge):
+ EXPECT_EQ(fused_weights.size(),unfused_weights.size());
+ for(std::size_t i = 0; i < fused_weights.size(); ++i) EXPECT_NEAR(fused_weights[i],unfused_weights[i],1e-8);
+
+ //Conjugated operands and two-site tensors not matching the open indices are rejected:
+ EXPECT_FALSE(exatn::applyTwoSiteGateSVDSync("T(a,k,l,c)=Q0(a,i,b)*Q1(b,j,c)*G+(i,j,k,l)",truncation));
+ EXPECT_FALSE(exatn::applyTwoSiteGateSVDSync("T(a,k,l,c)=Q0+(a,i,b)*Q1(b,j,c)*G(i,j,k,l)",truncation));
+ EXPECT_FALSE(exatn::applyTwoSiteGateSVDSync("T(a,i,l,c)=Q0(a,i,b)*Q1(b,j,c)*G(i,j,k,l)",truncation));
+ EXPECT_FALSE(exatn::applyTwoSiteGateSVDSync("T(a,k,k,c)=Q0(a,i,b)*Q1(b,j,c)*G(i,j,k,l)",truncation));
+ EXPECT_FALSE(exatn::applyTwoSiteGateSVDSync("T(a,k,l)=Q0(a,i,b)*Q1(b,j,c)*G(i,j,k,l)",truncation));
+
+ success = exatn::destroyTensorSync("G"); assert(success);
+ for(unsigned int site = 0; site < num_sites; ++site){
+  success = exatn::destroyTensorSync("P" + std::to_string(site)); assert(success);
+  success = exatn::destroyTensorSync("Q" + std::to_string(site)); assert(success);
+ }
+
+ exatn::sync();
+}
+#endif
+
+
+#ifdef EXATN_TEST27
+TEST(NumServerTester, MPSZipperNumServer)
+{
+ using exatn::Tensor;
+ using exatn::TensorShape;
+ using exatn::TensorNetwork;
+ using exatn::TensorOperator;
+ using exatn::TensorExpansion;
+ using exatn::TensorElementType;
+
+ const unsigned int num_sites = 16; //number of MPS sites
+ const int max_bond_dim = 32;        //max MPS bond dimension
+
+ exatn::resetRuntimeLoggingLevel(0); //debug
+
+ bool success = true;
+
+ //Nearest-neighbor Hamiltonian with 1-body terms:
+ TensorOperator ham("Hamiltonian");
+ for(unsigned int i = 0; i < num_sites; ++i){
+  auto u = std::make_shared<Tensor>("U" + std::to_string(i),TensorShape{2,2});
+  success = exatn::createTensorSync(u,TensorElementType::COMPLEX64); assert(success);
+  success = exatn::initTensorRndSync(u->getName()); assert(success);
+  success = ham.appendComponent(u,{{i,0}},{{i,1}},{1.0,0.0}); assert(success);
+  if(i + 1 < num_sites){
+   auto t = std::make_shared<Tensor>("T" + std::to_string(i),TensorShape{2,2,2,2});
+   success = exatn::createTensorSync(t,TensorElementType::COMPLEX64); assert(success);
+   success = exatn::initTensorRndSync(t->getName()); assert(success);
+   success = ham.appendComponent(t,{{i,0},{i+1,1}},{{i,2},{i+1,3}},{1.0,0.0}); assert(success);
+  }
+ }
+
+ //Random MPS:
+ auto & network_build_factory = *(exatn::NetworkBuildFactory::get());
+ auto builder = network_build_factory.createNetworkBuilderShared("MPS");
+ success = builder->setParameter("max_bond_dim",max_bond_dim); assert(success);
+ auto mps = exatn::makeSharedTensorNetwork("MPS",
+                                           std::make_shared<Tensor>("Z",std::vector<exatn::DimExtent>(num_sites,2)),
+                                           *builder);
+ for(auto iter = mps->cbegin(); iter != mps->cend(); ++iter){
+  if(iter->first != 0){
+   success = exatn::createTensorSync(iter->second.getTensor(),TensorElementType::COMPLEX64); assert(success);
+   success = exatn::initTensorRndSync(iter->second.getName()); assert(success);
+  }
+ }
+ TensorExpansion ket;
+ success = ket.appendComponent(mps,{1.0,0.0}); assert(success);
+ ket.rename("MPSket");
+ TensorExpansion bra(ket);
+ bra.conjugate();
+ bra.rename("MPSbra");
+
+ success = exatn::createTensorSync("AC0",TensorElementType::COMPLEX64,TensorShape{}); assert(success);
+ success = exatn::createTensorSync("AC1",TensorElementType::COMPLEX64,TensorShape{}); assert(success);
+ success = exatn::initTensorSync("AC0",0.0); assert(success);
+ success = exatn::initTensorSync("AC1",0.0); assert(success);
+
+ //Expectation value via the MPS zipper:
+ exatn::sync();
+ auto time_start = exatn::Timer::timeInSecHR();
+ success = exatn::evaluateExpectationSync(bra,ket,ham,exatn::getTensor("AC0")); assert(success);
+ auto zipper_time = exatn::Timer::timeInSecHR(time_start);
+
+ //Expectation value via the generic tensor network expansion evaluation:
+ TensorExpansion closed(bra,ket,ham);
+ closed.rename("MPSbraHamMPSket");
+ time_start = exatn::Timer::timeInSecHR();
+ success = exatn::evaluateSync(closed,exatn::getTensor("AC1")); assert(success);
+ auto generic_time = exatn::Timer::timeInSecHR(time_start);
+
+ auto get_value = [](const std::string & name){
+  auto talsh_tensor = exatn::getLocalTensor(name);
+  const std::complex<double> * body_ptr;
+  auto access_granted = talsh_tensor->getDataAccessHostConst(&body_ptr); assert(access_granted);
+  return *body_ptr;
+ };
+ const auto zipper_value = get_value("AC0");
+ const auto generic_value = get_value("AC1");
+ std::cout << "Expectation value: MPS zipper = " << zipper_value << " (" << zipper_time << " sec); Generic = "
+           << generic_value << " (" << generic_time << " sec)" << std::endl;
+ EXPECT_NEAR(std::abs(zipper_value - generic_value),0.0,1e-6 * std::abs(generic_value));
+
+ success = exatn::destroyTensorSync("AC1"); assert(success);
+ success = exatn::destroyTensorSync("AC0"); assert(success);
+ for(auto iter = mps->cbegin(); iter != mps->cend(); ++iter){
+  if(iter->first != 0){
+   success = exatn::destroyTensorSync(iter->second.getName()); assert(success);
+  }
+ }
+ for(unsigned int i = 0; i < num_sites; ++i){
+  success = exatn::destroyTensorSync("U" + std::to_string(i)); assert(success);
+  if(i + 1 < num_sites){
+   success = exatn::destroyTensorSync("T" + std::to_string(i)); assert(success);
+  }
+ }
+
+ exatn::sync();
+}
+#endif
+
+
+#ifdef EXATN_TEST28
+TEST(NumServerTester, OperatorGroupingNumServer)
+{
+ using exatn::Tensor;
+ using exatn::TensorShape;
+ using exatn::TensorNetwork;
+ using exatn::TensorOperator;
+ using exatn::TensorExpansion;
+ using exatn::TensorElementType;
+
+ const unsigned int num_sites = 12; //number of MPS sites
+ const int max_bond_dim = 16;        //max MPS bond dimension
+
+ exatn::resetRuntimeLoggingLevel(0); //debug
+
+ bool success = true;
+
+ //Hamiltonian with three 2-body terms per bond (one with permuted legs) and two 1-body terms per site:
+ const std::vector<std::string> bond_terms{"XX","YY","ZZ"};
+ const std::vector<std::string> site_terms{"X","Z"};
+ TensorOperator ham("Hamiltonian");
+ for(unsigned int i = 0; i < num_sites; ++i){
+  for(const auto & term: site_terms){
+   auto u = std::make_shared<Tensor>(term + std::to_string(i),TensorShape{2,2});
+   success = exatn::createTensorSync(u,TensorElementType::COMPLEX64); assert(success);
+   success = exatn::initTensorRndSync(u->getName()); assert(success);
+   success = ham.appendComponent(u,{{i,0}},{{i,1}},{0.5,0.0}); assert(success);
+  }
+  if(i + 1 < num_sites){
+   for(const auto & term: bond_terms){
+    auto t = std::make_shared<Tensor>(term + std::to_string(i),TensorShape{2,2,2,2});
+    success = exatn::createTensorSync(t,TensorElementType::COMPLEX64); assert(success);
+    success = exatn::initTensorRndSync(t->getName()); assert(success);
+    if(term == "YY"){
+     success = ham.appendComponent(t,{{i+1,1},{i,0}},{{i+1,3},{i,2}},{0.0,1.0}); assert(success);
+    }else{
+     success = ham.appendComponent(t,{{i,0},{i+1,1}},{{i,2},{i+1,3}},{1.0,0.0}); assert(success);
+    }
+   }
+  }
+ }
+
+ //Grouped Hamiltonian:
+ TensorOperator grouped_ham("GroupedHamiltonian");
+ std::vector<std::string> group_tensors;
+ success = exatn::groupTensorOperatorSync(ham,grouped_ham,&group_tensors); assert(success);
+ std::cout << "Number of Hamiltonian components: " << ham.getNumComponents() << " --> "
+           << grouped_ham.getNumComponents() << " (" << group_tensors.size() << " group tensors)" << std::endl;
+ EXPECT_EQ(grouped_ham.getNumComponents(),num_sites + (num_sites - 1));
+ EXPECT_EQ(group_tensors.size(),grouped_ham.getNumComponents());
+
+ //Random MPS:
+ auto & network_build_factory = *(exatn::NetworkBuildFactory::get());
+ auto builder = network_build_factory.createNetworkBuilderShared("MPS");
+ success = builder->setParameter("max_bond_dim",max_bond_dim); assert(success);
+ auto mps = exatn::makeSharedTensorNetwork("MPS",
+                                           std::make_shared<Tensor>("Z",std::vector<exatn::DimExtent>(num_sites,2)),
+                                           *builder);
+ for(auto iter = mps->cbegin(); iter != mps->cend(); ++iter){
+  if(iter->first != 0){
+   success = exatn::createTensorSync(iter->second.getTensor(),TensorElementType::COMPLEX64); assert(success);
+   success = exatn::initTensorRndSync(iter->second.getName()); assert(success);
+  }
+ }
+ TensorExpansion ket;
+ success = ket.appendComponent(mps,{1.0,0.0}); assert(success);
+ ket.rename("MPSket");
+ TensorExpansion bra(ket);
+ bra.conjugate();
+ bra.rename("MPSbra");
+
+ success = exatn::createTensorSync("AC0",TensorElementType::COMPLEX64,TensorShape{}); assert(success);
+ success = exatn::createTensorSync("AC1",TensorElementType::COMPLEX64,TensorShape{}); assert(success);
+ success = exatn::initTensorSync("AC0",0.0); assert(success);
+ success = exatn::initTensorSync("AC1",0.0); assert(success);
+
+ //Expectation value of the original Hamiltonian:
+ exatn::sync();
+ auto time_start = exatn::Timer::timeInSecHR();
+ success = exatn::evaluateExpectationSync(bra,ket,ham,exatn::getTensor("AC0")); assert(success);
+ auto original_time = exatn::Timer::timeInSecHR(time_start);
+
+ //Expectation value of the grouped Hamiltonian:
+ time_start = exatn::Timer::timeInSecHR();
+ success = exatn::evaluateExpectationSync(bra,ket,grouped_ham,exatn::getTensor("AC1")); assert(success);
+ auto grouped_time = exatn::Timer::timeInSecHR(time_start);
+
+ auto get_value = [](const std::string & name){
+  auto talsh_tensor = exatn::getLocalTensor(name);
+  const std::complex<double> * body_ptr;
+  auto access_granted = talsh_tensor->getDataAccessHostConst(&body_ptr); assert(access_granted);
+  return *body_ptr;
+ };
+ const auto original_value = get_value("AC0");
+ const auto grouped_value = get_value("AC1");
+ std::cout << "Expectation value: Original = " << original_value << " (" << original_time << " sec); Grouped = "
+           << grouped_value << " (" << grouped_time << " sec)" << std::endl;
+ EXPECT_NEAR(std::abs(grouped_value - original_value),0.0,1e-6 * std::abs(original_value));
+
+ success = exatn::destroyTensorSync("AC1"); assert(success);
+ success = exatn::destroyTensorSync("AC0"); assert(success);
+ for(const auto & name: group_tensors){
+  success = exatn::destroyTensorSync(name); assert(success);
+ }
+ for(auto iter = mps->cbegin(); iter != mps->cend(); ++iter){
+  if(iter->first != 0){
+   success = exatn::destroyTensorSync(iter->second.getName()); assert(success);
+  }
+ }
+ for(unsigned int i = 0; i < num_sites; ++i){
+  for(const auto & term: site_terms){
+   success = exatn::destroyTensorSync(term + std::to_string(i)); assert(success);
+  }
+  if(i + 1 < num_sites){
+   for(const auto & term: bond_terms){
+    success = exatn::destroyTensorSync(term + std::to_string(i)); assert(success);
+   }
+  }
+ }
+
+ exatn::sync();
+}
+#endif
+
+
+#ifdef EXATN_TEST29
+TEST(NumServerTester, BlockDavidsonNumServer)
+{
+ using exatn::Tensor;
+ using exatn::TensorShape;
+ using exatn::TensorNetwork;
+ using exatn::TensorOperator;
+ using exatn::TensorExpansion;
+ using exatn::TensorElementType;
+
+ exatn::resetRuntimeLoggingLevel(0); //debug
+
+ //Define Ising Hamiltonian constants:
+ constexpr std::complex<double> ZERO{0.0,0.0};
+ constexpr std::complex<double> HAMT{-1.0,0.0};
+ constexpr std::complex<double> HAMU{-2.0,0.0};
+
+ //Ising Hamiltonian tensor elements:
+ std::vector<std::complex<double>> hamt { //Sigma_Z_i X Sigma_Z_(i+1)
+  HAMT,  ZERO,  ZERO,  ZERO,
+  ZERO, -HAMT,  ZERO,  ZERO,
+  ZERO,  ZERO, -HAMT,  ZERO,
+  ZERO,  ZERO,  ZERO,  HAMT
+ };
+ std::vector<std::complex<double>> hamu { //Sigma_X_i
+  ZERO,  HAMU,
+  HAMU,  ZERO
+ };
+
+ bool success = true;
+
+ //Ising Hamiltonian on 4 sites:
+ auto ham = std::make_shared<TensorOperator>("Hamiltonian");
+ for(unsigned int i = 0; i < 4; ++i){
+  auto u = std::make_shared<Tensor>("U" + std::to_string(i),TensorShape{2,2});
+  success = exatn::createTensorSync(u,TensorElementType::COMPLEX64); assert(success);
+  success = exatn::initTensorDataSync(u->getName(),hamu); assert(success);
+  success = ham->appendComponent(u,{{i,0}},{{i,1}},{1.0,0.0}); assert(success);
+  if(i < 3){
+   auto t = std::make_shared<Tensor>("T" + std::to_string(i),TensorShape{2,2,2,2});
+   success = exatn::createTensorSync(t,TensorElementType::COMPLEX64); assert(success);
+   success = exatn::initTensorDataSync(t->getName(),hamt); assert(success);
+   success = ham->appendComponent(t,{{i,0},{i+1,1}},{{i,2},{i+1,3}},{1.0,0.0}); assert(success);
+  }
+ }
+
+ //4-site MPS form of the eigenvectors (exact with bond dimension 4):
+ auto & network_build_factory = *(exatn::NetworkBuildFactory::get());
+ auto builder = network_build_factory.createNetworkBuilderShared("MPS");
+ success = builder->setParameter("max_bond_dim",4); assert(success);
+ auto mps = exatn::makeSharedTensorNetwork("MPS",
+                                           std::make_shared<Tensor>("Z",TensorShape{2,2,2,2}),
+                                           *builder);
+ mps->markOptimizableTensors([](const Tensor & tensor){return true;});
+ for(auto iter = mps->cbegin(); iter != mps->cend(); ++iter){
+  if(iter->first != 0){
+   success = exatn::createTensorSync(iter->second.getTensor(),TensorElementType::COMPLEX64); assert(success);
+   success = exatn::initTensorRndSync(iter->second.getName()); assert(success);
+  }
+ }
+ auto guess = std::make_shared<TensorExpansion>();
+ success = guess->appendComponent(mps,{1.0,0.0}); assert(success);
+
+ //Two lowest eigenroots by the block Davidson procedure:
+ const unsigned int num_roots = 2;
+ exatn::TensorNetworkEigenSolver eigensolver(ham,guess,1e-4);
+ const std::vector<double> * accuracy = nullptr;
+ success = eigensolver.solve(num_roots,&accuracy); assert(success);
+ for(const auto & metrics: eigensolver.getIterationMetrics()){
+  std::cout << "Subspace dimension " << metrics.subspace_dim << ": Converged roots = " << metrics.num_converged
+            << "; Eigenvalues/residuals:";
+  for(unsigned int root = 0; root < num_roots; ++root)
+   std::cout << " " << metrics.eigenvalues[root].real() << "/" << metrics.residual_norms[root];
+  std::cout << "; Time = " << metrics.iteration_time << " sec (evaluation " << metrics.evaluation_time << " sec)" << std::endl;
+ }
+ const std::vector<double> reference{-8.37679863685,-5.86584450625};
+ for(unsigned int root = 0; root < num_roots; ++root){
+  std::complex<double> eigenvalue;
+  double root_accuracy = 0.0;
+  auto eigenvector = eigensolver.getEigenRoot(root,&eigenvalue,&root_accuracy);
+  EXPECT_TRUE(eigenvector != nullptr);
+  EXPECT_EQ(root_accuracy,(*accuracy)[root]);
+  EXPECT_NEAR(eigenvalue.real(),reference[root],1e-4);
+ }
+ success = eigensolver.destroyBasis(); assert(success);
+
+ for(auto iter = mps->cbegin(); iter != mps->cend(); ++iter){
+  if(iter->first != 0){
+   success = exatn::destroyTensorSync(iter->second.getName()); assert(success);
+  }
+ }
+ for(unsigned int i = 0; i < 4; ++i){
+  success = exatn::destroyTensorSync("U" + std::to_string(i)); assert(success);
+  if(i < 3){
+   success = exatn::destroyTensorSync("T" + std::to_string(i)); assert(success);
+  }
+ }
+
+ exatn::sync();
+}
+#endif
+
+
+#ifdef EXATN_TEST30
+TEST(NumServerTester, BoundaryMPSNumServer)
+{
+ using exatn::Tensor;
+ using exatn::TensorNetwork;
+ using exatn::TensorElementType;
+
+ exatn::resetRuntimeLoggingLevel(0); //debug
+
+ const unsigned int num_rows = 4;
+ const unsigned int num_cols = 4;
+ const int bond_dim = 2;
+
+ bool success = true;
+
+ //Random PEPS on a 4x4 grid:
+ auto & network_build_factory = *(exatn::NetworkBuildFactory::get());
+ auto builder = network_build_factory.createNetworkBuilderShared("PEPS");
+ success = builder->setParameter("max_bond_dim",bond_dim); assert(success);
+ success = builder->setParameter("num_rows",num_rows); assert(success);
+ auto peps = exatn::makeSharedTensorNetwork("PEPS",
+                                            std::make_shared<Tensor>("Z",std::vector<exatn::DimExtent>(num_rows*num_cols,2)),
+                                            *builder);
+ for(auto iter = peps->cbegin(); iter != peps->cend(); ++iter){
+  if(iter->first != 0){
+   success = exatn::createTensorSync(iter->second.getTensor(),TensorElementType::COMPLEX64); assert(success);
+   success = exatn::initTensorRndSync(iter->second.getName()); assert(success);
+  }
+ }
+
+ //Pauli Z operator:
+ success = exatn::createTensorSync("PZ",TensorElementType::COMPLEX64,exatn::TensorShape{2,2}); assert(success);
+ success = exatn::initTensorDataSync("PZ",std::vector<std::complex<double>>{{1.0,0.0},{0.0,0.0},{0.0,0.0},{-1.0,0.0}});
+ assert(success);
+ const std::map<unsigned int, std::string> site_operators{{num_cols + 1,"PZ"}};
+
+ //Reference values from the exact contraction:
+ exatn::BoundaryMPS boundary_mps(peps,num_rows,1);
+ EXPECT_TRUE(boundary_mps.isApplicable());
+ std::complex<double> exact_norm, exact_value;
+ success = boundary_mps.evaluateNorm(&exact_norm,true); assert(success);
+ const auto exact_metrics = boundary_mps.getMetrics();
+ success = boundary_mps.evaluateExpectation(site_operators,&exact_value,true); assert(success);
+ std::cout << "Exact contraction: Norm = " << exact_norm << "; <Z> = " << (exact_value / exact_norm)
+           << "; FMA flops = " << exact_metrics.fma_flops << "; Time (sec) = " << exact_metrics.time << std::endl;
+
+ //Accuracy/cost tradeoff of the boundary MPS bond dimension:
+ for(std::size_t max_bond_dim: {1,4,16,64}){
+  boundary_mps.resetMaxBondDim(max_bond_dim);
+  std::complex<double> norm, value;
+  success = boundary_mps.evaluateNorm(&norm); assert(success);
+  const auto metrics = boundary_mps.getMetrics();
+  success = boundary_mps.evaluateExpectation(site_operators,&value); assert(success);
+  const double error = std::abs(norm - exact_norm) / std::abs(exact_norm);
+  std::cout << "Boundary MPS with chi = " << max_bond_dim << ": Norm relative error = " << error
+            << "; <Z> = " << (value / norm) << "; FMA flops = " << metrics.fma_flops
+            << "; Achieved chi = " << metrics.max_bond_dim << "; Discarded weight = " << metrics.discarded_weight
+            << "; Time (sec) = " << metrics.time << std::endl;
+  EXPECT_LE(metrics.max_bond_dim,max_bond_dim);
+  if(max_bond_dim == 64){ //exact for a 4x4 grid with bond dimension 2
+   EXPECT_NEAR(error,0.0,1e-8);
+   EXPECT_NEAR(std::abs(value - exact_value) / std::abs(exact_norm),0.0,1e-8);
+  }
+ }
+
+ success = exatn::destroyTensorSync("PZ"); assert(success);
+ for(auto iter = peps->cbegin(); iter != peps->cend(); ++iter){
+  if(iter->first != 0){
+   success = exatn::destroyTensorSync(iter->second.getName()); assert(success);
+  }
+ }
+
+ exatn::sync();
+}
+#endif
+
+
+#ifdef EXATN_TEST31
+TEST(NumServerTester, SliceInvariantHoistingNumServer)
+{
+ using exatn::Tensor;
+ using exatn::TensorShape;
+ using exatn::TensorNetwork;
+ using exatn::TensorElementType;
+ using exatn::numerics::ContrTriple;
+ using exatn::numerics::SliceDependence;
+
+ exatn::resetRuntimeLoggingLevel(0); //debug
+
+ bool success = true;
+
+ //V(k) = B(k,l,n)*C(l,m,n)*D(m) does not depend on the split indices of A(i,j,k)*V(k)*E(j):
+ const exatn::DimExtent ext = 256, ext_small = 16;
+ auto z0 = std::make_shared<Tensor>("Z0",TensorShape{ext});
+ auto z1 = std::make_shared<Tensor>("Z1",TensorShape{ext});
+ std::map<std::string,std::shared_ptr<Tensor>> tensors{
+  {"A",std::make_shared<Tensor>("A",TensorShape{ext,ext,ext_small})},
+  {"B",std::make_shared<Tensor>("B",TensorShape{ext_small,ext_small,ext_small})},
+  {"C",std::make_shared<Tensor>("C",TensorShape{ext_small,ext_small,ext_small})},
+  {"D",std::make_shared<Tensor>("D",TensorShape{ext_small})},
+  {"E",std::make_shared<Tensor>("E",TensorShape{ext})}};
+ for(auto & tensor: tensors){
+  success = exatn::createTensorSync(tensor.second,TensorElementType::REAL64); assert(success);
+  success = exatn::initTensorRndSync(tensor.first); assert(success);
+ }
+ success = exatn::createTensorSync(z0,TensorElementType::REAL64); assert(success);
+ success = exatn::createTensorSync(z1,TensorElementType::REAL64); assert(success);
+
+ //Fixed contraction sequence: (C*D)*B first, then A, then E:
+ const std::list<ContrTriple> contr_seq{{6,3,4},{7,2,6},{8,1,7},{0,8,5}};
+ const double contr_seq_flops = static_cast<double>(ext_small*ext_small*ext_small*2 + ext*ext*ext_small + ext*ext);
+
+ //Reference evaluation without index splitting:
+ tensors["Z0"] = z0;
+ TensorNetwork network0("HoistingReference","Z0(i)+=A(i,j,k)*B(k,l,n)*C(l,m,n)*D(m)*E(j)",tensors);
+ network0.importContractionSequence(contr_seq,contr_seq_flops);
+ success = exatn::evaluateSync(network0); assert(success);
+ const auto stats0 = exatn::numericalServer->getLastNetworkExecStats();
+ EXPECT_EQ(stats0.num_split_indices,0U);
+ EXPECT_EQ(stats0.num_hoisted_ops,0U);
+
+ //Evaluation with index splitting forced by a small memory limit:
+ exatn::ProcessGroup all_processes(exatn::getDefaultProcessGroup());
+ all_processes.resetMemoryLimitPerProcess(1024*1024);
+ tensors.erase("Z0");
+ tensors["Z1"] = z1;
+ TensorNetwork network1("HoistingSliced","Z1(i)+=A(i,j,k)*B(k,l,n)*C(l,m,n)*D(m)*E(j)",tensors);
+ network1.importContractionSequence(contr_seq,contr_seq_flops);
+ success = exatn::evaluateSync(all_processes,network1); assert(success);
+ const auto stats1 = exatn::numericalServer->getLastNetworkExecStats();
+ EXPECT_GT(stats1.num_split_indices,0U);
+
+ //Slice-invariant tensor operations are submitted once, the rest once per tensor sub-network:
+ std::size_t num_invariant = 0, num_retained = 0;
+ const auto & op_list = network1.getOperationList();
+ for(const auto & op: op_list){
+  const auto dependence = network1.getSliceDependence(*op);
+  if(dependence == SliceDependence::INVARIANT) ++num_invariant;
+  if(dependence == SliceDependence::RETAINED) ++num_retained;
+ }
+ std::size_t num_subnetworks = 1;
+ for(unsigned int i = 0; i < network1.getNumSplitIndices(); ++i) num_subnetworks *= network1.getSplitIndexInfo(i).second.size();
+ std::cout << "Sub-networks = " << num_subnetworks << " (executed locally " << stats1.num_subnetworks
+           << "); Hoisted operations = " << stats1.num_hoisted_ops << " (" << num_invariant << " slice-invariant of "
+           << op_list.size() << "); Operations per sub-network = " << stats1.num_template_ops << std::endl;
+ EXPECT_GT(num_invariant,0U);
+ EXPECT_GT(num_subnetworks,1U);
+ if(stats1.num_subnetworks > 0){ //current process has a share of tensor sub-networks
+  EXPECT_EQ(stats1.num_hoisted_ops,num_invariant);
+  EXPECT_EQ(stats1.num_template_ops,op_list.size() - num_invariant - num_retained);
+ }
+ if(exatn::getNumProcesses() == 1) EXPECT_EQ(stats1.num_subnetworks,num_subnetworks);
+
+ //The sliced evaluation must reproduce the unsplit one:
+ double norm0 = 0.0, norm_diff = 0.0;
+ success = exatn::computeNorm2Sync("Z0",norm0); assert(success);
+ success = exatn::addTensorsSync("Z1(i)+=Z0(i)",-1.0); assert(success);
+ success = exatn::computeNorm2Sync("Z1",norm_diff); assert(success);
+ std::cout << "Z0 2-norm = " << norm0 << "; Sliced deviation 2-norm = " << norm_diff << std::endl;
+ EXPECT_GT(norm0,0.0);
+ EXPECT_LE(norm_diff,1e-10*norm0);
+
+ success = exatn::destroyTensorSync("Z1"); assert(success);
+ success = exatn::destroyTensorSync("Z0"); assert(success);
+ for(auto & tensor: tensors){
+  if(tensor.first != "Z1"){
+   success = exatn::destroyTensorSync(tensor.first); assert(success);
+  }
+ }
+
+ exatn::sync();
+}
+#endif
+
+#ifdef EXATN_TEST32
+TEST(NumServerTester, ReconstructorNumServer)
+{
+ using exatn::Tensor;
+ using exatn::TensorShape;
+ using exatn::TensorExpansion;
+ using exatn::TensorElementType;
+
+ exatn::resetRuntimeLoggingLevel(0); //debug
+
+ bool success = true;
+ const double tolerance = 1e-5;
+
+ //Builds a 4-site MPS ket of a given bond dimension with random tensors:
+ auto & network_build_factory = *(exatn::NetworkBuildFactory::get());
+ auto build_mps = [&](const std::string & name, exatn::DimExtent bond_dim){
+  auto builder = network_build_factory.createNetworkBuilderShared("MPS");
+  auto done = builder->setParameter("max_bond_dim",bond_dim); assert(done);
+  auto network = exatn::makeSharedTensorNetwork(name,
+                                                std::make_shared<Tensor>(name + "Tensor",TensorShape{2,2,2,2}),
+                                                *builder);
+  for(auto iter = network->cbegin(); iter != network->cend(); ++iter){
+   if(iter->first != 0){
+    done = exatn::createTensorSync(iter->second.getTensor(),TensorElementType::COMPLEX64); assert(done);
+    done = exatn::initTensorRndSync(iter->second.getName()); assert(done);
+   }
+  }
+  return network;
+ };
+
+ //Target MPS (bond dimension 4) and its MPS approximant (bond dimension 2):
+ auto target_net = build_mps("Target",4);
+ auto target = std::make_shared<TensorExpansion>();
+ success = target->appendComponent(target_net,{1.0,0.0}); assert(success);
+ auto approximant_net = build_mps("Approximant",2);
+ approximant_net->markOptimizableTensors([](const Tensor & tensor){return true;});
+ TensorExpansion approximant_ket;
+ success = approximant_ket.appendComponent(approximant_net,{1.0,0.0}); assert(success);
+ auto approximant = std::make_shared<TensorExpansion>(approximant_ket,false); // |approximant>
+ approximant->conjugate(); // <approximant|
+
+ //Exact fidelity |<approximant|target>|^2 / (<approximant|approximant> * <target|target>):
+ auto scalar = exatn::makeSharedTensor("Scalar");
+ success = exatn::createTensorSync(scalar,TensorElementType::COMPLEX64); assert(success);
+ auto evaluate_closure = [&](TensorExpansion & closure){
+  double value = 0.0;
+  auto done = exatn::initTensorSync("Scalar",0.0); assert(done);
+  done = exatn::evaluateSync(closure,scalar); assert(done);
+  done = exatn::computeNorm1Sync("Scalar",value); assert(done);
+  return value;
+ };
+ auto exact_fidelity = [&](){
+  TensorExpansion overlap(*approximant,*target);
+  TensorExpansion approximant_conj(*approximant,false);
+  approximant_conj.conjugate();
+  TensorExpansion approximant_norm(*approximant,approximant_conj);
+  TensorExpansion target_conj(*target,false);
+  target_conj.conjugate();
+  TensorExpansion target_norm(target_conj,*target);
+  const double overlap_abs = evaluate_closure(overlap);
+  return overlap_abs * overlap_abs / (evaluate_closure(approximant_norm) * evaluate_closure(target_norm));
+ };
+ const double initial_fidelity = exact_fidelity();
+
+ //Reconstruct the target MPS by the smaller MPS approximant:
+ exatn::TensorNetworkReconstructor reconstructor(target,approximant,tolerance);
+ double fidelity = 0.0;
+ success = reconstructor.reconstruct(&fidelity);
+ EXPECT_TRUE(success);
+ double solution_fidelity = 0.0;
+ auto solution = reconstructor.getSolution(&solution_fidelity);
+ EXPECT_TRUE(static_cast<bool>(solution));
+ EXPECT_EQ(solution_fidelity,fidelity);
+ const double final_fidelity = exact_fidelity();
+ std::cout << "Reconstruction fidelity: Initial = " << initial_fidelity << "; Returned = " << fidelity
+           << "; Exact = " << final_fidelity << std::endl;
+ EXPECT_GT(fidelity,initial_fidelity);
+ EXPECT_LE(fidelity,1.0 + tolerance);
+ EXPECT_NEAR(fidelity,final_fidelity,1e-6);
+
+ //The converged approximant must stay converged:
+ double refined_fidelity = 0.0;
+ success = reconstructor.reconstruct(&refined_fidelity); assert(success);
+ std::cout << "Reconstruction fidelity after restart = " << refined_fidelity << std::endl;
+ EXPECT_GE(refined_fidelity,fidelity - tolerance);
+ EXPECT_NEAR(refined_fidelity,exact_fidelity(),1e-6);
+
+ success = exatn::destroyTensorSync("Scalar"); assert(success);
+ for(auto network: {approximant_net,target_net}){
+  for(auto iter = network->cbegin(); iter != network->cend(); ++iter){
+   if(iter->first != 0){
+    success = exatn::destroyTensorSync(iter->second.getName()); assert(success);
+   }
+  }
+ }
+
+ exatn::sync();
+}
+#endif
+
 int main(int argc, char **argv) {
 
   exatn::ParamConf exatn_parameters;
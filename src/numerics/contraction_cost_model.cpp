@@ -0,0 +1,284 @@
+/** ExaTN::Numerics: Calibrated cost model for tensor contractions
+REVISION: 2020/10/07
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+#include "contraction_cost_model.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <limits>
+
+#include <cmath>
+#include <cassert>
+
+namespace exatn{
+
+namespace numerics{
+
+constexpr const unsigned int ContractionCostModel::MAX_LOG_DIM;
+constexpr const unsigned int ContractionCostModel::MAX_LOG_VOLUME;
+constexpr const unsigned int ContractionCostModel::MAX_RANK;
+
+std::shared_ptr<const ContractionCostModel> ContractionCostModel::active_model_;
+
+
+inline unsigned int logBin(double value, unsigned int max_bin) //helper
+{
+ if(value <= 1.0) return 0;
+ return std::min(static_cast<unsigned int>(std::lround(std::log2(value))),max_bin);
+}
+
+
+ContractionCostModel::ContractionCostModel():
+ peak_throughput_(0.0)
+{
+}
+
+
+void ContractionCostModel::appendGemmSample(double m, double n, double k, double time)
+{
+ assert(m >= 1.0 && n >= 1.0 && k >= 1.0 && time > 0.0);
+ gemm_samples_.emplace_back(std::make_tuple(m,n,k,time));
+ gemm_table_.clear(); //prediction tables need to be rebuilt
+ return;
+}
+
+
+void ContractionCostModel::appendPermutationSample(unsigned int rank, double volume, double time)
+{
+ assert(volume >= 1.0 && time > 0.0);
+ perm_samples_.emplace_back(std::make_tuple(rank,volume,time));
+ gemm_table_.clear(); //prediction tables need to be rebuilt
+ return;
+}
+
+
+bool ContractionCostModel::finalize()
+{
+ gemm_table_.clear();
+ perm_table_.clear();
+ peak_throughput_ = 0.0;
+ if(gemm_samples_.empty()) return false;
+ //GEMM throughput table (nearest measured sample in the log2 space of GEMM shapes):
+ std::vector<std::tuple<double,double,double,double>> gemm_points; //{log2(M),log2(N),log2(K),FMA/s}
+ for(const auto & sample: gemm_samples_){
+  const double m = std::get<0>(sample), n = std::get<1>(sample), k = std::get<2>(sample);
+  const double throughput = m * n * k / std::get<3>(sample);
+  gemm_points.emplace_back(std::make_tuple(std::log2(m),std::log2(n),std::log2(k),throughput));
+  peak_throughput_ = std::max(peak_throughput_,throughput);
+ }
+ const unsigned int num_bins = MAX_LOG_DIM + 1;
+ gemm_table_.resize(num_bins * num_bins * num_bins);
+ for(unsigned int bm = 0; bm < num_bins; ++bm){
+  for(unsigned int bn = 0; bn < num_bins; ++bn){
+   for(unsigned int bk = 0; bk < num_bins; ++bk){
+    double min_dist = std::numeric_limits<double>::max(), throughput = peak_throughput_;
+    for(const auto & point: gemm_points){
+     const double dm = std::get<0>(point) - bm, dn = std::get<1>(point) - bn, dk = std::get<2>(point) - bk;
+     const double dist = dm*dm + dn*dn + dk*dk;
+     if(dist < min_dist){
+      min_dist = dist;
+      throughput = std::get<3>(point);
+     }
+    }
+    gemm_table_[(bm * num_bins + bn) * num_bins + bk] = throughput;
+   }
+  }
+ }
+ //Permutation throughput table (nearest measured sample in the {rank,log2(volume)} space):
+ if(!perm_samples_.empty()){
+  const unsigned int num_ranks = MAX_RANK + 1;
+  const unsigned int num_vol_bins = MAX_LOG_VOLUME + 1;
+  perm_table_.resize(num_ranks * num_vol_bins);
+  for(unsigned int rank = 0; rank < num_ranks; ++rank){
+   for(unsigned int bv = 0; bv < num_vol_bins; ++bv){
+    double min_dist = std::numeric_limits<double>::max(), throughput = 0.0;
+    for(const auto & sample: perm_samples_){
+     const double dr = static_cast<double>(std::get<0>(sample)) - rank;
+     const double dv = std::log2(std::get<1>(sample)) - bv;
+     const double dist = dr*dr + dv*dv;
+     if(dist < min_dist){
+      min_dist = dist;
+      throughput = std::get<1>(sample) / std::get<2>(sample);
+     }
+    }
+    perm_table_[rank * num_vol_bins + bv] = throughput;
+   }
+  }
+ }
+ return true;
+}
+
+
+bool ContractionCostModel::isCalibrated() const
+{
+ return !(gemm_table_.empty());
+}
+
+
+double ContractionCostModel::getPeakThroughput() const
+{
+ return peak_throughput_;
+}
+
+
+double ContractionCostModel::predictGemmTime(double m, double n, double k) const
+{
+ assert(isCalibrated());
+ const unsigned int num_bins = MAX_LOG_DIM + 1;
+ const auto bm = logBin(m,MAX_LOG_DIM), bn = logBin(n,MAX_LOG_DIM), bk = logBin(k,MAX_LOG_DIM);
+ return (m * n * k) / gemm_table_[(bm * num_bins + bn) * num_bins + bk];
+}
+
+
+double ContractionCostModel::predictPermutationTime(unsigned int rank, double volume) const
+{
+ if(rank < 2 || perm_table_.empty()) return 0.0;
+ const auto bv = logBin(volume,MAX_LOG_VOLUME);
+ return volume / perm_table_[std::min(rank,MAX_RANK) * (MAX_LOG_VOLUME + 1) + bv];
+}
+
+
+double ContractionCostModel::predictContractionTime(double m, double n, double k,
+                                                    unsigned int left_rank, unsigned int right_rank, unsigned int result_rank,
+                                                    bool permute_left, bool permute_right, bool permute_result) const
+{
+ double time = predictGemmTime(m,n,k);
+ if(permute_left) time += predictPermutationTime(left_rank,m*k);
+ if(permute_right) time += predictPermutationTime(right_rank,k*n);
+ if(permute_result) time += predictPermutationTime(result_rank,m*n);
+ return time;
+}
+
+
+double ContractionCostModel::predictEffectiveFlops(double m, double n, double k,
+                                                   unsigned int left_rank, unsigned int right_rank, unsigned int result_rank,
+                                                   bool permute_left, bool permute_right, bool permute_result) const
+{
+ return predictContractionTime(m,n,k,left_rank,right_rank,result_rank,permute_left,permute_right,permute_result)
+        * peak_throughput_;
+}
+
+
+bool ContractionCostModel::saveToFile(const std::string & file_name) const
+{
+ std::ofstream model_file(file_name,std::ios::out|std::ios::trunc);
+ if(!model_file.is_open()){
+  std::cout << "#ERROR(exatn::numerics::ContractionCostModel::saveToFile): Unable to open file " << file_name << std::endl;
+  return false;
+ }
+ model_file << "#ExaTN tensor contraction cost model" << std::endl;
+ model_file << "#GEMM M N K time(sec)" << std::endl;
+ model_file << "#PERM rank volume time(sec)" << std::endl;
+ model_file.precision(12);
+ for(const auto & sample: gemm_samples_){
+  model_file << "GEMM " << std::get<0>(sample) << " " << std::get<1>(sample) << " "
+             << std::get<2>(sample) << " " << std::get<3>(sample) << std::endl;
+ }
+ for(const auto & sample: perm_samples_){
+  model_file << "PERM " << std::get<0>(sample) << " " << std::get<1>(sample) << " "
+             << std::get<2>(sample) << std::endl;
+ }
+ model_file.close();
+ return true;
+}
+
+
+bool ContractionCostModel::loadFromFile(const std::string & file_name)
+{
+ std::ifstream model_file(file_name,std::ios::in);
+ if(!model_file.is_open()){
+  std::cout << "#ERROR(exatn::numerics::ContractionCostModel::loadFromFile): Unable to open file " << file_name << std::endl;
+  return false;
+ }
+ gemm_samples_.clear();
+ perm_samples_.clear();
+ std::string line, keyword;
+ while(std::getline(model_file,line)){
+  if(line.empty() || line[0] == '#') continue;
+  std::istringstream line_stream(line);
+  line_stream >> keyword;
+  bool success = false;
+  if(keyword == "GEMM"){
+   double m = 0.0, n = 0.0, k = 0.0, time = 0.0;
+   success = static_cast<bool>(line_stream >> m >> n >> k >> time);
+   if(success) success = (m >= 1.0 && n >= 1.0 && k >= 1.0 && time > 0.0);
+   if(success) appendGemmSample(m,n,k,time);
+  }else if(keyword == "PERM"){
+   unsigned int rank = 0; double volume = 0.0, time = 0.0;
+   success = static_cast<bool>(line_stream >> rank >> volume >> time);
+   if(success) success = (volume >= 1.0 && time > 0.0);
+   if(success) appendPermutationSample(rank,volume,time);
+  }
+  if(!success){
+   std::cout << "#ERROR(exatn::numerics::ContractionCostModel::loadFromFile): Invalid line in file "
+             << file_name << ": " << line << std::endl;
+   model_file.close();
+   return false;
+  }
+ }
+ model_file.close();
+ return finalize();
+}
+
+
+void ContractionCostModel::packSamples(std::vector<double> & samples) const
+{
+ samples.clear();
+ samples.emplace_back(static_cast<double>(gemm_samples_.size()));
+ samples.emplace_back(static_cast<double>(perm_samples_.size()));
+ for(const auto & sample: gemm_samples_){
+  samples.emplace_back(std::get<0>(sample)); samples.emplace_back(std::get<1>(sample));
+  samples.emplace_back(std::get<2>(sample)); samples.emplace_back(std::get<3>(sample));
+ }
+ for(const auto & sample: perm_samples_){
+  samples.emplace_back(static_cast<double>(std::get<0>(sample)));
+  samples.emplace_back(std::get<1>(sample)); samples.emplace_back(std::get<2>(sample));
+ }
+ return;
+}
+
+
+bool ContractionCostModel::unpackSamples(const std::vector<double> & samples)
+{
+ if(samples.size() < 2) return false;
+ const auto num_gemm = static_cast<std::size_t>(samples[0]);
+ const auto num_perm = static_cast<std::size_t>(samples[1]);
+ if(samples.size() != 2 + num_gemm * 4 + num_perm * 3) return false;
+ gemm_samples_.clear();
+ perm_samples_.clear();
+ std::size_t pos = 2;
+ for(std::size_t i = 0; i < num_gemm; ++i, pos += 4) appendGemmSample(samples[pos],samples[pos+1],samples[pos+2],samples[pos+3]);
+ for(std::size_t i = 0; i < num_perm; ++i, pos += 3) appendPermutationSample(static_cast<unsigned int>(samples[pos]),samples[pos+1],samples[pos+2]);
+ return finalize();
+}
+
+
+void ContractionCostModel::activate(std::shared_ptr<const ContractionCostModel> cost_model)
+{
+ assert(cost_model);
+ assert(cost_model->isCalibrated());
+ active_model_ = cost_model;
+ return;
+}
+
+
+void ContractionCostModel::deactivate()
+{
+ active_model_.reset();
+ return;
+}
+
+
+const ContractionCostModel * ContractionCostModel::getActive()
+{
+ return active_model_.get();
+}
+
+} //namespace numerics
+
+} //namespace exatn
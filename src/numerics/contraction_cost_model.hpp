@@ -0,0 +1,138 @@
+/** ExaTN::Numerics: Calibrated cost model for tensor contractions
+REVISION: 2020/10/07
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+/** Rationale:
+ (a) The raw FMA flop count of a tensor contraction does not distinguish a memory-bound
+     skinny tensor contraction from a large square GEMM of a similar flop count. The
+     calibrated cost model predicts the execution time of a tensor contraction on the
+     active node executor from the measured GEMM throughput (as a function of the GEMM
+     shape {M,N,K}) and the measured tensor permutation throughput (as a function of the
+     tensor rank and volume).
+ (b) The measured samples are saved to and loaded from a text file (or packed into a plain
+     vector to be communicated to other processes). After loading, the
+     samples are mapped onto dense tables over the log2-binned GEMM shapes and permutation
+     volumes (nearest calibrated sample), thus making predictions cheap enough for use
+     inside tensor contraction sequence optimizers.
+ (c) A tensor contraction is predicted to take the GEMM time plus the permutation time
+     of each tensor operand whose contracted dimensions do not form a contiguous block.
+     The predicted time can be expressed in effective FMA flops, that is, the FMA flop
+     count the fastest calibrated GEMM would execute in the same time.
+ (d) Once activated, the cost model is used by tensor contraction sequence optimizers
+     and the index splitting (slicing) planner instead of the raw FMA flop count.
+**/
+
+#ifndef EXATN_NUMERICS_CONTRACTION_COST_MODEL_HPP_
+#define EXATN_NUMERICS_CONTRACTION_COST_MODEL_HPP_
+
+#include "tensor_basic.hpp"
+
+#include <vector>
+#include <tuple>
+#include <string>
+#include <memory>
+
+namespace exatn{
+
+namespace numerics{
+
+class ContractionCostModel{
+
+public:
+
+ static constexpr const unsigned int MAX_LOG_DIM = 32;    //max log2 of a GEMM dimension in the prediction table
+ static constexpr const unsigned int MAX_LOG_VOLUME = 48; //max log2 of a tensor volume in the prediction table
+ static constexpr const unsigned int MAX_RANK = 32;       //max tensor rank in the prediction table
+
+ ContractionCostModel();
+
+ ContractionCostModel(const ContractionCostModel &) = default;
+ ContractionCostModel & operator=(const ContractionCostModel &) = default;
+ ContractionCostModel(ContractionCostModel &&) noexcept = default;
+ ContractionCostModel & operator=(ContractionCostModel &&) noexcept = default;
+ ~ContractionCostModel() = default;
+
+ /** Appends a measured GEMM sample: D(M,N) += L(M,K) * R(K,N). **/
+ void appendGemmSample(double m,     //in: M dimension
+                       double n,     //in: N dimension
+                       double k,     //in: K dimension
+                       double time); //in: measured execution time (seconds)
+
+ /** Appends a measured tensor permutation sample. **/
+ void appendPermutationSample(unsigned int rank, //in: tensor rank
+                              double volume,     //in: tensor volume
+                              double time);      //in: measured execution time (seconds)
+
+ /** Builds the prediction tables from the measured samples. Returns FALSE
+     if there are no GEMM samples. Must be called before making predictions. **/
+ bool finalize();
+
+ /** Returns TRUE if the cost model is ready for making predictions. **/
+ bool isCalibrated() const;
+
+ /** Returns the max measured GEMM throughput (FMA/s). **/
+ double getPeakThroughput() const;
+
+ /** Predicts the GEMM execution time (seconds). **/
+ double predictGemmTime(double m, double n, double k) const;
+
+ /** Predicts the tensor permutation execution time (seconds). **/
+ double predictPermutationTime(unsigned int rank, double volume) const;
+
+ /** Predicts the tensor contraction execution time (seconds): D(M,N) += L(M,K) * R(K,N). **/
+ double predictContractionTime(double m,                  //in: M dimension (volume of the uncontracted dimensions of the left tensor)
+                               double n,                  //in: N dimension (volume of the uncontracted dimensions of the right tensor)
+                               double k,                  //in: K dimension (volume of the contracted dimensions)
+                               unsigned int left_rank,    //in: rank of the left tensor
+                               unsigned int right_rank,   //in: rank of the right tensor
+                               unsigned int result_rank,  //in: rank of the result tensor
+                               bool permute_left = true,  //in: whether or not the left tensor needs a permutation
+                               bool permute_right = true, //in: whether or not the right tensor needs a permutation
+                               bool permute_result = false) const; //in: whether or not the result tensor needs a permutation
+
+ /** Predicts the tensor contraction execution time expressed in effective FMA flops
+     (the FMA flop count the fastest calibrated GEMM would execute in the same time). **/
+ double predictEffectiveFlops(double m, double n, double k,
+                              unsigned int left_rank, unsigned int right_rank, unsigned int result_rank,
+                              bool permute_left = true, bool permute_right = true, bool permute_result = false) const;
+
+ /** Saves the measured samples into a file. **/
+ bool saveToFile(const std::string & file_name) const;
+
+ /** Loads the measured samples from a file and builds the prediction tables. **/
+ bool loadFromFile(const std::string & file_name);
+
+ /** Packs the measured samples into a plain vector (for communication). **/
+ void packSamples(std::vector<double> & samples) const;
+
+ /** Unpacks the measured samples from a plain vector and builds the prediction tables. **/
+ bool unpackSamples(const std::vector<double> & samples);
+
+ /** Activates a calibrated cost model for all tensor contraction sequence optimizers
+     and the index splitting planner of the current process. **/
+ static void activate(std::shared_ptr<const ContractionCostModel> cost_model);
+
+ /** Deactivates the previously activated cost model. **/
+ static void deactivate();
+
+ /** Returns the active cost model or nullptr if none is active. **/
+ static const ContractionCostModel * getActive();
+
+private:
+
+ std::vector<std::tuple<double,double,double,double>> gemm_samples_; //measured GEMM samples: {M,N,K,time}
+ std::vector<std::tuple<unsigned int,double,double>> perm_samples_;  //measured permutation samples: {rank,volume,time}
+ std::vector<double> gemm_table_; //GEMM throughput (FMA/s) over log2-binned {M,N,K}
+ std::vector<double> perm_table_; //permutation throughput (elements/s) over {rank, log2-binned volume}
+ double peak_throughput_;         //max measured GEMM throughput (FMA/s)
+
+ static std::shared_ptr<const ContractionCostModel> active_model_; //active cost model
+};
+
+} //namespace numerics
+
+} //namespace exatn
+
+#endif //EXATN_NUMERICS_CONTRACTION_COST_MODEL_HPP_
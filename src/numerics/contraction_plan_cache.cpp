@@ -0,0 +1,416 @@
+/** ExaTN::Numerics: Persistent cache of tensor network contraction plans
+REVISION: 2020/10/07
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+#include "contraction_plan_cache.hpp"
+#include "tensor_network.hpp"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <unordered_map>
+#include <map>
+#include <list>
+#include <algorithm>
+#include <functional>
+
+#include <cstring>
+#include <cmath>
+#include <cassert>
+
+namespace exatn{
+
+namespace numerics{
+
+constexpr const std::uint64_t ContractionPlanCache::MAGIC;
+constexpr const std::uint64_t ContractionPlanCache::VERSION;
+constexpr const std::uint64_t ContractionPlanCache::RECORD_HEADER_WORDS;
+
+
+inline void hashCombine(std::uint64_t & seed, std::uint64_t value) //helper
+{
+ seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+ return;
+}
+
+
+inline std::size_t countDistinct(std::vector<std::uint64_t> values) //helper
+{
+ std::sort(values.begin(),values.end());
+ return static_cast<std::size_t>(std::distance(values.begin(),std::unique(values.begin(),values.end())));
+}
+
+
+ContractionPlanCache::ContractionPlanCache(const std::string & file_name,
+                                           std::size_t capacity):
+ file_name_(file_name), fd_(-1), base_(nullptr), capacity_(0)
+{
+ const std::size_t header_words = sizeof(FileHeader) / sizeof(std::uint64_t);
+ fd_ = open(file_name_.c_str(), O_RDWR | O_CREAT, 0644);
+ if(fd_ < 0){
+  std::cout << "#ERROR(exatn::numerics::ContractionPlanCache): Unable to open file " << file_name_ << std::endl;
+  return;
+ }
+ auto errc = flock(fd_,LOCK_EX); assert(errc == 0);
+ struct stat file_stat;
+ errc = fstat(fd_,&file_stat); assert(errc == 0);
+ std::size_t file_size = static_cast<std::size_t>(file_stat.st_size);
+ bool new_file = (file_size < sizeof(FileHeader));
+ if(new_file){ //initialize a new file
+  file_size = std::max(capacity / sizeof(std::uint64_t),header_words) * sizeof(std::uint64_t);
+  errc = ftruncate(fd_,file_size);
+  if(errc != 0){
+   std::cout << "#ERROR(exatn::numerics::ContractionPlanCache): Unable to allocate file " << file_name_ << std::endl;
+   flock(fd_,LOCK_UN); close(fd_); fd_ = -1;
+   return;
+  }
+ }
+ void * addr = mmap(nullptr,file_size,PROT_READ|PROT_WRITE,MAP_SHARED,fd_,0);
+ if(addr == MAP_FAILED){
+  std::cout << "#ERROR(exatn::numerics::ContractionPlanCache): Unable to memory-map file " << file_name_ << std::endl;
+  flock(fd_,LOCK_UN); close(fd_); fd_ = -1;
+  return;
+ }
+ base_ = static_cast<std::uint64_t*>(addr);
+ auto & header = *reinterpret_cast<FileHeader*>(base_);
+ if(new_file){
+  header.magic = MAGIC;
+  header.version = VERSION;
+  header.capacity = file_size / sizeof(std::uint64_t);
+  header.used = header_words;
+  errc = msync(base_,sizeof(FileHeader),MS_SYNC); assert(errc == 0);
+ }
+ if(header.magic != MAGIC || header.version != VERSION || header.capacity * sizeof(std::uint64_t) > file_size ||
+    header.used < header_words || header.used > header.capacity){
+  std::cout << "#ERROR(exatn::numerics::ContractionPlanCache): Invalid format of file " << file_name_ << std::endl;
+  munmap(base_,file_size); base_ = nullptr;
+  flock(fd_,LOCK_UN); close(fd_); fd_ = -1;
+  return;
+ }
+ capacity_ = header.capacity;
+ errc = flock(fd_,LOCK_UN); assert(errc == 0);
+}
+
+
+ContractionPlanCache::~ContractionPlanCache()
+{
+ closeFile();
+}
+
+
+void ContractionPlanCache::closeFile()
+{
+ if(base_ != nullptr){
+  msync(base_,capacity_*sizeof(std::uint64_t),MS_SYNC);
+  munmap(base_,capacity_*sizeof(std::uint64_t));
+  base_ = nullptr;
+ }
+ if(fd_ >= 0){
+  close(fd_);
+  fd_ = -1;
+ }
+ return;
+}
+
+
+bool ContractionPlanCache::isOpen() const
+{
+ return (base_ != nullptr);
+}
+
+
+bool ContractionPlanCache::isValidRecord(std::size_t offset, std::size_t used) const
+{
+ if(offset + RECORD_HEADER_WORDS > used) return false;
+ const std::uint64_t * rec = base_ + offset;
+ return (rec[0] >= RECORD_HEADER_WORDS + rec[4] && offset + rec[0] <= used);
+}
+
+
+std::size_t ContractionPlanCache::computeStructuralHash(const TensorNetwork & network,
+                                                        std::vector<unsigned int> * canonical_order,
+                                                        std::vector<std::uint64_t> * canonical_structure)
+{
+ //Collect tensor ids (output tensor first):
+ std::vector<unsigned int> ids;
+ for(auto iter = network.cbegin(); iter != network.cend(); ++iter){
+  if(iter->first != 0) ids.emplace_back(iter->first);
+ }
+ std::sort(ids.begin(),ids.end());
+ ids.insert(ids.begin(),0U);
+ const std::size_t num_vertices = ids.size();
+ std::unordered_map<unsigned int,std::size_t> vertex; //tensor id --> graph vertex
+ for(std::size_t i = 0; i < num_vertices; ++i) vertex[ids[i]] = i;
+
+ //Extract tensor connections and dimension extents:
+ std::vector<const std::vector<TensorLeg>*> legs(num_vertices);
+ std::vector<std::vector<std::uint64_t>> extents(num_vertices);
+ for(std::size_t i = 0; i < num_vertices; ++i){
+  legs[i] = network.getTensorConnections(ids[i]); assert(legs[i] != nullptr);
+  const auto tensor = network.getTensor(ids[i]);
+  for(unsigned int j = 0; j < legs[i]->size(); ++j){
+   extents[i].emplace_back(static_cast<std::uint64_t>(tensor->getDimExtent(j)));
+  }
+ }
+
+ //Initial vertex colors:
+ std::vector<std::uint64_t> colors(num_vertices), new_colors(num_vertices);
+ for(std::size_t i = 0; i < num_vertices; ++i){
+  std::uint64_t color = (i == 0) ? 1 : 2; //output tensor is distinguished
+  hashCombine(color,legs[i]->size());
+  for(const auto & extent: extents[i]) hashCombine(color,extent);
+  colors[i] = color;
+ }
+
+ //Iterative color refinement until the vertex partition stabilizes:
+ auto refine = [&](std::vector<std::uint64_t> & cols){
+  auto num_classes = countDistinct(cols);
+  while(true){
+   for(std::size_t i = 0; i < num_vertices; ++i){
+    std::uint64_t color = cols[i];
+    for(const auto & leg: *(legs[i])){
+     hashCombine(color,cols[vertex[leg.getTensorId()]]);
+     hashCombine(color,leg.getDimensionId());
+    }
+    new_colors[i] = color;
+   }
+   cols.swap(new_colors);
+   const auto new_num_classes = countDistinct(cols);
+   if(new_num_classes <= num_classes) break;
+   num_classes = new_num_classes;
+  }
+  return;
+ };
+ refine(colors);
+
+ //Structural hash is invariant to tensor id relabeling:
+ auto sorted_colors = colors;
+ std::sort(sorted_colors.begin(),sorted_colors.end());
+ std::uint64_t hash = num_vertices;
+ for(const auto & color: sorted_colors) hashCombine(hash,color);
+
+ //Canonical order of tensors: Vertices of the first non-trivial color class are individualized one at a time,
+ //each choice being explored, and the discrete partition with the lexicographically smallest network structure
+ //is taken, such that the canonical order does not depend on the tensor ids (unless the search is truncated):
+ if(canonical_order != nullptr || canonical_structure != nullptr){
+  const std::size_t MAX_DISCRETE_PARTITIONS = 256; //search limit (beyond it a cache miss may occur for relabeled tensor ids)
+  std::size_t num_partitions = 0;
+  std::vector<std::size_t> best_order;
+  std::vector<std::uint64_t> best_structure;
+  std::function<void (std::vector<std::uint64_t> &)> search = [&](std::vector<std::uint64_t> & cols){
+   std::map<std::uint64_t,std::vector<std::size_t>> classes; //color --> vertices
+   for(std::size_t i = 0; i < num_vertices; ++i) classes[cols[i]].emplace_back(i);
+   auto iter = std::find_if(classes.begin(),classes.end(),[](const auto & cls){return (cls.second.size() > 1);});
+   if(iter != classes.end()){
+    const auto cls = iter->second; //copy
+    for(std::size_t k = 0; k < cls.size(); ++k){
+     if(k > 0 && num_partitions >= MAX_DISCRETE_PARTITIONS) break;
+     auto ind_cols = cols;
+     hashCombine(ind_cols[cls[k]],num_vertices); //individualize the vertex
+     refine(ind_cols);
+     search(ind_cols);
+    }
+    return;
+   }
+   //Discrete partition:
+   ++num_partitions;
+   std::vector<std::size_t> order(num_vertices);
+   for(std::size_t i = 0; i < num_vertices; ++i) order[i] = i;
+   std::sort(order.begin(),order.end(),[&cols](const std::size_t & v1, const std::size_t & v2){
+                                         if(v1 == 0 || v2 == 0) return (v1 == 0 && v2 != 0); //output tensor first
+                                         return (cols[v1] < cols[v2]);
+                                        });
+   std::vector<std::uint64_t> position(num_vertices); //vertex --> canonical position
+   for(std::size_t i = 0; i < num_vertices; ++i) position[order[i]] = i;
+   std::vector<std::uint64_t> structure;
+   for(std::size_t i = 0; i < num_vertices; ++i){
+    const auto v = order[i];
+    structure.emplace_back(legs[v]->size());
+    for(unsigned int j = 0; j < legs[v]->size(); ++j){
+     const auto & leg = (*(legs[v]))[j];
+     structure.emplace_back((position[vertex[leg.getTensorId()]] << 32) | leg.getDimensionId());
+     structure.emplace_back(extents[v][j]);
+    }
+   }
+   if(best_order.empty() || structure < best_structure){
+    best_order.swap(order);
+    best_structure.swap(structure);
+   }
+   return;
+  };
+  search(colors);
+  if(canonical_order != nullptr){
+   canonical_order->resize(num_vertices);
+   for(std::size_t i = 0; i < num_vertices; ++i) (*canonical_order)[i] = ids[best_order[i]];
+  }
+  if(canonical_structure != nullptr) canonical_structure->swap(best_structure);
+ }
+ return static_cast<std::size_t>(hash);
+}
+
+
+bool ContractionPlanCache::retrievePlan(TensorNetwork & network,
+                                        std::vector<std::pair<std::string,std::size_t>> * split_plan,
+                                        std::size_t * max_intermediate_volume)
+{
+ if(!isOpen()) return false;
+ if(network.getNumTensors() < 2) return false;
+ std::vector<unsigned int> order;
+ std::vector<std::uint64_t> structure;
+ const std::uint64_t hash = computeStructuralHash(network,&order,&structure);
+ //Look up the latest contraction plan stored for the same canonical network structure:
+ std::vector<std::uint64_t> record;
+ auto errc = flock(fd_,LOCK_SH); assert(errc == 0);
+ const auto & header = *reinterpret_cast<const FileHeader*>(base_);
+ std::size_t offset = sizeof(FileHeader) / sizeof(std::uint64_t);
+ bool corrupted = false;
+ while(offset < header.used){
+  const std::uint64_t * rec = base_ + offset;
+  if(!isValidRecord(offset,header.used)){corrupted = true; break;}
+  if(rec[1] == hash && rec[4] == structure.size()){
+   if(std::equal(structure.cbegin(),structure.cend(),rec + 7)) record.assign(rec,rec + rec[0]);
+  }
+  offset += rec[0];
+ }
+ if(corrupted){
+  std::cout << "#ERROR(exatn::numerics::ContractionPlanCache::retrievePlan): Corrupted record in file "
+            << file_name_ << ", contraction plan cache has been dropped!" << std::endl;
+  closeFile(); //also releases the file lock
+  return false;
+ }
+ errc = flock(fd_,LOCK_UN); assert(errc == 0);
+ if(record.empty()) return false;
+ //Remap the canonical tensor contraction sequence to the tensor ids of the given tensor network:
+ const std::uint64_t num_vertices = order.size(); //output tensor included
+ const unsigned int intermediate_base = network.getMaxTensorId() + 1;
+ auto tensor_id = [&](std::uint64_t canonical_id){
+  if(canonical_id < num_vertices) return order[canonical_id];
+  return static_cast<unsigned int>(intermediate_base + (canonical_id - num_vertices));
+ };
+ std::list<ContrTriple> contr_seq;
+ const std::uint64_t * triples = record.data() + 7 + record[4];
+ for(std::uint64_t i = 0; i < record[5]; ++i){
+  contr_seq.emplace_back(ContrTriple{tensor_id(triples[i*3]),tensor_id(triples[i*3+1]),tensor_id(triples[i*3+2])});
+ }
+ //Recompute the FMA flop count for the actual dimension extents:
+ double fma_flops = 0.0;
+ TensorNetwork net(network);
+ for(const auto & contr: contr_seq){
+  fma_flops += net.getContractionCost(contr.left_id,contr.right_id);
+  if(contr.result_id != 0){
+   auto merged = net.mergeTensors(contr.left_id,contr.right_id,contr.result_id);
+   if(!merged) return false;
+  }
+ }
+ network.importContractionSequence(contr_seq,fma_flops);
+ //Extract the index splitting plan:
+ if(split_plan != nullptr){
+  split_plan->clear();
+  const std::uint64_t * split_entry = triples + record[5] * 3;
+  for(std::uint64_t i = 0; i < record[6]; ++i){
+   const auto label_length = split_entry[0];
+   const auto num_segments = split_entry[1];
+   std::string label(reinterpret_cast<const char*>(split_entry + 2),label_length);
+   split_plan->emplace_back(std::make_pair(label,static_cast<std::size_t>(num_segments)));
+   split_entry += (2 + (label_length + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+  }
+ }
+ if(max_intermediate_volume != nullptr) *max_intermediate_volume = static_cast<std::size_t>(record[3]);
+ return true;
+}
+
+
+bool ContractionPlanCache::storePlan(const TensorNetwork & network,
+                                     std::size_t max_intermediate_volume)
+{
+ if(!isOpen()) return false;
+ double fma_flops = 0.0;
+ const auto & contr_seq = network.exportContractionSequence(&fma_flops);
+ if(contr_seq.empty()) return false;
+ std::vector<unsigned int> order;
+ std::vector<std::uint64_t> structure;
+ const std::uint64_t hash = computeStructuralHash(network,&order,&structure);
+ const std::uint64_t num_vertices = order.size(); //output tensor included
+ //Canonical numeration of tensors (intermediates are numbered in the order of appearance):
+ std::unordered_map<unsigned int,std::uint64_t> canonical_id;
+ for(std::uint64_t i = 0; i < num_vertices; ++i) canonical_id[order[i]] = i;
+ std::uint64_t num_intermediates = 0;
+ for(const auto & contr: contr_seq){
+  if(contr.result_id != 0){
+   auto res = canonical_id.emplace(std::make_pair(contr.result_id,num_vertices + num_intermediates));
+   if(!res.second) return false;
+   ++num_intermediates;
+  }
+ }
+ //Assemble the record:
+ std::vector<std::uint64_t> record(7,0);
+ record[1] = hash;
+ std::memcpy(&(record[2]),&fma_flops,sizeof(std::uint64_t));
+ record[3] = max_intermediate_volume;
+ record[4] = structure.size();
+ record[5] = contr_seq.size();
+ record.insert(record.end(),structure.cbegin(),structure.cend());
+ for(const auto & contr: contr_seq){
+  record.emplace_back(canonical_id.at(contr.result_id));
+  record.emplace_back(canonical_id.at(contr.left_id));
+  record.emplace_back(canonical_id.at(contr.right_id));
+ }
+ const auto num_split_indices = network.getNumSplitIndices();
+ record[6] = num_split_indices;
+ for(unsigned int i = 0; i < num_split_indices; ++i){
+  const auto & split_info = network.getSplitIndexInfo(i);
+  const auto & label = split_info.first;
+  const std::size_t label_words = (label.length() + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+  record.emplace_back(label.length());
+  record.emplace_back(split_info.second.size());
+  const auto pos = record.size();
+  record.resize(pos + label_words,0);
+  std::memcpy(&(record[pos]),label.data(),label.length());
+ }
+ record[0] = record.size();
+ //Append the record unless the same plan has already been stored:
+ bool stored = false;
+ auto errc = flock(fd_,LOCK_EX); assert(errc == 0);
+ auto & header = *reinterpret_cast<FileHeader*>(base_);
+ std::size_t offset = sizeof(FileHeader) / sizeof(std::uint64_t);
+ bool found = false, corrupted = false;
+ while(offset < header.used && !found){
+  const std::uint64_t * rec = base_ + offset;
+  if(!isValidRecord(offset,header.used)){corrupted = true; break;}
+  if(rec[1] == hash && rec[3] == record[3] && rec[4] == structure.size()){
+   found = std::equal(structure.cbegin(),structure.cend(),rec + 7);
+  }
+  offset += rec[0];
+ }
+ if(corrupted){
+  std::cout << "#ERROR(exatn::numerics::ContractionPlanCache::storePlan): Corrupted record in file "
+            << file_name_ << ", contraction plan cache has been dropped!" << std::endl;
+  closeFile(); //also releases the file lock
+  return false;
+ }
+ if(!found){
+  if(header.used + record.size() <= capacity_){
+   std::memcpy(base_ + header.used,record.data(),record.size()*sizeof(std::uint64_t));
+   errc = msync(base_,(header.used + record.size())*sizeof(std::uint64_t),MS_ASYNC); assert(errc == 0);
+   header.used += record.size();
+   errc = msync(base_,sizeof(FileHeader),MS_SYNC); assert(errc == 0);
+   stored = true;
+  }else{
+   std::cout << "#WARNING(exatn::numerics::ContractionPlanCache::storePlan): File " << file_name_
+             << " is full, contraction plan has not been stored!" << std::endl;
+  }
+ }
+ errc = flock(fd_,LOCK_UN); assert(errc == 0);
+ return stored;
+}
+
+} //namespace numerics
+
+} //namespace exatn
@@ -0,0 +1,114 @@
+/** ExaTN::Numerics: Persistent cache of tensor network contraction plans
+REVISION: 2020/10/07
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+/** Rationale:
+ (a) A contraction plan of a tensor network consists of the pseudo-optimal
+     tensor contraction sequence, its FMA flop count, and the index splitting
+     (slicing) plan together with the intermediate volume limit it was generated for.
+ (b) Contraction plans are keyed by a canonical structural hash of the tensor network
+     which only depends on the network topology and the exact dimension extents,
+     thus being invariant to tensor naming and tensor id relabeling. Tensors are put
+     in a canonical order by the iterative color refinement of the tensor network graph,
+     followed by the individualization of the remaining equivalent tensors, choosing the
+     lexicographically smallest canonical network structure among all explored choices.
+     A cache hit is confirmed by an exact comparison of the canonical network structure
+     (including the dimension extents) stored with the plan, after which the stored tensor
+     contraction sequence is remapped to the tensor ids of the given tensor network.
+ (c) Contraction plans are stored in an append-only memory-mapped file which can be
+     shared by multiple processes and reused across multiple runs. Appends are serialized
+     via an exclusive advisory file lock, look-ups are done under a shared file lock.
+**/
+
+#ifndef EXATN_NUMERICS_CONTRACTION_PLAN_CACHE_HPP_
+#define EXATN_NUMERICS_CONTRACTION_PLAN_CACHE_HPP_
+
+#include "tensor_basic.hpp"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace exatn{
+
+namespace numerics{
+
+class TensorNetwork;
+
+class ContractionPlanCache{
+
+public:
+
+ static constexpr const std::size_t DEFAULT_CAPACITY = 64UL * 1024UL * 1024UL; //bytes
+
+ /** Opens an existing or creates a new memory-mapped file storing contraction plans.
+     The capacity is only used when a new file is created. **/
+ ContractionPlanCache(const std::string & file_name,            //in: file name
+                      std::size_t capacity = DEFAULT_CAPACITY); //in: file capacity in bytes
+
+ ContractionPlanCache(const ContractionPlanCache &) = delete;
+ ContractionPlanCache & operator=(const ContractionPlanCache &) = delete;
+ ContractionPlanCache(ContractionPlanCache &&) noexcept = delete;
+ ContractionPlanCache & operator=(ContractionPlanCache &&) noexcept = delete;
+ ~ContractionPlanCache();
+
+ /** Returns TRUE if the memory-mapped file has been successfully opened. **/
+ bool isOpen() const;
+
+ /** Looks up a contraction plan for a given tensor network. If found, imports the
+     tensor contraction sequence into the tensor network (with remapped tensor ids)
+     and returns TRUE, together with the index splitting plan and the intermediate
+     volume limit the latter was generated for. **/
+ bool retrievePlan(TensorNetwork & network,                                               //inout: tensor network
+                   std::vector<std::pair<std::string,std::size_t>> * split_plan = nullptr, //out: index label --> number of segments
+                   std::size_t * max_intermediate_volume = nullptr);                      //out: intermediate volume limit for the index splitting plan
+
+ /** Stores the contraction plan of a given tensor network which must already have
+     its tensor contraction sequence determined. The index splitting plan will be stored
+     if the tensor network indices have been split. Returns FALSE if the plan could not
+     be stored or the same plan has already been stored before. **/
+ bool storePlan(const TensorNetwork & network,            //in: tensor network
+                std::size_t max_intermediate_volume = 0); //in: intermediate volume limit used for index splitting
+
+ /** Computes the canonical structural hash of a tensor network which is invariant
+     to tensor naming and tensor id relabeling. Optionally returns the canonical order
+     of the tensor ids (output tensor first) and the canonical network structure. **/
+ static std::size_t computeStructuralHash(const TensorNetwork & network,                              //in: tensor network
+                                          std::vector<unsigned int> * canonical_order = nullptr,      //out: canonical order of tensor ids
+                                          std::vector<std::uint64_t> * canonical_structure = nullptr); //out: canonical network structure
+
+private:
+
+ //File header:
+ struct FileHeader{
+  std::uint64_t magic;    //file format identifier
+  std::uint64_t version;  //file format version
+  std::uint64_t capacity; //file capacity in 64-bit words
+  std::uint64_t used;     //number of used 64-bit words (including the header)
+ };
+
+ static constexpr const std::uint64_t MAGIC = 0x4e41504e54415845ULL; //file format identifier
+ static constexpr const std::uint64_t VERSION = 2; //file format version
+ static constexpr const std::uint64_t RECORD_HEADER_WORDS = 7; //number of 64-bit words in the record header
+
+ /** Returns TRUE if the record at a given offset (in 64-bit words) is consistent:
+     Its length covers its header and network structure and does not exceed the used space. **/
+ bool isValidRecord(std::size_t offset,      //in: record offset in 64-bit words
+                    std::size_t used) const; //in: number of used 64-bit words
+
+ /** Unmaps and closes the file (also releases the file lock). **/
+ void closeFile();
+
+ std::string file_name_;  //file name
+ int fd_;                 //file descriptor
+ std::uint64_t * base_;   //base address of the memory-mapped file
+ std::size_t capacity_;   //file capacity in 64-bit words
+};
+
+} //namespace numerics
+
+} //namespace exatn
+
+#endif //EXATN_NUMERICS_CONTRACTION_PLAN_CACHE_HPP_
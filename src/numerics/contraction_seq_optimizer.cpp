@@ -1,5 +1,5 @@
 /** ExaTN::Numerics: Tensor contraction sequence optimizer: Base
-REVISION: 2020/08/06
+REVISION: 2020/09/14
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
@@ -7,11 +7,21 @@ Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 #include "contraction_seq_optimizer.hpp"
 #include "tensor_network.hpp"
 #include "metis_graph.hpp"
+#include "contraction_cost_model.hpp"
+#include "timers.hpp"
+
+#include <unordered_set>
+#include <algorithm>
+#include <bitset>
+#include <cmath>
 
 namespace exatn{
 
 namespace numerics{
 
+constexpr const unsigned int ContractionSeqOptimizer::DEFAULT_REFINEMENT_WINDOW;
+constexpr const unsigned int ContractionSeqOptimizer::MAX_REFINEMENT_WINDOW;
+
 //Cache of already determined tensor network contraction sequences:
 std::unordered_map<std::string,ContractionSeqOptimizer::CachedContrSeq> ContractionSeqOptimizer::cached_contr_seqs_;
 
@@ -75,6 +85,246 @@ std::pair<const std::list<ContrTriple> *, double> ContractionSeqOptimizer::findC
  return std::pair<const std::list<ContrTriple> *, double> {nullptr,0.0};
 }
 
+
+double ContractionSeqOptimizer::refineContractionSequence(const TensorNetwork & network,
+                                                          std::list<ContrTriple> & contr_seq,
+                                                          unsigned int window_size,
+                                                          ContrSeqRefinementInfo * refinement_info)
+{
+ constexpr const std::size_t MAX_WINDOW_EDGES = 256; //max number of distinct tensor network edges in a subtree window
+ constexpr const unsigned int MAX_PASSES = 4; //max number of refinement passes over the contraction tree
+ constexpr const double REL_TOLERANCE = 1e-9; //min relative flop reduction required for a subtree window replacement
+ using EdgeSet = std::vector<unsigned int>; //ordered set of tensor network edges (bonds)
+
+ const double time_start = exatn::Timer::timeInSecHR();
+ window_size = std::min(window_size,MAX_REFINEMENT_WINDOW);
+
+ //Enumerate tensor network edges (bonds) and collect open edges of input tensors:
+ std::vector<double> edge_extent; //edge id --> dimension extent
+ std::unordered_map<unsigned int,EdgeSet> open_edges; //tensor id --> its open edges
+ std::unordered_map<std::uint64_t,unsigned int> edge_ids; //tensor leg end (tensor id, dimension id) --> edge id
+ for(auto iter = network.cbegin(); iter != network.cend(); ++iter){
+  const auto tensor_id = iter->first;
+  if(tensor_id != 0){ //input tensor
+   auto & edges = open_edges[tensor_id];
+   const auto & legs = iter->second.getTensorLegs();
+   for(unsigned int i = 0; i < legs.size(); ++i){
+    const std::uint64_t this_end = (static_cast<std::uint64_t>(tensor_id) << 32) | i;
+    const std::uint64_t other_end = (static_cast<std::uint64_t>(legs[i].getTensorId()) << 32) | legs[i].getDimensionId();
+    auto edge = edge_ids.find(other_end);
+    if(edge != edge_ids.end()){
+     edges.emplace_back(edge->second);
+    }else{
+     edges.emplace_back(edge_extent.size());
+     edge_ids.emplace(std::make_pair(this_end,edges.back()));
+     edge_extent.emplace_back(static_cast<double>(iter->second.getDimExtent(i)));
+    }
+   }
+   std::sort(edges.begin(),edges.end());
+  }
+ }
+
+ //Build the contraction tree:
+ std::unordered_map<unsigned int,std::pair<unsigned int,unsigned int>> tree; //intermediate id --> {left id, right id}
+ std::unordered_map<unsigned int,double> node_flops; //intermediate id --> FMA flop count of its contraction
+ std::unordered_map<unsigned int,double> node_cost; //intermediate id --> cost of its contraction (FMA flops or predicted effective flops)
+ std::vector<unsigned int> internal_nodes; //intermediate ids in the original order of contractions
+ const auto * cost_model = ContractionCostModel::getActive(); //calibrated cost model (optional)
+ auto contract_edges = [&](unsigned int result_id, unsigned int left_id, unsigned int right_id){
+  const auto & left_edges = open_edges.at(left_id);
+  const auto & right_edges = open_edges.at(right_id);
+  EdgeSet contr_edges, result_edges;
+  std::set_intersection(left_edges.cbegin(),left_edges.cend(),right_edges.cbegin(),right_edges.cend(),std::back_inserter(contr_edges));
+  std::set_symmetric_difference(left_edges.cbegin(),left_edges.cend(),right_edges.cbegin(),right_edges.cend(),std::back_inserter(result_edges));
+  double left_vol = 1.0, right_vol = 1.0, contr_vol = 1.0;
+  for(const auto & edge: left_edges) left_vol *= edge_extent[edge];
+  for(const auto & edge: right_edges) right_vol *= edge_extent[edge];
+  for(const auto & edge: contr_edges) contr_vol *= edge_extent[edge];
+  const double flops = left_vol * right_vol / contr_vol;
+  node_flops[result_id] = flops;
+  if(cost_model != nullptr){
+   node_cost[result_id] = cost_model->predictEffectiveFlops(left_vol / contr_vol,right_vol / contr_vol,contr_vol,
+                                                            left_edges.size(),right_edges.size(),result_edges.size());
+  }else{
+   node_cost[result_id] = flops;
+  }
+  open_edges[result_id] = std::move(result_edges);
+  tree[result_id] = std::make_pair(left_id,right_id);
+  return flops;
+ };
+ double original_flops = 0.0;
+ for(const auto & contr: contr_seq){
+  original_flops += contract_edges(contr.result_id,contr.left_id,contr.right_id);
+  internal_nodes.emplace_back(contr.result_id);
+ }
+
+ //Refine subtree windows rooted at each intermediate (bottom-up):
+ double total_flops = original_flops;
+ unsigned int num_windows = 0, num_refined = 0;
+ bool refined = false;
+ if(window_size > 2){
+  const unsigned int max_subsets = (1U << window_size);
+  std::vector<std::bitset<MAX_WINDOW_EDGES>> subset_edges(max_subsets); //open edges of a subset of window leaves
+  std::vector<double> subset_vol(max_subsets); //volume of the open edges of a subset of window leaves
+  std::vector<double> subset_vol_sqrt(max_subsets); //square root of the volume of the open edges of a subset of window leaves
+  std::vector<double> subset_cost(max_subsets); //min FMA flop count for contracting a subset of window leaves
+  std::vector<unsigned int> subset_split(max_subsets); //optimal split of a subset of window leaves (left part)
+  std::vector<unsigned int> frontier; //window leaves
+  std::vector<unsigned int> window_nodes; //window intermediates
+  std::vector<std::vector<unsigned int>> leaf_edges; //local edges of each window leaf
+  std::vector<double> local_extent; //local edge --> dimension extent
+  std::unordered_map<unsigned int,unsigned int> local_edge; //edge id --> local edge id
+  bool improved = true;
+  for(unsigned int pass = 0; pass < MAX_PASSES && improved; ++pass){
+   improved = false;
+   for(const auto root_id: internal_nodes){
+    //Grow the subtree window by expanding its most expensive intermediate leaf:
+    frontier.clear(); window_nodes.clear();
+    window_nodes.emplace_back(root_id);
+    frontier.emplace_back(tree[root_id].first);
+    frontier.emplace_back(tree[root_id].second);
+    double window_cost = node_cost[root_id];
+    while(frontier.size() < window_size){
+     int expand = -1;
+     for(int i = 0; i < static_cast<int>(frontier.size()); ++i){
+      auto node = node_cost.find(frontier[i]);
+      if(node != node_cost.end()){
+       if(expand < 0 || node->second > node_cost[frontier[expand]]) expand = i;
+      }
+     }
+     if(expand < 0) break; //only input tensors left
+     const auto node_id = frontier[expand];
+     window_nodes.emplace_back(node_id);
+     window_cost += node_cost[node_id];
+     frontier[expand] = tree[node_id].first;
+     frontier.emplace_back(tree[node_id].second);
+    }
+    const unsigned int num_leaves = frontier.size();
+    if(num_leaves < 3) continue; //nothing to reorder
+    //Map the tensor network edges carried by the window leaves to local edges:
+    local_edge.clear(); local_extent.clear();
+    leaf_edges.resize(num_leaves);
+    for(unsigned int i = 0; i < num_leaves; ++i){
+     leaf_edges[i].clear();
+     for(const auto & edge: open_edges[frontier[i]]){
+      auto res = local_edge.emplace(std::make_pair(edge,local_extent.size()));
+      if(res.second) local_extent.emplace_back(edge_extent[edge]);
+      leaf_edges[i].emplace_back(res.first->second);
+     }
+    }
+    if(local_extent.size() > MAX_WINDOW_EDGES) continue; //window is too wide
+    ++num_windows;
+    //Open edges and volumes of all subsets of window leaves:
+    const unsigned int full_set = (1U << num_leaves) - 1;
+    subset_edges[0].reset();
+    subset_vol[0] = 1.0;
+    double vol = 1.0;
+    for(unsigned int subset = 1; subset <= full_set; ++subset){
+     unsigned int leaf = 0;
+     while(((subset >> leaf) & 1U) == 0) ++leaf;
+     const unsigned int rest = subset ^ (1U << leaf);
+     subset_edges[subset] = subset_edges[rest];
+     vol = subset_vol[rest];
+     for(const auto & edge: leaf_edges[leaf]){
+      if(subset_edges[subset].test(edge)){
+       vol /= local_extent[edge];
+       subset_edges[subset].reset(edge);
+      }else{
+       vol *= local_extent[edge];
+       subset_edges[subset].set(edge);
+      }
+     }
+     subset_vol[subset] = vol;
+     subset_vol_sqrt[subset] = std::sqrt(vol);
+    }
+    //Dynamic programming over subsets of window leaves:
+    for(unsigned int subset = 1; subset <= full_set; ++subset){
+     const unsigned int lowest = subset & (~subset + 1U);
+     if(subset == lowest){ //single leaf
+      subset_cost[subset] = 0.0;
+      continue;
+     }
+     double best_cost = -1.0;
+     unsigned int best_split = 0;
+     for(unsigned int left = (subset - 1) & subset; left > 0; left = (left - 1) & subset){
+      if((left & lowest) == 0) continue; //each split is only considered once
+      const unsigned int right = subset ^ left;
+      //FMA flops = vol(left) * vol(right) / vol(contracted) = sqrt(vol(left) * vol(right) * vol(result)):
+      double cost = subset_vol_sqrt[left] * subset_vol_sqrt[right] * subset_vol_sqrt[subset];
+      if(cost_model != nullptr){
+       const double contr_vol = subset_vol_sqrt[left] * subset_vol_sqrt[right] / subset_vol_sqrt[subset];
+       cost = cost_model->predictEffectiveFlops(subset_vol[left] / contr_vol,subset_vol[right] / contr_vol,contr_vol,
+                                                subset_edges[left].count(),subset_edges[right].count(),subset_edges[subset].count());
+      }
+      cost += subset_cost[left] + subset_cost[right];
+      if(best_cost < 0.0 || cost < best_cost){
+       best_cost = cost;
+       best_split = left;
+      }
+     }
+     subset_cost[subset] = best_cost;
+     subset_split[subset] = best_split;
+    }
+    //Replace the subtree window if its contraction cost has been reduced:
+    if(subset_cost[full_set] < window_cost * (1.0 - REL_TOLERANCE)){
+     std::vector<unsigned int> free_ids(window_nodes.cbegin() + 1,window_nodes.cend()); //root id is retained
+     std::function<unsigned int (unsigned int)> rebuild = [&](unsigned int subset){
+      if((subset & (subset - 1U)) == 0){ //single leaf
+       unsigned int leaf = 0;
+       while(((subset >> leaf) & 1U) == 0) ++leaf;
+       return frontier[leaf];
+      }
+      const auto left_id = rebuild(subset_split[subset]);
+      const auto right_id = rebuild(subset ^ subset_split[subset]);
+      unsigned int node_id = root_id;
+      if(subset != full_set){
+       node_id = free_ids.back();
+       free_ids.pop_back();
+      }
+      contract_edges(node_id,left_id,right_id);
+      return node_id;
+     };
+     rebuild(full_set);
+     assert(free_ids.empty());
+     ++num_refined;
+     improved = true;
+     refined = true;
+    }
+   }
+  }
+ }
+
+ //Regenerate the tensor contraction sequence (post-order traversal of the contraction tree):
+ if(refined){
+  total_flops = 0.0;
+  for(const auto & node: node_flops) total_flops += node.second;
+  contr_seq.clear();
+  std::vector<std::pair<unsigned int,bool>> stack; //{node id, children visited}
+  stack.emplace_back(std::make_pair(0U,false));
+  while(!stack.empty()){
+   auto node = stack.back(); stack.pop_back();
+   auto iter = tree.find(node.first);
+   if(iter != tree.end()){
+    if(node.second){
+     contr_seq.emplace_back(ContrTriple{iter->first,iter->second.first,iter->second.second});
+    }else{
+     stack.emplace_back(std::make_pair(node.first,true));
+     stack.emplace_back(std::make_pair(iter->second.second,false));
+     stack.emplace_back(std::make_pair(iter->second.first,false));
+    }
+   }
+  }
+ }
+ if(refinement_info != nullptr){
+  refinement_info->original_flops = original_flops;
+  refinement_info->refined_flops = total_flops;
+  refinement_info->time = exatn::Timer::timeInSecHR(time_start);
+  refinement_info->num_windows = num_windows;
+  refinement_info->num_refined = num_refined;
+ }
+ return total_flops;
+}
+
 } //namespace numerics
 
 } //namespace exatn
@@ -1,10 +1,15 @@
 /** ExaTN::Numerics: Tensor contraction sequence optimizer
-REVISION: 2020/08/11
+REVISION: 2020/09/14
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 
 /** Rationale:
+ (a) A tensor contraction sequence optimizer determines a pseudo-optimal
+     tensor contraction sequence (contraction tree) for a given tensor network.
+ (b) Any tensor contraction sequence can be further improved by a local refinement
+     post-pass which exactly re-optimizes small subtrees (windows) of the contraction
+     tree via dynamic programming over the subsets of the window leaves.
 **/
 
 #ifndef EXATN_NUMERICS_CONTRACTION_SEQ_OPTIMIZER_HPP_
@@ -29,6 +34,15 @@ struct ContrTriple{
  unsigned int right_id;  //id of the right input tensor (old)
 };
 
+//Tensor contraction sequence refinement info:
+struct ContrSeqRefinementInfo{
+ double original_flops;    //FMA flop count before refinement
+ double refined_flops;     //FMA flop count after refinement
+ double time;              //time spent in refinement (seconds)
+ unsigned int num_windows; //number of inspected subtree windows
+ unsigned int num_refined; //number of re-optimized subtree windows
+};
+
 class TensorNetwork;
 class MetisGraph;
 
@@ -43,6 +57,9 @@ class ContractionSeqOptimizer{
 
 public:
 
+ static constexpr const unsigned int DEFAULT_REFINEMENT_WINDOW = 10; //default max number of leaves in a refined subtree
+ static constexpr const unsigned int MAX_REFINEMENT_WINDOW = 14;     //max number of leaves in a refined subtree
+
  virtual ~ContractionSeqOptimizer() = default;
 
  /** Determines the pseudo-optimal tensor contraction sequence required for
@@ -57,6 +74,18 @@ public:
                                              std::list<ContrTriple> & contr_seq,
                                              std::function<unsigned int ()> intermediate_num_generator) = 0;
 
+ /** Refines a given tensor contraction sequence determined by any optimizer for a given
+     tensor network by exactly re-optimizing its subtrees containing up to window_size leaves
+     (leaves are either input tensors or intermediates computed outside of the subtree).
+     The intermediate tensor id's are preserved, with the output tensor (id 0) staying
+     the root of the contraction tree. If the calibrated cost model is active, the subtrees
+     are re-optimized with respect to the predicted execution time instead of the FMA flop count.
+     Returns the FMA flop count of the refined sequence. **/
+ static double refineContractionSequence(const TensorNetwork & network,                           //in: tensor network
+                                         std::list<ContrTriple> & contr_seq,                      //inout: tensor contraction sequence
+                                         unsigned int window_size = DEFAULT_REFINEMENT_WINDOW,    //in: max number of leaves in a refined subtree
+                                         ContrSeqRefinementInfo * refinement_info = nullptr);     //out: refinement info
+
  /** Caches the determined pseudo-optimal tensor contraction sequence for a given
      tensor network for a later retrieval for the same tensor networks. Returns TRUE
      on success, FALSE in case this tensor network has already been cached before. **/
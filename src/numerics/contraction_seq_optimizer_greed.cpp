@@ -1,11 +1,12 @@
 /** ExaTN::Numerics: Tensor contraction sequence optimizer: Greedy heuristics
-REVISION: 2020/04/29
+REVISION: 2020/09/25
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 
 #include "contraction_seq_optimizer_greed.hpp"
 #include "tensor_network.hpp"
+#include "flat_tensor_network.hpp"
 
 #include <cassert>
 
@@ -47,10 +48,14 @@ double ContractionSeqOptimizerGreed::determineContractionSequence(const TensorNe
  const bool only_connected = true;
 
  using ContractionSequence = std::list<ContrTriple>;
- using ContrPath = std::tuple<TensorNetwork,       //0: current state of the tensor network
+ using ContrPath = std::tuple<FlatTensorNetwork,   //0: current state of the tensor network (flat layout)
                               ContractionSequence, //1: tensor contraction sequence resulted in this state
-                              double,              //2: current total flop count
-                              double>;             //3: local differential volume (temporary)
+                              double>;             //2: current total flop count
+ using ContrCandidate = std::tuple<std::size_t,    //0: parental contraction path
+                                   unsigned int,   //1: left tensor id
+                                   unsigned int,   //2: right tensor id
+                                   double,         //3: total flop count
+                                   double>;        //4: local differential volume
 
  contr_seq.clear();
  double flops = 0.0;
@@ -61,16 +66,14 @@ double ContractionSeqOptimizerGreed::determineContractionSequence(const TensorNe
  if(debugging) std::cout << "#DEBUG(ContractionSeqOptimizerGreed): Determining a pseudo-optimal tensor contraction sequence ... \n"; //debug
  auto timeBeg = std::chrono::high_resolution_clock::now();
 
- ContractionSequence contrSeqEmpty;
  std::vector<ContrPath> inputPaths; //considered contraction paths
- inputPaths.emplace_back(std::make_tuple(network,contrSeqEmpty,0.0,0.0)); //initial configuration
+ inputPaths.emplace_back(std::make_tuple(FlatTensorNetwork(network),ContractionSequence(),0.0)); //initial configuration
 
- //auto cmpPaths = [](const ContrPath & left, const ContrPath & right){return (std::get<3>(left) < std::get<3>(right));};
- auto cmpPaths = [](const ContrPath & left, const ContrPath & right){
-                    if(std::get<3>(left) == std::get<3>(right)) return (std::get<2>(left) < std::get<2>(right));
-                    return (std::get<3>(left) < std::get<3>(right));
+ auto cmpCands = [](const ContrCandidate & left, const ContrCandidate & right){
+                    if(std::get<4>(left) == std::get<4>(right)) return (std::get<3>(left) < std::get<3>(right));
+                    return (std::get<4>(left) < std::get<4>(right));
                    };
- std::priority_queue<ContrPath, std::vector<ContrPath>, decltype(cmpPaths)> priq(cmpPaths); //prioritized contraction paths
+ std::priority_queue<ContrCandidate, std::vector<ContrCandidate>, decltype(cmpCands)> priq(cmpCands); //prioritized contraction candidates
 
  //Loop over the tensor contractions (passes):
  for(decltype(numContractions) pass = 0; pass < numContractions; ++pass){
@@ -79,60 +82,36 @@ double ContractionSeqOptimizerGreed::determineContractionSequence(const TensorNe
              << inputPaths.size() << " candidates" << std::endl; //debug
   }
   unsigned int intermediate_id = intermediate_num_generator(); //id of the next intermediate tensor
-  unsigned int numPassCands = 0, candid = 0;
-  //Update the list of promising contraction path candidates due to a new tensor contraction:
-  for(auto & contrPath: inputPaths){
-   //std::cout << " #DEBUG(ContractionSeqOptimizerGreed): Processing candidate path " << candid++ << std::endl; //debug
-   auto & parentTensNet = std::get<0>(contrPath); //parental tensor network
-   const auto numTensors = parentTensNet.getNumTensors(); //number of r.h.s. tensors in the parental tensor network
-   const auto & parentContrSeq = std::get<1>(contrPath); //contraction sequence for the parental tensor network
+  unsigned int numPassCands = 0;
+  //Update the list of promising contraction candidates due to a new tensor contraction
+  //(only the surviving candidates will have their tensor networks updated):
+  for(std::size_t path = 0; path < inputPaths.size(); ++path){
+   const auto & parentTensNet = std::get<0>(inputPaths[path]); //parental tensor network
+   const auto parentFlops = std::get<2>(inputPaths[path]);
+   const auto slots = parentTensNet.getSlots();
    //Inspect contractions of all unique pairs of tensors:
-   for(auto iter_i = parentTensNet.begin(); iter_i != parentTensNet.end(); ++iter_i){ //r.h.s. tensors
-    auto i = iter_i->first;
-    if(i != 0){ //exclude output tensor
-     const auto & tensor_i = iter_i->second; //connected tensor i
-     //std::cout << "  First tensor id " << i << std::endl; //debug
+   for(std::size_t slot_i = 0; slot_i < slots.size(); ++slot_i){ //r.h.s. tensors
+    const auto i = slots[slot_i];
+    if(i != 0){ //exclude free slots
      const auto adjacent_tensors = parentTensNet.getAdjacentTensors(i);
      if(only_connected && !adjacent_tensors.empty()){
-      for(auto & j: adjacent_tensors){
+      for(const auto j: adjacent_tensors){
        if(j > i){ //unique pairs
-        const auto & tensor_j = *(parentTensNet.getTensorConn(j));
         double diff_vol;
-        double contrCost = getTensorContractionCost(tensor_i,tensor_j,&diff_vol); //tensor contraction cost (flops)
-        //double contrCost = parentTensNet.getContractionCost(i,j,&diff_vol); //tensor contraction cost (flops)
-        //std::cout << "  New candidate contracted pair of tensors is {" << i << "," << j << "} with cost " << contrCost << std::endl; //debug
-        TensorNetwork tensNet(parentTensNet);
-        auto contracted = tensNet.mergeTensors(i,j,intermediate_id); assert(contracted);
-        auto cSeq = parentContrSeq;
-        if(pass == numContractions - 1){ //the very last tensor contraction writes into the output tensor #0
-         cSeq.emplace_back(ContrTriple{0,i,j}); //append the last pair of contracted tensors
-        }else{
-         cSeq.emplace_back(ContrTriple{intermediate_id,i,j}); //append a new pair of contracted tensors
-        }
-        priq.emplace(std::make_tuple(tensNet, cSeq, contrCost + std::get<2>(contrPath), diff_vol)); //cloning tensor network and contraction sequence
-        if(priq.size() > num_walkers_) priq.pop(); //remove the top-costly contraction path when limit achieved
+        double contrCost = parentTensNet.getContractionCost(i,j,&diff_vol,true); //tensor contraction cost (flops or predicted effective flops)
+        priq.emplace(std::make_tuple(path,i,j,contrCost + parentFlops,diff_vol));
+        if(priq.size() > num_walkers_) priq.pop(); //remove the top-costly contraction candidate when limit achieved
         numPassCands++;
        }
       }
      }else{
-      for(auto iter_j = std::next(iter_i); iter_j != parentTensNet.end(); ++iter_j){ //r.h.s. tensors
-       auto j = iter_j->first;
-       if(j != 0){ //exclude output tensor
-        const auto & tensor_j = iter_j->second; //connected tensor j
+      for(std::size_t slot_j = slot_i + 1; slot_j < slots.size(); ++slot_j){ //r.h.s. tensors
+       const auto j = slots[slot_j];
+       if(j != 0){ //exclude free slots
         double diff_vol;
-        double contrCost = getTensorContractionCost(tensor_i,tensor_j,&diff_vol); //tensor contraction cost (flops)
-        //double contrCost = parentTensNet.getContractionCost(i,j,&diff_vol); //tensor contraction cost (flops)
-        //std::cout << "  New candidate contracted pair of tensors is {" << i << "," << j << "} with cost " << contrCost << std::endl; //debug
-        TensorNetwork tensNet(parentTensNet);
-        auto contracted = tensNet.mergeTensors(i,j,intermediate_id); assert(contracted);
-        auto cSeq = parentContrSeq;
-        if(pass == numContractions - 1){ //the very last tensor contraction writes into the output tensor #0
-         cSeq.emplace_back(ContrTriple{0,i,j}); //append the last pair of contracted tensors
-        }else{
-         cSeq.emplace_back(ContrTriple{intermediate_id,i,j}); //append a new pair of contracted tensors
-        }
-        priq.emplace(std::make_tuple(tensNet, cSeq, contrCost + std::get<2>(contrPath), diff_vol)); //cloning tensor network and contraction sequence
-        if(priq.size() > num_walkers_) priq.pop(); //remove the top-costly contraction path when limit achieved
+        double contrCost = parentTensNet.getContractionCost(i,j,&diff_vol,true); //tensor contraction cost (flops or predicted effective flops)
+        priq.emplace(std::make_tuple(path,i,j,contrCost + parentFlops,diff_vol));
+        if(priq.size() > num_walkers_) priq.pop(); //remove the top-costly contraction candidate when limit achieved
         numPassCands++;
        }
       }
@@ -144,22 +123,31 @@ double ContractionSeqOptimizerGreed::determineContractionSequence(const TensorNe
    std::cout << "#DEBUG(ContractionSeqOptimizerGreed): Pass " << pass << ": Total number of candidates considered = "
              << numPassCands << std::endl; //debug
   }
-  //Collect the cheapest contraction paths left:
-  inputPaths.clear();
+  //Collect the cheapest contraction candidates left:
   if(pass == numContractions - 1){ //last pass
-   while(priq.size() > 1) priq.pop(); //get to the cheapest contraction path
-   contr_seq = std::get<1>(priq.top());
-   flops = std::get<2>(priq.top());
+   while(priq.size() > 1) priq.pop(); //get to the cheapest contraction candidate
+   const auto & best = priq.top();
+   contr_seq = std::get<1>(inputPaths[std::get<0>(best)]);
+   contr_seq.emplace_back(ContrTriple{0,std::get<1>(best),std::get<2>(best)}); //the very last tensor contraction writes into the output tensor #0
+   flops = std::get<3>(best);
    priq.pop();
    if(debugging){
     std::cout << "#DEBUG(ContractionSeqOptimizerGreed): Best tensor contraction sequence found has cost (flops) = "
               << flops << std::endl; //debug
    }
-  }else{ //intermediate pass
+  }else{ //intermediate pass: Apply the surviving tensor contractions
+   std::vector<ContrPath> outputPaths;
    while(priq.size() > 0){
-    inputPaths.emplace_back(priq.top());
+    const auto & cand = priq.top();
+    const auto & parentPath = inputPaths[std::get<0>(cand)];
+    outputPaths.emplace_back(parentPath); //cloning tensor network and contraction sequence
+    auto & contrPath = outputPaths.back();
+    auto contracted = std::get<0>(contrPath).mergeTensors(std::get<1>(cand),std::get<2>(cand),intermediate_id); assert(contracted);
+    std::get<1>(contrPath).emplace_back(ContrTriple{intermediate_id,std::get<1>(cand),std::get<2>(cand)}); //append a new pair of contracted tensors
+    std::get<2>(contrPath) = std::get<3>(cand);
     priq.pop();
    }
+   inputPaths.swap(outputPaths);
   }
  }
 
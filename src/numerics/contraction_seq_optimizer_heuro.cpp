@@ -1,5 +1,5 @@
 /** ExaTN::Numerics: Tensor contraction sequence optimizer: Greedy heuristics
-REVISION: 2020/04/29
+REVISION: 2020/09/16
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
@@ -78,7 +78,7 @@ double ContractionSeqOptimizerHeuro::determineContractionSequence(const TensorNe
       auto j = iter_j->first;
       if(j != 0){ //exclude output tensor
        const auto & tensor_j = iter_j->second; //connected tensor j
-       double contrCost = getTensorContractionCost(tensor_i,tensor_j); //tensor contraction cost (flops)
+       double contrCost = getTensorContractionCost(tensor_i,tensor_j,nullptr,nullptr,true); //tensor contraction cost (flops or predicted effective flops)
        //double contrCost = parentTensNet.getContractionCost(i,j); //tensor contraction cost (flops)
        //std::cout << "  New candidate contracted pair of tensors is {" << i << "," << j << "} with cost " << contrCost << std::endl; //debug
        TensorNetwork tensNet(parentTensNet);
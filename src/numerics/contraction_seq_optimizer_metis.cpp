@@ -1,5 +1,5 @@
 /** ExaTN::Numerics: Tensor contraction sequence optimizer: Metis heuristics
-REVISION: 2020/05/20
+REVISION: 2020/09/25
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
@@ -8,6 +8,7 @@ Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 #include "tensor_network.hpp"
 
 #include "metis_graph.hpp"
+#include "flat_tensor_network.hpp"
 
 #include <algorithm>
 #include <random>
@@ -76,12 +77,12 @@ double ContractionSeqOptimizerMetis::determineContractionSequence(const TensorNe
    //Determine a tensor contraction sequence:
    std::list<ContrTriple> cseq;
    determineContrSequence(network,cseq,intermediate_num_generator);
-   //Compute the total FMA flop count:
-   TensorNetwork net(network);
+   //Compute the total FMA flop count (or the predicted effective flop count if the calibrated cost model is active):
+   FlatTensorNetwork net(network);
    std::vector<double> contr_flops(cseq.size(),0.0);
    double flps = 0.0; std::size_t i = 0;
    for(const auto & contr_triple: cseq){
-    contr_flops[i] = net.getContractionCost(contr_triple.left_id,contr_triple.right_id);
+    contr_flops[i] = net.getContractionCost(contr_triple.left_id,contr_triple.right_id,nullptr,true);
     flps += contr_flops[i++];
     if(contr_triple.result_id != 0){ //intermediate tensor contraction
      bool success = net.mergeTensors(contr_triple.left_id,contr_triple.right_id,contr_triple.result_id);
@@ -0,0 +1,359 @@
+/** ExaTN::Numerics: Tensor contraction sequence optimizer: Tree decomposition heuristics
+REVISION: 2020/10/07
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+#include "contraction_seq_optimizer_treewidth.hpp"
+#include "tensor_network.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <random>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <chrono>
+
+#include <cmath>
+#include <cassert>
+
+namespace exatn{
+
+namespace numerics{
+
+constexpr const double ContractionSeqOptimizerTreewidth::DEFAULT_TIME_BUDGET;
+constexpr const unsigned int ContractionSeqOptimizerTreewidth::MAX_TRIALS;
+
+double ContractionSeqOptimizerTreewidth::time_budget_ = ContractionSeqOptimizerTreewidth::DEFAULT_TIME_BUDGET;
+double ContractionSeqOptimizerTreewidth::contraction_width_ = 0.0;
+
+
+void ContractionSeqOptimizerTreewidth::resetTimeBudget(double time_budget)
+{
+ assert(time_budget >= 0.0);
+ time_budget_ = time_budget;
+ return;
+}
+
+
+double ContractionSeqOptimizerTreewidth::getTimeBudget()
+{
+ return time_budget_;
+}
+
+
+double ContractionSeqOptimizerTreewidth::getContractionWidth()
+{
+ return contraction_width_;
+}
+
+
+void ContractionSeqOptimizerTreewidth::buildIndexGraph(const TensorNetwork & network,
+                                                       IndexGraph & graph)
+{
+ graph = IndexGraph();
+ std::map<std::pair<unsigned int,unsigned int>,unsigned int> bundles; //{tensor id, tensor id} --> index bundle id
+ std::map<unsigned int,std::vector<unsigned int>> tensor_bundles; //tensor id --> index bundles carried by the tensor
+ for(auto iter = network.cbegin(); iter != network.cend(); ++iter){
+  const auto tensor_id = iter->first;
+  if(tensor_id == 0) continue; //output tensor
+  auto & carried = tensor_bundles[tensor_id];
+  const auto & legs = iter->second.getTensorLegs();
+  for(unsigned int dim = 0; dim < legs.size(); ++dim){
+   const auto other_id = legs[dim].getTensorId();
+   if(other_id == tensor_id){ //trace legs do not form index bundles but contribute to the tensor volume
+    graph.trace_weight[tensor_id] += std::log2(static_cast<double>(iter->second.getDimExtent(dim)));
+    continue;
+   }
+   const auto key = (other_id == 0) ? std::make_pair(tensor_id,tensor_id) //open index bundle
+                                    : std::make_pair(std::min(tensor_id,other_id),std::max(tensor_id,other_id));
+   auto res = bundles.emplace(std::make_pair(key,static_cast<unsigned int>(graph.weight.size())));
+   if(res.second){ //new index bundle
+    graph.weight.emplace_back(0.0);
+    graph.open.emplace_back(other_id == 0);
+    graph.tensors.emplace_back(key);
+   }
+   carried.emplace_back(res.first->second);
+   //Each contracted edge is seen from both tensors but accounted once:
+   if(other_id == 0 || tensor_id < other_id){
+    graph.weight[res.first->second] += std::log2(static_cast<double>(iter->second.getDimExtent(dim)));
+   }
+  }
+ }
+ //Index bundles carried by the same tensor are adjacent:
+ graph.adjacency.resize(graph.weight.size());
+ for(const auto & carried: tensor_bundles){
+  for(const auto & b0: carried.second){
+   for(const auto & b1: carried.second){
+    if(b1 != b0) graph.adjacency[b0].emplace_back(b1);
+   }
+  }
+ }
+ for(auto & neighbors: graph.adjacency){
+  std::sort(neighbors.begin(),neighbors.end());
+  neighbors.erase(std::unique(neighbors.begin(),neighbors.end()),neighbors.end());
+ }
+ return;
+}
+
+
+double ContractionSeqOptimizerTreewidth::generateEliminationOrder(const IndexGraph & graph,
+                                                                  bool min_fill,
+                                                                  unsigned int seed,
+                                                                  double width_bound,
+                                                                  std::vector<unsigned int> & order)
+{
+ const unsigned int num_vertices = graph.weight.size();
+ auto adjacency = graph.adjacency; //elimination graph (lazily ignores eliminated vertices)
+ std::vector<bool> alive(num_vertices,true);
+ std::vector<std::pair<double,double>> score(num_vertices); //{primary score, weighted degree}
+ std::mt19937 generator(seed);
+ order.clear();
+
+ auto adjacent = [&adjacency](unsigned int v0, unsigned int v1){
+  return std::binary_search(adjacency[v0].cbegin(),adjacency[v0].cend(),v1);
+ };
+ auto connect = [&adjacency](unsigned int v0, unsigned int v1){
+  auto pos = std::lower_bound(adjacency[v0].begin(),adjacency[v0].end(),v1);
+  if(pos == adjacency[v0].end() || *pos != v1) adjacency[v0].insert(pos,v1);
+ };
+ auto compute_score = [&](unsigned int v){
+  std::vector<unsigned int> neighbors;
+  double weighted_degree = 0.0;
+  for(const auto & n: adjacency[v]){
+   if(alive[n]){
+    neighbors.emplace_back(n);
+    weighted_degree += graph.weight[n];
+   }
+  }
+  double fill = 0.0;
+  if(min_fill){
+   for(std::size_t i = 0; i < neighbors.size(); ++i){
+    for(std::size_t j = i + 1; j < neighbors.size(); ++j){
+     if(!adjacent(neighbors[i],neighbors[j])) fill += 1.0;
+    }
+   }
+  }else{
+   fill = weighted_degree;
+  }
+  score[v] = std::make_pair(fill,weighted_degree);
+ };
+
+ unsigned int num_eliminated = 0;
+ for(unsigned int v = 0; v < num_vertices; ++v){
+  if(graph.open[v]) ++num_eliminated; else compute_score(v);
+ }
+ double width = 0.0;
+ std::vector<unsigned int> candidates;
+ while(num_eliminated < num_vertices){
+  //Select the next vertex to eliminate:
+  candidates.clear();
+  for(unsigned int v = 0; v < num_vertices; ++v){
+   if(alive[v] && !graph.open[v]){
+    if(candidates.empty()){
+     candidates.emplace_back(v);
+    }else{
+     const auto & best = score[candidates[0]];
+     if(score[v].first < best.first || (seed == 0 && score[v].first == best.first && score[v].second < best.second)){
+      candidates.clear();
+      candidates.emplace_back(v);
+     }else if(score[v] == best || (seed != 0 && score[v].first == best.first)){
+      candidates.emplace_back(v);
+     }
+    }
+   }
+  }
+  unsigned int vertex = candidates[0];
+  if(seed != 0 && candidates.size() > 1){
+   vertex = candidates[std::uniform_int_distribution<std::size_t>(0,candidates.size()-1)(generator)];
+  }
+  //Eliminate the selected vertex:
+  std::vector<unsigned int> neighbors;
+  double clique_width = graph.weight[vertex];
+  for(const auto & n: adjacency[vertex]){
+   if(alive[n]){
+    neighbors.emplace_back(n);
+    clique_width += graph.weight[n];
+   }
+  }
+  width = std::max(width,clique_width);
+  if(width > width_bound) return -1.0; //elimination ordering is no better than the known one
+  alive[vertex] = false;
+  order.emplace_back(vertex);
+  ++num_eliminated;
+  for(std::size_t i = 0; i < neighbors.size(); ++i){
+   for(std::size_t j = i + 1; j < neighbors.size(); ++j){
+    if(!adjacent(neighbors[i],neighbors[j])){
+     connect(neighbors[i],neighbors[j]);
+     connect(neighbors[j],neighbors[i]);
+    }
+   }
+  }
+  //Update the scores of the affected vertices (within distance two from the eliminated one):
+  std::vector<unsigned int> affected(neighbors);
+  if(min_fill){
+   for(const auto & n: neighbors){
+    for(const auto & m: adjacency[n]) if(alive[m]) affected.emplace_back(m);
+   }
+   std::sort(affected.begin(),affected.end());
+   affected.erase(std::unique(affected.begin(),affected.end()),affected.end());
+  }
+  for(const auto & v: affected) if(!graph.open[v]) compute_score(v);
+ }
+ return width;
+}
+
+
+std::pair<double,double> ContractionSeqOptimizerTreewidth::convertEliminationOrder(const TensorNetwork & network,
+                                                                                   const IndexGraph & graph,
+                                                                                   const std::vector<unsigned int> & order,
+                                                                                   std::list<ContrTriple> & contr_seq)
+{
+ //Current tensors (input or intermediate) represented by the sets of carried index bundles:
+ struct Node{
+  unsigned int id;                  //tensor id (input or intermediate)
+  std::vector<unsigned int> bundles; //sorted index bundles carried by the tensor
+  double log_volume;                 //log2 of the tensor volume
+ };
+ contr_seq.clear();
+ std::vector<Node> nodes;
+ std::unordered_map<unsigned int,unsigned int> parent; //input tensor id --> node (union-find)
+ unsigned int next_id = 0;
+ for(auto iter = network.cbegin(); iter != network.cend(); ++iter){
+  if(iter->first != 0){
+   parent[iter->first] = nodes.size();
+   auto trace = graph.trace_weight.find(iter->first);
+   nodes.emplace_back(Node{iter->first,{},(trace != graph.trace_weight.end()) ? trace->second : 0.0});
+  }
+  next_id = std::max(next_id,iter->first + 1);
+ }
+ for(unsigned int b = 0; b < graph.tensors.size(); ++b){
+  const auto & tensors = graph.tensors[b];
+  for(const auto & tensor_id: {tensors.first,tensors.second}){
+   auto & node = nodes[parent[tensor_id]];
+   if(node.bundles.empty() || node.bundles.back() != b){
+    node.bundles.emplace_back(b);
+    node.log_volume += graph.weight[b];
+   }
+  }
+ }
+ std::vector<unsigned int> node_parent(nodes.size());
+ for(unsigned int i = 0; i < node_parent.size(); ++i) node_parent[i] = i;
+ std::function<unsigned int (unsigned int)> find_root = [&](unsigned int i){
+  while(node_parent[i] != i){node_parent[i] = node_parent[node_parent[i]]; i = node_parent[i];}
+  return i;
+ };
+ unsigned int num_contractions = nodes.size() - 1;
+ double flops = 0.0, width = 0.0;
+ auto contract = [&](unsigned int n0, unsigned int n1){
+  auto & left = nodes[n0];
+  auto & right = nodes[n1];
+  std::vector<unsigned int> bundles;
+  std::set_symmetric_difference(left.bundles.cbegin(),left.bundles.cend(),
+                                right.bundles.cbegin(),right.bundles.cend(),std::back_inserter(bundles));
+  double log_volume = 0.0;
+  for(const auto & b: bundles) log_volume += graph.weight[b];
+  flops += std::exp2(0.5 * (left.log_volume + right.log_volume + log_volume)); //left * right / contracted
+  width = std::max(width,log_volume);
+  const unsigned int result_id = (contr_seq.size() + 1 == num_contractions) ? 0 : next_id++;
+  contr_seq.emplace_back(ContrTriple{result_id,left.id,right.id});
+  left = Node{result_id,bundles,log_volume};
+  node_parent[n1] = n0;
+  return;
+ };
+ //Contract pairs of tensors sharing the eliminated index bundles:
+ for(const auto & b: order){
+  const auto n0 = find_root(parent[graph.tensors[b].first]);
+  const auto n1 = find_root(parent[graph.tensors[b].second]);
+  if(n0 != n1) contract(n0,n1);
+ }
+ //Contract the remaining tensors (disconnected or only carrying open index bundles) in the order of increasing volume:
+ std::vector<unsigned int> roots;
+ for(unsigned int i = 0; i < nodes.size(); ++i) if(find_root(i) == i) roots.emplace_back(i);
+ while(roots.size() > 1){
+  std::sort(roots.begin(),roots.end(),[&nodes](unsigned int n0, unsigned int n1){
+   return nodes[n0].log_volume > nodes[n1].log_volume;
+  });
+  const auto n1 = roots.back(); roots.pop_back();
+  const auto n0 = roots.back();
+  contract(n0,n1);
+ }
+ assert(contr_seq.size() == num_contractions);
+ return std::make_pair(flops,width);
+}
+
+
+double ContractionSeqOptimizerTreewidth::determineContractionSequence(const TensorNetwork & network,
+                                                                      std::list<ContrTriple> & contr_seq,
+                                                                      std::function<unsigned int ()> intermediate_num_generator)
+{
+ const bool debugging = false;
+ const double WIDTH_TOLERANCE = 1e-6;
+
+ contr_seq.clear();
+ contraction_width_ = 0.0;
+ double flops = 0.0;
+ if(network.getNumTensors() < 2) return flops;
+
+ auto time_beg = std::chrono::high_resolution_clock::now();
+ IndexGraph graph;
+ buildIndexGraph(network,graph);
+ std::list<ContrTriple> best_seq, seq;
+ std::vector<unsigned int> order;
+ double best_elim_width = std::numeric_limits<double>::max();
+ double best_width = std::numeric_limits<double>::max();
+ double best_flops = std::numeric_limits<double>::max();
+ unsigned int num_trials = 0;
+ for(unsigned int trial = 0; trial < MAX_TRIALS; ++trial){
+  const bool min_fill = (trial % 4 != 3); //every fourth trial uses the min-degree heuristics
+  const double elim_width = generateEliminationOrder(graph,min_fill,trial,best_elim_width,order);
+  ++num_trials;
+  if(elim_width >= 0.0){
+   best_elim_width = std::min(best_elim_width,elim_width);
+   const auto cost = convertEliminationOrder(network,graph,order,seq);
+   if(cost.second < best_width - WIDTH_TOLERANCE ||
+      (cost.second <= best_width + WIDTH_TOLERANCE && cost.first < best_flops)){
+    best_flops = cost.first;
+    best_width = cost.second;
+    best_seq = seq;
+   }
+  }
+  auto time_end = std::chrono::high_resolution_clock::now();
+  if(std::chrono::duration_cast<std::chrono::duration<double>>(time_end - time_beg).count() >= time_budget_) break;
+ }
+ assert(!best_seq.empty());
+ //Renumber the intermediate tensors:
+ std::unordered_map<unsigned int,unsigned int> intermediates; //temporary intermediate id --> generated intermediate id
+ for(auto & contr: best_seq){
+  auto iter = intermediates.find(contr.left_id);
+  if(iter != intermediates.end()) contr.left_id = iter->second;
+  iter = intermediates.find(contr.right_id);
+  if(iter != intermediates.end()) contr.right_id = iter->second;
+  if(contr.result_id != 0){
+   const auto result_id = intermediate_num_generator();
+   intermediates[contr.result_id] = result_id;
+   contr.result_id = result_id;
+  }
+ }
+ contr_seq = std::move(best_seq);
+ flops = best_flops;
+ contraction_width_ = best_width;
+ if(debugging){
+  auto time_end = std::chrono::high_resolution_clock::now();
+  std::cout << "#DEBUG(ContractionSeqOptimizerTreewidth): Done (" << num_trials << " trials, "
+            << std::chrono::duration_cast<std::chrono::duration<double>>(time_end - time_beg).count()
+            << " sec): Contraction width = " << contraction_width_ << "; FMA flops = " << flops << std::endl; //debug
+ }
+ return flops;
+}
+
+
+std::unique_ptr<ContractionSeqOptimizer> ContractionSeqOptimizerTreewidth::createNew()
+{
+ return std::unique_ptr<ContractionSeqOptimizer>(new ContractionSeqOptimizerTreewidth());
+}
+
+} //namespace numerics
+
+} //namespace exatn
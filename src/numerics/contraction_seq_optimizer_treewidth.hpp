@@ -0,0 +1,108 @@
+/** ExaTN::Numerics: Tensor contraction sequence optimizer: Tree decomposition heuristics
+REVISION: 2020/10/07
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+/** Rationale:
+ (a) The tensor contraction sequence is derived from an elimination ordering of the
+     index graph (line graph) of the tensor network: Each vertex of the index graph is
+     a bundle of the tensor network edges connecting the same pair of tensors (or the
+     open edges of a tensor), weighted by the log2 of its dimension volume; two vertices
+     are adjacent if they are carried by the same tensor. Eliminating an index bundle
+     contracts the two tensors currently carrying it. The contraction width, that is,
+     the log2 of the largest intermediate tensor volume, is bounded by the weighted
+     width of the elimination ordering (tree decomposition of the line graph).
+     Trace legs (connecting a tensor to itself) do not form index bundles, but
+     they do contribute to the volume of the input tensor carrying them.
+ (b) Elimination orderings are found by the weighted min-fill and min-degree heuristics
+     with randomized tie breaking, repeated until the time budget is exhausted. The open
+     index bundles (connected to the output tensor) are never eliminated. The sequence
+     with the smallest contraction width is selected, ties being resolved by the FMA
+     flop count. This is well suited for quantum circuit tensor networks where the
+     recursive graph bisection performs poorly.
+ (c) The time budget and the achieved contraction width are process-wide settings
+     since tensor contraction sequence optimizers are instantiated by name.
+**/
+
+#ifndef EXATN_NUMERICS_CONTRACTION_SEQ_OPTIMIZER_TREEWIDTH_HPP_
+#define EXATN_NUMERICS_CONTRACTION_SEQ_OPTIMIZER_TREEWIDTH_HPP_
+
+#include "contraction_seq_optimizer.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace exatn{
+
+namespace numerics{
+
+class ContractionSeqOptimizerTreewidth: public ContractionSeqOptimizer{
+
+public:
+
+ static constexpr const double DEFAULT_TIME_BUDGET = 1.0; //default time budget (seconds)
+ static constexpr const unsigned int MAX_TRIALS = 256;    //max number of tried elimination orderings
+
+ ContractionSeqOptimizerTreewidth() = default;
+ virtual ~ContractionSeqOptimizerTreewidth() = default;
+
+ virtual double determineContractionSequence(const TensorNetwork & network,
+                                             std::list<ContrTriple> & contr_seq,
+                                             std::function<unsigned int ()> intermediate_num_generator) override;
+
+ /** Resets the time budget for the search of elimination orderings (seconds).
+     At least one elimination ordering is always generated. **/
+ static void resetTimeBudget(double time_budget);
+
+ /** Returns the current time budget (seconds). **/
+ static double getTimeBudget();
+
+ /** Returns the contraction width (log2 of the largest intermediate tensor volume)
+     of the most recently determined tensor contraction sequence. **/
+ static double getContractionWidth();
+
+ static std::unique_ptr<ContractionSeqOptimizer> createNew();
+
+protected:
+
+ //Index graph of a tensor network:
+ struct IndexGraph{
+  std::vector<double> weight;                    //log2 of the index bundle volume
+  std::vector<bool> open;                        //whether or not the index bundle is open (connected to the output tensor)
+  std::vector<std::pair<unsigned int,unsigned int>> tensors; //pair of input tensors carrying the index bundle (the same for open bundles)
+  std::vector<std::vector<unsigned int>> adjacency; //sorted adjacency lists
+  std::unordered_map<unsigned int,double> trace_weight; //input tensor id --> log2 of the volume of its trace legs (connected to itself)
+ };
+
+ /** Builds the index graph of a tensor network. **/
+ static void buildIndexGraph(const TensorNetwork & network,
+                             IndexGraph & graph);
+
+ /** Generates an elimination ordering of the non-open index bundles by the weighted
+     min-fill (or min-degree) heuristics with optional randomized tie breaking. Returns
+     the weighted width of the elimination ordering, or a negative value if the width
+     has exceeded the provided upper bound (elimination is aborted). **/
+ static double generateEliminationOrder(const IndexGraph & graph,
+                                        bool min_fill,
+                                        unsigned int seed,
+                                        double width_bound,
+                                        std::vector<unsigned int> & order);
+
+ /** Converts an elimination ordering into a tensor contraction sequence with tensor ids
+     starting from zero (output tensor) such that the intermediate tensors are numbered
+     sequentially after the input tensors. Returns the FMA flop count and the contraction width. **/
+ static std::pair<double,double> convertEliminationOrder(const TensorNetwork & network,
+                                                         const IndexGraph & graph,
+                                                         const std::vector<unsigned int> & order,
+                                                         std::list<ContrTriple> & contr_seq);
+
+ static double time_budget_;       //time budget (seconds)
+ static double contraction_width_; //contraction width of the most recently determined sequence
+};
+
+} //namespace numerics
+
+} //namespace exatn
+
+#endif //EXATN_NUMERICS_CONTRACTION_SEQ_OPTIMIZER_TREEWIDTH_HPP_
@@ -0,0 +1,420 @@
+/** ExaTN::Numerics: Cached environments of a closed tensor network swept over its sites
+REVISION: 2020/09/29
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+#include "environment_cache.hpp"
+#include "tensor_symbol.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <iostream>
+
+#include <cassert>
+
+namespace exatn{
+
+namespace numerics{
+
+EnvironmentCache::EnvironmentCache(std::shared_ptr<TensorNetwork> network,
+                                   const std::vector<std::string> & sites):
+ network_(network), site_names_(sites), max_tensor_id_(0)
+{
+ assert(network_ && network_->isFinalized());
+ assert(network_->getRank() == 0); //closed tensor network
+ const unsigned int num_sites = site_names_.size();
+ assert(num_sites > 0);
+ //Collect the tensor ids in the order of increasing id:
+ std::vector<unsigned int> tensor_ids;
+ for(auto iter = network_->cbegin(); iter != network_->cend(); ++iter){
+  if(iter->first != 0) tensor_ids.emplace_back(iter->first);
+ }
+ std::sort(tensor_ids.begin(),tensor_ids.end());
+ max_tensor_id_ = tensor_ids.back();
+ //Assign the tensors defining the sites:
+ site_tensors_.resize(num_sites);
+ std::deque<unsigned int> bfs;
+ for(unsigned int site = 0; site < num_sites; ++site){
+  for(const auto & id: tensor_ids){
+   if(network_->getTensor(id)->getName() == site_names_[site]){
+    auto res = site_of_.emplace(std::make_pair(id,site));
+    if(res.second){
+     site_tensors_[site].emplace_back(id);
+     bfs.emplace_back(id);
+    }
+   }
+  }
+  if(site_tensors_[site].empty()){
+   std::cout << "#ERROR(exatn::numerics::EnvironmentCache): Site tensor " << site_names_[site]
+             << " is not found in tensor network " << network_->getName() << std::endl;
+   assert(false);
+  }
+ }
+ //Attach the remaining tensors to the nearest sites (breadth-first search from all sites):
+ while(!bfs.empty()){
+  const auto id = bfs.front(); bfs.pop_front();
+  const auto site = site_of_[id];
+  const auto adjacent = network_->getAdjacentTensors(id);
+  for(const auto & adj_id: adjacent){
+   auto res = site_of_.emplace(std::make_pair(adj_id,site));
+   if(res.second){
+    site_tensors_[site].emplace_back(adj_id);
+    bfs.emplace_back(adj_id);
+   }
+  }
+ }
+ for(const auto & id: tensor_ids){ //disconnected tensors are attached to the first site
+  auto res = site_of_.emplace(std::make_pair(id,0U));
+  if(res.second) site_tensors_[0].emplace_back(id);
+ }
+ //Enumerate the edges:
+ for(const auto & id: tensor_ids){
+  const auto * legs = network_->getTensorConnections(id);
+  assert(legs != nullptr);
+  auto & edges = edge_of_[id];
+  edges.resize(legs->size());
+  for(unsigned int dim = 0; dim < legs->size(); ++dim){
+   const auto other_id = (*legs)[dim].getTensorId();
+   const auto other_dim = (*legs)[dim].getDimensionId();
+   assert(other_id != 0); //closed tensor network
+   if(other_id > id || (other_id == id && other_dim > dim)){ //new edge
+    edges[dim] = edges_.size();
+    edges_.emplace_back(Edge{{id,other_id},{dim,other_dim}});
+   }else{ //edge has already been enumerated from the other side
+    edges[dim] = edge_of_[other_id][other_dim];
+   }
+  }
+ }
+ //Create the environment tensors (the cut between sites K and K+1 is shared by L[K+1] and R[K]):
+ left_.resize(num_sites);
+ right_.resize(num_sites);
+ for(unsigned int site = 0; site < num_sites - 1; ++site){
+  std::vector<unsigned int> cut;
+  std::vector<DimExtent> extents;
+  std::vector<std::pair<SpaceId,SubspaceId>> subspaces;
+  for(unsigned int edge_id = 0; edge_id < edges_.size(); ++edge_id){
+   const auto & edge = edges_[edge_id];
+   const auto site0 = site_of_[edge.tensor_id[0]];
+   const auto site1 = site_of_[edge.tensor_id[1]];
+   if(std::min(site0,site1) <= site && std::max(site0,site1) > site){
+    const auto * tensor_conn = network_->getTensorConn(edge.tensor_id[0]);
+    cut.emplace_back(edge_id);
+    extents.emplace_back(tensor_conn->getDimExtent(edge.dim_id[0]));
+    subspaces.emplace_back(tensor_conn->getDimSpaceAttr(edge.dim_id[0]));
+   }
+  }
+  auto left_env = std::make_shared<Tensor>("_eL",extents,subspaces);
+  left_env->rename(tensor_hex_name("eL",left_env->getTensorHash()));
+  left_[site+1] = Environment{left_env,cut};
+  auto right_env = std::make_shared<Tensor>("_eR",extents,subspaces);
+  right_env->rename(tensor_hex_name("eR",right_env->getTensorHash()));
+  right_[site] = Environment{right_env,cut};
+ }
+ left_update_.resize(num_sites);
+ right_update_.resize(num_sites);
+ closure_.resize(num_sites);
+}
+
+
+unsigned int EnvironmentCache::getNumSites() const
+{
+ return site_names_.size();
+}
+
+
+const std::vector<unsigned int> & EnvironmentCache::getSiteTensorIds(unsigned int site) const
+{
+ assert(site < site_tensors_.size());
+ return site_tensors_[site];
+}
+
+
+std::vector<unsigned int> EnvironmentCache::getSiteTensorIds(unsigned int site,
+                                                             bool conjugated) const
+{
+ assert(site < site_tensors_.size());
+ std::vector<unsigned int> ids;
+ for(const auto & id: site_tensors_[site]){
+  bool conj;
+  const auto tensor = network_->getTensor(id,&conj);
+  if(tensor->getName() == site_names_[site] && conj == conjugated) ids.emplace_back(id);
+ }
+ return ids;
+}
+
+
+std::vector<std::shared_ptr<Tensor>> EnvironmentCache::getEnvironmentTensors() const
+{
+ std::vector<std::shared_ptr<Tensor>> tensors;
+ for(const auto & env: left_) if(env.tensor) tensors.emplace_back(env.tensor);
+ for(const auto & env: right_) if(env.tensor) tensors.emplace_back(env.tensor);
+ return tensors;
+}
+
+
+std::shared_ptr<Tensor> EnvironmentCache::getLeftEnvironment(unsigned int site) const
+{
+ assert(site < left_.size());
+ return left_[site].tensor;
+}
+
+
+std::shared_ptr<Tensor> EnvironmentCache::getRightEnvironment(unsigned int site) const
+{
+ assert(site < right_.size());
+ return right_[site].tensor;
+}
+
+
+std::shared_ptr<TensorNetwork> EnvironmentCache::getLeftUpdateNetwork(unsigned int site)
+{
+ assert(site + 1 < left_.size());
+ auto & network = left_update_[site];
+ if(!network){
+  const auto & next = left_[site+1];
+  network = buildNetwork(next.tensor->getName(),next.tensor,next.edges,
+                         site_tensors_[site],left_[site],Environment{});
+ }
+ return network;
+}
+
+
+std::shared_ptr<TensorNetwork> EnvironmentCache::getRightUpdateNetwork(unsigned int site)
+{
+ assert(site > 0 && site < right_.size());
+ auto & network = right_update_[site];
+ if(!network){
+  const auto & prev = right_[site-1];
+  network = buildNetwork(prev.tensor->getName(),prev.tensor,prev.edges,
+                         site_tensors_[site],Environment{},right_[site]);
+ }
+ return network;
+}
+
+
+std::shared_ptr<TensorNetwork> EnvironmentCache::getGradientNetwork(unsigned int site,
+                                                                    unsigned int tensor_id)
+{
+ assert(site < site_tensors_.size());
+ auto & network = gradient_[tensor_id];
+ if(!network){
+  const auto & tensors = site_tensors_[site];
+  assert(std::find(tensors.cbegin(),tensors.cend(),tensor_id) != tensors.cend());
+  std::vector<unsigned int> members;
+  for(const auto & id: tensors) if(id != tensor_id) members.emplace_back(id);
+  const auto * tensor_conn = network_->getTensorConn(tensor_id);
+  auto gradient = std::make_shared<Tensor>("_eG",tensor_conn->getShape(),tensor_conn->getSignature());
+  gradient->rename(tensor_hex_name("eG",gradient->getTensorHash()));
+  network = buildNetwork(gradient->getName(),gradient,edge_of_[tensor_id],
+                         members,left_[site],right_[site]);
+ }
+ return network;
+}
+
+
+std::shared_ptr<TensorNetwork> EnvironmentCache::getClosureNetwork(unsigned int site)
+{
+ assert(site < closure_.size());
+ auto & network = closure_[site];
+ if(!network){
+  auto scalar = std::make_shared<Tensor>("_eS");
+  scalar->rename(tensor_hex_name("eS",scalar->getTensorHash()));
+  network = buildNetwork(scalar->getName(),scalar,std::vector<unsigned int>{},
+                         site_tensors_[site],left_[site],right_[site]);
+ }
+ return network;
+}
+
+
+std::shared_ptr<TensorNetwork> EnvironmentCache::buildNetwork(const std::string & name,
+                                                              std::shared_ptr<Tensor> output_tensor,
+                                                              const std::vector<unsigned int> & output_edges,
+                                                              const std::vector<unsigned int> & members,
+                                                              const Environment & left,
+                                                              const Environment & right) const
+{
+ //Each participating edge has exactly two endpoints in the new tensor network:
+ struct Endpoint{
+  unsigned int tensor_id; //tensor id in the new tensor network
+  unsigned int dim_id;    //tensor dimension id
+  bool member;            //whether or not the tensor comes from the closed tensor network
+ };
+ const unsigned int left_id = max_tensor_id_ + 1;
+ const unsigned int right_id = max_tensor_id_ + 2;
+ std::unordered_map<unsigned int,std::vector<Endpoint>> endpoints; //edge id --> its endpoints
+ for(const auto & id: members){
+  const auto & edges = edge_of_.at(id);
+  for(unsigned int dim = 0; dim < edges.size(); ++dim) endpoints[edges[dim]].emplace_back(Endpoint{id,dim,true});
+ }
+ for(unsigned int dim = 0; dim < left.edges.size(); ++dim) endpoints[left.edges[dim]].emplace_back(Endpoint{left_id,dim,false});
+ for(unsigned int dim = 0; dim < right.edges.size(); ++dim) endpoints[right.edges[dim]].emplace_back(Endpoint{right_id,dim,false});
+ for(unsigned int dim = 0; dim < output_edges.size(); ++dim) endpoints[output_edges[dim]].emplace_back(Endpoint{0,dim,false});
+ //Produces the leg of an endpoint connecting it to the other endpoint of the same edge:
+ auto make_leg = [&](unsigned int edge_id, const Endpoint & self){
+  const auto & ends = endpoints.at(edge_id);
+  assert(ends.size() == 2);
+  const auto & other = (ends[0].tensor_id == self.tensor_id && ends[0].dim_id == self.dim_id) ? ends[1] : ends[0];
+  LegDirection direction = LegDirection::UNDIRECT;
+  if(self.member){
+   direction = network_->getTensorConn(self.tensor_id)->getTensorLeg(self.dim_id).getDirection();
+  }else if(other.member){
+   direction = reverseLegDirection(network_->getTensorConn(other.tensor_id)->getTensorLeg(other.dim_id).getDirection());
+  }
+  return TensorLeg(other.tensor_id,other.dim_id,direction);
+ };
+ //Build the tensor network:
+ std::vector<TensorLeg> legs;
+ for(unsigned int dim = 0; dim < output_edges.size(); ++dim) legs.emplace_back(make_leg(output_edges[dim],Endpoint{0,dim,false}));
+ auto network = std::make_shared<TensorNetwork>(name,output_tensor,legs);
+ bool success = true;
+ for(const auto & id: members){
+  bool conjugated;
+  auto tensor = network_->getTensor(id,&conjugated);
+  const auto & edges = edge_of_.at(id);
+  legs.clear();
+  for(unsigned int dim = 0; dim < edges.size(); ++dim) legs.emplace_back(make_leg(edges[dim],Endpoint{id,dim,true}));
+  success = network->placeTensor(id,tensor,legs,conjugated); assert(success);
+ }
+ if(left.tensor){
+  legs.clear();
+  for(unsigned int dim = 0; dim < left.edges.size(); ++dim) legs.emplace_back(make_leg(left.edges[dim],Endpoint{left_id,dim,false}));
+  success = network->placeTensor(left_id,left.tensor,legs); assert(success);
+ }
+ if(right.tensor){
+  legs.clear();
+  for(unsigned int dim = 0; dim < right.edges.size(); ++dim) legs.emplace_back(make_leg(right.edges[dim],Endpoint{right_id,dim,false}));
+  success = network->placeTensor(right_id,right.tensor,legs); assert(success);
+ }
+ success = network->finalize(true); assert(success);
+ return network;
+}
+
+
+void EnvironmentCache::printIt() const
+{
+ std::cout << "EnvironmentCache(" << network_->getName() << "){" << std::endl;
+ for(unsigned int site = 0; site < site_names_.size(); ++site){
+  std::cout << " Site " << site << " (" << site_names_[site] << "):";
+  for(const auto & id: site_tensors_[site]) std::cout << " " << network_->getTensor(id)->getName() << "#" << id;
+  if(site + 1 < site_names_.size()) std::cout << "; Cut rank = " << left_[site+1].edges.size();
+  std::cout << std::endl;
+ }
+ std::cout << "}" << std::endl;
+ return;
+}
+
+
+ExpansionEnvironmentCache::ExpansionEnvironmentCache(const TensorExpansion & functional,
+                                                     const std::vector<std::string> & sites):
+ num_sites_(sites.size())
+{
+ assert(functional.getRank() == 0); //closed tensor network expansion
+ for(auto network = functional.cbegin(); network != functional.cend(); ++network){
+  //Sites of the environment cache: Sites present in the tensor network (in the sweep order):
+  std::vector<std::string> local_sites;
+  std::vector<int> site_map(num_sites_,-1);
+  for(unsigned int site = 0; site < num_sites_; ++site){
+   if(!(network->network_->getTensorIdsInNetwork(sites[site],true).empty() &&
+        network->network_->getTensorIdsInNetwork(sites[site],false).empty())){
+    site_map[site] = local_sites.size();
+    local_sites.emplace_back(sites[site]);
+   }
+  }
+  if(!local_sites.empty()){
+   components_.emplace_back(Component{std::make_shared<EnvironmentCache>(network->network_,local_sites),
+                                      network->coefficient_,
+                                      site_map});
+  }
+ }
+}
+
+
+unsigned int ExpansionEnvironmentCache::getNumSites() const
+{
+ return num_sites_;
+}
+
+
+bool ExpansionEnvironmentCache::isSesquilinear() const
+{
+ for(const auto & component: components_){
+  for(const auto & site: component.sites){
+   if(site >= 0){
+    if(component.cache->getSiteTensorIds(site,true).size() != 1 ||
+       component.cache->getSiteTensorIds(site,false).size() != 1) return false;
+   }
+  }
+ }
+ return true;
+}
+
+
+std::vector<std::shared_ptr<Tensor>> ExpansionEnvironmentCache::getEnvironmentTensors() const
+{
+ std::vector<std::shared_ptr<Tensor>> tensors;
+ for(const auto & component: components_){
+  const auto env_tensors = component.cache->getEnvironmentTensors();
+  tensors.insert(tensors.end(),env_tensors.cbegin(),env_tensors.cend());
+ }
+ return tensors;
+}
+
+
+std::vector<std::shared_ptr<TensorNetwork>> ExpansionEnvironmentCache::getLeftUpdateNetworks(unsigned int site)
+{
+ assert(site < num_sites_);
+ std::vector<std::shared_ptr<TensorNetwork>> networks;
+ for(auto & component: components_){
+  const int local_site = component.sites[site];
+  if(local_site >= 0 && local_site + 1 < component.cache->getNumSites())
+   networks.emplace_back(component.cache->getLeftUpdateNetwork(local_site));
+ }
+ return networks;
+}
+
+
+std::vector<std::shared_ptr<TensorNetwork>> ExpansionEnvironmentCache::getRightUpdateNetworks(unsigned int site)
+{
+ assert(site < num_sites_);
+ std::vector<std::shared_ptr<TensorNetwork>> networks;
+ for(auto & component: components_){
+  const int local_site = component.sites[site];
+  if(local_site > 0) networks.emplace_back(component.cache->getRightUpdateNetwork(local_site));
+ }
+ return networks;
+}
+
+
+TensorExpansion ExpansionEnvironmentCache::getGradientExpansion(unsigned int site,
+                                                                bool conjugated)
+{
+ assert(site < num_sites_);
+ TensorExpansion gradient;
+ for(auto & component: components_){
+  const int local_site = component.sites[site];
+  if(local_site >= 0){
+   const auto tensor_ids = component.cache->getSiteTensorIds(local_site,conjugated);
+   for(const auto & tensor_id: tensor_ids){
+    gradient.appendComponent(component.cache->getGradientNetwork(local_site,tensor_id),component.coefficient);
+   }
+  }
+ }
+ return gradient;
+}
+
+
+TensorExpansion ExpansionEnvironmentCache::getClosureExpansion(unsigned int site)
+{
+ assert(site < num_sites_);
+ TensorExpansion closure;
+ for(auto & component: components_){
+  const int local_site = component.sites[site];
+  if(local_site >= 0) closure.appendComponent(component.cache->getClosureNetwork(local_site),component.coefficient);
+ }
+ return closure;
+}
+
+} //namespace numerics
+
+} //namespace exatn
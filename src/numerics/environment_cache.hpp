@@ -0,0 +1,202 @@
+/** ExaTN::Numerics: Cached environments of a closed tensor network swept over its sites
+REVISION: 2020/09/29
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+/** Rationale:
+ (a) A closed (scalar) tensor network is partitioned into an ordered sequence of sites:
+     Each site is defined by a tensor name (all tensors with that name belong to the site,
+     for example, the bra and ket copies of an optimizable tensor), and every other tensor
+     is attached to the nearest site (the earliest one in case of a tie).
+ (b) The left environment of site K is the contraction of all sites preceding K,
+     the right environment of site K is the contraction of all sites following K.
+     Both are represented by explicit tensors whose legs are the tensor network
+     edges crossing the respective cut, in the order of increasing edge id.
+     The left environment of site K+1 is obtained from the left environment of site K
+     and the site K itself, the right environment of site K-1 is obtained likewise.
+     Thus, sweeping over N sites only requires O(N) tensor network contractions.
+ (c) The gradient of the closed tensor network with respect to one of the site tensors,
+     as well as the full scalar value, are computed from the two environments of the site
+     plus the (remaining) tensors of the site.
+ (d) The environment cache only builds the (small) tensor networks performing these
+     contractions, the environment tensors being their input/output tensors.
+     The tensor networks are built once and can be evaluated repeatedly,
+     thus reusing their tensor contraction sequences. The environment tensors
+     must be created (allocated) by the client before evaluating these tensor networks.
+ (e) The expansion environment cache maintains the environment caches of all closed
+     tensor networks constituting a closed tensor network expansion (functional),
+     where each tensor network may only contain some of the sites. The gradient
+     and the full scalar value of the functional are then tensor network expansions
+     composed of the respective tensor networks of all environment caches.
+**/
+
+#ifndef EXATN_NUMERICS_ENVIRONMENT_CACHE_HPP_
+#define EXATN_NUMERICS_ENVIRONMENT_CACHE_HPP_
+
+#include "tensor_basic.hpp"
+#include "tensor_network.hpp"
+#include "tensor_expansion.hpp"
+
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace exatn{
+
+namespace numerics{
+
+class EnvironmentCache{
+
+public:
+
+ /** Partitions a closed tensor network into sites defined by the given tensor names (sweep order). **/
+ EnvironmentCache(std::shared_ptr<TensorNetwork> network,   //in: closed (scalar) finalized tensor network
+                  const std::vector<std::string> & sites); //in: names of the tensors defining the sites (in the sweep order)
+
+ EnvironmentCache(const EnvironmentCache &) = default;
+ EnvironmentCache & operator=(const EnvironmentCache &) = default;
+ EnvironmentCache(EnvironmentCache &&) noexcept = default;
+ EnvironmentCache & operator=(EnvironmentCache &&) noexcept = default;
+ ~EnvironmentCache() = default;
+
+ /** Returns the number of sites. **/
+ unsigned int getNumSites() const;
+
+ /** Returns the ids of all tensors attached to a given site. **/
+ const std::vector<unsigned int> & getSiteTensorIds(unsigned int site) const;
+
+ /** Returns the ids of the tensors defining a given site (optionally only conjugated or non-conjugated ones). **/
+ std::vector<unsigned int> getSiteTensorIds(unsigned int site,
+                                            bool conjugated) const;
+
+ /** Returns all environment tensors (they need to be created before
+     evaluating the environment tensor networks). **/
+ std::vector<std::shared_ptr<Tensor>> getEnvironmentTensors() const;
+
+ /** Returns the left environment tensor of a given site (nullptr for the first site). **/
+ std::shared_ptr<Tensor> getLeftEnvironment(unsigned int site) const;
+
+ /** Returns the right environment tensor of a given site (nullptr for the last site). **/
+ std::shared_ptr<Tensor> getRightEnvironment(unsigned int site) const;
+
+ /** Returns the tensor network computing the left environment of the next site (site + 1)
+     from the left environment of the given site and the given site itself. **/
+ std::shared_ptr<TensorNetwork> getLeftUpdateNetwork(unsigned int site);
+
+ /** Returns the tensor network computing the right environment of the previous site (site - 1)
+     from the right environment of the given site and the given site itself. **/
+ std::shared_ptr<TensorNetwork> getRightUpdateNetwork(unsigned int site);
+
+ /** Returns the tensor network computing the gradient of the closed tensor network
+     with respect to a given tensor of a given site. The output tensor of the returned
+     tensor network is a new tensor congruent with the differentiated tensor. **/
+ std::shared_ptr<TensorNetwork> getGradientNetwork(unsigned int site,       //in: site
+                                                   unsigned int tensor_id); //in: id of the differentiated tensor (belongs to the site)
+
+ /** Returns the tensor network computing the scalar value of the closed tensor network
+     from the environments of a given site. The output tensor of the returned tensor
+     network is a new scalar tensor. **/
+ std::shared_ptr<TensorNetwork> getClosureNetwork(unsigned int site);
+
+ /** Prints the site partitioning. **/
+ void printIt() const;
+
+private:
+
+ //Tensor network edge (connection of two tensor legs):
+ struct Edge{
+  unsigned int tensor_id[2]; //ids of the connected tensors
+  unsigned int dim_id[2];    //ids of the connected tensor dimensions
+ };
+
+ //Environment tensor:
+ struct Environment{
+  std::shared_ptr<Tensor> tensor;  //environment tensor (nullptr if absent)
+  std::vector<unsigned int> edges; //edges crossing the cut: environment tensor dimension --> edge id
+ };
+
+ /** Builds a tensor network from the given tensors of the closed tensor network and environments. **/
+ std::shared_ptr<TensorNetwork> buildNetwork(const std::string & name,                 //in: tensor network name
+                                             std::shared_ptr<Tensor> output_tensor,    //in: output tensor
+                                             const std::vector<unsigned int> & output_edges, //in: output tensor dimension --> edge id
+                                             const std::vector<unsigned int> & members, //in: ids of the tensors from the closed tensor network
+                                             const Environment & left,                 //in: left environment (may be absent)
+                                             const Environment & right) const;         //in: right environment (may be absent)
+
+ std::shared_ptr<TensorNetwork> network_;             //closed tensor network
+ std::vector<std::string> site_names_;                //site --> name of the tensors defining the site
+ std::vector<std::vector<unsigned int>> site_tensors_; //site --> ids of all tensors attached to the site
+ std::unordered_map<unsigned int,unsigned int> site_of_; //tensor id --> site
+ std::unordered_map<unsigned int,std::vector<unsigned int>> edge_of_; //tensor id --> edge id for each tensor dimension
+ std::vector<Edge> edges_;                            //edges of the closed tensor network
+ unsigned int max_tensor_id_;                         //max tensor id in the closed tensor network
+ std::vector<Environment> left_;                      //site --> left environment
+ std::vector<Environment> right_;                     //site --> right environment
+ std::vector<std::shared_ptr<TensorNetwork>> left_update_;  //site --> left environment update tensor network
+ std::vector<std::shared_ptr<TensorNetwork>> right_update_; //site --> right environment update tensor network
+ std::vector<std::shared_ptr<TensorNetwork>> closure_;      //site --> closure tensor network
+ std::unordered_map<unsigned int,std::shared_ptr<TensorNetwork>> gradient_; //differentiated tensor id --> gradient tensor network
+};
+
+
+class ExpansionEnvironmentCache{
+
+public:
+
+ /** Builds the environment caches for all tensor networks of a closed tensor network expansion.
+     The sites are defined by the given tensor names (sweep order). **/
+ ExpansionEnvironmentCache(const TensorExpansion & functional,          //in: closed (scalar) tensor network expansion
+                           const std::vector<std::string> & sites);    //in: names of the tensors defining the sites (in the sweep order)
+
+ ExpansionEnvironmentCache(const ExpansionEnvironmentCache &) = default;
+ ExpansionEnvironmentCache & operator=(const ExpansionEnvironmentCache &) = default;
+ ExpansionEnvironmentCache(ExpansionEnvironmentCache &&) noexcept = default;
+ ExpansionEnvironmentCache & operator=(ExpansionEnvironmentCache &&) noexcept = default;
+ ~ExpansionEnvironmentCache() = default;
+
+ /** Returns the number of sites. **/
+ unsigned int getNumSites() const;
+
+ /** Returns TRUE if each tensor network of the functional contains each of its sites
+     exactly once conjugated and exactly once non-conjugated, that is, the functional
+     is a Hermitian form with respect to each site tensor. **/
+ bool isSesquilinear() const;
+
+ /** Returns all environment tensors of all environment caches. **/
+ std::vector<std::shared_ptr<Tensor>> getEnvironmentTensors() const;
+
+ /** Returns the tensor networks updating the left environments of the next site (site + 1). **/
+ std::vector<std::shared_ptr<TensorNetwork>> getLeftUpdateNetworks(unsigned int site);
+
+ /** Returns the tensor networks updating the right environments of the previous site (site - 1). **/
+ std::vector<std::shared_ptr<TensorNetwork>> getRightUpdateNetworks(unsigned int site);
+
+ /** Returns the tensor network expansion computing the gradient of the functional
+     with respect to the conjugated (or non-conjugated) tensors of a given site. **/
+ TensorExpansion getGradientExpansion(unsigned int site,
+                                      bool conjugated = true);
+
+ /** Returns the tensor network expansion computing the scalar value of the functional
+     from the environments of a given site. **/
+ TensorExpansion getClosureExpansion(unsigned int site);
+
+private:
+
+ //Environment cache of a tensor network of the functional:
+ struct Component{
+  std::shared_ptr<EnvironmentCache> cache; //environment cache of the tensor network
+  std::complex<double> coefficient;        //expansion coefficient of the tensor network
+  std::vector<int> sites;                  //site --> site in the environment cache (-1: absent)
+ };
+
+ unsigned int num_sites_;            //number of sites
+ std::vector<Component> components_; //environment caches of the tensor networks of the functional
+};
+
+} //namespace numerics
+
+} //namespace exatn
+
+#endif //EXATN_NUMERICS_ENVIRONMENT_CACHE_HPP_
@@ -0,0 +1,295 @@
+/** ExaTN::Numerics: Flat index-addressed layout of a tensor network
+REVISION: 2020/09/25
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+#include "flat_tensor_network.hpp"
+#include "tensor_network.hpp"
+#include "contraction_cost_model.hpp"
+
+#include <iostream>
+#include <algorithm>
+
+namespace exatn{
+
+namespace numerics{
+
+FlatTensorNetwork::FlatTensorNetwork(const TensorNetwork & network):
+ num_tensors_(0), live_legs_(0), live_adj_(0)
+{
+ assert(network.isFinalized());
+ std::vector<unsigned int> ids;
+ ids.reserve(network.getNumTensors());
+ unsigned int max_id = 0;
+ for(auto iter = network.cbegin(); iter != network.cend(); ++iter){
+  if(iter->first != 0) ids.emplace_back(iter->first);
+  max_id = std::max(max_id,iter->first);
+ }
+ std::sort(ids.begin(),ids.end());
+ num_tensors_ = ids.size();
+ slot_of_.assign(max_id + 1,0);
+ slot_tensor_.reserve(num_tensors_);
+ volume_.reserve(num_tensors_);
+ leg_offset_.reserve(num_tensors_); leg_count_.reserve(num_tensors_);
+ adj_offset_.reserve(num_tensors_); adj_count_.reserve(num_tensors_);
+ for(const auto tensor_id: ids){
+  const auto * tensor = network.getTensorConn(tensor_id);
+  assert(tensor != nullptr);
+  const auto & legs = tensor->getTensorLegs();
+  slot_of_[tensor_id] = slot_tensor_.size() + 1;
+  slot_tensor_.emplace_back(tensor_id);
+  leg_offset_.emplace_back(leg_tensor_.size());
+  leg_count_.emplace_back(legs.size());
+  adj_offset_.emplace_back(adj_.size());
+  double vol = 1.0;
+  unsigned int num_adjacent = 0;
+  for(unsigned int i = 0; i < legs.size(); ++i){
+   const auto other_id = legs[i].getTensorId();
+   leg_tensor_.emplace_back(other_id);
+   leg_dim_.emplace_back(legs[i].getDimensionId());
+   leg_extent_.emplace_back(tensor->getDimExtent(i));
+   vol *= static_cast<double>(tensor->getDimExtent(i));
+   if(other_id != 0){ //ignore the output tensor
+    if(std::find(adj_.end() - num_adjacent,adj_.end(),other_id) == adj_.end()){
+     adj_.emplace_back(other_id);
+     ++num_adjacent;
+    }
+   }
+  }
+  adj_count_.emplace_back(num_adjacent);
+  volume_.emplace_back(vol);
+ }
+ live_legs_ = leg_tensor_.size();
+ live_adj_ = adj_.size();
+}
+
+
+unsigned int FlatTensorNetwork::getNumTensors() const
+{
+ return num_tensors_;
+}
+
+
+ConstSpan<unsigned int> FlatTensorNetwork::getSlots() const
+{
+ return ConstSpan<unsigned int>(slot_tensor_.data(),slot_tensor_.size());
+}
+
+
+bool FlatTensorNetwork::hasTensor(unsigned int tensor_id) const
+{
+ return (tensor_id != 0 && tensor_id < slot_of_.size() && slot_of_[tensor_id] != 0);
+}
+
+
+unsigned int FlatTensorNetwork::getRank(unsigned int tensor_id) const
+{
+ return leg_count_[getSlot(tensor_id)];
+}
+
+
+double FlatTensorNetwork::getVolume(unsigned int tensor_id) const
+{
+ return volume_[getSlot(tensor_id)];
+}
+
+
+ConstSpan<unsigned int> FlatTensorNetwork::getLegTensorIds(unsigned int tensor_id) const
+{
+ const auto slot = getSlot(tensor_id);
+ return ConstSpan<unsigned int>(leg_tensor_.data() + leg_offset_[slot],leg_count_[slot]);
+}
+
+
+ConstSpan<unsigned int> FlatTensorNetwork::getLegDimensionIds(unsigned int tensor_id) const
+{
+ const auto slot = getSlot(tensor_id);
+ return ConstSpan<unsigned int>(leg_dim_.data() + leg_offset_[slot],leg_count_[slot]);
+}
+
+
+ConstSpan<DimExtent> FlatTensorNetwork::getDimExtents(unsigned int tensor_id) const
+{
+ const auto slot = getSlot(tensor_id);
+ return ConstSpan<DimExtent>(leg_extent_.data() + leg_offset_[slot],leg_count_[slot]);
+}
+
+
+ConstSpan<unsigned int> FlatTensorNetwork::getAdjacentTensors(unsigned int tensor_id) const
+{
+ const auto slot = getSlot(tensor_id);
+ return ConstSpan<unsigned int>(adj_.data() + adj_offset_[slot],adj_count_[slot]);
+}
+
+
+double FlatTensorNetwork::getContractionCost(unsigned int left_id, unsigned int right_id,
+                                             double * diff_volume, bool adjust_cost) const
+{
+ const auto left_slot = getSlot(left_id);
+ const auto right_slot = getSlot(right_id);
+ const auto left_rank = leg_count_[left_slot];
+ const auto right_rank = leg_count_[right_slot];
+ const unsigned int * right_legs = leg_tensor_.data() + leg_offset_[right_slot];
+ const DimExtent * right_dims = leg_extent_.data() + leg_offset_[right_slot];
+ const double left_vol = volume_[left_slot];
+ const double right_vol = volume_[right_slot];
+ double contr_vol = 1.0;
+ unsigned int num_contracted = 0;
+ for(unsigned int i = 0; i < right_rank; ++i){
+  if(right_legs[i] == left_id){ //contracted dimension
+   contr_vol *= static_cast<double>(right_dims[i]);
+   ++num_contracted;
+  }
+ }
+ double flops = left_vol * right_vol / contr_vol; //FMA flops (no FMA prefactor)
+ if(diff_volume != nullptr) *diff_volume = flops / contr_vol - (left_vol + right_vol);
+ if(adjust_cost){ //replace the flop count by the predicted execution time (in effective flops) if the calibrated cost model is active
+  const auto * cost_model = ContractionCostModel::getActive();
+  if(cost_model != nullptr){
+   //A tensor operand needs a permutation unless its contracted dimensions form a contiguous leading or trailing block:
+   auto needs_permutation = [](const unsigned int * legs, unsigned int rank, unsigned int other_id){
+    int first = -1, last = -1, num_contr = 0;
+    for(int i = 0; i < static_cast<int>(rank); ++i){
+     if(legs[i] == other_id){
+      if(first < 0) first = i;
+      last = i; ++num_contr;
+     }
+    }
+    if(num_contr == 0 || num_contr == static_cast<int>(rank)) return false;
+    if(last - first + 1 != num_contr) return true;
+    return !(first == 0 || last == static_cast<int>(rank) - 1);
+   };
+   flops = cost_model->predictEffectiveFlops(left_vol / contr_vol,right_vol / contr_vol,contr_vol,
+                                             left_rank,right_rank,left_rank + right_rank - num_contracted * 2,
+                                             needs_permutation(leg_tensor_.data() + leg_offset_[left_slot],left_rank,right_id),
+                                             needs_permutation(right_legs,right_rank,left_id));
+  }
+ }
+ return flops;
+}
+
+
+bool FlatTensorNetwork::mergeTensors(unsigned int left_id, unsigned int right_id, unsigned int result_id)
+{
+ if(left_id == right_id || left_id == result_id || right_id == result_id ||
+    left_id == 0 || right_id == 0 || result_id == 0){
+  std::cout << "#ERROR(FlatTensorNetwork::mergeTensors): Invalid arguments: " <<
+   left_id << " " << right_id << " " << result_id << std::endl;
+  return false;
+ }
+ if(!hasTensor(left_id) || !hasTensor(right_id) || hasTensor(result_id)){
+  std::cout << "#ERROR(FlatTensorNetwork::mergeTensors): Invalid request: Merged tensors must be present " <<
+   "while the result tensor must be absent: " << left_id << " " << right_id << " " << result_id << std::endl;
+  return false;
+ }
+ const auto left_slot = getSlot(left_id);
+ const auto right_slot = getSlot(right_id);
+ //Append the legs of the result (uncontracted legs of the left tensor followed by those of the right tensor):
+ const std::size_t result_offset = leg_tensor_.size();
+ double result_vol = 1.0;
+ for(const auto & operand: {std::make_pair(left_slot,right_id),std::make_pair(right_slot,left_id)}){
+  const auto offset = leg_offset_[operand.first];
+  const auto rank = leg_count_[operand.first];
+  for(std::size_t i = offset; i < offset + rank; ++i){
+   const unsigned int other_id = leg_tensor_[i];
+   if(other_id != operand.second){ //uncontracted leg
+    const unsigned int other_dim = leg_dim_[i];
+    const DimExtent extent = leg_extent_[i];
+    leg_tensor_.emplace_back(other_id);
+    leg_dim_.emplace_back(other_dim);
+    leg_extent_.emplace_back(extent);
+    result_vol *= static_cast<double>(extent);
+   }
+  }
+ }
+ const unsigned int result_rank = leg_tensor_.size() - result_offset;
+ //Append the adjacency list of the result and update the neighbors:
+ const std::size_t result_adj_offset = adj_.size();
+ for(unsigned int i = 0; i < result_rank; ++i){
+  const auto other_id = leg_tensor_[result_offset + i];
+  if(other_id != 0){ //input tensor (not the output tensor)
+   assert(other_id != left_id && other_id != right_id); //trace legs are not supported
+   const auto other_slot = getSlot(other_id);
+   const auto other_leg = leg_offset_[other_slot] + leg_dim_[result_offset + i];
+   leg_tensor_[other_leg] = result_id;
+   leg_dim_[other_leg] = i;
+   if(std::find(adj_.begin() + result_adj_offset,adj_.end(),other_id) == adj_.end()){
+    adj_.emplace_back(other_id);
+    //Replace the merged tensors by the result in the adjacency list of the neighbor:
+    auto * adjacent = adj_.data() + adj_offset_[other_slot];
+    unsigned int num_adjacent = 0;
+    bool replaced = false;
+    for(unsigned int j = 0; j < adj_count_[other_slot]; ++j){
+     if(adjacent[j] == left_id || adjacent[j] == right_id){
+      if(replaced) continue;
+      adjacent[num_adjacent++] = result_id;
+      replaced = true;
+     }else{
+      adjacent[num_adjacent++] = adjacent[j];
+     }
+    }
+    live_adj_ -= (adj_count_[other_slot] - num_adjacent);
+    adj_count_[other_slot] = num_adjacent;
+   }
+  }
+ }
+ const unsigned int result_adj_count = adj_.size() - result_adj_offset;
+ //Release the slots of the merged tensors:
+ for(const auto slot: {left_slot,right_slot}){
+  slot_of_[slot_tensor_[slot]] = 0;
+  slot_tensor_[slot] = 0;
+  live_legs_ -= leg_count_[slot];
+  live_adj_ -= adj_count_[slot];
+  leg_count_[slot] = 0;
+  adj_count_[slot] = 0;
+  free_slots_.emplace_back(slot);
+ }
+ //Place the result into a free slot:
+ const auto result_slot = free_slots_.back();
+ free_slots_.pop_back();
+ if(result_id >= slot_of_.size()) slot_of_.resize(result_id + 1,0);
+ slot_of_[result_id] = result_slot + 1;
+ slot_tensor_[result_slot] = result_id;
+ volume_[result_slot] = result_vol;
+ leg_offset_[result_slot] = result_offset;
+ leg_count_[result_slot] = result_rank;
+ adj_offset_[result_slot] = result_adj_offset;
+ adj_count_[result_slot] = result_adj_count;
+ live_legs_ += result_rank;
+ live_adj_ += result_adj_count;
+ --num_tensors_;
+ //Reclaim the abandoned ranges:
+ if(leg_tensor_.size() > 2 * live_legs_ + 64 || adj_.size() > 2 * live_adj_ + 64) compact();
+ return true;
+}
+
+
+void FlatTensorNetwork::compact()
+{
+ std::vector<unsigned int> leg_tensor, leg_dim, adj;
+ std::vector<DimExtent> leg_extent;
+ leg_tensor.reserve(live_legs_); leg_dim.reserve(live_legs_); leg_extent.reserve(live_legs_);
+ adj.reserve(live_adj_);
+ for(unsigned int slot = 0; slot < slot_tensor_.size(); ++slot){
+  if(slot_tensor_[slot] != 0){
+   const auto offset = leg_offset_[slot];
+   leg_offset_[slot] = leg_tensor.size();
+   leg_tensor.insert(leg_tensor.end(),leg_tensor_.begin() + offset,leg_tensor_.begin() + offset + leg_count_[slot]);
+   leg_dim.insert(leg_dim.end(),leg_dim_.begin() + offset,leg_dim_.begin() + offset + leg_count_[slot]);
+   leg_extent.insert(leg_extent.end(),leg_extent_.begin() + offset,leg_extent_.begin() + offset + leg_count_[slot]);
+   const auto adj_offset = adj_offset_[slot];
+   adj_offset_[slot] = adj.size();
+   adj.insert(adj.end(),adj_.begin() + adj_offset,adj_.begin() + adj_offset + adj_count_[slot]);
+  }
+ }
+ leg_tensor_.swap(leg_tensor);
+ leg_dim_.swap(leg_dim);
+ leg_extent_.swap(leg_extent);
+ adj_.swap(adj);
+ return;
+}
+
+} //namespace numerics
+
+} //namespace exatn
@@ -0,0 +1,154 @@
+/** ExaTN::Numerics: Flat index-addressed layout of a tensor network
+REVISION: 2020/09/25
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+/** Rationale:
+ (a) The flat layout mirrors the structure of a tensor network (input tensors
+     and their legs) in dense arrays for the tensor contraction sequence planning
+     which repeatedly queries adjacency, evaluates contraction costs and merges tensors.
+     Tensors occupy slots of a vector addressed via a dense tensor id table, freed slots
+     being recycled through a free list. Tensor legs are stored as structure-of-arrays
+     (connected tensor id, its dimension id, dimension extent) in contiguous per-tensor
+     ranges; the adjacency lists of the tensors are stored likewise.
+ (b) Adjacency and leg queries return non-owning spans without allocation. Merging
+     two tensors appends the legs and the adjacency list of the result while the legs
+     and adjacency lists of the neighbors are updated in place. Abandoned ranges are
+     reclaimed by periodic compaction. Any merge invalidates previously returned spans.
+ (c) The output tensor (id 0) does not occupy a slot: Legs connected to it are open legs.
+     The resulting tensor legs and adjacency lists are identical to those produced by
+     TensorNetwork::mergeTensors. The flat layout carries no tensor objects, thus it only
+     serves the planning while the tensor network itself remains the evaluated object.
+**/
+
+#ifndef EXATN_NUMERICS_FLAT_TENSOR_NETWORK_HPP_
+#define EXATN_NUMERICS_FLAT_TENSOR_NETWORK_HPP_
+
+#include "tensor_basic.hpp"
+
+#include <vector>
+
+#include <cassert>
+
+namespace exatn{
+
+namespace numerics{
+
+class TensorNetwork;
+
+
+/** Non-owning view of a contiguous constant range. **/
+template <typename T>
+class ConstSpan{
+
+public:
+
+ ConstSpan(const T * data, std::size_t size): data_(data), size_(size) {}
+
+ inline const T * begin() const {return data_;}
+ inline const T * end() const {return data_ + size_;}
+ inline std::size_t size() const {return size_;}
+ inline bool empty() const {return (size_ == 0);}
+ inline const T & operator[](std::size_t i) const {return data_[i];}
+
+private:
+
+ const T * data_;
+ std::size_t size_;
+};
+
+
+class FlatTensorNetwork{
+
+public:
+
+ /** Builds the flat layout of a finalized tensor network. The input
+     tensors occupy the slots in the order of increasing tensor id. **/
+ FlatTensorNetwork(const TensorNetwork & network);
+
+ FlatTensorNetwork(const FlatTensorNetwork &) = default;
+ FlatTensorNetwork & operator=(const FlatTensorNetwork &) = default;
+ FlatTensorNetwork(FlatTensorNetwork &&) noexcept = default;
+ FlatTensorNetwork & operator=(FlatTensorNetwork &&) noexcept = default;
+ ~FlatTensorNetwork() = default;
+
+ /** Returns the number of input tensors (the output tensor is not counted). **/
+ unsigned int getNumTensors() const;
+
+ /** Returns the ids of the tensors occupying the slots (0 for free slots). **/
+ ConstSpan<unsigned int> getSlots() const;
+
+ /** Returns TRUE if a given input tensor is present. **/
+ bool hasTensor(unsigned int tensor_id) const;
+
+ /** Returns the rank of a given input tensor. **/
+ unsigned int getRank(unsigned int tensor_id) const;
+
+ /** Returns the volume of a given input tensor. **/
+ double getVolume(unsigned int tensor_id) const;
+
+ /** Returns the ids of the tensors connected to the legs of a given input tensor (0 for open legs). **/
+ ConstSpan<unsigned int> getLegTensorIds(unsigned int tensor_id) const;
+
+ /** Returns the dimension ids in the connected tensors for the legs of a given input tensor. **/
+ ConstSpan<unsigned int> getLegDimensionIds(unsigned int tensor_id) const;
+
+ /** Returns the dimension extents of a given input tensor. **/
+ ConstSpan<DimExtent> getDimExtents(unsigned int tensor_id) const;
+
+ /** Returns the ids of the input tensors adjacent to a given input tensor
+     in the order of their first appearance among its legs. **/
+ ConstSpan<unsigned int> getAdjacentTensors(unsigned int tensor_id) const;
+
+ /** Returns the FMA flop count for the contraction of two input tensors, with the same
+     semantics as the free function getTensorContractionCost (TensorNetwork). **/
+ double getContractionCost(unsigned int left_id,          //in: left tensor id
+                           unsigned int right_id,         //in: right tensor id
+                           double * diff_volume = nullptr, //out: vol(result) - vol(left) - vol(right)
+                           bool adjust_cost = false) const; //in: whether or not to use the calibrated cost model (if active)
+
+ /** Merges two input tensors into a new one with the given id,
+     with the same leg order as TensorNetwork::mergeTensors. **/
+ bool mergeTensors(unsigned int left_id,    //in: left tensor id (present)
+                   unsigned int right_id,   //in: right tensor id (present)
+                   unsigned int result_id); //in: result tensor id (absent)
+
+private:
+
+ /** Returns the slot occupied by a given input tensor. **/
+ inline unsigned int getSlot(unsigned int tensor_id) const;
+
+ /** Removes abandoned ranges from the leg and adjacency arrays. **/
+ void compact();
+
+ unsigned int num_tensors_;              //number of input tensors
+ std::vector<unsigned int> slot_of_;     //tensor id --> slot + 1 (0: absent)
+ std::vector<unsigned int> slot_tensor_; //slot --> tensor id (0: free slot)
+ std::vector<unsigned int> free_slots_;  //free list of slots
+ std::vector<double> volume_;            //slot --> tensor volume
+ std::vector<std::size_t> leg_offset_;   //slot --> offset of its legs
+ std::vector<unsigned int> leg_count_;   //slot --> number of its legs (rank)
+ std::vector<std::size_t> adj_offset_;   //slot --> offset of its adjacency list
+ std::vector<unsigned int> adj_count_;   //slot --> size of its adjacency list
+ std::vector<unsigned int> leg_tensor_;  //leg --> connected tensor id
+ std::vector<unsigned int> leg_dim_;     //leg --> dimension id in the connected tensor
+ std::vector<DimExtent> leg_extent_;     //leg --> dimension extent
+ std::vector<unsigned int> adj_;         //adjacency lists
+ std::size_t live_legs_;                 //number of legs in use
+ std::size_t live_adj_;                  //number of adjacency list entries in use
+};
+
+
+//DEFINITIONS:
+inline unsigned int FlatTensorNetwork::getSlot(unsigned int tensor_id) const
+{
+ assert(tensor_id < slot_of_.size() && slot_of_[tensor_id] != 0);
+ return slot_of_[tensor_id] - 1;
+}
+
+} //namespace numerics
+
+} //namespace exatn
+
+#endif //EXATN_NUMERICS_FLAT_TENSOR_NETWORK_HPP_
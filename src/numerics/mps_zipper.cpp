@@ -0,0 +1,220 @@
+/** ExaTN::Numerics: Zipper evaluation of MPS-MPO-MPS sandwiches
+REVISION: 2020/10/02
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+#include "mps_zipper.hpp"
+
+#include <unordered_map>
+#include <algorithm>
+#include <list>
+
+#include <cassert>
+
+namespace exatn{
+
+namespace numerics{
+
+MPSZipper::MPSZipper(const TensorExpansion & bra,
+                     const TensorExpansion & ket,
+                     const TensorOperator & tensor_operator):
+ expansion_(bra,ket,tensor_operator), num_sites_(0), fma_flops_(0.0), applicable_(false)
+{
+ //Keys of the tensors at each site of each bra and ket component (tensor name and conjugation):
+ auto get_keys = [](const TensorExpansion & expansion, std::vector<std::vector<std::string>> & keys){
+  for(auto component = expansion.cbegin(); component != expansion.cend(); ++component){
+   const auto & network = *(component->network_);
+   std::vector<unsigned int> sites;
+   if(!getSites(network,sites)) return false;
+   keys.emplace_back(std::vector<std::string>(sites.size()));
+   for(unsigned int i = 0; i < sites.size(); ++i){
+    bool conj;
+    auto tensor = network.getTensor(sites[i],&conj);
+    keys.back()[i] = tensor->getName() + (conj ? "+" : "");
+   }
+  }
+  return !keys.empty();
+ };
+ std::vector<std::vector<std::string>> bra_keys, ket_keys;
+ if(!(get_keys(bra,bra_keys) && get_keys(ket,ket_keys))) return;
+ num_sites_ = ket_keys[0].size();
+ for(const auto * keys: {&bra_keys, &ket_keys}){
+  for(const auto & component_keys: *keys) if(component_keys.size() != num_sites_) return;
+ }
+ //Components of <bra|operator|ket> go in the order: Bra component --> ket component --> operator component:
+ const std::size_t num_operator_components = tensor_operator.getNumComponents();
+ if(expansion_.getNumComponents() != bra_keys.size() * ket_keys.size() * num_operator_components) return;
+ std::size_t i = 0;
+ applicable_ = true;
+ for(auto component = expansion_.begin(); component != expansion_.end() && applicable_; ++component, ++i){
+  const auto & component_ket_keys = ket_keys[(i / num_operator_components) % ket_keys.size()];
+  const auto & component_bra_keys = bra_keys[i / (num_operator_components * ket_keys.size())];
+  applicable_ = zipNetwork(*(component->network_),component_ket_keys,component_bra_keys);
+ }
+ if(!applicable_){ //discard the partially imported contraction sequences
+  for(auto component = expansion_.begin(); component != expansion_.end(); ++component){
+   if(!(component->network_->exportContractionSequence().empty()))
+    component->network_->importContractionSequence(std::list<ContrTriple>{});
+  }
+  fma_flops_ = 0.0;
+ }
+}
+
+
+bool MPSZipper::isApplicable() const
+{
+ return applicable_;
+}
+
+
+unsigned int MPSZipper::getNumSites() const
+{
+ return num_sites_;
+}
+
+
+double MPSZipper::getFMAFlops() const
+{
+ return fma_flops_;
+}
+
+
+TensorExpansion & MPSZipper::getExpansion()
+{
+ return expansion_;
+}
+
+
+bool MPSZipper::getSites(const TensorNetwork & network,
+                         std::vector<unsigned int> & sites)
+{
+ const auto num_sites = network.getRank();
+ if(num_sites == 0 || network.getNumTensors() != num_sites) return false;
+ sites.assign(num_sites,0);
+ std::unordered_map<unsigned int,unsigned int> site_of; //tensor id --> site
+ for(auto iter = network.cbegin(); iter != network.cend(); ++iter){
+  if(iter->first != 0){
+   int site = -1;
+   for(const auto & leg: iter->second.getTensorLegs()){
+    if(leg.getTensorId() == 0){
+     if(site >= 0) return false; //each tensor must carry exactly one output leg
+     site = leg.getDimensionId();
+    }
+   }
+   if(site < 0 || sites[site] != 0) return false;
+   sites[site] = iter->first;
+   site_of[iter->first] = site;
+  }
+ }
+ //Each tensor may only be connected to its neighbors in the chain:
+ for(unsigned int site = 0; site < num_sites; ++site){
+  const auto * legs = network.getTensorConnections(sites[site]);
+  assert(legs != nullptr);
+  for(const auto & leg: *legs){
+   if(leg.getTensorId() != 0){
+    const auto other = site_of[leg.getTensorId()];
+    if(other + 1 != site && other != site + 1) return false;
+   }
+  }
+ }
+ return true;
+}
+
+
+bool MPSZipper::zipNetwork(TensorNetwork & network,
+                           const std::vector<std::string> & ket_keys,
+                           const std::vector<std::string> & bra_keys)
+{
+ const unsigned int num_sites = ket_keys.size();
+ if(network.getRank() != 0 || !network.isFinalized()) return false;
+ //Identify the ket and bra tensors of each site, all other tensors belong to the operator:
+ std::unordered_map<std::string,unsigned int> site_of_key; //tensor key --> site
+ for(unsigned int site = 0; site < num_sites; ++site){
+  site_of_key[ket_keys[site]] = site;
+  site_of_key[bra_keys[site]] = num_sites + site;
+ }
+ if(site_of_key.size() != 2 * num_sites) return false; //ket and bra keys must be distinct
+ std::vector<unsigned int> site_tensors(2 * num_sites,0); //ket tensor ids followed by bra tensor ids
+ std::unordered_map<unsigned int,unsigned int> site_of; //ket/bra tensor id --> site
+ std::vector<unsigned int> operator_tensors;
+ for(auto iter = network.cbegin(); iter != network.cend(); ++iter){
+  if(iter->first != 0){
+   bool conj;
+   auto tensor = network.getTensor(iter->first,&conj);
+   auto key = site_of_key.find(tensor->getName() + (conj ? "+" : ""));
+   if(key != site_of_key.end()){
+    if(site_tensors[key->second] != 0) return false; //ket and bra tensors must be unique
+    site_tensors[key->second] = iter->first;
+    site_of[iter->first] = key->second % num_sites;
+   }else{
+    operator_tensors.emplace_back(iter->first);
+   }
+  }
+ }
+ for(const auto & id: site_tensors) if(id == 0) return false;
+ std::sort(operator_tensors.begin(),operator_tensors.end());
+ //Determine the sites acted upon by each operator tensor:
+ std::vector<std::vector<unsigned int>> operators_at(num_sites); //first site --> operator tensors
+ unsigned int first_site = num_sites - 1, last_site = num_sites - 1; //range of sites acted upon by the operator
+ if(!operator_tensors.empty()){
+  first_site = num_sites; last_site = 0;
+  for(const auto & id: operator_tensors){
+   unsigned int first = num_sites, last = 0;
+   const auto * legs = network.getTensorConnections(id);
+   assert(legs != nullptr);
+   for(const auto & leg: *legs){
+    auto site = site_of.find(leg.getTensorId());
+    if(site != site_of.end()){
+     first = std::min(first,site->second);
+     last = std::max(last,site->second);
+    }
+   }
+   if(first == num_sites) return false; //operator tensor is not attached to any site
+   operators_at[first].emplace_back(id);
+   first_site = std::min(first_site,first);
+   last_site = std::max(last_site,last);
+  }
+ }
+ //Build the zipper contraction sequence:
+ TensorNetwork net(network);
+ const unsigned int num_contractions = network.getNumTensors() - 1;
+ unsigned int next_id = net.getMaxTensorId() + 1;
+ unsigned int num_contracted = 0;
+ double flops = 0.0;
+ std::list<ContrTriple> contr_seq;
+ auto absorb = [&](unsigned int env_id, unsigned int tensor_id){ //absorbs a tensor into an environment (0: none yet)
+  if(env_id == 0) return tensor_id;
+  flops += net.getContractionCost(env_id,tensor_id);
+  unsigned int result_id = 0;
+  if(++num_contracted < num_contractions){
+   result_id = next_id++;
+   auto merged = net.mergeTensors(env_id,tensor_id,result_id); assert(merged);
+  }
+  contr_seq.emplace_back(ContrTriple{result_id,env_id,tensor_id});
+  return result_id;
+ };
+ unsigned int left_env = 0, right_env = 0;
+ for(unsigned int site = 0; site < first_site; ++site){ //left environment
+  left_env = absorb(left_env,site_tensors[site]);
+  left_env = absorb(left_env,site_tensors[num_sites + site]);
+ }
+ for(unsigned int site = num_sites - 1; site > last_site; --site){ //right environment
+  right_env = absorb(right_env,site_tensors[site]);
+  right_env = absorb(right_env,site_tensors[num_sites + site]);
+ }
+ for(unsigned int site = first_site; site <= last_site; ++site){ //sites acted upon by the operator
+  left_env = absorb(left_env,site_tensors[site]);
+  for(const auto & id: operators_at[site]) left_env = absorb(left_env,id);
+  left_env = absorb(left_env,site_tensors[num_sites + site]);
+ }
+ if(right_env != 0) left_env = absorb(left_env,right_env);
+ if(num_contracted != num_contractions) return false;
+ network.importContractionSequence(contr_seq,flops);
+ fma_flops_ += flops;
+ return true;
+}
+
+} //namespace numerics
+
+} //namespace exatn
@@ -0,0 +1,101 @@
+/** ExaTN::Numerics: Zipper evaluation of MPS-MPO-MPS sandwiches
+REVISION: 2020/10/02
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+/** Rationale:
+ (a) The MPS zipper builds the closed tensor network expansion <bra|operator|ket>
+     from a bra and a ket tensor network expansion and a tensor network operator.
+     If each bra and ket component is a matrix product state (MPS), that is,
+     a chain of tensors each carrying exactly one output leg (site) and only
+     connected to its two neighbors in the chain, each component of the closed
+     expansion is an MPS-MPO-MPS sandwich, where the operator tensors (local terms
+     or MPO tensors) are attached to the sites they act on.
+ (b) Instead of running a generic tensor contraction sequence optimizer, the zipper
+     imports the standard zipper contraction sequence into each tensor network component:
+     The left environment is grown from the first site up to the first site acted on
+     by the operator component, by absorbing the ket and then the bra tensor of each site;
+     the right environment is grown likewise from the last site down to the last site acted
+     on by the operator component; the sites in between are absorbed into the left environment
+     one by one (ket tensor, operator tensors starting at that site, bra tensor), followed by
+     the final contraction with the right environment. For bond dimension D, each step costs
+     O(D^3) (times the physical and MPO bond dimensions).
+ (c) The left and right environments over the sites not acted upon by the operator component
+     are identical for all operator terms, thus they are computed only once when the closed
+     expansion is evaluated with common subexpression elimination (see TensorExpansionPlan).
+ (d) If some component is not an MPS-MPO-MPS sandwich, the closed expansion is still built,
+     but without the imported contraction sequences (the zipper is not applicable).
+**/
+
+#ifndef EXATN_NUMERICS_MPS_ZIPPER_HPP_
+#define EXATN_NUMERICS_MPS_ZIPPER_HPP_
+
+#include "tensor_basic.hpp"
+#include "tensor_network.hpp"
+#include "tensor_expansion.hpp"
+#include "tensor_operator.hpp"
+
+#include <string>
+#include <vector>
+
+namespace exatn{
+
+namespace numerics{
+
+class MPSZipper{
+
+public:
+
+ /** Builds the closed tensor network expansion <bra|operator|ket> and imports
+     the zipper tensor contraction sequences if applicable. The bra tensor
+     network expansion is expected to be already conjugated. **/
+ MPSZipper(const TensorExpansion & bra,                //in: bra tensor network expansion (conjugated)
+           const TensorExpansion & ket,                //in: ket tensor network expansion
+           const TensorOperator & tensor_operator);    //in: tensor network operator
+
+ MPSZipper(const MPSZipper &) = default;
+ MPSZipper & operator=(const MPSZipper &) = default;
+ MPSZipper(MPSZipper &&) noexcept = default;
+ MPSZipper & operator=(MPSZipper &&) noexcept = default;
+ ~MPSZipper() = default;
+
+ /** Returns TRUE if all components of the closed tensor network expansion
+     are MPS-MPO-MPS sandwiches with the zipper contraction sequence imported. **/
+ bool isApplicable() const;
+
+ /** Returns the number of sites. **/
+ unsigned int getNumSites() const;
+
+ /** Returns the total FMA flop count of the zipper contraction sequences
+     (without sharing the environments among the operator terms). **/
+ double getFMAFlops() const;
+
+ /** Returns the closed tensor network expansion <bra|operator|ket>. **/
+ TensorExpansion & getExpansion();
+
+private:
+
+ /** Determines the sites of a matrix product state: Site (output leg) --> tensor id.
+     Returns FALSE if the tensor network is not a matrix product state. **/
+ static bool getSites(const TensorNetwork & network,        //in: tensor network
+                      std::vector<unsigned int> & sites);   //out: site --> tensor id
+
+ /** Imports the zipper contraction sequence into a closed tensor network component,
+     given the keys of its ket and bra tensors for each site. Returns FALSE if
+     the tensor network component is not an MPS-MPO-MPS sandwich. **/
+ bool zipNetwork(TensorNetwork & network,                   //inout: closed tensor network component
+                 const std::vector<std::string> & ket_keys, //in: site --> key of the ket tensor
+                 const std::vector<std::string> & bra_keys);//in: site --> key of the bra tensor
+
+ TensorExpansion expansion_; //closed tensor network expansion <bra|operator|ket>
+ unsigned int num_sites_;    //number of sites
+ double fma_flops_;          //total FMA flop count of the zipper contraction sequences
+ bool applicable_;           //whether or not the zipper contraction sequences have been imported
+};
+
+} //namespace numerics
+
+} //namespace exatn
+
+#endif //EXATN_NUMERICS_MPS_ZIPPER_HPP_
@@ -1,8 +1,8 @@
 /** ExaTN::Numerics: Tensor network builder factory
-REVISION: 2019/11/01
+REVISION: 2020/10/06
 
-Copyright (C) 2018-2019 Dmitry I. Lyakh (Liakh)
-Copyright (C) 2018-2019 Oak Ridge National Laboratory (UT-Battelle) **/
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 
 #include "network_build_factory.hpp"
 
@@ -14,6 +14,7 @@ NetworkBuildFactory::NetworkBuildFactory()
 {
  registerNetworkBuilder("MPS",&NetworkBuilderMPS::createNew);
  registerNetworkBuilder("Tree",&NetworkBuilderTree::createNew);
+ registerNetworkBuilder("PEPS",&NetworkBuilderPEPS::createNew);
 }
 
 void NetworkBuildFactory::registerNetworkBuilder(const std::string & name, createNetworkBuilderFn creator)
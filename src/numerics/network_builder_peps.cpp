@@ -0,0 +1,126 @@
+/** ExaTN::Numerics: Tensor network builder: PEPS: Projected Entangled Pair State
+REVISION: 2020/10/06
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+#include "network_builder_peps.hpp"
+#include "tensor_network.hpp"
+
+#include <vector>
+#include <iostream>
+
+#include <cassert>
+
+namespace exatn{
+
+namespace numerics{
+
+NetworkBuilderPEPS::NetworkBuilderPEPS():
+ max_bond_dim_(1), num_rows_(0)
+{
+}
+
+
+bool NetworkBuilderPEPS::getParameter(const std::string & name, long long * value) const
+{
+ bool found = true;
+ if(name == "max_bond_dim"){
+  *value = max_bond_dim_;
+ }else if(name == "num_rows"){
+  *value = num_rows_;
+ }else{
+  found = false;
+ }
+ return found;
+}
+
+
+bool NetworkBuilderPEPS::setParameter(const std::string & name, long long value)
+{
+ bool found = true;
+ if(name == "max_bond_dim"){
+  max_bond_dim_ = value;
+ }else if(name == "num_rows"){
+  num_rows_ = value;
+ }else{
+  found = false;
+ }
+ return found;
+}
+
+
+void NetworkBuilderPEPS::build(TensorNetwork & network)
+{
+ assert(max_bond_dim_ >= 1 && num_rows_ >= 0);
+ //Inspect the output tensor:
+ auto output_tensor = network.getTensor(0);
+ const unsigned int output_tensor_rank = output_tensor->getRank();
+ const auto & output_dim_extents = output_tensor->getDimExtents();
+ if(output_tensor_rank == 0) return;
+ //Determine the grid shape:
+ unsigned int num_rows = num_rows_;
+ if(num_rows == 0){
+  num_rows = 1;
+  for(unsigned int i = 1; i * i <= output_tensor_rank; ++i) if(output_tensor_rank % i == 0) num_rows = i;
+ }
+ if(output_tensor_rank % num_rows != 0){
+  std::cout << "#ERROR(exatn::numerics::NetworkBuilderPEPS::build): Number of grid rows " << num_rows
+            << " does not divide the output tensor rank " << output_tensor_rank << std::endl;
+  assert(false);
+ }
+ const unsigned int num_cols = output_tensor_rank / num_rows;
+ //Position of the bond in a given direction (0:left, 1:up, 2:right, 3:down) among the legs of a site tensor:
+ auto bond_position = [num_rows,num_cols](unsigned int row, unsigned int col, unsigned int direction){
+  const bool present[4] = {col > 0, row > 0, col + 1 < num_cols, row + 1 < num_rows};
+  assert(present[direction]);
+  unsigned int position = 1; //physical leg goes first
+  for(unsigned int i = 0; i < direction; ++i) if(present[i]) ++position;
+  return position;
+ };
+ //Append the site tensors:
+ const DimExtent bond_dim = static_cast<DimExtent>(max_bond_dim_);
+ for(unsigned int row = 0; row < num_rows; ++row){
+  for(unsigned int col = 0; col < num_cols; ++col){
+   const unsigned int site = row * num_cols + col;
+   std::vector<DimExtent> dim_extents{output_dim_extents[site]};
+   std::vector<TensorLeg> legs{TensorLeg{0,site}};
+   if(col > 0){ //left bond
+    dim_extents.emplace_back(bond_dim);
+    legs.emplace_back(TensorLeg{site,bond_position(row,col-1,2)});
+   }
+   if(row > 0){ //up bond
+    dim_extents.emplace_back(bond_dim);
+    legs.emplace_back(TensorLeg{site + 1 - num_cols,bond_position(row-1,col,3)});
+   }
+   if(col + 1 < num_cols){ //right bond
+    dim_extents.emplace_back(bond_dim);
+    legs.emplace_back(TensorLeg{site + 2,bond_position(row,col+1,0)});
+   }
+   if(row + 1 < num_rows){ //down bond
+    dim_extents.emplace_back(bond_dim);
+    legs.emplace_back(TensorLeg{site + 1 + num_cols,bond_position(row+1,col,1)});
+   }
+   auto appended = network.placeTensor(site + 1, //tensor id
+                                       std::make_shared<Tensor>("_T"+std::to_string(site + 1),dim_extents), //tensor name
+                                       legs,
+                                       false,
+                                       false
+                                      );
+   assert(appended);
+   auto & tensor = *(network.getTensor(site + 1));
+   tensor.rename(generateTensorName(tensor,"t"));
+  }
+ }
+ return;
+}
+
+
+std::unique_ptr<NetworkBuilder> NetworkBuilderPEPS::createNew()
+{
+ return std::unique_ptr<NetworkBuilder>(new NetworkBuilderPEPS());
+}
+
+} //namespace numerics
+
+} //namespace exatn
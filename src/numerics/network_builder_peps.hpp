@@ -0,0 +1,66 @@
+/** ExaTN::Numerics: Tensor network builder: PEPS: Projected Entangled Pair State
+REVISION: 2020/10/06
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+/** Rationale:
+ (a) The PEPS builder arranges the output tensor modes row-wise on a rectangular
+     grid of num_rows x num_cols sites: Site (r,c) corresponds to the output
+     tensor mode r * num_cols + c and is represented by the tensor with
+     id r * num_cols + c + 1 connected to its (up to four) nearest neighbors.
+ (b) The legs of each site tensor go in the order: Physical (output) leg,
+     left bond, up bond, right bond, down bond, where the bonds absent
+     at the grid boundaries are skipped. All bonds have the dimension max_bond_dim.
+ (c) If the number of rows is not set (zero), the grid is chosen as close
+     to a square as possible (num_rows <= num_cols).
+**/
+
+#ifndef EXATN_NUMERICS_NETWORK_BUILDER_PEPS_HPP_
+#define EXATN_NUMERICS_NETWORK_BUILDER_PEPS_HPP_
+
+#include "tensor_basic.hpp"
+#include "network_builder.hpp"
+
+#include <string>
+#include <memory>
+
+namespace exatn{
+
+namespace numerics{
+
+class NetworkBuilderPEPS: public NetworkBuilder{
+
+public:
+
+ NetworkBuilderPEPS();
+ NetworkBuilderPEPS(const NetworkBuilderPEPS &) = default;
+ NetworkBuilderPEPS & operator=(const NetworkBuilderPEPS &) = default;
+ NetworkBuilderPEPS(NetworkBuilderPEPS &&) noexcept = default;
+ NetworkBuilderPEPS & operator=(NetworkBuilderPEPS &&) noexcept = default;
+ virtual ~NetworkBuilderPEPS() = default;
+
+ /** Retrieves a specific parameter of the tensor network builder. **/
+ virtual bool getParameter(const std::string & name, long long * value) const override;
+
+ /** Sets a specific parameter of the tensor network builder:
+     "max_bond_dim": Bond dimension;
+     "num_rows": Number of grid rows (must divide the output tensor rank, 0: automatic). **/
+ virtual bool setParameter(const std::string & name, long long value) override;
+
+ /** Builds a tensor network of a specific kind. **/
+ virtual void build(TensorNetwork & network) override;
+
+ static std::unique_ptr<NetworkBuilder> createNew();
+
+private:
+
+ long long max_bond_dim_; //bond dimension
+ long long num_rows_;     //number of grid rows (0: automatic)
+};
+
+} //namespace numerics
+
+} //namespace exatn
+
+#endif //EXATN_NUMERICS_NETWORK_BUILDER_PEPS_HPP_
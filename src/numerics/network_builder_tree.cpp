@@ -1,18 +1,26 @@
 /** ExaTN::Numerics: Tensor network builder: Tree: Tree Tensor Network
-REVISION: 2019/11/01
+REVISION: 2020/10/05
 
-Copyright (C) 2018-2019 Dmitry I. Lyakh (Liakh)
-Copyright (C) 2018-2019 Oak Ridge National Laboratory (UT-Battelle) **/
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 
 #include "network_builder_tree.hpp"
 #include "tensor_network.hpp"
+#include "metis_graph.hpp"
+
+#include <unordered_map>
+#include <map>
+#include <algorithm>
+#include <cmath>
+
+#include <cassert>
 
 namespace exatn{
 
 namespace numerics{
 
 NetworkBuilderTree::NetworkBuilderTree():
- max_bond_dim_(1), arity_(2)
+ max_bond_dim_(1), arity_(2), isometric_(false)
 {
 }
 
@@ -24,6 +32,8 @@ bool NetworkBuilderTree::getParameter(const std::string & name, long long * valu
   *value = max_bond_dim_;
  }else if(name == "arity"){
   *value = arity_;
+ }else if(name == "isometric"){
+  *value = (isometric_ ? 1 : 0);
  }else{
   found = false;
  }
@@ -38,6 +48,8 @@ bool NetworkBuilderTree::setParameter(const std::string & name, long long value)
   max_bond_dim_ = value;
  }else if(name == "arity"){
   arity_ = value;
+ }else if(name == "isometric"){
+  isometric_ = (value != 0);
  }else{
   found = false;
  }
@@ -45,9 +57,176 @@ bool NetworkBuilderTree::setParameter(const std::string & name, long long value)
 }
 
 
+bool NetworkBuilderTree::setModeAffinity(const std::vector<std::pair<unsigned int, unsigned int>> & edges,
+                                         const std::vector<double> & weights)
+{
+ if(edges.size() != weights.size()){
+  std::cout << "#ERROR(exatn::numerics::NetworkBuilderTree::setModeAffinity): Number of weights does not match number of edges: "
+            << weights.size() << " versus " << edges.size() << std::endl;
+  return false;
+ }
+ for(const auto & weight: weights){
+  if(!(weight > 0.0)){
+   std::cout << "#ERROR(exatn::numerics::NetworkBuilderTree::setModeAffinity): Non-positive affinity weight: "
+             << weight << std::endl;
+   return false;
+  }
+ }
+ affinity_edges_ = edges;
+ affinity_weights_ = weights;
+ return true;
+}
+
+
+std::vector<std::vector<unsigned int>> NetworkBuilderTree::splitModes(const std::vector<unsigned int> & modes) const
+{
+ const std::size_t num_modes = modes.size();
+ const std::size_t num_parts = std::min(static_cast<std::size_t>(arity_),num_modes);
+ std::vector<std::vector<unsigned int>> parts;
+ //Partition the mode affinity graph induced on the given modes:
+ if(!affinity_edges_.empty()){
+  std::unordered_map<unsigned int, std::size_t> vertex_of; //output tensor mode --> graph vertex
+  for(std::size_t i = 0; i < num_modes; ++i) vertex_of[modes[i]] = i;
+  std::vector<std::map<std::size_t,double>> adjacency(num_modes);
+  double max_weight = 0.0;
+  for(std::size_t i = 0; i < affinity_edges_.size(); ++i){
+   auto vertex0 = vertex_of.find(affinity_edges_[i].first);
+   auto vertex1 = vertex_of.find(affinity_edges_[i].second);
+   if(vertex0 != vertex_of.end() && vertex1 != vertex_of.end() && vertex0->second != vertex1->second){
+    auto & weight = adjacency[vertex0->second][vertex1->second];
+    weight += affinity_weights_[i];
+    adjacency[vertex1->second][vertex0->second] = weight;
+    max_weight = std::max(max_weight,weight);
+   }
+  }
+  if(max_weight > 0.0){
+   MetisGraph graph;
+   for(std::size_t i = 0; i < num_modes; ++i){
+    std::vector<std::size_t> adj_vertices, edge_weights;
+    for(const auto & edge: adjacency[i]){
+     adj_vertices.emplace_back(edge.first);
+     edge_weights.emplace_back(std::max(static_cast<std::size_t>(1),
+                                        static_cast<std::size_t>(std::llround(edge.second / max_weight * AFFINITY_RESOLUTION))));
+    }
+    graph.appendVertex(adj_vertices.size(),adj_vertices.data(),edge_weights.data(),1);
+   }
+   if(graph.partitionGraph(num_parts,PARTITION_IMBALANCE)){
+    const auto & partitions = graph.getPartitions();
+    parts.resize(num_parts);
+    for(std::size_t i = 0; i < num_modes; ++i) parts[partitions[i]].emplace_back(modes[i]);
+    parts.erase(std::remove_if(parts.begin(),parts.end(),
+                               [](const std::vector<unsigned int> & part){return part.empty();}),parts.end());
+    if(parts.size() < 2) parts.clear(); //degenerate partitioning: Fall back to the natural order
+    std::sort(parts.begin(),parts.end()); //subtrees are ordered by their first modes
+   }
+  }
+ }
+ //Split the modes into contiguous groups in their natural order:
+ if(parts.empty()){
+  std::size_t first = 0;
+  for(std::size_t i = 0; i < num_parts; ++i){
+   const std::size_t last = ((i + 1) * num_modes) / num_parts;
+   parts.emplace_back(std::vector<unsigned int>(modes.begin() + first,modes.begin() + last));
+   first = last;
+  }
+ }
+ return parts;
+}
+
+
 void NetworkBuilderTree::build(TensorNetwork & network)
 {
- //`Finish
+ assert(arity_ >= 2 && max_bond_dim_ >= 1);
+ //Inspect the output tensor:
+ auto output_tensor = network.getTensor(0);
+ const auto output_tensor_rank = output_tensor->getRank();
+ const auto & output_dim_extents = output_tensor->getDimExtents();
+ if(output_tensor_rank == 0) return;
+ //Build the tree structure top-down (node 0 is the root):
+ struct TreeNode{
+  std::vector<unsigned int> modes;                         //output tensor modes in the subtree
+  std::vector<std::pair<bool,unsigned int>> children;      //child legs: {true,output tensor mode} or {false,child node}
+  unsigned int parent;                                     //parent node
+  unsigned int position;                                   //position of the node among the children of its parent
+  DimExtent bond_dim;                                      //dimension of the bond to the parent node
+ };
+ std::vector<TreeNode> nodes;
+ std::vector<unsigned int> all_modes(output_tensor_rank);
+ for(unsigned int i = 0; i < output_tensor_rank; ++i) all_modes[i] = i;
+ nodes.emplace_back(TreeNode{all_modes,{},0,0,1});
+ for(unsigned int n = 0; n < nodes.size(); ++n){
+  const auto modes = nodes[n].modes;
+  if(modes.size() <= static_cast<std::size_t>(arity_)){
+   for(const auto & mode: modes) nodes[n].children.emplace_back(std::make_pair(true,mode));
+  }else{
+   const auto parts = splitModes(modes);
+   for(const auto & part: parts){
+    if(part.size() == 1){
+     nodes[n].children.emplace_back(std::make_pair(true,part[0]));
+    }else{
+     const unsigned int position = nodes[n].children.size();
+     nodes.emplace_back(TreeNode{part,{},n,position,1});
+     nodes[n].children.emplace_back(std::make_pair(false,static_cast<unsigned int>(nodes.size() - 1)));
+    }
+   }
+  }
+ }
+ //Compute the bond dimensions bottom-up (children always follow their parents):
+ const DimExtent max_dim = static_cast<DimExtent>(max_bond_dim_);
+ auto capped_product = [max_dim](DimExtent dim0, DimExtent dim1){
+  return (dim0 > max_dim / dim1) ? max_dim : std::min(dim0 * dim1,max_dim);
+ };
+ std::vector<bool> inside(output_tensor_rank);
+ for(unsigned int n = nodes.size() - 1; n > 0; --n){
+  auto & node = nodes[n];
+  std::fill(inside.begin(),inside.end(),false);
+  for(const auto & mode: node.modes) inside[mode] = true;
+  DimExtent inner_dim = 1, outer_dim = 1, child_dim = 1;
+  for(unsigned int i = 0; i < output_tensor_rank; ++i){
+   if(inside[i]){
+    inner_dim = capped_product(inner_dim,output_dim_extents[i]);
+   }else{
+    outer_dim = capped_product(outer_dim,output_dim_extents[i]);
+   }
+  }
+  for(const auto & child: node.children){
+   child_dim = capped_product(child_dim,child.first ? output_dim_extents[child.second] : nodes[child.second].bond_dim);
+  }
+  node.bond_dim = std::min({max_dim,inner_dim,outer_dim,child_dim});
+ }
+ //Append the tree tensors (tensor id = node id + 1):
+ for(unsigned int n = 0; n < nodes.size(); ++n){
+  const auto & node = nodes[n];
+  std::vector<DimExtent> dim_extents;
+  std::vector<TensorLeg> legs;
+  for(const auto & child: node.children){
+   if(child.first){ //output tensor mode
+    dim_extents.emplace_back(output_dim_extents[child.second]);
+    legs.emplace_back(TensorLeg{0,child.second});
+   }else{ //bond to the child tensor (its last leg)
+    dim_extents.emplace_back(nodes[child.second].bond_dim);
+    legs.emplace_back(TensorLeg{child.second + 1,static_cast<unsigned int>(nodes[child.second].children.size())});
+   }
+  }
+  if(n > 0){ //bond to the parent tensor
+   dim_extents.emplace_back(node.bond_dim);
+   legs.emplace_back(TensorLeg{node.parent + 1,node.position});
+  }
+  auto appended = network.placeTensor(n + 1, //tensor id
+                                      std::make_shared<Tensor>("_T"+std::to_string(n + 1),dim_extents), //tensor name
+                                      legs,
+                                      false,
+                                      false
+                                     );
+  assert(appended);
+  auto & tensor = *(network.getTensor(n + 1));
+  tensor.rename(generateTensorName(tensor,"t"));
+  if(isometric_ && n > 0){ //isometry over the child legs
+   std::vector<unsigned int> iso_dims(node.children.size());
+   for(unsigned int i = 0; i < iso_dims.size(); ++i) iso_dims[i] = i;
+   tensor.registerIsometry(iso_dims);
+  }
+ }
  return;
 }
 
@@ -1,10 +1,29 @@
 /** ExaTN::Numerics: Tensor network builder: Tree: Tree Tensor Network
-REVISION: 2019/11/01
+REVISION: 2020/10/05
 
-Copyright (C) 2018-2019 Dmitry I. Lyakh (Liakh)
-Copyright (C) 2018-2019 Oak Ridge National Laboratory (UT-Battelle) **/
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 
 /** Rationale:
+ (a) The tree tensor network (TTN) builder recursively splits the output tensor modes
+     into (at most) arity groups, each group forming a subtree, until a group contains
+     no more than arity modes, which are then attached directly to the tensor at the
+     bottom of the subtree. The bond between a subtree and its parent tensor has the
+     dimension equal to the minimum of the maximal bond dimension and the volumes
+     of the output modes inside and outside the subtree.
+ (b) By default, the output tensor modes are split into contiguous groups in their
+     natural order. If the mode affinity graph is provided (for example, an interaction
+     graph or mutual information), the modes are split by recursive k-way partitioning
+     of the affinity graph via METIS (MetisGraph) minimizing the affinity weight cut
+     between the subtrees, such that strongly correlated modes end up in the same subtree.
+ (c) Optionally, the TTN tensors can be emitted in the isometric (canonical) form with
+     the root tensor being the center: Each non-root tensor has the isometry registered
+     over all its dimensions except the bond to its parent tensor, such that the norm
+     contractions of the non-root tensors with their conjugates can be removed by
+     TensorNetwork::collapseIsometries(). The actual tensor bodies must then be
+     initialized as isometries (for example, orthogonalized random tensors).
+ (d) Tensor legs of each TTN tensor: Child legs (output modes or bonds to the child
+     tensors) in the order of the subtrees, followed by the bond to the parent tensor.
 **/
 
 #ifndef EXATN_NUMERICS_NETWORK_BUILDER_TREE_HPP_
@@ -14,6 +33,8 @@ Copyright (C) 2018-2019 Oak Ridge National Laboratory (UT-Battelle) **/
 #include "network_builder.hpp"
 
 #include <string>
+#include <vector>
+#include <utility>
 #include <memory>
 
 namespace exatn{
@@ -34,9 +55,18 @@ public:
  /** Retrieves a specific parameter of the tensor network builder. **/
  virtual bool getParameter(const std::string & name, long long * value) const override;
 
- /** Sets a specific parameter of the tensor network builder. **/
+ /** Sets a specific parameter of the tensor network builder:
+      "max_bond_dim": Maximal internal bond dimension;
+      "arity": Tree arity (>= 2);
+      "isometric": Whether or not to register isometries in the non-root tensors (0/1). **/
  virtual bool setParameter(const std::string & name, long long value) override;
 
+ /** Sets the mode affinity graph over the output tensor modes: Each edge connects
+     two output tensor modes with a positive affinity weight. An empty edge list
+     restores the natural order of the output tensor modes. **/
+ bool setModeAffinity(const std::vector<std::pair<unsigned int, unsigned int>> & edges, //in: pairs of affine output tensor modes
+                      const std::vector<double> & weights);                             //in: positive affinity weights of the edges
+
  /** Builds a tensor network of a specific kind. **/
  virtual void build(TensorNetwork & network) override;
 
@@ -44,8 +74,17 @@ public:
 
 private:
 
+ static constexpr double AFFINITY_RESOLUTION = 1000.0; //integer resolution of the (relative) affinity weights
+ static constexpr double PARTITION_IMBALANCE = 1.05;   //tolerated weight imbalance of the mode partitions
+
+ /** Splits a group of output tensor modes into (at most) arity non-empty subgroups. **/
+ std::vector<std::vector<unsigned int>> splitModes(const std::vector<unsigned int> & modes) const;
+
  long long max_bond_dim_; //maximal internal bond dimension
  long long arity_;        //tree arity
+ bool isometric_;         //whether or not to register isometries in the non-root tensors
+ std::vector<std::pair<unsigned int, unsigned int>> affinity_edges_; //edges of the mode affinity graph
+ std::vector<double> affinity_weights_;                              //affinity weights of the edges
 };
 
 } //namespace numerics
@@ -0,0 +1,199 @@
+/** ExaTN::Numerics: Sliced execution template for a tensor network with split indices
+REVISION: 2020/10/07
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+#include "sliced_execution_template.hpp"
+#include "tensor_op_factory.hpp"
+
+#include <unordered_map>
+#include <iostream>
+#include <string>
+
+#include <cassert>
+
+namespace exatn{
+
+namespace numerics{
+
+constexpr const unsigned int SlicedExecutionTemplate::DEFAULT_POOL_SIZE;
+
+
+SlicedExecutionTemplate::SlicedExecutionTemplate(const TensorNetwork & network,
+                                                 const std::list<std::shared_ptr<TensorOperation>> & operations,
+                                                 bool hoist_invariants,
+                                                 unsigned int pool_size):
+ output_tensor_(network.getTensor(0)), next_instance_(0)
+{
+ assert(pool_size > 0);
+ const auto num_split_indices = network.getNumSplitIndices();
+ for(unsigned int i = 0; i < num_split_indices; ++i) split_indices_.emplace_back(network.getSplitIndexInfo(i));
+ std::unordered_map<TensorHashType,unsigned int> intermediate_slots; //parental tensor hash --> slot
+ std::unordered_map<TensorHashType,unsigned int> input_slots;        //parental tensor hash --> slot (within a tensor operation)
+ for(const auto & op: operations){
+  if(hoist_invariants && network.getSliceDependence(*op) != SliceDependence::DEPENDENT) continue;
+  entries_.emplace_back(Entry{op,{}});
+  auto & entry = entries_.back();
+  input_slots.clear();
+  const auto num_operands = op->getNumOperands();
+  for(unsigned int op_num = 0; op_num < num_operands; ++op_num){
+   auto tensor = op->getTensorOperand(op_num);
+   const auto tensor_hash = tensor->getTensorHash();
+   const bool tensor_is_output = (tensor == output_tensor_);
+   const bool tensor_is_intermediate = tensorNameIsIntermediate(*tensor);
+   //Look up the tensor operand in the table of sliced tensor operands:
+   std::pair<TensorHashType,TensorHashType> key;
+   if(tensor_is_intermediate || tensor_is_output){ //intermediate tensor (including output tensor)
+    key = std::make_pair(static_cast<TensorHashType>(0),tensor_hash);
+   }else{ //input tensor
+    key = std::make_pair(op->getTensorOpHash(),static_cast<TensorHashType>(op_num));
+   }
+   const auto * tensor_info = network.getSplitTensorInfo(key);
+   if(tensor_info != nullptr){ //tensor has split indices
+    const bool persistent = (tensor_is_intermediate && !tensor_is_output); //pure intermediate tensor
+    auto & slot_table = persistent ? intermediate_slots : input_slots;
+    auto res = slot_table.emplace(std::make_pair(tensor_hash,static_cast<unsigned int>(slots_.size())));
+    if(res.second) slots_.emplace_back(Slot{tensor,persistent,tensor_is_output,*tensor_info});
+    entry.bindings.emplace_back(std::make_pair(op_num,res.first->second));
+   }
+  }
+ }
+ //Build the template instances once:
+ pool_.resize(pool_size);
+ for(unsigned int i = 0; i < pool_size; ++i) buildInstance(i,pool_[i]);
+}
+
+
+std::size_t SlicedExecutionTemplate::getNumOperations() const
+{
+ return entries_.size();
+}
+
+
+unsigned int SlicedExecutionTemplate::getNumSlots() const
+{
+ return slots_.size();
+}
+
+
+unsigned int SlicedExecutionTemplate::getPoolSize() const
+{
+ return pool_.size();
+}
+
+
+const std::vector<std::shared_ptr<TensorOperation>> & SlicedExecutionTemplate::getPendingOperations() const
+{
+ static const std::vector<std::shared_ptr<TensorOperation>> no_operations;
+ const auto & instance = pool_[next_instance_];
+ if(!instance.instantiated) return no_operations;
+ return instance.operations;
+}
+
+
+void SlicedExecutionTemplate::buildInstance(unsigned int instance_id,
+                                            Instance & instance) const
+{
+ auto & tensor_op_factory = *(TensorOpFactory::get());
+ instance.slices.clear();
+ instance.operations.clear();
+ instance.last_op = 0;
+ instance.instantiated = false;
+ //Slices (bound to their index segments upon instantiation):
+ for(unsigned int i = 0; i < slots_.size(); ++i){
+  instance.slices.emplace_back(std::make_shared<Tensor>(*(slots_[i].tensor)));
+  instance.slices.back()->rename("_s" + std::to_string(i) + "_" + std::to_string(instance_id));
+ }
+ //Tensor operations with the sliced tensor operands bound to the slices:
+ std::vector<bool> extracted(slots_.size(),false); //whether or not the slice of an input slot currently exists
+ std::vector<unsigned int> created; //input slots sliced within the current tensor operation
+ for(const auto & entry: entries_){
+  std::shared_ptr<TensorOperation> tens_op(std::move(entry.op->clone()));
+  std::shared_ptr<Tensor> output_tensor_slice;
+  created.clear();
+  for(const auto & binding: entry.bindings){
+   const auto & slot = slots_[binding.second];
+   const auto & slice = instance.slices[binding.second];
+   if(!slot.intermediate && !extracted[binding.second]){ //input/output tensor: create slice and extract its contents
+    auto create_slice = tensor_op_factory.createTensorOpShared(TensorOpCode::CREATE);
+    create_slice->setTensorOperand(slice);
+    std::dynamic_pointer_cast<TensorOpCreate>(create_slice)->resetTensorElementType(slot.tensor->getElementType());
+    instance.operations.emplace_back(create_slice);
+    auto extract_slice = tensor_op_factory.createTensorOpShared(TensorOpCode::SLICE);
+    extract_slice->setTensorOperand(slice);
+    extract_slice->setTensorOperand(slot.tensor);
+    instance.operations.emplace_back(extract_slice);
+    if(slot.output) output_tensor_slice = slice;
+    extracted[binding.second] = true;
+    created.emplace_back(binding.second);
+   }
+   bool replaced = tens_op->resetTensorOperand(binding.first,slice); assert(replaced);
+  }
+  instance.operations.emplace_back(tens_op);
+  instance.last_op = instance.operations.size() - 1;
+  //Insert the output tensor slice back into the output tensor:
+  if(output_tensor_slice){
+   auto insert_slice = tensor_op_factory.createTensorOpShared(TensorOpCode::INSERT);
+   insert_slice->setTensorOperand(output_tensor_);
+   insert_slice->setTensorOperand(output_tensor_slice);
+   instance.operations.emplace_back(insert_slice);
+   instance.last_op = instance.operations.size() - 1;
+  }
+  //Destroy temporary input tensor slices:
+  for(const auto & slot: created){
+   auto destroy_slice = tensor_op_factory.createTensorOpShared(TensorOpCode::DESTROY);
+   destroy_slice->setTensorOperand(instance.slices[slot]);
+   instance.operations.emplace_back(destroy_slice);
+   extracted[slot] = false;
+  }
+ }
+ return;
+}
+
+
+void SlicedExecutionTemplate::bindSlice(const Slot & slot,
+                                        Tensor & slice,
+                                        const TensorRange & work_range) const
+{
+ const auto & tensor = *(slot.tensor);
+ for(const auto & split_dim: slot.split_dims){
+  const auto & segment = split_indices_[split_dim.first].second[work_range.getIndex(split_dim.first)];
+  slice.replaceDimension(split_dim.second,std::make_pair(tensor.getDimSpaceId(split_dim.second),segment.first),segment.second);
+ }
+ return;
+}
+
+
+std::size_t SlicedExecutionTemplate::instantiate(const TensorRange & work_range,
+                                                 std::vector<std::shared_ptr<TensorOperation>> & operations)
+{
+ auto & instance = pool_[next_instance_];
+ next_instance_ = (next_instance_ + 1) % pool_.size();
+ //Rebind the slices of the template instance to the current index segments:
+ for(unsigned int i = 0; i < slots_.size(); ++i) bindSlice(slots_[i],*(instance.slices[i]),work_range);
+ instance.instantiated = true;
+ operations.assign(instance.operations.cbegin(),instance.operations.cend());
+ return instance.last_op;
+}
+
+
+void SlicedExecutionTemplate::printItFile(std::ofstream & output_file) const
+{
+ output_file << "SlicedExecutionTemplate{" << std::endl;
+ output_file << " Number of tensor operations = " << entries_.size() << std::endl;
+ output_file << " Number of template instances = " << pool_.size() << std::endl;
+ for(const auto & slot: slots_){
+  output_file << " Tensor " << slot.tensor->getName() << " (intermediate = " << slot.intermediate << "):";
+  for(const auto & split_dim: slot.split_dims){
+   output_file << " " << split_indices_[split_dim.first].first << " in position " << split_dim.second;
+  }
+  output_file << std::endl;
+ }
+ output_file << "}" << std::endl;
+ return;
+}
+
+} //namespace numerics
+
+} //namespace exatn
@@ -0,0 +1,142 @@
+/** ExaTN::Numerics: Sliced execution template for a tensor network with split indices
+REVISION: 2020/10/07
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+/** Rationale:
+ (a) Once some indices of a tensor network have been split, the tensor operation list
+     is executed once per tensor sub-network (slice), with the sliced tensor operands
+     replaced by their respective slices. The sliced execution template analyzes
+     the tensor operation list only once: Each sliced tensor operand is bound to
+     a slot which carries its parental tensor and its split dimensions.
+ (b) The template is compiled into a pool of template instances, one per tensor sub-network
+     in flight. Each template instance owns the clones of the template tensor operations
+     (together with the creation, extraction, insertion and destruction of slices) with
+     their sliced tensor operands already bound to the slices owned by the same instance.
+     The slices are named deterministically after their slot and template instance.
+     Instantiating the template for a given tensor sub-network (a position in the range
+     of index segments) only rebinds the slices of the next template instance (round robin)
+     to their index segments, thus no tensor operations or tensors are created per slice.
+     Since the submitted tensor operations are owned by the runtime until completion,
+     the tensor operations of a template instance must have completed before the
+     template instance is reused (see getPendingOperations).
+ (c) Slices of input tensors (and of the output tensor of the tensor network) are created,
+     extracted, used and destroyed within each tensor operation. Slices of intermediate
+     tensors persist over the whole tensor sub-network, being created and destroyed
+     by the tensor operations of the tensor operation list.
+**/
+
+#ifndef EXATN_NUMERICS_SLICED_EXECUTION_TEMPLATE_HPP_
+#define EXATN_NUMERICS_SLICED_EXECUTION_TEMPLATE_HPP_
+
+#include "tensor_basic.hpp"
+#include "tensor_network.hpp"
+#include "tensor_range.hpp"
+
+#include <list>
+#include <vector>
+#include <memory>
+#include <fstream>
+
+namespace exatn{
+
+namespace numerics{
+
+class SlicedExecutionTemplate{
+
+public:
+
+ static constexpr const unsigned int DEFAULT_POOL_SIZE = 4; //default number of template instances (tensor sub-networks in flight)
+
+ /** Compiles the tensor operation list of a tensor network with split indices
+     into the sliced execution template with a given number of template instances.
+     If the slice-invariant tensor operations are hoisted, they are excluded
+     (executed outside of the template). **/
+ SlicedExecutionTemplate(const TensorNetwork & network,                                 //in: tensor network with split indices
+                         const std::list<std::shared_ptr<TensorOperation>> & operations, //in: tensor operation list of the tensor network
+                         bool hoist_invariants = false,                                  //in: whether or not slice-invariant tensor operations are excluded
+                         unsigned int pool_size = DEFAULT_POOL_SIZE);                    //in: number of template instances (tensor sub-networks in flight)
+
+ SlicedExecutionTemplate(const SlicedExecutionTemplate &) = delete;
+ SlicedExecutionTemplate & operator=(const SlicedExecutionTemplate &) = delete;
+ SlicedExecutionTemplate(SlicedExecutionTemplate &&) noexcept = default;
+ SlicedExecutionTemplate & operator=(SlicedExecutionTemplate &&) noexcept = default;
+ ~SlicedExecutionTemplate() = default;
+
+ /** Returns the number of template tensor operations. **/
+ std::size_t getNumOperations() const;
+
+ /** Returns the number of slots (sliced tensor operands). **/
+ unsigned int getNumSlots() const;
+
+ /** Returns the number of template instances (tensor sub-networks in flight). **/
+ unsigned int getPoolSize() const;
+
+ /** Returns the tensor operations of the template instance to be reused by the next
+     instantiation if it has already been instantiated (empty otherwise). These tensor
+     operations must have completed before the next instantiation. **/
+ const std::vector<std::shared_ptr<TensorOperation>> & getPendingOperations() const;
+
+ /** Instantiates the template for the tensor sub-network selected by the current
+     position of the work range (segment selectors for all split indices) by rebinding
+     the slices of the next template instance. The tensor operations of the template instance
+     (including creation, extraction, insertion and destruction of slices) are returned
+     in the order of submission. Returns the position of the last tensor operation
+     which is not a destruction of a slice, or zero if there are no tensor operations. **/
+ std::size_t instantiate(const TensorRange & work_range,                             //in: current position in the range of index segments
+                         std::vector<std::shared_ptr<TensorOperation>> & operations); //out: tensor operations for the tensor sub-network
+
+ /** Prints the slots. **/
+ void printItFile(std::ofstream & output_file) const;
+
+private:
+
+ //Sliced tensor operand:
+ struct Slot{
+  std::shared_ptr<Tensor> tensor; //parental tensor
+  bool intermediate;              //whether or not the slice persists over the tensor sub-network (pure intermediate tensor)
+  bool output;                    //whether or not the parental tensor is the output tensor of the tensor network
+  std::vector<std::pair<unsigned int,   //global id of the split index
+                        unsigned int>>  //dimension position in the tensor
+              split_dims;               //split dimensions of the tensor
+ };
+
+ //Template tensor operation:
+ struct Entry{
+  std::shared_ptr<TensorOperation> op;     //template tensor operation
+  std::vector<std::pair<unsigned int,      //tensor operand position
+                        unsigned int>>     //slot
+              bindings;                    //sliced tensor operands
+ };
+
+ //Template instance (one tensor sub-network in flight):
+ struct Instance{
+  std::vector<std::shared_ptr<Tensor>> slices;              //slices (slot --> slice)
+  std::vector<std::shared_ptr<TensorOperation>> operations; //tensor operations in the order of submission
+  std::size_t last_op;                                      //position of the last tensor operation which is not a destruction of a slice
+  bool instantiated;                                        //whether or not the template instance has been instantiated
+ };
+
+ /** Builds a template instance with its slices and tensor operations. **/
+ void buildInstance(unsigned int instance_id,
+                    Instance & instance) const;
+
+ /** Rebinds the slice of a slot to the index segments selected by the current position of the work range. **/
+ void bindSlice(const Slot & slot,
+                Tensor & slice,
+                const TensorRange & work_range) const;
+
+ std::vector<std::pair<std::string,IndexSplit>> split_indices_; //split indices (global id --> label, segments)
+ std::vector<Slot> slots_;                                      //sliced tensor operands
+ std::vector<Entry> entries_;                                   //template tensor operations
+ std::shared_ptr<Tensor> output_tensor_;                        //output tensor of the tensor network
+ std::vector<Instance> pool_;                                   //template instances
+ unsigned int next_instance_;                                   //template instance to be instantiated next
+};
+
+} //namespace numerics
+
+} //namespace exatn
+
+#endif //EXATN_NUMERICS_SLICED_EXECUTION_TEMPLATE_HPP_
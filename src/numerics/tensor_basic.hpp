@@ -51,7 +51,8 @@ enum class TensorOpCode{
  ORTHOGONALIZE_SVD, //tensor orthogonalization via SVD
  ORTHOGONALIZE_MGS, //tensor orthogonalization via Modified Gram-Schmidt
  BROADCAST,         //tensor broadcast (parallel execution only)
- ALLREDUCE          //tensor allreduce (parallel execution only)
+ ALLREDUCE,         //tensor allreduce (parallel execution only)
+ APPLY_GATE_SVD2    //fused two-site gate application with truncated SVD into two tensor factors
 };
 
 enum class TensorElementType{
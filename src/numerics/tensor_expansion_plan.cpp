@@ -0,0 +1,201 @@
+/** ExaTN::Numerics: Combined evaluation plan for a tensor network expansion
+REVISION: 2020/10/07
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+#include "tensor_expansion_plan.hpp"
+#include "tensor_op_factory.hpp"
+#include "tensor_symbol.hpp"
+#include "functor_init_val.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+
+#include <cassert>
+
+namespace exatn{
+
+namespace numerics{
+
+TensorExpansionPlan::TensorExpansionPlan(TensorExpansion & expansion,
+                                         const std::string & contr_seq_opt_name,
+                                         bool refine):
+ fma_flops_(0.0), saved_fma_flops_(0.0), num_shared_intermediates_(0), max_intermediate_presence_volume_(0.0)
+{
+ auto & tensor_op_factory = *(TensorOpFactory::get());
+ std::unordered_map<std::string,std::shared_ptr<Tensor>> computed; //canonical key --> computed intermediate tensor
+ std::unordered_set<std::string> reused; //canonical keys of reused intermediate tensors
+ std::list<std::shared_ptr<TensorOperation>> operations; //combined list of tensor operations (without destruction)
+ for(auto component = expansion.begin(); component != expansion.end(); ++component){
+  auto & network = *(component->network_);
+  if(network.getNumTensors() > 1 && network.exportContractionSequence().empty())
+   network.determineContractionSequence(contr_seq_opt_name,refine);
+  TensorNetwork net(network);
+  //Canonical keys of the input tensors (tensor identity):
+  std::unordered_map<unsigned int,std::string> keys; //tensor id --> canonical key
+  for(auto iter = net.cbegin(); iter != net.cend(); ++iter){
+   if(iter->first != 0){
+    bool conj;
+    auto tensor = net.getTensor(iter->first,&conj);
+    keys[iter->first] = tensor->getName() + (conj ? "+" : "");
+   }
+  }
+  if(net.getNumTensors() > 1){ //two or more input tensors: One or more contractions
+   auto contr_seq = network.exportContractionSequence(); //copy
+   for(auto contr: contr_seq){
+    //Canonicalize the contraction subtree:
+    if(keys[contr.right_id] < keys[contr.left_id]) std::swap(contr.left_id,contr.right_id);
+    const auto * left_legs = net.getTensorConnections(contr.left_id);
+    assert(left_legs != nullptr);
+    std::string key = "(" + keys[contr.left_id] + "*" + keys[contr.right_id] + ":";
+    for(unsigned int i = 0; i < left_legs->size(); ++i){
+     const auto & leg = (*left_legs)[i];
+     if(leg.getTensorId() == contr.right_id) key += std::to_string(i) + "," + std::to_string(leg.getDimensionId()) + ";";
+    }
+    key += ")";
+    bool conj1, conj2;
+    auto tensor1 = net.getTensor(contr.left_id,&conj1);
+    auto tensor2 = net.getTensor(contr.right_id,&conj2);
+    const double flops = net.getContractionCost(contr.left_id,contr.right_id);
+    IndexModeMap contr_pattern;
+    std::shared_ptr<Tensor> tensor0;
+    if(contr.result_id != 0){ //intermediate contraction
+     auto merged = net.mergeTensors(contr.left_id,contr.right_id,contr.result_id,&contr_pattern);
+     assert(merged);
+     keys[contr.result_id] = key;
+     auto shared = computed.find(key);
+     if(shared != computed.end()){ //intermediate tensor has already been computed
+      auto substituted = net.substituteTensor(contr.result_id,shared->second);
+      assert(substituted);
+      saved_fma_flops_ += flops;
+      reused.emplace(key);
+      continue;
+     }
+     tensor0 = net.getTensor(contr.result_id);
+     tensor0->rename(tensor_hex_name("x",tensor0->getTensorHash())); //intermediates of all components must have unique names (not _yID)
+     computed.emplace(std::make_pair(key,tensor0));
+     auto op_create = tensor_op_factory.createTensorOpShared(TensorOpCode::CREATE); //create intermediate
+     op_create->setTensorOperand(tensor0);
+     if(tensor0->getElementType() != TensorElementType::VOID)
+      std::dynamic_pointer_cast<TensorOpCreate>(op_create)->resetTensorElementType(tensor0->getElementType());
+     operations.emplace_back(op_create);
+     std::shared_ptr<TensorOperation> op_init(std::move(tensor_op_factory.createTensorOp(TensorOpCode::TRANSFORM))); //init intermediate to zero
+     op_init->setTensorOperand(tensor0);
+     std::dynamic_pointer_cast<TensorOpTransform>(op_init)->
+          resetFunctor(std::shared_ptr<talsh::TensorFunctor<Identifiable>>(new FunctorInitVal(0.0)));
+     operations.emplace_back(op_init);
+    }else{ //last contraction accumulates into the output tensor of the tensor network
+     const auto * right_legs = net.getTensorConnections(contr.right_id);
+     assert(right_legs != nullptr);
+     std::vector<TensorLeg> pattern(*left_legs);
+     pattern.insert(pattern.end(),right_legs->begin(),right_legs->end());
+     auto generated = generate_contraction_pattern(pattern,left_legs->size(),right_legs->size(),
+                                                   contr_pattern,conj1,conj2);
+     assert(generated);
+     tensor0 = net.getTensor(0);
+     if(tensor0->getElementType() == TensorElementType::VOID) tensor0->setElementType(tensor1->getElementType());
+    }
+    auto op = tensor_op_factory.createTensorOp(TensorOpCode::CONTRACT);
+    op->setTensorOperand(tensor0);
+    op->setTensorOperand(tensor1,conj1);
+    op->setTensorOperand(tensor2,conj2);
+    op->setIndexPattern(std::move(contr_pattern));
+    assert(op->isSet());
+    operations.emplace_back(std::shared_ptr<TensorOperation>(std::move(op)));
+    fma_flops_ += flops;
+   }
+  }else{ //one input tensor: Single addition
+   unsigned int left_id = 0;
+   for(auto iter = net.cbegin(); iter != net.cend(); ++iter) if(iter->first != 0) left_id = iter->first;
+   bool conj1;
+   auto tensor0 = net.getTensor(0);
+   auto tensor1 = net.getTensor(left_id,&conj1);
+   if(tensor0->getElementType() == TensorElementType::VOID) tensor0->setElementType(tensor1->getElementType());
+   auto op = tensor_op_factory.createTensorOp(TensorOpCode::ADD);
+   op->setTensorOperand(tensor0);
+   op->setTensorOperand(tensor1,conj1);
+   const auto * tensor1_legs = net.getTensorConnections(left_id);
+   assert(tensor1_legs != nullptr);
+   IndexModeMap add_pattern;
+   auto generated = generate_addition_pattern(*tensor1_legs,add_pattern,conj1);
+   assert(generated);
+   op->setIndexPattern(std::move(add_pattern));
+   assert(op->isSet());
+   operations.emplace_back(std::shared_ptr<TensorOperation>(std::move(op)));
+  }
+ }
+ num_shared_intermediates_ = reused.size();
+ //Destroy each intermediate tensor right after its last use:
+ std::unordered_map<const Tensor*,std::size_t> last_use; //intermediate tensor --> position of its last use
+ std::size_t position = 0;
+ for(const auto & op: operations){
+  if(op->getOpcode() == TensorOpCode::CREATE){
+   last_use[op->getTensorOperand(0).get()] = position;
+  }else{
+   for(unsigned int i = op->getNumOperandsOut(); i < op->getNumOperands(); ++i){
+    auto iter = last_use.find(op->getTensorOperand(i).get());
+    if(iter != last_use.end()) iter->second = position;
+   }
+  }
+  ++position;
+ }
+ std::vector<std::vector<std::shared_ptr<Tensor>>> destructions(operations.size()); //position --> intermediate tensors to destroy
+ for(const auto & op: operations){
+  if(op->getOpcode() == TensorOpCode::CREATE){
+   auto tensor = op->getTensorOperand(0);
+   destructions[last_use[tensor.get()]].emplace_back(tensor);
+  }
+ }
+ double intermediates_vol = 0.0;
+ position = 0;
+ for(auto & op: operations){
+  if(op->getOpcode() == TensorOpCode::CREATE){
+   intermediates_vol += static_cast<double>(op->getTensorOperand(0)->getVolume());
+   max_intermediate_presence_volume_ = std::max(max_intermediate_presence_volume_,intermediates_vol);
+  }
+  operations_.emplace_back(op);
+  for(auto & tensor: destructions[position]){
+   intermediates_vol -= static_cast<double>(tensor->getVolume());
+   auto op_destroy = tensor_op_factory.createTensorOp(TensorOpCode::DESTROY); //destroy intermediate
+   op_destroy->setTensorOperand(tensor);
+   operations_.emplace_back(std::shared_ptr<TensorOperation>(std::move(op_destroy)));
+  }
+  ++position;
+ }
+}
+
+
+const std::list<std::shared_ptr<TensorOperation>> & TensorExpansionPlan::getOperationList() const
+{
+ return operations_;
+}
+
+
+double TensorExpansionPlan::getFMAFlops() const
+{
+ return fma_flops_;
+}
+
+
+double TensorExpansionPlan::getSavedFMAFlops() const
+{
+ return saved_fma_flops_;
+}
+
+
+unsigned int TensorExpansionPlan::getNumSharedIntermediates() const
+{
+ return num_shared_intermediates_;
+}
+
+
+double TensorExpansionPlan::getMaxIntermediatePresenceVolume() const
+{
+ return max_intermediate_presence_volume_;
+}
+
+} //namespace numerics
+
+} //namespace exatn
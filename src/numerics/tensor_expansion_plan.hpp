@@ -0,0 +1,84 @@
+/** ExaTN::Numerics: Combined evaluation plan for a tensor network expansion
+REVISION: 2020/09/21
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+/** Rationale:
+ (a) Tensor network components of a tensor network expansion often share large
+     sub-networks, for example, the bra and ket tensor networks shared by all operator
+     terms in an inner product expansion. The combined evaluation plan computes each
+     intermediate tensor shared by multiple contraction subtrees only once
+     (common subexpression elimination).
+ (b) Each contraction subtree is canonicalized by ordering the two contracted children
+     by their canonical keys. A leaf key identifies an input tensor by its name and
+     conjugation; the key of an intermediate tensor is composed of the keys of its
+     children and the contracted mode pairs. Identical keys therefore imply identical
+     intermediate tensors, including the order of their modes.
+ (c) The combined list of tensor operations evaluates the output tensors of all tensor
+     network components (which must already exist and be initialized to zero), where each
+     intermediate tensor is created once and destroyed right after its last use.
+**/
+
+#ifndef EXATN_NUMERICS_TENSOR_EXPANSION_PLAN_HPP_
+#define EXATN_NUMERICS_TENSOR_EXPANSION_PLAN_HPP_
+
+#include "tensor_basic.hpp"
+#include "tensor_expansion.hpp"
+#include "tensor_operation.hpp"
+
+#include <list>
+#include <memory>
+#include <string>
+
+namespace exatn{
+
+namespace numerics{
+
+class TensorExpansionPlan{
+
+public:
+
+ /** Builds the combined evaluation plan for a given tensor network expansion. Tensor network
+     components without a tensor contraction sequence will have it determined by the
+     given tensor contraction sequence optimizer. **/
+ TensorExpansionPlan(TensorExpansion & expansion,                          //in: tensor network expansion
+                     const std::string & contr_seq_opt_name = "metis",     //in: tensor contraction sequence optimizer name
+                     bool refine = false);                                 //in: whether or not to refine tensor contraction sequences
+
+ TensorExpansionPlan(const TensorExpansionPlan &) = default;
+ TensorExpansionPlan & operator=(const TensorExpansionPlan &) = default;
+ TensorExpansionPlan(TensorExpansionPlan &&) noexcept = default;
+ TensorExpansionPlan & operator=(TensorExpansionPlan &&) noexcept = default;
+ ~TensorExpansionPlan() = default;
+
+ /** Returns the combined list of tensor operations evaluating the output tensors of all
+     tensor network components (the output tensors must already exist and be zeroed). **/
+ const std::list<std::shared_ptr<TensorOperation>> & getOperationList() const;
+
+ /** Returns the FMA flop count of the combined evaluation plan. **/
+ double getFMAFlops() const;
+
+ /** Returns the FMA flop count saved by computing shared intermediates only once. **/
+ double getSavedFMAFlops() const;
+
+ /** Returns the number of intermediate tensors reused at least once. **/
+ unsigned int getNumSharedIntermediates() const;
+
+ /** Returns the max total volume of intermediate tensors present at a time. **/
+ double getMaxIntermediatePresenceVolume() const;
+
+private:
+
+ std::list<std::shared_ptr<TensorOperation>> operations_; //combined list of tensor operations
+ double fma_flops_;                         //FMA flop count of the combined evaluation plan
+ double saved_fma_flops_;                   //FMA flop count saved due to shared intermediates
+ unsigned int num_shared_intermediates_;    //number of reused intermediate tensors
+ double max_intermediate_presence_volume_;  //max total volume of intermediate tensors present at a time
+};
+
+} //namespace numerics
+
+} //namespace exatn
+
+#endif //EXATN_NUMERICS_TENSOR_EXPANSION_PLAN_HPP_
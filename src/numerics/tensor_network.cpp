@@ -1,12 +1,14 @@
 /** ExaTN::Numerics: Tensor network
-REVISION: 2020/09/07
+REVISION: 2020/09/26
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 
 #include "tensor_network.hpp"
 #include "tensor_symbol.hpp"
+#include "flat_tensor_network.hpp"
 #include "contraction_seq_optimizer_factory.hpp"
+#include "contraction_cost_model.hpp"
 #include "functor_init_val.hpp"
 
 #include "metis_graph.hpp"
@@ -18,6 +20,7 @@ Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 #include <vector>
 #include <list>
 #include <map>
+#include <unordered_set>
 #include <memory>
 #include <algorithm>
 
@@ -69,9 +72,11 @@ bool tensorNameIsIntermediate(const Tensor & tensor,
 
 //Main:
 TensorNetwork::TensorNetwork():
- explicit_output_(0), finalized_(1), max_tensor_id_(0),
+ explicit_output_(0), finalized_(1), tensors_(std::make_shared<std::unordered_map<unsigned int, TensorConn>>()), max_tensor_id_(0),
  contraction_seq_flops_(0.0), max_intermediate_presence_volume_(0.0),
- max_intermediate_volume_(0.0), max_intermediate_rank_(0), universal_indexing_(false)
+ max_intermediate_volume_(0.0), max_intermediate_rank_(0),
+ slice_invariant_flops_(0.0), slice_invariant_volume_(0.0),
+ max_sliced_presence_volume_(0.0), max_hoisted_presence_volume_(0.0), universal_indexing_(false)
 {
  auto res = emplaceTensorConnDirect(false,
                                     0U, //output tensor (id = 0)
@@ -84,9 +89,11 @@ TensorNetwork::TensorNetwork():
 
 
 TensorNetwork::TensorNetwork(const std::string & name):
- explicit_output_(0), finalized_(1), name_(name), max_tensor_id_(0),
+ explicit_output_(0), finalized_(1), name_(name), tensors_(std::make_shared<std::unordered_map<unsigned int, TensorConn>>()), max_tensor_id_(0),
  contraction_seq_flops_(0.0), max_intermediate_presence_volume_(0.0),
- max_intermediate_volume_(0.0), max_intermediate_rank_(0), universal_indexing_(false)
+ max_intermediate_volume_(0.0), max_intermediate_rank_(0),
+ slice_invariant_flops_(0.0), slice_invariant_volume_(0.0),
+ max_sliced_presence_volume_(0.0), max_hoisted_presence_volume_(0.0), universal_indexing_(false)
 {
  auto res = emplaceTensorConnDirect(false,
                                     0U, //output tensor (id = 0)
@@ -101,9 +108,11 @@ TensorNetwork::TensorNetwork(const std::string & name):
 TensorNetwork::TensorNetwork(const std::string & name,
                              std::shared_ptr<Tensor> output_tensor,
                              const std::vector<TensorLeg> & output_legs):
- explicit_output_(1), finalized_(0), name_(name), max_tensor_id_(0),
+ explicit_output_(1), finalized_(0), name_(name), tensors_(std::make_shared<std::unordered_map<unsigned int, TensorConn>>()), max_tensor_id_(0),
  contraction_seq_flops_(0.0), max_intermediate_presence_volume_(0.0),
- max_intermediate_volume_(0.0), max_intermediate_rank_(0), universal_indexing_(false)
+ max_intermediate_volume_(0.0), max_intermediate_rank_(0),
+ slice_invariant_flops_(0.0), slice_invariant_volume_(0.0),
+ max_sliced_presence_volume_(0.0), max_hoisted_presence_volume_(0.0), universal_indexing_(false)
 {
  auto res = emplaceTensorConnDirect(false,
                                     0U, //output tensor (id = 0)
@@ -118,9 +127,11 @@ TensorNetwork::TensorNetwork(const std::string & name,
 TensorNetwork::TensorNetwork(const std::string & name,
                              const std::string & tensor_network,
                              const std::map<std::string,std::shared_ptr<Tensor>> & tensors):
- explicit_output_(1), finalized_(0), name_(name), max_tensor_id_(0),
+ explicit_output_(1), finalized_(0), name_(name), tensors_(std::make_shared<std::unordered_map<unsigned int, TensorConn>>()), max_tensor_id_(0),
  contraction_seq_flops_(0.0), max_intermediate_presence_volume_(0.0),
- max_intermediate_volume_(0.0), max_intermediate_rank_(0), universal_indexing_(false)
+ max_intermediate_volume_(0.0), max_intermediate_rank_(0),
+ slice_invariant_flops_(0.0), slice_invariant_volume_(0.0),
+ max_sliced_presence_volume_(0.0), max_hoisted_presence_volume_(0.0), universal_indexing_(false)
 {
  //Convert tensor hypernetwork into regular tensor network, if needed:
  //`Finish
@@ -200,9 +211,11 @@ TensorNetwork::TensorNetwork(const std::string & name,
 TensorNetwork::TensorNetwork(const std::string & name,
                              std::shared_ptr<Tensor> output_tensor,
                              NetworkBuilder & builder):
- explicit_output_(1), finalized_(0), name_(name), max_tensor_id_(0),
+ explicit_output_(1), finalized_(0), name_(name), tensors_(std::make_shared<std::unordered_map<unsigned int, TensorConn>>()), max_tensor_id_(0),
  contraction_seq_flops_(0.0), max_intermediate_presence_volume_(0.0),
- max_intermediate_volume_(0.0), max_intermediate_rank_(0), universal_indexing_(false)
+ max_intermediate_volume_(0.0), max_intermediate_rank_(0),
+ slice_invariant_flops_(0.0), slice_invariant_volume_(0.0),
+ max_sliced_presence_volume_(0.0), max_hoisted_presence_volume_(0.0), universal_indexing_(false)
 {
  auto res = emplaceTensorConnDirect(false,
                                     0U, //output tensor (id = 0)
@@ -232,7 +245,7 @@ void TensorNetwork::printIt(bool with_tensor_hash) const
  std::cout << "TensorNetwork(" << name_
            << ")[rank = " << this->getRank()
            << ", size = " << this->getNumTensors() << "]{" << std::endl;
- for(const auto & kv: tensors_){
+ for(const auto & kv: *tensors_){
   std::cout << " ";
   kv.second.printIt(with_tensor_hash);
  }
@@ -243,7 +256,7 @@ void TensorNetwork::printIt(bool with_tensor_hash) const
 
 bool TensorNetwork::isEmpty() const
 {
- return (tensors_.size() <= 1); //only output tensor exists => still empty
+ return (tensors_->size() <= 1); //only output tensor exists => still empty
 }
 
 
@@ -268,20 +281,20 @@ bool TensorNetwork::isValid()
 unsigned int TensorNetwork::getRank() const
 {
  assert(this->isFinalized());
- return tensors_.at(0).getNumLegs(); //output tensor
+ return tensors_->at(0).getNumLegs(); //output tensor
 }
 
 
 unsigned int TensorNetwork::getNumTensors() const
 {
- return static_cast<unsigned int>(tensors_.size() - 1); //output tensor is not counted
+ return static_cast<unsigned int>(tensors_->size() - 1); //output tensor is not counted
 }
 
 
 unsigned int TensorNetwork::getMaxTensorId()
 {
  if(max_tensor_id_ == 0){
-  for(const auto & kv: tensors_) max_tensor_id_ = std::max(max_tensor_id_,kv.first);
+  for(const auto & kv: *tensors_) max_tensor_id_ = std::max(max_tensor_id_,kv.first);
  }
  return max_tensor_id_;
 }
@@ -308,8 +321,9 @@ void TensorNetwork::updateMaxTensorIdOnRemove(unsigned int tensor_id)
 void TensorNetwork::resetOutputTensor(const std::string & name)
 {
  assert(finalized_ != 0);
- auto iter = tensors_.find(0);
- assert(iter != tensors_.end());
+ auto & tensors = mutableTensorConns();
+ auto iter = tensors.find(0);
+ assert(iter != tensors.end());
  iter->second.replaceStoredTensor(name);
  return;
 }
@@ -319,8 +333,9 @@ void TensorNetwork::resetOutputTensor(const std::vector<unsigned int> & order,
                                       const std::string & name)
 {
  assert(finalized_ != 0);
- auto iter = tensors_.find(0);
- assert(iter != tensors_.end());
+ auto & tensors = mutableTensorConns();
+ auto iter = tensors.find(0);
+ assert(iter != tensors.end());
  iter->second.replaceStoredTensor(order,name);
  return;
 }
@@ -343,8 +358,17 @@ void TensorNetwork::rename(const std::string & name)
 
 TensorConn * TensorNetwork::getTensorConn(unsigned int tensor_id)
 {
- auto it = tensors_.find(tensor_id);
- if(it == tensors_.end()) return nullptr;
+ auto & tensors = mutableTensorConns();
+ auto it = tensors.find(tensor_id);
+ if(it == tensors.end()) return nullptr;
+ return &(it->second);
+}
+
+
+const TensorConn * TensorNetwork::getTensorConn(unsigned int tensor_id) const
+{
+ auto it = tensors_->find(tensor_id);
+ if(it == tensors_->end()) return nullptr;
  return &(it->second);
 }
 
@@ -353,7 +377,7 @@ std::vector<TensorConn*> TensorNetwork::getTensorConnAll()
 {
  std::vector<TensorConn*> tensors(this->getNumTensors(),nullptr);
  unsigned int i = 0;
- for(auto & kv: tensors_){
+ for(auto & kv: mutableTensorConns()){
   if(kv.first != 0) tensors[i++] = &(kv.second);
  }
  return tensors;
@@ -362,8 +386,8 @@ std::vector<TensorConn*> TensorNetwork::getTensorConnAll()
 
 std::shared_ptr<Tensor> TensorNetwork::getTensor(unsigned int tensor_id, bool * conjugated) const
 {
- auto it = tensors_.find(tensor_id);
- if(it == tensors_.end()) return std::shared_ptr<Tensor>(nullptr);
+ auto it = tensors_->find(tensor_id);
+ if(it == tensors_->end()) return std::shared_ptr<Tensor>(nullptr);
  if(conjugated != nullptr) *conjugated = (it->second).isComplexConjugated();
  return (it->second).getTensor();
 }
@@ -371,8 +395,8 @@ std::shared_ptr<Tensor> TensorNetwork::getTensor(unsigned int tensor_id, bool *
 
 const std::vector<TensorLeg> * TensorNetwork::getTensorConnections(unsigned int tensor_id) const
 {
- auto it = tensors_.find(tensor_id);
- if(it == tensors_.end()) return nullptr;
+ auto it = tensors_->find(tensor_id);
+ if(it == tensors_->end()) return nullptr;
  return &((it->second).getTensorLegs());
 }
 
@@ -414,17 +438,17 @@ bool TensorNetwork::finalize(bool check_validity)
 }
 
 
-bool TensorNetwork::checkConnections(unsigned int tensor_id)
+bool TensorNetwork::checkConnections(unsigned int tensor_id) const
 {
  assert(finalized_ != 0); //tensor network must be in finalized state
- auto * tensor = this->getTensorConn(tensor_id);
+ const auto * tensor = this->getTensorConn(tensor_id);
  assert(tensor != nullptr); //invalid tensor_id
  auto tensor_rank = tensor->getNumLegs();
  for(unsigned int i = 0; i < tensor_rank; ++i){
   const auto & tensor_leg = tensor->getTensorLeg(i);
   auto other_tensor_id = tensor_leg.getTensorId();
   auto other_tensor_leg_id = tensor_leg.getDimensionId();
-  auto * other_tensor = this->getTensorConn(other_tensor_id);
+  const auto * other_tensor = this->getTensorConn(other_tensor_id);
   assert(other_tensor != nullptr); //unable to find the linked tensor
   const auto & other_tensor_leg = other_tensor->getTensorLeg(other_tensor_leg_id);
   if(other_tensor_leg.getTensorId() != tensor_id ||
@@ -435,10 +459,10 @@ bool TensorNetwork::checkConnections(unsigned int tensor_id)
 }
 
 
-bool TensorNetwork::checkConnections()
+bool TensorNetwork::checkConnections() const
 {
  assert(finalized_ != 0); //tensor network must be in finalized state
- for(const auto & kv: tensors_){
+ for(const auto & kv: *tensors_){
   if(!checkConnections(kv.first)) return false;
  }
  return true;
@@ -468,7 +492,8 @@ void TensorNetwork::updateConnections(unsigned int tensor_id)
 
 void TensorNetwork::updateConnectionsFromInputTensors()
 {
- for(auto iter = this->cbegin(); iter != this->cend(); ++iter){
+ const auto & tensors = mutableTensorConns(); //updated connections will not be shared
+ for(auto iter = tensors.cbegin(); iter != tensors.cend(); ++iter){
   if(iter->first != 0) updateConnections(iter->first);
  }
  return;
@@ -486,6 +511,11 @@ void TensorNetwork::invalidateContractionSequence()
 {
  split_tensors_.clear();
  split_indices_.clear();
+ slice_dependence_.clear();
+ slice_invariant_flops_ = 0.0;
+ slice_invariant_volume_ = 0.0;
+ max_sliced_presence_volume_ = 0.0;
+ max_hoisted_presence_volume_ = 0.0;
  operations_.clear();
  contraction_seq_.clear();
  contraction_seq_flops_ = 0.0;
@@ -497,22 +527,61 @@ void TensorNetwork::invalidateContractionSequence()
 }
 
 
-double TensorNetwork::determineContractionSequence(ContractionSeqOptimizer & contr_seq_optimizer)
+double TensorNetwork::determineContractionSequence(ContractionSeqOptimizer & contr_seq_optimizer,
+                                                   bool refine,
+                                                   ContrSeqRefinementInfo * refinement_info,
+                                                   bool simplify,
+                                                   unsigned int * num_removed)
 {
  assert(finalized_ != 0); //tensor network must be in finalized state
+ if(num_removed != nullptr) *num_removed = 0;
  if(contraction_seq_.empty()){
-  auto intermediate_num_begin = this->getMaxTensorId() + 1;
+  TensorNetwork * network = this;
+  std::unique_ptr<TensorNetwork> simplified;
+  std::list<ContrTriple> merges;
+  double merge_flops = 0.0;
+  if(simplify && this->getNumTensors() > 2){ //optimize the simplified copy of the tensor network
+   simplified = std::unique_ptr<TensorNetwork>(new TensorNetwork(*this));
+   auto removed = simplified->simplify(merges,&merge_flops);
+   if(num_removed != nullptr) *num_removed = removed;
+   if(removed > 0) network = simplified.get();
+  }
+  auto intermediate_num_begin = network->getMaxTensorId() + 1;
   auto intermediate_num_generator = [intermediate_num_begin]() mutable {return intermediate_num_begin++;};
-  contraction_seq_flops_ = contr_seq_optimizer.determineContractionSequence(*this,contraction_seq_,intermediate_num_generator);
+  contraction_seq_flops_ = contr_seq_optimizer.determineContractionSequence(*network,contraction_seq_,intermediate_num_generator);
+  if(!merges.empty()){ //prepend the merges performed by simplification
+   contraction_seq_.splice(contraction_seq_.begin(),merges);
+   contraction_seq_flops_ += merge_flops;
+  }
+  if(ContractionCostModel::getActive() != nullptr && !contraction_seq_.empty()){ //optimizer minimized the predicted time: Recompute FMA flops
+   contraction_seq_flops_ = 0.0;
+   FlatTensorNetwork net(*this);
+   for(const auto & contr: contraction_seq_){
+    contraction_seq_flops_ += net.getContractionCost(contr.left_id,contr.right_id);
+    if(contr.result_id != 0){
+     auto merged = net.mergeTensors(contr.left_id,contr.right_id,contr.result_id); assert(merged);
+    }
+   }
+  }
+  if(refine && contraction_seq_.size() > 1){
+   contraction_seq_flops_ = ContractionSeqOptimizer::refineContractionSequence(*this,contraction_seq_,
+                             ContractionSeqOptimizer::DEFAULT_REFINEMENT_WINDOW,refinement_info);
+   refinement_info = nullptr; //refinement info has already been set
+  }
   max_intermediate_presence_volume_ = 0.0;
   max_intermediate_volume_ = 0.0;
   max_intermediate_rank_ = 0;
  }
+ if(refinement_info != nullptr) *refinement_info = ContrSeqRefinementInfo{contraction_seq_flops_,contraction_seq_flops_,0.0,0,0};
  return contraction_seq_flops_;
 }
 
 
-double TensorNetwork::determineContractionSequence(const std::string & contr_seq_opt_name)
+double TensorNetwork::determineContractionSequence(const std::string & contr_seq_opt_name,
+                                                   bool refine,
+                                                   ContrSeqRefinementInfo * refinement_info,
+                                                   bool simplify,
+                                                   unsigned int * num_removed)
 {
  auto iter = optimizers.find(contr_seq_opt_name);
  if(iter == optimizers.end()){ //not cached
@@ -529,7 +598,7 @@ double TensorNetwork::determineContractionSequence(const std::string & contr_seq
    assert(false);
   }
  }
- return determineContractionSequence(*(iter->second));
+ return determineContractionSequence(*(iter->second),refine,refinement_info,simplify,num_removed);
 }
 
 
@@ -594,129 +663,79 @@ inline IndexSplit splitDimension(std::pair<SpaceId,SubspaceId> space_attr, //hel
 void TensorNetwork::establishUniversalIndexNumeration()
 {
  if(universal_indexing_) return;
- std::unordered_map<TensorHashType,std::string> intermediates; //tensor hash --> symbolic tensor intermediate with universal indices
- std::unordered_map<std::string,std::string> index_map; //old index name --> new index name
- std::vector<std::string> tens_operands; //extracted tensor operands
- std::vector<IndexLabel> indices,new_indices; //indices extracted from a tensor
- std::string tensor_name; //tensor name extracted from a tensor
- std::string new_pattern; //new tensor operation index pattern
- bool conjugated = false;
+ std::unordered_map<TensorHashType,std::vector<unsigned int>> intermediates; //tensor hash --> universal index labels of an intermediate tensor
+ std::unordered_map<unsigned int,unsigned int> index_map; //old index label --> new index label
  bool output_tensor_done = false;
- int num_internal_indices = 0;
+ unsigned int num_internal_indices = 0;
  //Update index patterns in all tensor operations in reverse order:
  for(auto op_iter = operations_.rbegin(); op_iter != operations_.rend(); ++op_iter){
   auto & op = *(*op_iter); //tensor operation
   const auto num_operands = op.getNumOperands();
   const auto num_operands_out = op.getNumOperandsOut();
   assert(num_operands <= 3 && num_operands_out <= 1); //`Only expecting regular tensor operations so far
-  const auto & old_pattern = op.getIndexPattern();
-  if(old_pattern.length() > 0){ //index pattern present
+  if(op.hasIndexPattern()){ //index pattern present
    assert(num_operands > 1 && num_operands_out == 1); //presence of index pattern assumes two or more operands
-   //std::cout << "#DEBUG(TensorNetwork::establishUniversalIndexNumeration): Old pattern: " << old_pattern << std::endl; //debug
-   tens_operands.clear();
-   bool success = parse_tensor_network(old_pattern,tens_operands);
-   if(success){
-    //Process all tensor operands:
-    if(tens_operands.size() == num_operands){
-     new_pattern.clear();
-     //Process the only output tensor operand (#0):
-     tensor_name.clear(); indices.clear();
-     success = parse_tensor(tens_operands[0],tensor_name,indices,conjugated);
-     if(success){
-      //std::cout << " New output tensor: " << tens_operands[0] << std::endl; //debug
-      const auto & tens0 = *(op.getTensorOperand(0));
-      auto tensor_hash = tens0.getTensorHash();
-      //Pre-save the output tensor of the tensor network:
-      if(!output_tensor_done){
-       assert(!conjugated); //output tensor cannot be conjugated
-       auto res = intermediates.emplace(std::make_pair(tensor_hash,
-                   assemble_symbolic_tensor(tens0.getName(),indices,conjugated)));
-       assert(res.second);
-       //std::cout << " Saved tensor: " << res.first->second << std::endl; //debug
-       output_tensor_done = true;
-      }
-      //Retreive the intermediate (output) tensor operand in a universal form:
-      auto tens_iter = intermediates.find(tensor_hash); assert(tens_iter != intermediates.end());
-      //std::cout << " Found intermediate: " << tens_iter->second << std::endl; //debug
-      new_pattern += (tens_iter->second + "+="); //append universally indexed output tensor operand to the new index pattern
-      //Establish uncontracted index remapping:
-      index_map.clear(); tensor_name.clear(); new_indices.clear();
-      success = parse_tensor(tens_iter->second,tensor_name,new_indices,conjugated); assert(success);
-      //std::cout << " Sizes of indices: " << indices.size() << " " << new_indices.size() << std::endl; //debug
-      assert(new_indices.size() == indices.size());
-      for(auto it_old = indices.cbegin(),
-               it_new = new_indices.cbegin(); it_old != indices.cend(); ++it_old,
-                                                                        ++it_new){
-       index_map.emplace(std::make_pair(it_old->label,it_new->label));
-      }
-      //Process input tensor operands:
-      int num_contr_indices = 0;
-      for(unsigned int op_num = 1; op_num < num_operands; ++op_num){ //`Assumes a single output tensor operand (#0)
-       //std::cout << " New input tensor: " << tens_operands[op_num] << std::endl; //debug
-       tensor_name.clear(); indices.clear();
-       success = parse_tensor(tens_operands[op_num],tensor_name,indices,conjugated);
-       if(success){
-        const auto & tens = *(op.getTensorOperand(op_num));
-        tensor_hash = tens.getTensorHash();
-        //Update the numeration of contracted indices with global numbers and remap uncontracted indices:
-        num_contr_indices = 0;
-        for(auto & index: indices){
-         if(index.label[0] == 'c'){ //contracted index requires global shift
-          num_contr_indices++;
-          auto old_number = std::stoi(index.label.substr(1));
-          index.label = ("c" + std::to_string(num_internal_indices + old_number));
-         }else if(index.label[0] == 'u'){ //uncontracted indices need remapping
-          index.label = index_map[index.label];
-         }else{
-          std::cout << "#ERROR(exatn::numerics::TensorNetwork::establishUniversalIndexNumeration): "
-                    << "Invalid index label encountered: " << index.label << std::endl;
-          assert(false);
-         }
-        }
-        const auto symb_tensor = assemble_symbolic_tensor(tens.getName(),indices,conjugated);
-        if(isPureIntermediateTensorName(symb_tensor)){
-         assert(!conjugated); //intermediate tensors do not appear conjugated
-         auto res = intermediates.emplace(std::make_pair(tensor_hash,symb_tensor));
-         if(!res.second){
-          std::cout << "#ERROR(exatn::numerics::TensorNetwork::establishUniversalIndexNumeration): "
-                    << "Intermediate tensor already saved previously: " << symb_tensor << std::endl;
-          assert(false);
-         }
-         //std::cout << " Saved tensor: " << res.first->second << std::endl; //debug
-        }
-        if(op_num == 1){
-         new_pattern += symb_tensor;
-        }else if(op_num == 2){
-         new_pattern += ("*" + symb_tensor);
-        }else{
-         assert(false); //`At most three tensor operands are expected so far
-        }
-       }else{
+   IndexModeMap mode_map(op.getIndexModeMap());
+   if(mode_map.operands.size() == num_operands && mode_map.isCanonical()){
+    //Process the only output tensor operand (#0):
+    auto & output = mode_map.operands[0];
+    const auto & tens0 = *(op.getTensorOperand(0));
+    const auto tensor_hash = tens0.getTensorHash();
+    //Pre-save the output tensor of the tensor network:
+    if(!output_tensor_done){
+     assert(!(output.conjugated)); //output tensor cannot be conjugated
+     auto res = intermediates.emplace(std::make_pair(tensor_hash,output.modes));
+     assert(res.second);
+     output_tensor_done = true;
+    }
+    //Retreive the intermediate (output) tensor operand in a universal form:
+    auto tens_iter = intermediates.find(tensor_hash); assert(tens_iter != intermediates.end());
+    const auto & new_modes = tens_iter->second;
+    assert(new_modes.size() == output.modes.size());
+    //Establish uncontracted index remapping:
+    index_map.clear();
+    for(unsigned int i = 0; i < new_modes.size(); ++i) index_map.emplace(std::make_pair(output.modes[i],new_modes[i]));
+    output.name = tens0.getName();
+    output.modes = new_modes;
+    //Process input tensor operands:
+    unsigned int num_contr_indices = 0;
+    for(unsigned int op_num = 1; op_num < num_operands; ++op_num){ //`Assumes a single output tensor operand (#0)
+     auto & input = mode_map.operands[op_num];
+     const auto & tens = *(op.getTensorOperand(op_num));
+     //Update the numeration of contracted indices with global numbers and remap uncontracted indices:
+     num_contr_indices = 0;
+     for(auto & label: input.modes){
+      if(IndexModeMap::isContractedLabel(label)){ //contracted index requires global shift
+       num_contr_indices++;
+       label = IndexModeMap::canonicalLabel(num_internal_indices + IndexModeMap::getLabelNumber(label),true);
+      }else{ //uncontracted indices need remapping
+       auto mapped = index_map.find(label);
+       if(mapped == index_map.end()){
         std::cout << "#ERROR(exatn::numerics::TensorNetwork::establishUniversalIndexNumeration): "
-                  << "Unable to parse tensor operand: " << tens_operands[op_num] << std::endl;
+                  << "Invalid index label encountered: " << mode_map.getLabelName(label) << std::endl;
         assert(false);
        }
+       label = mapped->second;
+      }
+     }
+     input.name = tens.getName();
+     if(isPureIntermediateTensorName(input.name)){
+      assert(!(input.conjugated)); //intermediate tensors do not appear conjugated
+      auto res = intermediates.emplace(std::make_pair(tens.getTensorHash(),input.modes));
+      if(!res.second){
+       std::cout << "#ERROR(exatn::numerics::TensorNetwork::establishUniversalIndexNumeration): "
+                 << "Intermediate tensor already saved previously: " << input.name << std::endl;
+       assert(false);
       }
-      num_internal_indices += num_contr_indices;
-      op.setIndexPattern(new_pattern);
-      //std::cout << " New index pattern: " << new_pattern << std::endl; //debug
-     }else{
-      std::cout << "#ERROR(exatn::numerics::TensorNetwork::establishUniversalIndexNumeration): "
-                << "Unable to parse tensor operand: " << tens_operands[0] << std::endl;
-      assert(false);
      }
-    }else{
-     std::cout << "#ERROR(exatn::numerics::TensorNetwork::establishUniversalIndexNumeration): "
-               << "Invalid number of tensor operands (" << tens_operands.size() << " VS " << num_operands
-               << ") parsed from: " << old_pattern << ": ";
-     for(const auto & operand: tens_operands) std::cout << operand << " ";
-     std::cout << std::endl;
-     op.printIt();
-     assert(false);
     }
+    num_internal_indices += num_contr_indices;
+    op.setIndexPattern(std::move(mode_map));
    }else{
     std::cout << "#ERROR(exatn::numerics::TensorNetwork::establishUniversalIndexNumeration): "
-              << "Unable to parse tensor operation index pattern: " << old_pattern << std::endl;
+              << "Invalid tensor operation index pattern (" << mode_map.operands.size() << " VS " << num_operands
+              << " tensor operands, canonical index labels expected): " << assemble_index_pattern(mode_map) << std::endl;
+    op.printIt();
     assert(false);
    }
   }
@@ -1323,6 +1342,17 @@ bool TensorNetwork::deleteTensor(unsigned int tensor_id)
 
 bool TensorNetwork::mergeTensors(unsigned int left_id, unsigned int right_id, unsigned int result_id,
                                  std::string * contr_pattern)
+{
+ if(contr_pattern == nullptr) return this->mergeTensors(left_id,right_id,result_id,static_cast<IndexModeMap*>(nullptr));
+ IndexModeMap contr_modes;
+ auto merged = this->mergeTensors(left_id,right_id,result_id,&contr_modes);
+ if(merged) *contr_pattern = assemble_index_pattern(contr_modes);
+ return merged;
+}
+
+
+bool TensorNetwork::mergeTensors(unsigned int left_id, unsigned int right_id, unsigned int result_id,
+                                 IndexModeMap * contr_modes)
 {
  if(left_id == right_id || left_id == result_id || right_id == result_id){
   std::cout << "#ERROR(TensorNetwork::mergeTensors): Invalid arguments: Cannot be identical: " <<
@@ -1377,9 +1407,9 @@ bool TensorNetwork::mergeTensors(unsigned int left_id, unsigned int right_id, un
  }
  assert(res_mode == num_uncontracted);
  //Generate symbolic contraction pattern if needed:
- if(contr_pattern != nullptr){
+ if(contr_modes != nullptr){
   auto generated = generate_contraction_pattern(pattern,left_tensor_rank,right_tensor_rank,
-                                                *contr_pattern,left_tensor_conj,right_tensor_conj);
+                                                *contr_modes,left_tensor_conj,right_tensor_conj);
   assert(generated);
  }
  //Append the tensor result:
@@ -1505,7 +1535,7 @@ bool TensorNetwork::substituteTensor(const std::string & name, std::shared_ptr<T
 {
  assert(name.length() > 0);
  int tensor_id = -1;
- for(const auto & kv: tensors_){
+ for(const auto & kv: *tensors_){
   if(kv.second.getName() == name){
    tensor_id = static_cast<int>(kv.first);
    break;
@@ -1520,7 +1550,7 @@ std::vector<unsigned int> TensorNetwork::getTensorIdsInNetwork(const std::string
 {
  assert(name.length() > 0);
  std::vector<unsigned int> ids;
- for(const auto & kv: tensors_){
+ for(const auto & kv: *tensors_){
   if(kv.second.getName() == name &&
      kv.second.isComplexConjugated() == conjugated) ids.emplace_back(kv.first);
  }
@@ -1636,6 +1666,79 @@ bool TensorNetwork::collapseIsometries()
 }
 
 
+std::vector<TensorProjection> TensorNetwork::fixBasisVectorIndices(std::function<bool (const Tensor &, DimOffset *)> basis_vector)
+{
+ std::vector<TensorProjection> projections;
+ if(finalized_ == 0){
+  std::cout << "#ERROR(TensorNetwork::fixBasisVectorIndices): Invalid request: " <<
+   "Fixing indices in an unfinalized tensor network is forbidden!" << std::endl;
+  return projections;
+ }
+ //Identify basis vector tensors:
+ std::map<unsigned int, DimOffset> basis_vectors; //basis vector tensor id --> position of the unit element
+ for(auto iter = this->cbegin(); iter != this->cend(); ++iter){
+  const auto & tensor = iter->second;
+  if(iter->first != 0 && tensor.getRank() == 1){
+   DimOffset position = 0;
+   if(basis_vector(*(tensor.getTensor()),&position)){
+    if(position < tensor.getDimExtent(0)) basis_vectors.emplace(std::make_pair(iter->first,position));
+   }
+  }
+ }
+ //Determine the fixed dimensions of the connected tensors:
+ std::map<unsigned int, std::vector<std::pair<unsigned int, DimOffset>>> fixed_dims; //connected tensor id --> fixed dimensions
+ std::vector<unsigned int> removed; //ids of the removed basis vector tensors
+ for(const auto & basis: basis_vectors){
+  const auto & leg = this->getTensorConn(basis.first)->getTensorLeg(0);
+  const auto other_id = leg.getTensorId();
+  if(other_id != 0 && basis_vectors.find(other_id) == basis_vectors.end()){ //connected to a regular input tensor
+   const auto * other_tensor = this->getTensorConn(other_id);
+   assert(other_tensor != nullptr);
+   if(other_tensor->getDimSpaceAttr(leg.getDimensionId()).first == SOME_SPACE){ //anonymous vector space
+    fixed_dims[other_id].emplace_back(std::make_pair(leg.getDimensionId(),basis.second));
+    removed.emplace_back(basis.first);
+   }
+  }
+ }
+ //Replace the connected tensors by their projections:
+ for(auto & fixed: fixed_dims){
+  std::sort(fixed.second.begin(),fixed.second.end());
+  auto * tensor = this->getTensorConn(fixed.first);
+  TensorProjection projection;
+  projection.original = tensor->getTensor();
+  projection.fixed_dims = fixed.second;
+  //Create the projected tensor (without isometries):
+  std::vector<DimExtent> extents;
+  std::vector<std::pair<SpaceId,SubspaceId>> subspaces;
+  for(unsigned int i = 0, j = 0; i < tensor->getRank(); ++i){
+   if(j < fixed.second.size() && fixed.second[j].first == i){
+    ++j;
+   }else{
+    extents.emplace_back(tensor->getDimExtent(i));
+    subspaces.emplace_back(tensor->getDimSpaceAttr(i));
+   }
+  }
+  projection.projected = std::make_shared<Tensor>("_p",extents,subspaces);
+  projection.projected->setElementType(projection.original->getElementType());
+  projection.projected->rename(tensor_hex_name("p",projection.projected->getTensorHash()));
+  //Delete the fixed legs and replace the stored tensor:
+  tensor->replaceStoredTensor(); //new tensor (the original one is not affected)
+  std::vector<unsigned int> deleted_legs;
+  for(const auto & dim: fixed.second) deleted_legs.emplace_back(dim.first);
+  tensor->deleteLegs(deleted_legs);
+  tensor->replaceStoredTensor(projection.projected);
+  this->updateConnections(fixed.first);
+  projections.emplace_back(projection);
+ }
+ //Remove the basis vector tensors:
+ for(const auto & tensor_id: removed){
+  auto erased = eraseTensorConn(tensor_id); assert(erased);
+ }
+ if(!removed.empty()) invalidateContractionSequence(); //invalidate previously cached tensor contraction sequence
+ return projections;
+}
+
+
 bool TensorNetwork::decomposeTensors()
 {
  if(finalized_ == 0){
@@ -1677,6 +1780,54 @@ bool TensorNetwork::decomposeTensors()
 }
 
 
+unsigned int TensorNetwork::simplify(std::list<ContrTriple> & merges, double * fma_flops)
+{
+ assert(finalized_ != 0); //tensor network must be in finalized state
+ unsigned int num_removed = 0;
+ double flops = 0.0;
+ bool merged = true;
+ while(merged && this->getNumTensors() > 2){
+  merged = false;
+  //Find the cheapest pair of connected input tensors whose merge does not increase the volume:
+  const auto & tensors = mutableTensorConns(); //the tensor network is about to be modified
+  double best_flops = -1.0;
+  unsigned int best_left = 0, best_right = 0;
+  for(auto iter = tensors.cbegin(); iter != tensors.cend(); ++iter){
+   const auto left_id = iter->first;
+   if(left_id == 0) continue; //output tensor
+   const double left_vol = static_cast<double>(iter->second.getTensor()->getVolume());
+   for(const auto & leg: iter->second.getTensorLegs()){
+    const auto right_id = leg.getTensorId();
+    if(right_id > left_id){ //each pair of connected input tensors is inspected once (parallel edges revisit it)
+     const auto * right_tensor = this->getTensorConn(right_id);
+     assert(right_tensor != nullptr);
+     const double right_vol = static_cast<double>(right_tensor->getTensor()->getVolume());
+     double diff_vol = 0.0;
+     const double contr_flops = getTensorContractionCost(iter->second,*right_tensor,&diff_vol);
+     if(diff_vol + left_vol + right_vol <= std::max(left_vol,right_vol)){
+      if(best_flops < 0.0 || contr_flops < best_flops ||
+         (contr_flops == best_flops && std::make_pair(left_id,right_id) < std::make_pair(best_left,best_right))){
+       best_flops = contr_flops; best_left = left_id; best_right = right_id;
+      }
+     }
+    }
+   }
+  }
+  //Merge the found pair of tensors:
+  if(best_flops >= 0.0){
+   const auto result_id = this->getMaxTensorId() + 1;
+   merged = mergeTensors(best_left,best_right,result_id);
+   assert(merged);
+   merges.emplace_back(ContrTriple{result_id,best_left,best_right});
+   flops += best_flops;
+   ++num_removed;
+  }
+ }
+ if(fma_flops != nullptr) *fma_flops = flops;
+ return num_removed;
+}
+
+
 bool TensorNetwork::partition(std::size_t num_parts,  //in: desired number of parts
                               double imbalance,       //in: tolerated partition weight imbalance
                               std::vector<std::pair<std::size_t,std::vector<std::size_t>>> & parts, //out: partitions
@@ -1738,15 +1889,36 @@ double getTensorContractionCost(const TensorConn & left_tensor, const TensorConn
  flops = left_vol * right_vol / contr_vol; //FMA flops (no FMA prefactor)
  if(diff_volume != nullptr) *diff_volume = flops / contr_vol - (left_vol + right_vol);
  if(arithm_intensity != nullptr) *arithm_intensity = flops / (left_vol + right_vol);
- if(adjust_cost){ //increase the "effective" flop count if arithmetic intensity is low
-  //`Finish: flops *= f(arithm_intensity): [max --> 1]
+ if(adjust_cost){ //replace the flop count by the predicted execution time (in effective flops) if the calibrated cost model is active
+  const auto * cost_model = ContractionCostModel::getActive();
+  if(cost_model != nullptr){
+   //A tensor operand needs a permutation unless its contracted dimensions form a contiguous leading or trailing block:
+   auto needs_permutation = [](const std::vector<TensorLeg> & legs, unsigned int other_id){
+    int first = -1, last = -1, num_contracted = 0;
+    for(int i = 0; i < static_cast<int>(legs.size()); ++i){
+     if(legs[i].getTensorId() == other_id){
+      if(first < 0) first = i;
+      last = i; ++num_contracted;
+     }
+    }
+    if(num_contracted == 0 || num_contracted == static_cast<int>(legs.size())) return false;
+    if(last - first + 1 != num_contracted) return true;
+    return !(first == 0 || last == static_cast<int>(legs.size()) - 1);
+   };
+   const unsigned int num_contracted = std::count_if(right_legs.cbegin(),right_legs.cend(),
+                                        [left_id](const TensorLeg & leg){return leg.getTensorId() == left_id;});
+   flops = cost_model->predictEffectiveFlops(left_vol / contr_vol,right_vol / contr_vol,contr_vol,
+                                             left_rank,right_rank,left_rank + right_rank - num_contracted * 2,
+                                             needs_permutation(left_tensor.getTensorLegs(),right_id),
+                                             needs_permutation(right_legs,left_id));
+  }
  }
  return flops;
 }
 
 
 double TensorNetwork::getContractionCost(unsigned int left_id, unsigned int right_id,
-                                         double * diff_volume, double * arithm_intensity, bool adjust_cost)
+                                         double * diff_volume, double * arithm_intensity, bool adjust_cost) const
 {
  double flops = -1.0; //error
  if(left_id != 0 && right_id != 0){
@@ -1782,7 +1954,7 @@ std::list<std::shared_ptr<TensorOperation>> & TensorNetwork::getOperationList(co
   auto & tensor_op_factory = *(TensorOpFactory::get());
   if(this->getNumTensors() > 1){ //two or more input tensors: One or more contractions
    TensorNetwork net(*this);
-   std::list<unsigned int> intermediates;
+   std::unordered_set<unsigned int> intermediates;
    unsigned int num_contractions = contraction_seq_.size();
    for(auto contr = contraction_seq_.cbegin(); contr != contraction_seq_.cend(); ++contr){
     //std::cout << "#DEBUG(TensorNetwork::getOperationList): Contracting " << contr->left_id << " * " << contr->right_id
@@ -1790,7 +1962,7 @@ std::list<std::shared_ptr<TensorOperation>> & TensorNetwork::getOperationList(co
     bool conj1, conj2;
     auto tensor1 = net.getTensor(contr->left_id,&conj1);
     auto tensor2 = net.getTensor(contr->right_id,&conj2);
-    std::string contr_pattern;
+    IndexModeMap contr_pattern;
     if(num_contractions > 1){ //intermediate contraction
      auto merged = net.mergeTensors(contr->left_id,contr->right_id,contr->result_id,&contr_pattern); //append intermediate _xHASH
      assert(merged);
@@ -1817,7 +1989,7 @@ std::list<std::shared_ptr<TensorOperation>> & TensorNetwork::getOperationList(co
      if(tensor0->getElementType() != TensorElementType::VOID)
       std::dynamic_pointer_cast<TensorOpCreate>(op_create)->resetTensorElementType(tensor0->getElementType());
      operations_.emplace_back(op_create);
-     intermediates.emplace_back(contr->result_id);
+     intermediates.emplace(contr->result_id);
      std::shared_ptr<TensorOperation> op_init(std::move(tensor_op_factory.createTensorOp(TensorOpCode::TRANSFORM))); //init intermediate to zero
      op_init->setTensorOperand(tensor0);
      std::dynamic_pointer_cast<TensorOpTransform>(op_init)->
@@ -1830,10 +2002,10 @@ std::list<std::shared_ptr<TensorOperation>> & TensorNetwork::getOperationList(co
     op->setTensorOperand(tensor0);
     op->setTensorOperand(tensor1,conj1);
     op->setTensorOperand(tensor2,conj2);
-    op->setIndexPattern(contr_pattern);
+    op->setIndexPattern(std::move(contr_pattern));
     assert(op->isSet());
     operations_.emplace_back(std::shared_ptr<TensorOperation>(std::move(op)));
-    auto left_intermediate = std::find(intermediates.begin(),intermediates.end(),contr->left_id);
+    auto left_intermediate = intermediates.find(contr->left_id);
     if(left_intermediate != intermediates.end()){
      intermediates_vol -= tensor1->getVolume();
      auto op_destroy = tensor_op_factory.createTensorOp(TensorOpCode::DESTROY); //destroy intermediate
@@ -1841,7 +2013,7 @@ std::list<std::shared_ptr<TensorOperation>> & TensorNetwork::getOperationList(co
      operations_.emplace_back(std::shared_ptr<TensorOperation>(std::move(op_destroy)));
      intermediates.erase(left_intermediate);
     }
-    auto right_intermediate = std::find(intermediates.begin(),intermediates.end(),contr->right_id);
+    auto right_intermediate = intermediates.find(contr->right_id);
     if(right_intermediate != intermediates.end()){
      intermediates_vol -= tensor2->getVolume();
      auto op_destroy = tensor_op_factory.createTensorOp(TensorOpCode::DESTROY); //destroy intermediate
@@ -1872,10 +2044,10 @@ std::list<std::shared_ptr<TensorOperation>> & TensorNetwork::getOperationList(co
    op->setTensorOperand(tensor1,conj1);
    const auto * tensor1_legs = this->getTensorConnections(left_tensor_id);
    assert(tensor1_legs != nullptr);
-   std::string contr_pattern;
+   IndexModeMap contr_pattern;
    auto generated = generate_addition_pattern(*tensor1_legs,contr_pattern,conj1);
    assert(generated);
-   op->setIndexPattern(contr_pattern);
+   op->setIndexPattern(std::move(contr_pattern));
    assert(op->isSet());
    operations_.emplace_back(std::shared_ptr<TensorOperation>(std::move(op)));
   }
@@ -1893,11 +2065,15 @@ void TensorNetwork::splitIndices(std::size_t max_intermediate_volume)
 {
  assert(!operations_.empty());
 
- std::unordered_map<std::string,   //index name
+ std::unordered_map<unsigned int,  //index label
                     double         //cumulative volume of all intermediates carrying this index
-                   > index_volume; //index name --> cumulative index volume
+                   > index_volume; //index label --> cumulative index volume
+
+ std::unordered_map<unsigned int,  //index label
+                    double         //cumulative predicted execution time of all tensor operations carrying this index
+                   > index_time;   //index label --> cumulative index time (only with the calibrated cost model)
 
- std::unordered_map<std::string,            //index label
+ std::unordered_map<unsigned int,           //index label
                     std::pair<unsigned int, //global index id
                               IndexSplit>   //splitting info (segment composition)
                    > splitted; //info on splitted indices
@@ -1906,56 +2082,54 @@ void TensorNetwork::splitIndices(std::size_t max_intermediate_volume)
                        std::size_t>  //number of segments to split into
             > dims; //for each tensor dimension
 
- std::vector<std::pair<unsigned int, //global id of the split index
-                       unsigned int> //dimension position in the tensor
-            > split_dims; //for each tensor dimension split
-
- std::vector<std::string> tens_operands; //extracted tensor operands
- std::vector<IndexLabel> indices; //indices extracted from a tensor
- std::string tens_name; //extracted tensor name
- bool conjugated = false;
+ const auto * cost_model = ContractionCostModel::getActive(); //calibrated cost model (optional)
 
  //Establish universal index numeration:
  split_tensors_.clear();
  split_indices_.clear();
  establishUniversalIndexNumeration();
 
- //Compute cumulative index volumes over all tensor operations:
+ //Compute cumulative index volumes (and predicted times) over all tensor operations:
  for(auto op_iter = operations_.cbegin(); op_iter != operations_.cend(); ++op_iter){
   const auto & op = *(*op_iter); //tensor operation
   const auto num_operands = op.getNumOperands();
-  const auto & pattern = op.getIndexPattern();
-  if(!pattern.empty()){ //tensor operation with two or more tensor operands (has a symbolic index pattern)
-   //Extract symbolic tensor operands from the current tensor operation:
-   tens_operands.clear();
-   bool success = parse_tensor_network(pattern,tens_operands);
-   if(success){
-    assert(tens_operands.size() == num_operands);
-    tens_name.clear(); indices.clear();
-    success = parse_tensor(tens_operands[0],tens_name,indices,conjugated); //`Assumes a single output tensor operand (#0)
-    if(success){
-     assert(!conjugated); //output tensor operands never appear conjugated
-     const auto & intermediate = *(op.getTensorOperand(0));
-     const auto & intermediate_name = intermediate.getName();
-     assert(intermediate_name == tens_name); //tensor must enter the symbolic index pattern under the same name
-     assert(indices.size() == intermediate.getRank());
-     double intermediate_volume = 1.0;
-     for(unsigned int i = 0; i < indices.size(); ++i){
-      intermediate_volume *= static_cast<double>(intermediate.getDimExtent(i)); //full dimension extent
-     }
-     for(unsigned int i = 0; i < indices.size(); ++i){
-      auto res = index_volume.emplace(std::make_pair(indices[i].label,intermediate_volume));
-      if(!(res.second)) res.first->second += intermediate_volume;
+  if(op.hasIndexPattern()){ //tensor operation with two or more tensor operands (has a symbolic index pattern)
+   const auto & mode_map = op.getIndexModeMap();
+   assert(mode_map.operands.size() == num_operands);
+   const auto & indices = mode_map.operands[0].modes; //`Assumes a single output tensor operand (#0)
+   assert(!(mode_map.operands[0].conjugated)); //output tensor operands never appear conjugated
+   const auto & intermediate = *(op.getTensorOperand(0));
+   assert(indices.size() == intermediate.getRank());
+   double intermediate_volume = 1.0;
+   for(unsigned int i = 0; i < indices.size(); ++i){
+    intermediate_volume *= static_cast<double>(intermediate.getDimExtent(i)); //full dimension extent
+   }
+   for(const auto & index: indices){
+    auto res = index_volume.emplace(std::make_pair(index,intermediate_volume));
+    if(!(res.second)) res.first->second += intermediate_volume;
+   }
+   //Predicted execution time of the tensor contraction (calibrated cost model):
+   if(cost_model != nullptr && num_operands == 3){
+    const auto & left_indices = mode_map.operands[1].modes;
+    const auto & right_indices = mode_map.operands[2].modes;
+    const auto & left_tensor = *(op.getTensorOperand(1));
+    const auto & right_tensor = *(op.getTensorOperand(2));
+    double left_volume = 1.0, right_volume = 1.0, contr_volume = 1.0;
+    for(unsigned int i = 0; i < left_indices.size(); ++i){
+     const double extent = static_cast<double>(left_tensor.getDimExtent(i));
+     left_volume *= extent;
+     auto contracted = std::find(right_indices.cbegin(),right_indices.cend(),left_indices[i]);
+     if(contracted != right_indices.cend()) contr_volume *= extent;
+    }
+    for(unsigned int i = 0; i < right_indices.size(); ++i) right_volume *= static_cast<double>(right_tensor.getDimExtent(i));
+    const double op_time = cost_model->predictContractionTime(left_volume / contr_volume,right_volume / contr_volume,contr_volume,
+                                                              left_indices.size(),right_indices.size(),indices.size());
+    for(const auto & operand: mode_map.operands){
+     for(const auto & index: operand.modes){
+      auto res = index_time.emplace(std::make_pair(index,op_time));
+      if(!(res.second)) res.first->second += op_time;
      }
-    }else{
-     std::cout << "#ERROR(exatn::numerics::TensorNetwork::splitIndices): "
-               << "Unable to parse the output tensor operand: " << tens_operands[0] << std::endl;
-     assert(false);
     }
-   }else{
-    std::cout << "#ERROR(exatn::numerics::TensorNetwork::splitIndices): "
-              << "Unable to parse the tensor operation index pattern: " << pattern << std::endl;
-    assert(false);
    }
   }
  }
@@ -1964,149 +2138,290 @@ void TensorNetwork::splitIndices(std::size_t max_intermediate_volume)
  unsigned int num_split_indices = 0; //total number of indices split
  for(auto op_iter = operations_.rbegin(); op_iter != operations_.rend(); ++op_iter){
   const auto & op = *(*op_iter); //tensor operation
-  const auto op_hash = op.getTensorOpHash();
   const auto num_operands = op.getNumOperands();
   const auto num_operands_out = op.getNumOperandsOut();
-  const auto & pattern = op.getIndexPattern();
   //Analyze the tensor operation with a symbolic index pattern:
-  if(!pattern.empty()){ //tensor operation with two or more tensor operands (has a symbolic index pattern)
+  if(op.hasIndexPattern()){ //tensor operation with two or more tensor operands (has a symbolic index pattern)
    assert(num_operands > 1 && num_operands_out == 1); //`Expecting only a single output tensor operand here (no SVDs, etc)
-   //Extract symbolic tensor operands from the current tensor operation:
-   tens_operands.clear();
-   bool success = parse_tensor_network(pattern,tens_operands);
-   if(success){
-    assert(tens_operands.size() == num_operands);
-    //Inspect the output tensor operand (intermediate tensor) and split its dimensions if needed:
-    tens_name.clear(); indices.clear();
-    success = parse_tensor(tens_operands[0],tens_name,indices,conjugated); //`Assumes a single output tensor operand (#0)
-    if(success){
-     assert(!conjugated); //output tensor operands never appear conjugated
-     const auto & intermediate = *(op.getTensorOperand(0));
-     const auto & intermediate_name = intermediate.getName();
-     assert(intermediate_name == tens_name); //tensor must enter the symbolic index pattern under the same name
-     assert(indices.size() == intermediate.getRank());
-     /*if(!isIntermediateTensorName(tens_name)){ //output tensor operands must be intermediate tensors
-      std::cout << "#ERROR(exatn::numerics::TensorNetwork::splitIndices): "
-                << "The output tensor operand name does not name an intermediate tensor: " << tens_name << std::endl;
-      assert(false);
-     }*/
-     //Compute the volume of the intermediate tensor and find its full dimensions:
-     dims.clear();
-     std::size_t intermediate_volume = 1;
-     for(unsigned int i = 0; i < indices.size(); ++i){
-      auto index_iter = splitted.find(indices[i].label);
-      if(index_iter != splitted.end()){
-       intermediate_volume *= index_iter->second.second[0].second; //segment extent (already split index)
-      }else{
-       intermediate_volume *= intermediate.getDimExtent(i); //full dimension extent
-       dims.emplace_back(std::pair<unsigned int,std::size_t>{i,1});
-      }
+   const auto & mode_map = op.getIndexModeMap();
+   assert(mode_map.operands.size() == num_operands);
+   //Inspect the output tensor operand (intermediate tensor) and split its dimensions if needed:
+   const auto & indices = mode_map.operands[0].modes; //`Assumes a single output tensor operand (#0)
+   assert(!(mode_map.operands[0].conjugated)); //output tensor operands never appear conjugated
+   const auto & intermediate = *(op.getTensorOperand(0));
+   assert(indices.size() == intermediate.getRank());
+   //Compute the volume of the intermediate tensor and find its full dimensions:
+   dims.clear();
+   std::size_t intermediate_volume = 1;
+   for(unsigned int i = 0; i < indices.size(); ++i){
+    auto index_iter = splitted.find(indices[i]);
+    if(index_iter != splitted.end()){
+     intermediate_volume *= index_iter->second.second[0].second; //segment extent (already split index)
+    }else{
+     intermediate_volume *= intermediate.getDimExtent(i); //full dimension extent
+     dims.emplace_back(std::pair<unsigned int,std::size_t>{i,1});
+    }
+   }
+   //Split the found full dimensions of the intermediate tensor:
+   if(max_intermediate_volume > 0 && intermediate_volume > max_intermediate_volume){
+    assert(dims.size() > 0); //at least one full dimension is expected
+    //Prioritize full indices by their cumulative volume (or cumulative predicted time with the calibrated cost model):
+    if(cost_model != nullptr){ //splitting indices carried by the most time consuming tensor operations minimizes redundant work
+     std::stable_sort(dims.begin(),dims.end(),[&index_time,&indices](const auto & d1, const auto & d2){
+                                               return index_time[indices[d1.first]]
+                                                    < index_time[indices[d2.first]];
+                                              });
+    }else{
+     std::stable_sort(dims.begin(),dims.end(),[&index_volume,&indices](const auto & d1, const auto & d2){
+                                               return index_volume[indices[d1.first]]
+                                                    < index_volume[indices[d2.first]];
+                                              });
+    }
+    //Reduce the volume of the intermediate tensor by increasing the number of segments per tensor dimensions:
+    int i = dims.size() - 1; //split dimensions from the right (because of column-wise tensor storage)
+    while(intermediate_volume > max_intermediate_volume){
+     if((dims[i].second)*2 <= intermediate.getDimExtent(dims[i].first)){
+      dims[i].second <<= 1; intermediate_volume >>= 1; //split tensor dimension in half
      }
-     //Split the found full dimensions of the intermediate tensor:
-     if(max_intermediate_volume > 0 && intermediate_volume > max_intermediate_volume){
-      assert(dims.size() > 0); //at least one full dimension is expected
-      //Prioritize full indices by their cumulative volume:
-      std::stable_sort(dims.begin(),dims.end(),[&index_volume,&indices](const auto & d1, const auto & d2){
-                                                return index_volume[indices[d1.first].label]
-                                                     < index_volume[indices[d2.first].label];
-                                               });
-      //Reduce the volume of the intermediate tensor by increasing the number of segments per tensor dimensions:
-      int i = dims.size() - 1; //split dimensions from the right (because of column-wise tensor storage)
-      while(intermediate_volume > max_intermediate_volume){
-       if((dims[i].second)*2 <= intermediate.getDimExtent(dims[i].first)){
-        dims[i].second <<= 1; intermediate_volume >>= 1; //split tensor dimension in half
-       }
-       if(--i < 0) i = dims.size() - 1;
-      }
-      //Split full tensor dimensions into segments:
-      for(const auto & dim: dims){
-       const auto & num_dim_segs = dim.second;
-       if(num_dim_segs > 1){ //number of segments
-        const auto & dim_pos = dim.first;
-        IndexSplit split_info = splitDimension(intermediate.getDimSpaceAttr(dim_pos),
-                                               intermediate.getDimExtent(dim_pos),
-                                               num_dim_segs);
-        auto saved = splitted.emplace(std::make_pair(indices[dim_pos].label,
-                                                     std::make_pair(num_split_indices,split_info)));
-        assert(saved.second);
-        split_indices_.emplace_back(std::make_pair(indices[dim_pos].label,split_info));
-        num_split_indices++;
+     if(--i < 0) i = dims.size() - 1;
+    }
+    //Split full tensor dimensions into segments:
+    for(const auto & dim: dims){
+     const auto & num_dim_segs = dim.second;
+     if(num_dim_segs > 1){ //number of segments
+      const auto & dim_pos = dim.first;
+      IndexSplit split_info = splitDimension(intermediate.getDimSpaceAttr(dim_pos),
+                                             intermediate.getDimExtent(dim_pos),
+                                             num_dim_segs);
+      auto saved = splitted.emplace(std::make_pair(indices[dim_pos],
+                                                   std::make_pair(num_split_indices,split_info)));
+      assert(saved.second);
+      split_indices_.emplace_back(std::make_pair(mode_map.getLabelName(indices[dim_pos]),split_info));
+      num_split_indices++;
+     }
+    }
+   }
+  }
+ }
+ assert(split_indices_.size() == num_split_indices);
+
+ //Mark index splitting in each affected tensor:
+ markSplitTensors();
+ return;
+}
+
+
+bool TensorNetwork::splitIndices(const std::vector<std::pair<std::string,std::size_t>> & split_plan)
+{
+ assert(!operations_.empty());
+
+ //Establish universal index numeration:
+ split_tensors_.clear();
+ split_indices_.clear();
+ establishUniversalIndexNumeration();
+
+ //Locate each index from the splitting plan in the tensor operation list and split it:
+ for(const auto & split_index: split_plan){
+  const auto & label_name = split_index.first;
+  const auto num_segments = split_index.second;
+  unsigned int label;
+  bool found = false;
+  if(IndexModeMap::parseCanonicalLabel(label_name,&label)){ //universal index labels are canonical
+   for(auto op_iter = operations_.cbegin(); op_iter != operations_.cend() && !found; ++op_iter){
+    const auto & op = *(*op_iter); //tensor operation
+    if(op.hasIndexPattern()){
+     const auto & mode_map = op.getIndexModeMap();
+     for(unsigned int op_num = 0; op_num < mode_map.operands.size() && !found; ++op_num){
+      const auto & indices = mode_map.operands[op_num].modes;
+      for(unsigned int i = 0; i < indices.size(); ++i){
+       if(indices[i] == label){
+        const auto & tensor = *(op.getTensorOperand(op_num));
+        if(num_segments < 2 || num_segments > tensor.getDimExtent(i)){
+         split_indices_.clear();
+         markSplitTensors();
+         return false;
+        }
+        split_indices_.emplace_back(std::make_pair(label_name,splitDimension(tensor.getDimSpaceAttr(i),
+                                                                             tensor.getDimExtent(i),
+                                                                             num_segments)));
+        found = true;
+        break;
        }
       }
      }
-    }else{
-     std::cout << "#ERROR(exatn::numerics::TensorNetwork::splitIndices): "
-               << "Unable to parse the output tensor operand: " << tens_operands[0] << std::endl;
-     assert(false);
     }
-   }else{
-    std::cout << "#ERROR(exatn::numerics::TensorNetwork::splitIndices): "
-              << "Unable to parse the tensor operation index pattern: " << pattern << std::endl;
-    assert(false);
    }
   }
+  if(!found){ //splitting plan does not match the tensor operation list
+   split_indices_.clear();
+   markSplitTensors();
+   return false;
+  }
  }
- assert(split_indices_.size() == num_split_indices);
+ //Mark index splitting in each affected tensor:
+ markSplitTensors();
+ return true;
+}
+
+
+void TensorNetwork::markSplitTensors()
+{
+ std::unordered_map<unsigned int, //index label
+                    unsigned int> //global index id
+                   split_ids; //split index label --> global split index id
+ for(unsigned int i = 0; i < split_indices_.size(); ++i){
+  unsigned int label;
+  auto parsed = IndexModeMap::parseCanonicalLabel(split_indices_[i].first,&label); assert(parsed);
+  auto res = split_ids.emplace(std::make_pair(label,i)); assert(res.second);
+ }
+
+ std::vector<std::pair<unsigned int, //global id of the split index
+                       unsigned int> //dimension position in the tensor
+            > split_dims; //for each tensor dimension split
+
+ split_tensors_.clear();
 
  //Traverse tensor operations in reverse order and mark index splitting in each affected tensor:
  for(auto op_iter = operations_.rbegin(); op_iter != operations_.rend(); ++op_iter){
   const auto & op = *(*op_iter); //tensor operation
   const auto op_hash = op.getTensorOpHash();
   const auto num_operands = op.getNumOperands();
-  const auto num_operands_out = op.getNumOperandsOut();
-  const auto & pattern = op.getIndexPattern();
   //Analyze the tensor operation with a symbolic index pattern:
-  if(!pattern.empty()){
-   //Extract symbolic tensor operands from the current tensor operation:
-   tens_operands.clear();
-   bool success = parse_tensor_network(pattern,tens_operands);
-   if(success){
-    assert(tens_operands.size() == num_operands);
-    //Inspect all tensor operands and mark their splitted dimensions:
+  if(op.hasIndexPattern()){
+   const auto & mode_map = op.getIndexModeMap();
+   assert(mode_map.operands.size() == num_operands);
+   //Inspect all tensor operands and mark their splitted dimensions:
+   for(unsigned int op_num = 0; op_num < num_operands; ++op_num){
+    const auto & tensor = *(op.getTensorOperand(op_num));
+    const auto tensor_hash = tensor.getTensorHash();
+    const auto & tensor_name = tensor.getName();
+    assert(mode_map.operands[op_num].name == tensor_name); //tensor must enter the symbolic index pattern under the same name
+    //Inspect indices of the tensor operand for having split dimensions:
+    const auto & indices = mode_map.operands[op_num].modes;
+    split_dims.clear();
+    for(unsigned int i = 0; i < indices.size(); ++i){
+     auto index_iter = split_ids.find(indices[i]);
+     if(index_iter != split_ids.end()){
+      split_dims.emplace_back(std::make_pair(index_iter->second,i));
+     }
+    }
+    //Save the inferred dimension splitting info for the tensor operand:
+    if(split_dims.size() > 0){
+     if(op_num == 0){ //output tensor operand: pure intermediate or output tensor `Assumes a single output tensor operand (#0)
+      //Intermediate tensors (including the tensor network output) are identified by the tensor hash:
+      const auto key = std::make_pair(static_cast<TensorHashType>(0),tensor_hash);
+      auto saved = split_tensors_.emplace(std::make_pair(key,split_dims));
+      assert(saved.second);
+     }else{
+      if(!isIntermediateTensorName(tensor_name)){ // input tensor operand
+       //Input tensors are identified by the tensor operation hash and their position in it:
+       const auto key = std::make_pair(op_hash,static_cast<TensorHashType>(op_num));
+       auto saved = split_tensors_.emplace(std::make_pair(key,split_dims));
+       assert(saved.second);
+      }
+     }
+    }
+   }
+  }
+ }
+
+ //Classify tensor operations by their slice dependence:
+ slice_dependence_.clear();
+ slice_invariant_flops_ = 0.0;
+ slice_invariant_volume_ = 0.0;
+ max_sliced_presence_volume_ = 0.0;
+ max_hoisted_presence_volume_ = 0.0;
+ if(split_indices_.size() > 0){
+  std::unordered_map<TensorHashType,double> dependent; //slice-dependent intermediates: tensor hash --> sliced volume
+  std::unordered_map<TensorHashType,double> retained;  //slice-invariant intermediates consumed by slice-dependent operations: tensor hash --> volume
+  //A tensor operation is slice-dependent if it has split tensor operands or slice-dependent intermediate operands:
+  for(auto op_iter = operations_.cbegin(); op_iter != operations_.cend(); ++op_iter){
+   const auto & op = *(*op_iter); //tensor operation
+   if(op.hasIndexPattern()){
+    const auto op_hash = op.getTensorOpHash();
+    const auto num_operands = op.getNumOperands();
+    bool slice_dependent = false;
     for(unsigned int op_num = 0; op_num < num_operands; ++op_num){
      const auto & tensor = *(op.getTensorOperand(op_num));
      const auto tensor_hash = tensor.getTensorHash();
-     const auto & tensor_name = tensor.getName();
-     //Inspect indices of the tensor operand for having split dimensions:
-     tens_name.clear(); indices.clear();
-     success = parse_tensor(tens_operands[op_num],tens_name,indices,conjugated);
-     if(success){
-      assert(tens_name == tensor_name); //tensor must enter the symbolic index pattern under the same name
-      split_dims.clear();
-      for(unsigned int i = 0; i < indices.size(); ++i){
-       auto index_iter = splitted.find(indices[i].label);
-       if(index_iter != splitted.end()){
-        split_dims.emplace_back(std::make_pair(index_iter->second.first,i));
-       }
+     if(op_num > 0 && dependent.find(tensor_hash) != dependent.end()){
+      slice_dependent = true;
+      break;
+     }
+     auto key = std::make_pair(op_hash,static_cast<TensorHashType>(op_num)); //input tensor
+     if(op_num == 0 || isIntermediateTensorName(tensor.getName())) //intermediate tensor (including output tensor)
+      key = std::make_pair(static_cast<TensorHashType>(0),tensor_hash);
+     if(split_tensors_.find(key) != split_tensors_.end()){
+      slice_dependent = true;
+      break;
+     }
+    }
+    if(slice_dependent){
+     //Mark the output tensor operand as slice-dependent and compute the volume of its largest slice:
+     const auto & tensor = *(op.getTensorOperand(0));
+     const auto tensor_hash = tensor.getTensorHash();
+     double volume = static_cast<double>(tensor.getVolume());
+     auto split_iter = split_tensors_.find(std::make_pair(static_cast<TensorHashType>(0),tensor_hash));
+     if(split_iter != split_tensors_.end()){
+      for(const auto & split_dim: split_iter->second){
+       DimExtent max_extent = 0;
+       for(const auto & segment: split_indices_[split_dim.first].second) max_extent = std::max(max_extent,segment.second);
+       volume *= (static_cast<double>(max_extent) / static_cast<double>(tensor.getDimExtent(split_dim.second)));
       }
-      //Save the inferred dimension splitting info for the tensor operand:
-      if(split_dims.size() > 0){
-       //std::cout << "#DEBUG(exatn::numerics::TensorNetwork::splitIndices): Splitting tensor " << tens_operands[op_num] << " @ "; //debug
-       //for(const auto & ind: split_dims) std::cout << " " << ind.second; std::cout << std::endl; //debug
-       if(op_num == 0){ //output tensor operand: pure intermediate or output tensor `Assumes a single output tensor operand (#0)
-        //Intermediate tensors (including the tensor network output) are identified by the tensor hash:
-        const auto key = std::make_pair(static_cast<TensorHashType>(0),tensor_hash);
-        auto saved = split_tensors_.emplace(std::make_pair(key,split_dims));
-        assert(saved.second);
-       }else{
-        if(!isIntermediateTensorName(tensor_name)){ // input tensor operand
-         //Input tensors are identified by the tensor operation hash and their position in it:
-         const auto key = std::make_pair(op_hash,static_cast<TensorHashType>(op_num));
-         auto saved = split_tensors_.emplace(std::make_pair(key,split_dims));
-         assert(saved.second);
-        }
-       }
+     }
+     dependent.emplace(std::make_pair(tensor_hash,volume));
+     //Slice-invariant intermediates consumed by a slice-dependent tensor operation need to be retained:
+     for(unsigned int op_num = 1; op_num < num_operands; ++op_num){
+      const auto & operand = *(op.getTensorOperand(op_num));
+      const auto operand_hash = operand.getTensorHash();
+      if(isPureIntermediateTensorName(operand.getName()) && dependent.find(operand_hash) == dependent.end())
+       retained.emplace(std::make_pair(operand_hash,static_cast<double>(operand.getVolume())));
+     }
+    }else{
+     slice_dependence_.emplace(std::make_pair(op_hash,SliceDependence::INVARIANT));
+     slice_invariant_flops_ += op.getFlopEstimate();
+    }
+   }
+  }
+  for(const auto & intermediate: retained) slice_invariant_volume_ += intermediate.second;
+  //Creation, initialization and destruction of intermediates inherit their slice dependence:
+  double sliced_volume = 0.0;   //present volume of intermediates when all tensor operations are executed per slice
+  double prologue_volume = 0.0; //present volume of slice-invariant intermediates when executed in advance
+  double hoisted_volume = 0.0;  //present volume of slice-dependent intermediates when executed per slice
+  for(auto op_iter = operations_.cbegin(); op_iter != operations_.cend(); ++op_iter){
+   const auto & op = *(*op_iter); //tensor operation
+   if(!(op.hasIndexPattern())){
+    const auto opcode = op.getOpcode();
+    const auto & tensor = *(op.getTensorOperand(0));
+    const auto tensor_hash = tensor.getTensorHash();
+    auto dep_iter = dependent.find(tensor_hash);
+    if(dep_iter != dependent.end()){ //slice-dependent intermediate
+     if(opcode == TensorOpCode::CREATE){
+      sliced_volume += dep_iter->second;
+      hoisted_volume += dep_iter->second;
+     }else if(opcode == TensorOpCode::DESTROY){
+      sliced_volume -= dep_iter->second;
+      hoisted_volume -= dep_iter->second;
+     }
+    }else{ //slice-invariant intermediate
+     const double volume = static_cast<double>(tensor.getVolume());
+     auto dependence = SliceDependence::INVARIANT;
+     if(opcode == TensorOpCode::CREATE){
+      sliced_volume += volume;
+      prologue_volume += volume;
+     }else if(opcode == TensorOpCode::DESTROY){
+      sliced_volume -= volume;
+      if(retained.find(tensor_hash) != retained.end()){
+       dependence = SliceDependence::RETAINED;
+      }else{
+       prologue_volume -= volume;
       }
-     }else{
-      std::cout << "#ERROR(exatn::numerics::TensorNetwork::splitIndices): "
-                << "Unable to parse a tensor operand: " << tens_operands[op_num] << std::endl;
-      assert(false);
      }
+     slice_dependence_.emplace(std::make_pair(op.getTensorOpHash(),dependence));
     }
-   }else{
-    std::cout << "#ERROR(exatn::numerics::TensorNetwork::splitIndices): "
-              << "Unable to parse the tensor operation index pattern: " << pattern << std::endl;
-    assert(false);
+    max_sliced_presence_volume_ = std::max(max_sliced_presence_volume_,sliced_volume);
+    max_hoisted_presence_volume_ = std::max(max_hoisted_presence_volume_,
+                                   std::max(prologue_volume,hoisted_volume + slice_invariant_volume_));
    }
   }
  }
@@ -2225,6 +2540,33 @@ void TensorNetwork::printSplitIndexInfo(std::ofstream & output_file, bool with_a
 }
 
 
+SliceDependence TensorNetwork::getSliceDependence(const TensorOperation & op) const
+{
+ auto iter = slice_dependence_.find(op.getTensorOpHash());
+ if(iter != slice_dependence_.end()) return iter->second;
+ return SliceDependence::DEPENDENT;
+}
+
+
+double TensorNetwork::getSliceInvariantFMAFlops() const
+{
+ return slice_invariant_flops_;
+}
+
+
+double TensorNetwork::getSliceInvariantVolume() const
+{
+ return slice_invariant_volume_;
+}
+
+
+double TensorNetwork::getMaxSlicedIntermediatePresenceVolume(bool hoist_invariants) const
+{
+ if(hoist_invariants) return max_hoisted_presence_volume_;
+ return max_sliced_presence_volume_;
+}
+
+
 double TensorNetwork::getFMAFlops() const
 {
  return contraction_seq_flops_;
@@ -2251,8 +2593,7 @@ bool TensorNetwork::printTensorNetwork(std::string & network)
   establishUniversalIndexNumeration();
   for(auto op_iter = operations_.cbegin(); op_iter != operations_.cend(); ++op_iter){
    const auto & op = *(*op_iter);
-   const auto & pattern = op.getIndexPattern();
-   if(!pattern.empty()) network += (pattern + "\n");
+   if(op.hasIndexPattern()) network += (op.getIndexPattern() + "\n");
   }
   return true;
  }
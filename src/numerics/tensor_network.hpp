@@ -1,5 +1,5 @@
 /** ExaTN::Numerics: Tensor network
-REVISION: 2020/08/11
+REVISION: 2020/09/26
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
@@ -54,6 +54,7 @@ Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 
 #include "tensor_basic.hpp"
 #include "tensor_connected.hpp"
+#include "tensor_symbol.hpp"
 #include "tensor_op_factory.hpp"
 #include "network_build_factory.hpp"
 #include "contraction_seq_optimizer.hpp"
@@ -76,6 +77,20 @@ namespace numerics{
 //Index (dimension) split information: Vector of segments the full dimension is split into:
 using IndexSplit = std::vector<std::pair<SubspaceId, DimExtent>>; //Segment = [subspace_base, segment_extent]
 
+//Slice dependence of a tensor operation from the operation list of a tensor network with split indices:
+enum class SliceDependence{
+ DEPENDENT, //tensor operation needs to be executed for each tensor sub-network (slice)
+ INVARIANT, //tensor operation produces the same result for all tensor sub-networks (slices)
+ RETAINED   //destruction of a slice-invariant intermediate which is consumed by slice-dependent tensor operations
+};
+
+//Projection of an input tensor of a tensor network obtained by fixing some of its indices:
+struct TensorProjection{
+ std::shared_ptr<Tensor> original;  //original input tensor
+ std::shared_ptr<Tensor> projected; //projected tensor (with the fixed dimensions removed)
+ std::vector<std::pair<unsigned int, DimOffset>> fixed_dims; //fixed dimensions of the original tensor and their values (ordered)
+};
+
 
 //Tests whether a given tensor has a name referring to an intermediate tensor of a tensor network:
 bool tensorNameIsIntermediate(const Tensor & tensor,            //in: tensor
@@ -167,14 +182,14 @@ public:
  /** Returns a list of the tensors adjacent to a given tensor by their Ids. **/
  std::list<unsigned int> getAdjacentTensors(unsigned int tensor_id) const;
 
- /** Begin iterator **/
- inline Iterator begin() {return tensors_.begin();}
- /** End iterator **/
- inline Iterator end() {return tensors_.end();}
+ /** Begin iterator (the shared tensor connection storage is copied first) **/
+ inline Iterator begin() {return mutableTensorConns().begin();}
+ /** End iterator (the shared tensor connection storage is copied first) **/
+ inline Iterator end() {return mutableTensorConns().end();}
  /** Begin constant iterator **/
- inline ConstIterator cbegin() const {return tensors_.cbegin();}
+ inline ConstIterator cbegin() const {return tensors_->cbegin();}
  /** End constant iterator **/
- inline ConstIterator cend() const {return tensors_.cend();}
+ inline ConstIterator cend() const {return tensors_->cend();}
 
  /** Finalizes the explicit construction of the tensor network (construction with advance knowledge).
      The tensor network cannot be empty. **/
@@ -257,6 +272,13 @@ public:
                    unsigned int result_id, //in: result tensor id (absent in the tensor network, to be appended)
                    std::string * contr_pattern = nullptr); //inout: corresponding tensor contraction pattern (owned by the caller)
 
+ /** Merges two tensors in a finalized tensor network, as above, returning
+     the tensor contraction pattern in its integer form. **/
+ bool mergeTensors(unsigned int left_id,          //in: left tensor id (present in the tensor network)
+                   unsigned int right_id,         //in: right tensor id (present in the tensor network)
+                   unsigned int result_id,        //in: result tensor id (absent in the tensor network, to be appended)
+                   IndexModeMap * contr_modes);   //out: integer form of the tensor contraction pattern (owned by the caller)
+
  /** Splits a given tensor in a finalized tensor network into two tensors by introducing new dimensions
      across the cutting boundary. The original tensor dimensions are then assigned to either left or
      right tensor. The new dimensions are then appended to both tensors at the end. The two tensors
@@ -295,9 +317,28 @@ public:
      of the output tensor it should be able to handle spectators (orphaned tensor legs). **/
  bool collapseIsometries();
 
+ /** Removes rank-1 basis vector tensors (one-hot vectors) connected to other input tensors by
+     fixing the corresponding index of the connected tensor, which is replaced by its projection
+     (a new tensor with the fixed dimensions removed and an automatically generated name).
+     The user-provided predicate returns TRUE for basis vector tensors together with the position
+     of their unit element. Only dimensions from anonymous vector spaces are fixed. Returns the
+     performed tensor projections which need to be computed before evaluating the tensor network. **/
+ std::vector<TensorProjection> fixBasisVectorIndices(std::function<bool (const Tensor & tensor, //in: rank-1 input tensor
+                                                                         DimOffset * position)> basis_vector); //out: position of the unit element
+
  /** Decomposes all tensors in the tensor network to restrict the highest tensor order to 3. **/
  bool decomposeTensors();
 
+ /** Simplifies the tensor network by repeatedly merging pairs of connected input tensors for which
+     the volume of the merged tensor does not exceed the volume of the larger one: Absorption of
+     vectors and matrices, fusion of consecutive gates acting on the same legs, and elimination
+     of parallel edges. At least two input tensors are always kept. The merged tensors are
+     intermediates, thus the performed merges are appended to the provided tensor contraction
+     sequence which must precede the contraction sequence of the simplified tensor network
+     in order to evaluate the original one. Returns the number of removed tensors. **/
+ unsigned int simplify(std::list<ContrTriple> & merges, //out: performed merges (tensor contraction sequence prefix)
+                       double * fma_flops = nullptr);   //out: FMA flop count of the performed merges
+
  /** Partitions the tensor network into multiple parts by minimizing the weighted edge cut.
      The returned vector <parts> is:
       parts[i] = pair{Partition weight, Ordered list of vertices forming partition i}.
@@ -324,15 +365,23 @@ public:
                            unsigned int right_id, //in: right tensor id (present in the tensor network)
                            double * diff_volume = nullptr, //out: vol(result) - vol(left) - vol(right)
                            double * arithm_intensity = nullptr, //out: arithmetic intensity of the tensor contraction
-                           bool adjust_cost = false); //in: whether or not to adjust the flops cost due to arithmetic intensity
+                           bool adjust_cost = false) const; //in: whether or not to adjust the flops cost due to arithmetic intensity
 
  /** Determines a pseudo-optimal tensor contraction sequence required for evaluating the tensor network.
      Returns an estimate of the total FMA flop count required by the returned contraction sequence.
      The tensor network must contain at least two input tensors in order to generate a single contraction.
      No contraction sequence is generated for tensor networks consisting of a single input tensor.
      If the tensor network already has its contraction sequence determined, does nothing. Note that
-     the FMA flop count neither includes the FMA factor of 2.0 nor the factor of 4.0 for complex numbers.**/
- double determineContractionSequence(const std::string & contr_seq_opt_name = "metis");
+     the FMA flop count neither includes the FMA factor of 2.0 nor the factor of 4.0 for complex numbers.
+     Optionally, the determined tensor contraction sequence can be further improved by the local
+     refinement post-pass which exactly re-optimizes small subtrees of the contraction tree.
+     Optionally, the tensor contraction sequence optimizer can be applied to a simplified
+     copy of the tensor network (see simplify()), the merges being prepended. **/
+ double determineContractionSequence(const std::string & contr_seq_opt_name = "metis",        //in: tensor contraction sequence optimizer name
+                                     bool refine = false,                                      //in: whether or not to refine the determined contraction sequence
+                                     ContrSeqRefinementInfo * refinement_info = nullptr,       //out: refinement info (flop reduction and time)
+                                     bool simplify = false,                                    //in: whether or not to simplify the tensor network before optimization
+                                     unsigned int * num_removed = nullptr);                    //out: number of tensors removed by simplification
 
  /** Imports and caches an externally provided tensor contraction sequence. **/
  void importContractionSequence(const std::list<ContrTriple> & contr_sequence, //in: imported tensor contraction sequence
@@ -357,6 +406,13 @@ public:
      the processing backend when the tensor network is submitted for evaluation. **/
  void splitIndices(std::size_t max_intermediate_volume); //in: intermediate volume limit
 
+ /** Splits indices of the tensor network according to an externally provided
+     splitting plan, for example, the one previously generated for a structurally
+     identical tensor network. Each plan entry specifies the universal index label
+     and the number of segments it needs to be split into. Returns FALSE if the
+     plan does not match the tensor operation list (no indices will be split then). **/
+ bool splitIndices(const std::vector<std::pair<std::string,std::size_t>> & split_plan); //in: index label --> number of segments
+
  /** Returns the total number of splitted indices. **/
  unsigned int getNumSplitIndices() const;
 
@@ -368,6 +424,25 @@ public:
  const std::vector<std::pair<unsigned int, unsigned int>> *
  getSplitTensorInfo(const std::pair<TensorHashType,TensorHashType> & key) const;
 
+ /** Returns the slice dependence of a given tensor operation from the operation list
+     once the tensor network indices have been split. Slice-invariant tensor operations
+     do not carry split indices, neither directly nor via their intermediate operands,
+     thus they only need to be executed once for all tensor sub-networks (slices). **/
+ SliceDependence getSliceDependence(const TensorOperation & op) const;
+
+ /** Returns the FMA flop count of all slice-invariant tensor operations. **/
+ double getSliceInvariantFMAFlops() const;
+
+ /** Returns the total volume of slice-invariant intermediates which have to be
+     retained over the execution of all slice-dependent tensor operations. **/
+ double getSliceInvariantVolume() const;
+
+ /** Returns the maximal cumulative volume of (sliced) intermediate tensors present
+     at a time during execution of a single tensor sub-network. If hoist_invariants is TRUE,
+     the slice-invariant tensor operations are assumed to have been executed only once in advance,
+     with the retained slice-invariant intermediates being present during the entire execution. **/
+ double getMaxSlicedIntermediatePresenceVolume(bool hoist_invariants = false) const;
+
  /** Prints information on index splitting within the tensor operation list. **/
  void printSplitIndexInfo(bool with_affected_tensors = false) const;
  void printSplitIndexInfo(std::ofstream & output_file,
@@ -393,6 +468,7 @@ public:
  /** Returns a non-owning pointer to a given tensor of the tensor network
      together with its connections (legs). If not found, returns nullptr. **/
  TensorConn * getTensorConn(unsigned int tensor_id);
+ const TensorConn * getTensorConn(unsigned int tensor_id) const;
 
 protected:
 
@@ -422,9 +498,9 @@ protected:
  std::vector<TensorConn*> getTensorConnAll();
 
  /** Checks validity of connections of a given tensor. **/
- bool checkConnections(unsigned int tensor_id);
+ bool checkConnections(unsigned int tensor_id) const;
  /** Checks validity of connections in the enitre tensor network. **/
- bool checkConnections();
+ bool checkConnections() const;
 
  /** Updates tensor network linking when a tensor has its connections modified:
      tensor_id is the id of the tensor whose leg numeration was updated. **/
@@ -445,7 +521,11 @@ protected:
      The tensor network must contain at least two input tensors in order to generate a single contraction.
      No contraction sequence is generated for tensor networks consisting of a single input tensor.
      If the tensor network already has its contraction sequence determined, does nothing. **/
- double determineContractionSequence(ContractionSeqOptimizer & contr_seq_optimizer);
+ double determineContractionSequence(ContractionSeqOptimizer & contr_seq_optimizer,
+                                     bool refine = false,
+                                     ContrSeqRefinementInfo * refinement_info = nullptr,
+                                     bool simplify = false,
+                                     unsigned int * num_removed = nullptr);
 
  /** Establishes a universal index numeration in the already generated tensor operation list
      such that a specific index occuring in different tensor operations will always refer
@@ -453,6 +533,11 @@ protected:
      If the tensor operation list is empty, does nothing. **/
  void establishUniversalIndexNumeration();
 
+ /** Marks tensor operands with split dimensions in the tensor operation list
+     according to the split indices and classifies each tensor operation
+     by its slice dependence (slice-invariant versus slice-dependent). **/
+ void markSplitTensors();
+
 private:
 
  /** Resets the output tensor in a finalized tensor network to a new
@@ -464,6 +549,11 @@ private:
  void resetOutputTensor(const std::vector<unsigned int> & order, //in: new order of dimensions (N2O)
                         const std::string & name = ""); //in: new name of the output tensor (if empty, will be generated automatically)
 
+ /** Returns the tensor connection storage for modification. The storage shared with
+     other copies of the tensor network is copied first (copy-on-write). Note that
+     previously obtained non-owning pointers and iterators will refer to the old storage. **/
+ inline std::unordered_map<unsigned int, TensorConn> & mutableTensorConns();
+
  /** Updates the max tensor id used in the tensor network when a tensor
      is either appended to or removed from the tensor network.  **/
  void updateMaxTensorIdOnAppend(unsigned int tensor_id);
@@ -473,8 +563,9 @@ private:
  int explicit_output_;                                  //whether or not the output tensor has been fully specified during construction
  int finalized_;                                        //finalization status of the tensor network
  std::string name_;                                     //tensor network name
- std::unordered_map<unsigned int, TensorConn> tensors_; //tensors connected to each other via legs (tensor connections)
+ std::shared_ptr<std::unordered_map<unsigned int, TensorConn>> tensors_; //tensors connected to each other via legs (tensor connections)
                                                         //map: Non-negative tensor id --> Connected tensor
+                                                        //shared by copies of the tensor network until modified (copy-on-write)
  /** Data members: Tensor id management: **/
  unsigned int max_tensor_id_; //cached max tensor id used so far (0:undefined)
 
@@ -493,15 +584,27 @@ private:
           std::vector<std::pair<unsigned int,  //global id of the split index (in split_indices_): [0..max]
                                 unsigned int>> //position of the split index in the tensor operand: [0..max]
          > split_tensors_; //information on tensors with split dimensions
+ std::unordered_map<TensorHashType,SliceDependence> slice_dependence_; //tensor operation hash --> slice dependence (if not DEPENDENT)
+ double slice_invariant_flops_; //FMA flop count of slice-invariant tensor operations
+ double slice_invariant_volume_; //total volume of retained slice-invariant intermediates
+ double max_sliced_presence_volume_; //max cumulative volume of sliced intermediates present at a time
+ double max_hoisted_presence_volume_; //same as above, but with slice-invariant tensor operations hoisted
  bool universal_indexing_; //universal indexing flag
 };
 
 
 //DEFINITIONS:
+inline std::unordered_map<unsigned int, TensorConn> & TensorNetwork::mutableTensorConns()
+{
+ if(tensors_.use_count() > 1) tensors_ = std::make_shared<std::unordered_map<unsigned int, TensorConn>>(*tensors_);
+ return *tensors_;
+}
+
+
 inline bool TensorNetwork::emplaceTensorConn(unsigned int tensor_id,
                                              const TensorConn & tensor_conn)
 {
- auto res = tensors_.emplace(tensor_id,tensor_conn);
+ auto res = mutableTensorConns().emplace(tensor_id,tensor_conn);
  if(res.second){
   res.first->second.resetTensorId(tensor_id);
   updateMaxTensorIdOnAppend(tensor_id);
@@ -514,11 +617,11 @@ inline bool TensorNetwork::emplaceTensorConn(bool dynamic_id_enabled,
                                              unsigned int tensor_id,
                                              const TensorConn & tensor_conn)
 {
- auto res = tensors_.emplace(tensor_id,tensor_conn);
+ auto res = mutableTensorConns().emplace(tensor_id,tensor_conn);
  if(!(res.second) && dynamic_id_enabled){
   tensor_id = getMaxTensorId() + 1;
   assert(tensor_id != 0); //unsigned int overflow
-  res = tensors_.emplace(tensor_id,tensor_conn);
+  res = mutableTensorConns().emplace(tensor_id,tensor_conn);
  }
  if(res.second){
   res.first->second.resetTensorId(tensor_id);
@@ -533,11 +636,11 @@ inline bool TensorNetwork::emplaceTensorConnDirect(bool dynamic_id_enabled,
                                                    unsigned int tensor_id,
                                                    Args&&... args)
 {
- auto res = tensors_.emplace(tensor_id,TensorConn(std::forward<Args>(args)...));
+ auto res = mutableTensorConns().emplace(tensor_id,TensorConn(std::forward<Args>(args)...));
  if(!(res.second) && dynamic_id_enabled){
   tensor_id = getMaxTensorId() + 1;
   assert(tensor_id != 0); //unsigned int overflow
-  res = tensors_.emplace(tensor_id,TensorConn(std::forward<Args>(args)...));
+  res = mutableTensorConns().emplace(tensor_id,TensorConn(std::forward<Args>(args)...));
  }
  if(res.second){
   res.first->second.resetTensorId(tensor_id);
@@ -553,11 +656,11 @@ inline bool TensorNetwork::emplaceTensorConnDirect(bool dynamic_name_enabled,
                                                    unsigned int tensor_id,
                                                    Args&&... args)
 {
- auto res = tensors_.emplace(tensor_id,TensorConn(std::forward<Args>(args)...));
+ auto res = mutableTensorConns().emplace(tensor_id,TensorConn(std::forward<Args>(args)...));
  if(!(res.second) && dynamic_id_enabled){
   tensor_id = getMaxTensorId() + 1;
   assert(tensor_id != 0); //unsigned int overflow
-  res = tensors_.emplace(tensor_id,TensorConn(std::forward<Args>(args)...));
+  res = mutableTensorConns().emplace(tensor_id,TensorConn(std::forward<Args>(args)...));
  }
  if(res.second){
   res.first->second.resetTensorId(tensor_id);
@@ -573,7 +676,7 @@ inline bool TensorNetwork::emplaceTensorConnDirect(bool dynamic_name_enabled,
 
 inline bool TensorNetwork::eraseTensorConn(unsigned int tensor_id)
 {
- auto num_deleted = tensors_.erase(tensor_id);
+ auto num_deleted = mutableTensorConns().erase(tensor_id);
  if(num_deleted == 1) updateMaxTensorIdOnRemove(tensor_id);
  return (num_deleted == 1);
 }
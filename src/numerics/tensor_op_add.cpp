@@ -1,5 +1,5 @@
 /** ExaTN::Numerics: Tensor operation: Adds a tensor to another tensor
-REVISION: 2020/08/11
+REVISION: 2020/09/26
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
@@ -22,7 +22,7 @@ TensorOpAdd::TensorOpAdd():
 
 bool TensorOpAdd::isSet() const
 {
- return (this->getNumOperandsSet() == this->getNumOperands() && this->getIndexPattern().length() > 0);
+ return (this->getNumOperandsSet() == this->getNumOperands() && this->hasIndexPattern());
 }
 
 int TensorOpAdd::accept(runtime::TensorNodeExecutor & node_executor,
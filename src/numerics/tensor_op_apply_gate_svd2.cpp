@@ -0,0 +1,95 @@
+/** ExaTN::Numerics: Tensor operation: Applies a two-site gate to two neighboring tensors with SVD truncation
+REVISION: 2020/10/01
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+#include "exatn_service.hpp"
+
+#include "tensor_op_apply_gate_svd2.hpp"
+
+#include "tensor_node_executor.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace exatn{
+
+namespace numerics{
+
+TensorOpApplyGateSVD2::TensorOpApplyGateSVD2():
+ TensorOperation(TensorOpCode::APPLY_GATE_SVD2,3,0,1+1*2+0*4,{1,2,3}),
+ achieved_rank_(0), discarded_weight_(0.0)
+{
+}
+
+bool TensorOpApplyGateSVD2::isSet() const
+{
+ return (this->getNumOperandsSet() == this->getNumOperands() && this->hasIndexPattern());
+}
+
+double TensorOpApplyGateSVD2::getFlopEstimate() const
+{
+ if(this->isSet()){
+  //Theta formation (bond contraction + gate application) plus the SVD of theta:
+  const double left_vol = static_cast<double>(this->getTensorOperand(0)->getVolume());
+  const double right_vol = static_cast<double>(this->getTensorOperand(1)->getVolume());
+  const double gate_vol = static_cast<double>(this->getTensorOperand(2)->getVolume());
+  const auto & left = this->getIndexModeMap().operands[1].modes;
+  const auto & right = this->getIndexModeMap().operands[2].modes;
+  double bond_dim = 1.0;
+  for(unsigned int i = 0; i < left.size(); ++i){
+   if(std::find(right.cbegin(),right.cend(),left[i]) != right.cend())
+    bond_dim *= static_cast<double>(this->getTensorOperand(0)->getDimExtent(i));
+  }
+  const double num_rows = left_vol / bond_dim;
+  const double num_cols = right_vol / bond_dim;
+  const double min_dim = std::min(num_rows,num_cols);
+  return num_rows * num_cols * (bond_dim + std::sqrt(gate_vol)) + num_rows * num_cols * min_dim;
+ }
+ return 0.0;
+}
+
+int TensorOpApplyGateSVD2::accept(runtime::TensorNodeExecutor & node_executor,
+                                  runtime::TensorOpExecHandle * exec_handle)
+{
+ return node_executor.execute(*this,exec_handle);
+}
+
+std::unique_ptr<TensorOperation> TensorOpApplyGateSVD2::createNew()
+{
+ return std::unique_ptr<TensorOperation>(new TensorOpApplyGateSVD2());
+}
+
+void TensorOpApplyGateSVD2::resetTruncation(const SVDTruncation & truncation)
+{
+ truncation_ = truncation;
+ return;
+}
+
+const SVDTruncation & TensorOpApplyGateSVD2::getTruncation() const
+{
+ return truncation_;
+}
+
+void TensorOpApplyGateSVD2::setTruncationResult(std::size_t achieved_rank,
+                                                double discarded_weight)
+{
+ achieved_rank_ = achieved_rank;
+ discarded_weight_ = discarded_weight;
+ return;
+}
+
+std::size_t TensorOpApplyGateSVD2::getAchievedRank() const
+{
+ return achieved_rank_;
+}
+
+double TensorOpApplyGateSVD2::getDiscardedWeight() const
+{
+ return discarded_weight_;
+}
+
+} //namespace numerics
+
+} //namespace exatn
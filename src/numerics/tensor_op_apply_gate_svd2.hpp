@@ -0,0 +1,92 @@
+/** ExaTN::Numerics: Tensor operation: Applies a two-site gate to two neighboring tensors with SVD truncation
+REVISION: 2020/10/01
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+/** Rationale:
+ (a) Applies a two-site gate to two neighboring tensors connected by a single bond
+     (for example, two neighboring MPS tensors) as a single fused tensor operation:
+     The two tensors are contracted with the gate into the two-site tensor (theta),
+     which is then decomposed via a truncated SVD with the singular values absorbed
+     as prescribed by the canonical form, and the two updated tensors are written
+     back in place (their shapes are preserved, the retained rank being limited
+     by the bond dimension), for example:
+     T(a,k,l,c) = L(a,i,b) * R(b,j,c) * G(i,j,k,l)
+     Virtual    = Operand 0 * Operand 1 * Operand 2
+     --> L(a,k,b) * R(b,l,c)
+     The two-site tensor T only exists inside the operation, its name is irrelevant.
+     The first half of the gate legs is contracted with the two tensors, the second half
+     of the gate legs replaces the contracted legs in place (ExaTN gate convention).
+ (b) The achieved rank and the truncation error (discarded weight) are recorded
+     in the tensor operation upon its execution.
+**/
+
+#ifndef EXATN_NUMERICS_TENSOR_OP_APPLY_GATE_SVD2_HPP_
+#define EXATN_NUMERICS_TENSOR_OP_APPLY_GATE_SVD2_HPP_
+
+#include "tensor_basic.hpp"
+#include "tensor_operation.hpp"
+#include "truncated_svd.hpp"
+
+namespace exatn{
+
+namespace numerics{
+
+class TensorOpApplyGateSVD2: public TensorOperation{
+public:
+
+ TensorOpApplyGateSVD2();
+
+ TensorOpApplyGateSVD2(const TensorOpApplyGateSVD2 &) = default;
+ TensorOpApplyGateSVD2 & operator=(const TensorOpApplyGateSVD2 &) = default;
+ TensorOpApplyGateSVD2(TensorOpApplyGateSVD2 &&) noexcept = default;
+ TensorOpApplyGateSVD2 & operator=(TensorOpApplyGateSVD2 &&) noexcept = default;
+ virtual ~TensorOpApplyGateSVD2() = default;
+
+ virtual std::unique_ptr<TensorOperation> clone() const override{
+  return std::unique_ptr<TensorOperation>(new TensorOpApplyGateSVD2(*this));
+ }
+
+ /** Returns TRUE iff the tensor operation is fully set. **/
+ virtual bool isSet() const override;
+
+ /** Returns the FMA flop estimate for the tensor operation. **/
+ virtual double getFlopEstimate() const override;
+
+ /** Accepts tensor node executor which will execute this tensor operation. **/
+ virtual int accept(runtime::TensorNodeExecutor & node_executor,
+                    runtime::TensorOpExecHandle * exec_handle) override;
+
+ /** Create a new polymorphic instance of this subclass. **/
+ static std::unique_ptr<TensorOperation> createNew();
+
+ /** Resets the SVD truncation parameters. **/
+ void resetTruncation(const SVDTruncation & truncation);
+
+ /** Returns the SVD truncation parameters. **/
+ const SVDTruncation & getTruncation() const;
+
+ /** Records the achieved rank and the discarded weight (by the executor). **/
+ void setTruncationResult(std::size_t achieved_rank,
+                          double discarded_weight);
+
+ /** Returns the achieved rank (zero before execution). **/
+ std::size_t getAchievedRank() const;
+
+ /** Returns the discarded weight (relative squared Frobenius norm of the truncation error). **/
+ double getDiscardedWeight() const;
+
+private:
+
+ SVDTruncation truncation_; //SVD truncation parameters
+ std::size_t achieved_rank_; //achieved rank (set upon execution)
+ double discarded_weight_;   //discarded weight (set upon execution)
+
+};
+
+} //namespace numerics
+
+} //namespace exatn
+
+#endif //EXATN_NUMERICS_TENSOR_OP_APPLY_GATE_SVD2_HPP_
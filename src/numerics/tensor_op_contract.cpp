@@ -1,5 +1,5 @@
 /** ExaTN::Numerics: Tensor operation: Contracts two tensors and accumulates the result into another tensor
-REVISION: 2020/08/11
+REVISION: 2020/09/26
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
@@ -25,7 +25,7 @@ TensorOpContract::TensorOpContract():
 
 bool TensorOpContract::isSet() const
 {
- return (this->getNumOperandsSet() == this->getNumOperands() && this->getIndexPattern().length() > 0);
+ return (this->getNumOperandsSet() == this->getNumOperands() && this->hasIndexPattern());
 }
 
 int TensorOpContract::accept(runtime::TensorNodeExecutor & node_executor,
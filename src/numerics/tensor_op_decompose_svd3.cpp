@@ -1,5 +1,5 @@
 /** ExaTN::Numerics: Tensor operation: Decomposes a tensor into three tensor factors via SVD
-REVISION: 2020/06/25
+REVISION: 2020/09/26
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
@@ -22,7 +22,7 @@ TensorOpDecomposeSVD3::TensorOpDecomposeSVD3():
 
 bool TensorOpDecomposeSVD3::isSet() const
 {
- return (this->getNumOperandsSet() == this->getNumOperands() && this->getIndexPattern().length() > 0);
+ return (this->getNumOperandsSet() == this->getNumOperands() && this->hasIndexPattern());
 }
 
 int TensorOpDecomposeSVD3::accept(runtime::TensorNodeExecutor & node_executor,
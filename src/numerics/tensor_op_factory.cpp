@@ -25,6 +25,7 @@ TensorOpFactory::TensorOpFactory()
  registerTensorOp(TensorOpCode::ORTHOGONALIZE_MGS,&TensorOpOrthogonalizeMGS::createNew);
  registerTensorOp(TensorOpCode::BROADCAST,&TensorOpBroadcast::createNew);
  registerTensorOp(TensorOpCode::ALLREDUCE,&TensorOpAllreduce::createNew);
+ registerTensorOp(TensorOpCode::APPLY_GATE_SVD2,&TensorOpApplyGateSVD2::createNew);
 }
 
 void TensorOpFactory::registerTensorOp(TensorOpCode opcode, createTensorOpFn creator)
@@ -26,6 +26,7 @@ Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 #include "tensor_op_orthogonalize_mgs.hpp"
 #include "tensor_op_broadcast.hpp"
 #include "tensor_op_allreduce.hpp"
+#include "tensor_op_apply_gate_svd2.hpp"
 
 #include <memory>
 #include <map>
@@ -1,5 +1,5 @@
 /** ExaTN::Numerics: Tensor operation: Orthogonalizes a tensor via SVD
-REVISION: 2020/06/25
+REVISION: 2020/09/26
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
@@ -21,7 +21,7 @@ TensorOpOrthogonalizeSVD::TensorOpOrthogonalizeSVD():
 
 bool TensorOpOrthogonalizeSVD::isSet() const
 {
- return (this->getNumOperandsSet() == this->getNumOperands() && this->getIndexPattern().length() > 0);
+ return (this->getNumOperandsSet() == this->getNumOperands() && this->hasIndexPattern());
 }
 
 int TensorOpOrthogonalizeSVD::accept(runtime::TensorNodeExecutor & node_executor,
@@ -1,11 +1,10 @@
 /** ExaTN::Numerics: Tensor operation
-REVISION: 2020/09/02
+REVISION: 2020/09/26
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 
 #include "tensor_operation.hpp"
-#include "tensor_symbol.hpp"
 
 #include <iostream>
 #include <ios>
@@ -45,7 +44,7 @@ double TensorOperation::getWordEstimate() const
 void TensorOperation::printIt() const
 {
  std::cout << "TensorOperation(opcode=" << static_cast<int>(opcode_) << ")[id=" << id_ << "]{" << std::endl;
- if(pattern_.length() > 0) std::cout << " " << pattern_ << std::endl;
+ if(this->hasIndexPattern()) std::cout << " " << assemble_index_pattern(*mode_map_) << std::endl;
  for(const auto & operand: operands_){
   const auto & tensor = std::get<0>(operand);
   std::cout << " ";
@@ -65,7 +64,7 @@ void TensorOperation::printIt() const
 void TensorOperation::printItFile(std::ofstream & output_file) const
 {
  output_file << "TensorOperation(opcode=" << static_cast<int>(opcode_) << ")[id=" << id_ << "]{" << std::endl;
- if(pattern_.length() > 0) output_file << " " << pattern_ << std::endl;
+ if(this->hasIndexPattern()) output_file << " " << assemble_index_pattern(*mode_map_) << std::endl;
  for(const auto & operand: operands_){
   const auto & tensor = std::get<0>(operand);
   output_file << " ";
@@ -185,65 +184,82 @@ void TensorOperation::setScalar(unsigned int scalar_num, const std::complex<doub
  return;
 }
 
-const std::string & TensorOperation::getIndexPattern() const
+bool TensorOperation::hasIndexPattern() const
 {
- return pattern_;
+ return (mode_map_ && !(mode_map_->empty()));
+}
+
+std::string TensorOperation::getIndexPattern() const
+{
+ if(!(this->hasIndexPattern())) return std::string();
+ return assemble_index_pattern(*mode_map_);
+}
+
+const IndexModeMap & TensorOperation::getIndexModeMap() const
+{
+ static const IndexModeMap empty_mode_map;
+ if(!mode_map_) return empty_mode_map;
+ return *mode_map_;
 }
 
 std::string TensorOperation::getIndexPatternReduced() const
 {
  std::string reduced;
- if(pattern_.length() > 0){
+ if(this->hasIndexPattern()){
+  const auto & mode_map = *mode_map_;
   const auto num_operands = this->getNumOperands();
-  std::vector<std::string> tensors;
-  auto parsed = parse_tensor_network(pattern_,tensors);
-  if(parsed){
-   const auto num_tensors = tensors.size();
-   assert(num_tensors == num_operands);
-   for(unsigned int oprnd = 0; oprnd < num_operands; ++oprnd){
-    const auto & tensor = *(this->getTensorOperand(oprnd));
-    if(symb_pos_[oprnd] >= 0){ //tensor operand is present in the symbolic index pattern
-     std::string tensor_name;
-     std::vector<IndexLabel> indices;
-     bool conj;
-     parsed = parse_tensor(tensors[symb_pos_[oprnd]],tensor_name,indices,conj);
-     if(parsed){
-      unsigned int i = 0;
-      auto iter = indices.begin();
-      while(iter != indices.end()){
-       if(tensor.getDimExtent(i++) > 1){
-        ++iter;
-       }else{
-        iter = indices.erase(iter); //remove indices associated with extent-1 dimensions
-       }
-      }
-      tensors[symb_pos_[oprnd]] = assemble_symbolic_tensor(tensor_name,indices,conj);
-     }else{
-      std::cout << "#ERROR(exatn::numerics::TensorOperation::getIndexPatternReduced): "
-                << "Unable to parse tensor operand " << symb_pos_[oprnd]
-                << " in symbolic tensor operation specification: " << pattern_ << std::endl;
-      assert(false);
-     }
-    }
+  const unsigned int num_tensors = mode_map.operands.size();
+  assert(num_tensors == num_operands);
+  std::vector<const Tensor*> tensors(num_tensors,nullptr); //symbolic tensor --> tensor operand
+  for(unsigned int oprnd = 0; oprnd < num_operands; ++oprnd){
+   if(symb_pos_[oprnd] >= 0) tensors[symb_pos_[oprnd]] = this->getTensorOperand(oprnd).get();
+  }
+  unsigned int num_assembled = 0;
+  for(unsigned int i = 0; i < num_tensors; ++i){
+   if(opcode_ == TensorOpCode::DECOMPOSE_SVD3 && i == 2) continue; //delete the middle tensor from the symbolic specification
+   const auto & operand = mode_map.operands[i];
+   if(num_assembled == 1){
+    reduced += "+=";
+   }else if(num_assembled > 1){
+    reduced += "*";
    }
-   if(opcode_ == TensorOpCode::DECOMPOSE_SVD3){ //delete the middle tensor from the symbolic specification
-    tensors.erase(tensors.begin()+2);
+   reduced += operand.name;
+   if(operand.conjugated) reduced += "+";
+   reduced += "(";
+   bool first = true;
+   for(unsigned int j = 0; j < operand.modes.size(); ++j){
+    if(tensors[i] != nullptr){ //remove indices associated with extent-1 dimensions
+     if(tensors[i]->getDimExtent(j) <= 1) continue;
+    }
+    if(!first) reduced += ",";
+    reduced += mode_map.getLabelName(operand.modes[j]);
+    first = false;
    }
-   reduced = assemble_symbolic_tensor_network(tensors);
-  }else{
-   std::cout << "#ERROR(exatn::numerics::TensorOperation::getIndexPatternReduced): "
-             << "Unable to parse the symbolic tensor operation specification: "
-             << pattern_ << std::endl;
-   assert(false);
+   reduced += ")";
+   ++num_assembled;
   }
  }
- return std::move(reduced);
+ return reduced;
 }
 
 void TensorOperation::setIndexPattern(const std::string & pattern)
+{
+ IndexModeMap mode_map;
+ if(parse_index_pattern(pattern,mode_map)){
+  this->setIndexPattern(std::move(mode_map));
+ }else{
+  std::cout << "#ERROR(exatn::numerics::TensorOperation::setIndexPattern): "
+            << "Unable to parse the symbolic tensor operation specification: "
+            << pattern << std::endl;
+  assert(false);
+ }
+ return;
+}
+
+void TensorOperation::setIndexPattern(IndexModeMap mode_map)
 {
  if(operands_.size() == num_operands_ && scalars_.size() == num_scalars_){
-  pattern_ = pattern;
+  mode_map_ = std::make_shared<const IndexModeMap>(std::move(mode_map));
  }else{
   std::cout << "#ERROR(exatn::numerics::TensorOperation::setIndexPattern): "
             << "Index pattern cannot be set until all operands and scalars have been set!\n";
@@ -1,5 +1,5 @@
 /** ExaTN::Numerics: Tensor operation
-REVISION: 2020/08/11
+REVISION: 2020/09/26
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
@@ -8,6 +8,9 @@ Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
  (a) A tensor operation is a formal numerical operation on one or more tensors.
  (b) A tensor operation may have mutable (output) and immutable (input) tensor operands.
      The mutable tensor operands must always precede immutable tensor operands!
+ (c) The symbolic tensor operation specification (index pattern) is stored in its
+     integer form (index mode map); the string form is only assembled on request.
+     The index mode map is immutable once set, thus it is shared by clones.
 **/
 
 #ifndef EXATN_NUMERICS_TENSOR_OPERATION_HPP_
@@ -15,6 +18,7 @@ Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 
 #include "tensor_basic.hpp"
 #include "tensor.hpp"
+#include "tensor_symbol.hpp"
 #include "timers.hpp"
 
 #include <initializer_list>
@@ -129,8 +133,15 @@ public:
  void setScalar(unsigned int scalar_num,
                 const std::complex<double> scalar);
 
- /** Returns the symbolic tensor operation specification (index pattern). **/
- const std::string & getIndexPattern() const;
+ /** Returns TRUE if the symbolic tensor operation specification (index pattern) is set. **/
+ bool hasIndexPattern() const;
+
+ /** Returns the symbolic tensor operation specification (index pattern) assembled
+     from its integer form (empty string if not set). **/
+ std::string getIndexPattern() const;
+
+ /** Returns the integer form of the symbolic tensor operation specification (index pattern). **/
+ const IndexModeMap & getIndexModeMap() const;
 
  /** Returns a reduced symbolic tensor operation specification (index pattern)
      in which indices associated with tensor dimensions of extent 1 are removed.
@@ -143,6 +154,10 @@ public:
      It is allowed to reset an already set index pattern via this function. **/
  void setIndexPattern(const std::string & pattern);
 
+ /** Sets the symbolic tensor operation specification (index pattern) in its integer form,
+     with the same requirements as above. **/
+ void setIndexPattern(IndexModeMap mode_map);
+
  /** Sets the unique integer identifier of the tensor operation. **/
  void setId(std::size_t id);
 
@@ -186,7 +201,7 @@ private:
 
 protected:
 
- std::string pattern_; //symbolic index pattern
+ std::shared_ptr<const IndexModeMap> mode_map_; //symbolic index pattern (integer form), shared by clones
  const std::vector<int> symb_pos_; //symb_pos_[operand_position] --> operand position in the symbolic index pattern;
  std::vector<std::tuple<std::shared_ptr<Tensor>,bool,bool>> operands_; //tensor operands <operand,conjugation,mutation>
  std::vector<std::complex<double>> scalars_; //additional scalars (prefactors)
@@ -1,11 +1,14 @@
 /** ExaTN::Numerics: Tensor operator
-REVISION: 2019/12/06
+REVISION: 2020/10/03
 
-Copyright (C) 2018-2019 Dmitry I. Lyakh (Liakh)
-Copyright (C) 2018-2019 Oak Ridge National Laboratory (UT-Battelle) **/
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 
 #include "tensor_operator.hpp"
 
+#include <unordered_map>
+#include <algorithm>
+
 namespace exatn{
 
 namespace numerics{
@@ -66,6 +69,79 @@ void TensorOperator::conjugate()
 }
 
 
+TensorOperator TensorOperator::groupComponents(std::vector<ComponentGroup> & groups) const
+{
+ groups.clear();
+ //Determine the support of each single-tensor component:
+ const std::size_t num_components = components_.size();
+ std::vector<int> group_of(num_components,-1); //component --> group (-1: not groupable)
+ std::vector<std::vector<std::size_t>> group_components; //group --> components
+ std::vector<GroupMember> members(num_components);
+ std::unordered_map<std::string,int> support_groups; //support key --> group
+ for(std::size_t i = 0; i < num_components; ++i){
+  const auto & component = components_[i];
+  if(component.network->getNumTensors() != 1) continue;
+  unsigned int tensor_id = 0;
+  for(auto iter = component.network->cbegin(); iter != component.network->cend(); ++iter){
+   if(iter->first != 0) tensor_id = iter->first;
+  }
+  bool conjugated;
+  auto tensor = component.network->getTensor(tensor_id,&conjugated);
+  if(conjugated) continue;
+  const auto * output_legs = component.network->getTensorConnections(0);
+  assert(output_legs != nullptr);
+  //Group tensor legs: Ket legs followed by bra legs, each ordered by global mode ids:
+  auto ket_legs = component.ket_legs;
+  auto bra_legs = component.bra_legs;
+  std::sort(ket_legs.begin(),ket_legs.end());
+  std::sort(bra_legs.begin(),bra_legs.end());
+  std::string key;
+  auto & member = members[i];
+  for(const auto * legs: {&ket_legs, &bra_legs}){
+   for(const auto & leg: *legs){
+    const auto dim = (*output_legs)[leg.second].getDimensionId(); //member tensor dimension
+    member.dims.emplace_back(dim);
+    key += std::to_string(leg.first) + ":" + std::to_string(tensor->getDimExtent(dim)) + ",";
+   }
+   key += "|";
+  }
+  member.tensor = tensor;
+  member.coefficient = component.coefficient;
+  auto res = support_groups.emplace(std::make_pair(key,static_cast<int>(group_components.size())));
+  if(res.second) group_components.emplace_back(std::vector<std::size_t>{});
+  group_of[i] = res.first->second;
+  group_components[group_of[i]].emplace_back(i);
+ }
+ //Build the grouped tensor operator:
+ TensorOperator grouped(name_);
+ for(std::size_t i = 0; i < num_components; ++i){
+  const auto & component = components_[i];
+  if(group_of[i] < 0 || group_components[group_of[i]].size() == 1){ //component is kept as is
+   grouped.components_.emplace_back(component);
+  }else if(group_components[group_of[i]][0] == i){ //first component of a group: Group tensor
+   const auto & member = members[i];
+   std::vector<DimExtent> extents;
+   for(const auto & dim: member.dims) extents.emplace_back(member.tensor->getDimExtent(dim));
+   auto group_tensor = std::make_shared<Tensor>("_" + name_ + "_g" + std::to_string(groups.size()),extents);
+   const unsigned int num_ket_legs = component.ket_legs.size();
+   std::vector<std::pair<unsigned int, unsigned int>> ket_pairing(num_ket_legs);
+   std::vector<std::pair<unsigned int, unsigned int>> bra_pairing(component.bra_legs.size());
+   auto ket_legs = component.ket_legs;
+   auto bra_legs = component.bra_legs;
+   std::sort(ket_legs.begin(),ket_legs.end());
+   std::sort(bra_legs.begin(),bra_legs.end());
+   for(unsigned int j = 0; j < ket_pairing.size(); ++j) ket_pairing[j] = {ket_legs[j].first,j};
+   for(unsigned int j = 0; j < bra_pairing.size(); ++j) bra_pairing[j] = {bra_legs[j].first,num_ket_legs + j};
+   auto appended = grouped.appendComponent(group_tensor,ket_pairing,bra_pairing,std::complex<double>{1.0,0.0});
+   assert(appended);
+   groups.emplace_back(ComponentGroup{group_tensor,{}});
+   for(const auto & j: group_components[group_of[i]]) groups.back().members.emplace_back(members[j]);
+  }
+ }
+ return grouped;
+}
+
+
 void TensorOperator::printIt() const
 {
  std::cout << "TensorNetworkOperator(" << this->getName()
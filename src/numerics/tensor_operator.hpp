@@ -1,5 +1,5 @@
 /** ExaTN::Numerics: Tensor operator
-REVISION: 2020/03/14
+REVISION: 2020/10/03
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
@@ -19,6 +19,11 @@ Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
      acting on a ket vector. The last component of the tensor operator
      is applied first when acting on a bra vector.
  (d) The order of components of a tensor operator is reversed upon conjugation.
+ (e) Components given by single tensors acting on the same global modes (same support)
+     can be grouped into a single component whose tensor is the sum of the scaled
+     component tensors, thus reducing the number of tensor networks built for
+     the tensor operator (for example, in an expectation value). The grouping
+     itself is symbolic: The group tensors need to be computed before use.
 **/
 
 #ifndef EXATN_NUMERICS_TENSOR_OPERATOR_HPP_
@@ -51,6 +56,25 @@ public:
   std::complex<double> coefficient;
  };
 
+ //Member of a group of tensor operator components:
+ struct GroupMember{
+  //Tensor of the grouped component:
+  std::shared_ptr<Tensor> tensor;
+  //Expansion coefficient of the grouped component:
+  std::complex<double> coefficient;
+  //Dimensions of the member tensor corresponding to the group tensor legs:
+  std::vector<unsigned int> dims;
+ };
+
+ //Group of tensor operator components acting on the same global modes:
+ struct ComponentGroup{
+  //Group tensor (sum of the scaled member tensors) with its ket legs followed by its bra legs,
+  //each in the order of increasing global mode ids:
+  std::shared_ptr<Tensor> tensor;
+  //Grouped components:
+  std::vector<GroupMember> members;
+ };
+
  using Iterator = typename std::vector<OperatorComponent>::iterator;
  using ConstIterator = typename std::vector<OperatorComponent>::const_iterator;
 
@@ -114,6 +138,14 @@ public:
      complex linear expansion coefficients are complex conjugated.  **/
  void conjugate();
 
+ /** Returns a new tensor operator in which the components given by single (non-conjugated) tensors
+     acting on the same global modes (ket and bra) are replaced by a single component with a new
+     group tensor (and unit coefficient), placed at the position of the first grouped component.
+     The group tensors are only declared: Each of them needs to be computed as the sum of its
+     scaled member tensors, as described by the returned groups. The group tensors are named
+     after the tensor operator. Components that are alone in their group are kept as is. **/
+ TensorOperator groupComponents(std::vector<ComponentGroup> & groups) const; //out: groups of two or more components
+
  /** Prints. **/
  void printIt() const;
 
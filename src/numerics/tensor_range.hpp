@@ -34,6 +34,7 @@ Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 namespace exatn{
 
@@ -72,6 +73,12 @@ public:
  inline bool reset(unsigned int num_agents,  //number of concurrent agents (iterators)
                    unsigned int agent_rank); //current agend id: [0..num_agents-1]
 
+ /** Resets the current multi-index to the beginning of an explicitly given
+     subrange [subrange_begin:subrange_end) of the flattened 1d super-range.
+     Returns TRUE on success, FALSE if the subrange is empty. **/
+ inline bool resetSubrange(DimOffset subrange_begin,  //in: first flat offset of the subrange
+                           DimOffset subrange_end);   //in: flat offset following the last one in the subrange
+
  /** Retrieves a specific index from the multi-index. **/
  inline DimOffset getIndex(unsigned int position) const;
 
@@ -209,6 +216,23 @@ inline bool TensorRange::reset(unsigned int num_agents,
 }
 
 
+inline bool TensorRange::resetSubrange(DimOffset subrange_begin,
+                                       DimOffset subrange_end)
+{
+ reset();
+ subrange_end = std::min(subrange_end,static_cast<DimOffset>(volume_));
+ if(subrange_begin >= subrange_end) return false;
+ subrange_begin_ = subrange_begin;
+ subrange_end_ = subrange_end;
+ auto offs = subrange_begin_;
+ for(unsigned int i = 0; i < extents_.size(); ++i){
+  mlndx_[i] = offs % extents_[i];
+  offs /= extents_[i];
+ }
+ return true;
+}
+
+
 inline DimOffset TensorRange::getIndex(unsigned int position) const
 {
  assert(position < mlndx_.size());
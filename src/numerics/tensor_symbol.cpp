@@ -1,17 +1,46 @@
 /** ExaTN: Numerics: Symbolic tensor processing
-REVISION: 2020/06/25
+REVISION: 2020/09/26
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
 
 #include "tensor_symbol.hpp"
 
+#include <unordered_map>
 #include <iostream>
 
 #include <cassert>
 
 namespace exatn{
 
+std::string IndexModeMap::getLabelName(unsigned int label) const
+{
+ if(label_names.empty()){
+  if(isContractedLabel(label)) return ("c" + std::to_string(getLabelNumber(label)));
+  return ("u" + std::to_string(getLabelNumber(label)));
+ }
+ assert(label < label_names.size());
+ return label_names[label];
+}
+
+
+bool IndexModeMap::parseCanonicalLabel(const std::string & label_name,
+                                       unsigned int * label)
+{
+ const auto len = label_name.length();
+ if(len < 2 || len > 9) return false;
+ if(label_name[0] != 'u' && label_name[0] != 'c') return false;
+ if(label_name[1] == '0' && len > 2) return false; //leading zeros are not canonical
+ unsigned int number = 0;
+ for(std::size_t i = 1; i < len; ++i){
+  if(!is_number(label_name[i])) return false;
+  number = number * 10 + static_cast<unsigned int>(label_name[i] - '0');
+ }
+ if(label != nullptr) *label = canonicalLabel(number,label_name[0] == 'c');
+ return true;
+}
+
+
 bool parse_tensor(const std::string & tensor,        //in: tensor as a string
                   std::string & tensor_name,         //out: tensor name
                   std::vector<IndexLabel> & indices, //out: tensor indices (labels)
@@ -134,6 +163,80 @@ bool parse_tensor_network(const std::string & network,        //in: tensor netwo
 }
 
 
+bool parse_index_pattern(const std::string & pattern, //in: symbolic index pattern
+                         IndexModeMap & mode_map)     //out: integer form of the index pattern
+{
+ mode_map.clear();
+ std::vector<std::string> tensors;
+ if(!parse_tensor_network(pattern,tensors)) return false;
+ std::vector<std::vector<IndexLabel>> tensor_indices(tensors.size());
+ mode_map.operands.resize(tensors.size());
+ bool canonical = true;
+ for(unsigned int i = 0; i < tensors.size(); ++i){
+  auto & operand = mode_map.operands[i];
+  auto & indices = tensor_indices[i];
+  if(!parse_tensor(tensors[i],operand.name,indices,operand.conjugated)){
+   mode_map.clear();
+   return false;
+  }
+  operand.separator = -1;
+  int num_outward = 0;
+  for(const auto & index: indices){
+   if(index.direction != LegDirection::UNDIRECT) operand.separator = 0;
+   if(index.direction == LegDirection::OUTWARD) ++num_outward;
+   if(canonical) canonical = IndexModeMap::parseCanonicalLabel(index.label,nullptr);
+  }
+  if(operand.separator >= 0) operand.separator = num_outward;
+ }
+ std::unordered_map<std::string,unsigned int> labels; //label name --> label
+ for(unsigned int i = 0; i < tensors.size(); ++i){
+  auto & operand = mode_map.operands[i];
+  operand.modes.resize(tensor_indices[i].size());
+  for(unsigned int j = 0; j < tensor_indices[i].size(); ++j){
+   const auto & label_name = tensor_indices[i][j].label;
+   if(canonical){
+    auto parsed = IndexModeMap::parseCanonicalLabel(label_name,&(operand.modes[j])); assert(parsed);
+   }else{
+    auto res = labels.emplace(std::make_pair(label_name,static_cast<unsigned int>(labels.size())));
+    if(res.second) mode_map.label_names.emplace_back(label_name);
+    operand.modes[j] = res.first->second;
+   }
+  }
+ }
+ return true;
+}
+
+
+std::string assemble_index_pattern(const IndexModeMap & mode_map)
+{
+ std::string pattern;
+ const unsigned int num_tensors = mode_map.operands.size();
+ for(unsigned int i = 0; i < num_tensors; ++i){
+  const auto & operand = mode_map.operands[i];
+  if(i == 1){
+   pattern += "+=";
+  }else if(i > 1){
+   pattern += "*";
+  }
+  pattern += operand.name;
+  if(operand.conjugated) pattern += "+";
+  pattern += "(";
+  const int rank = operand.modes.size();
+  for(int j = 0; j < rank; ++j){
+   if(j == operand.separator){
+    pattern += "|";
+   }else if(j > 0){
+    pattern += ",";
+   }
+   pattern += mode_map.getLabelName(operand.modes[j]);
+  }
+  if(operand.separator >= rank && rank > 0) pattern += "|";
+  pattern += ")";
+ }
+ return pattern;
+}
+
+
 std::string assemble_symbolic_tensor(const std::string & tensor_name,         //in: tensor name
                                      const std::vector<IndexLabel> & indices, //in: tensor indices
                                      bool conjugated)
@@ -169,7 +272,7 @@ std::string assemble_symbolic_tensor_network(const std::vector<std::string> & te
 bool generate_contraction_pattern(const std::vector<numerics::TensorLeg> & pattern,
                                   unsigned int left_tensor_rank,
                                   unsigned int right_tensor_rank,
-                                  std::string & symb_pattern,
+                                  IndexModeMap & mode_map,
                                   bool left_conjugated,
                                   bool right_conjugated,
                                   const std::string & dest_name,
@@ -177,103 +280,101 @@ bool generate_contraction_pattern(const std::vector<numerics::TensorLeg> & patte
                                   const std::string & right_name)
 /* pattern[left_rank + right_rank] = {left_legs + right_legs} */
 {
- const std::size_t DEFAULT_STRING_CAPACITY = 256; //string capacity reserve value
-
  assert(pattern.size() == left_tensor_rank + right_tensor_rank);
- symb_pattern.clear();
- if(pattern.empty()){ //multiplication of scalars
-  if(left_conjugated && right_conjugated){
-   symb_pattern = dest_name+"()+="+left_name+"+()*"+right_name+"+()";
-  }else if(left_conjugated && !right_conjugated){
-   symb_pattern = dest_name+"()+="+left_name+"+()*"+right_name+"()";
-  }else if(!left_conjugated && right_conjugated){
-   symb_pattern = dest_name+"()+="+left_name+"()*"+right_name+"+()";
-  }else{
-   symb_pattern = dest_name+"()+="+left_name+"()*"+right_name+"()";
-  }
- }else{ //at least one tensor is present
-  if(symb_pattern.capacity() < DEFAULT_STRING_CAPACITY) symb_pattern.reserve(DEFAULT_STRING_CAPACITY);
-  unsigned int dest_indices[left_tensor_rank + right_tensor_rank];
+ mode_map.label_names.clear();
+ mode_map.operands.resize(3);
+ auto & dest = mode_map.operands[0];
+ auto & left = mode_map.operands[1];
+ auto & right = mode_map.operands[2];
+ dest.name = dest_name; dest.conjugated = false; dest.separator = -1; dest.modes.clear();
+ left.name = left_name; left.conjugated = left_conjugated; left.separator = -1; left.modes.clear();
+ right.name = right_name; right.conjugated = right_conjugated; right.separator = -1; right.modes.clear();
+ if(!pattern.empty()){ //at least one tensor is present
+  std::vector<unsigned int> dest_indices(left_tensor_rank + right_tensor_rank);
   unsigned int dest_tensor_rank = 0;
   for(const auto & leg: pattern){
    if(leg.getTensorId() == 0){
     dest_indices[leg.getDimensionId()] = dest_tensor_rank++;
    }
   }
-  symb_pattern.append(dest_name+"(");
+  dest.modes.reserve(dest_tensor_rank);
   for(unsigned int i = 0; i < dest_tensor_rank; ++i){
-   symb_pattern.append("u"+std::to_string(dest_indices[i])+",");
-  }
-  if(symb_pattern[symb_pattern.size()-1] == ','){
-   symb_pattern.replace(symb_pattern.size()-1,1,")");
-  }else{
-   symb_pattern.append(")");
-  }
-  if(left_conjugated){
-   symb_pattern.append("+="+left_name+"+(");
-  }else{
-   symb_pattern.append("+="+left_name+"(");
+   dest.modes.emplace_back(IndexModeMap::canonicalLabel(dest_indices[i],false));
   }
+  left.modes.reserve(left_tensor_rank);
   dest_tensor_rank = 0;
   unsigned int contr_ind = 0;
   for(unsigned int i = 0; i < left_tensor_rank; ++i){
    if(pattern[i].getTensorId() == 0){
     dest_indices[i] = left_tensor_rank;
-    symb_pattern.append("u"+std::to_string(dest_tensor_rank++)+",");
+    left.modes.emplace_back(IndexModeMap::canonicalLabel(dest_tensor_rank++,false));
    }else{
     dest_indices[i] = contr_ind;
-    symb_pattern.append("c"+std::to_string(contr_ind++)+",");
+    left.modes.emplace_back(IndexModeMap::canonicalLabel(contr_ind++,true));
    }
   }
-  if(symb_pattern[symb_pattern.size()-1] == ','){
-   symb_pattern.replace(symb_pattern.size()-1,1,")");
-  }else{
-   symb_pattern.append(")");
-  }
-  if(right_conjugated){
-   symb_pattern.append("*"+right_name+"+(");
-  }else{
-   symb_pattern.append("*"+right_name+"(");
-  }
+  right.modes.reserve(right_tensor_rank);
   for(unsigned int i = left_tensor_rank; i < left_tensor_rank + right_tensor_rank; ++i){
    if(pattern[i].getTensorId() == 0){
-    symb_pattern.append("u"+std::to_string(dest_tensor_rank++)+",");
+    right.modes.emplace_back(IndexModeMap::canonicalLabel(dest_tensor_rank++,false));
    }else{
     contr_ind = dest_indices[pattern[i].getDimensionId()];
     assert(contr_ind < left_tensor_rank);
-    symb_pattern.append("c"+std::to_string(contr_ind)+",");
+    right.modes.emplace_back(IndexModeMap::canonicalLabel(contr_ind,true));
    }
   }
-  if(symb_pattern[symb_pattern.size()-1] == ','){
-   symb_pattern.replace(symb_pattern.size()-1,1,")");
-  }else{
-   symb_pattern.append(")");
-  }
  }
+ return true;
+}
+
+
+bool generate_contraction_pattern(const std::vector<numerics::TensorLeg> & pattern,
+                                  unsigned int left_tensor_rank,
+                                  unsigned int right_tensor_rank,
+                                  std::string & symb_pattern,
+                                  bool left_conjugated,
+                                  bool right_conjugated,
+                                  const std::string & dest_name,
+                                  const std::string & left_name,
+                                  const std::string & right_name)
+{
+ IndexModeMap mode_map;
+ auto generated = generate_contraction_pattern(pattern,left_tensor_rank,right_tensor_rank,mode_map,
+                                               left_conjugated,right_conjugated,dest_name,left_name,right_name);
+ if(generated) symb_pattern = assemble_index_pattern(mode_map);
  /*{//DEBUG:
   std::cout << std::endl;
   for(const auto & leg: pattern) leg.printIt();
   std::cout << " " << symb_pattern << std::endl;
  }*/
- return true;
+ return generated;
 }
 
 
 bool generate_addition_pattern(const std::vector<numerics::TensorLeg> & pattern,
-                               std::string & symb_pattern,
+                               IndexModeMap & mode_map,
                                bool conjugated,
                                const std::string & dest_name,
                                const std::string & left_name)
 /* pattern[left_rank] = {left_legs} */
 {
  unsigned int rank = pattern.size();
- auto generated = generate_contraction_pattern(pattern,rank,0,symb_pattern,
+ auto generated = generate_contraction_pattern(pattern,rank,0,mode_map,
                                                conjugated,false,dest_name,left_name);
- if(generated){
-  auto pos = symb_pattern.rfind("*R()");
-  generated = (pos != std::string::npos);
-  if(generated) symb_pattern.erase(pos);
- }
+ if(generated) mode_map.operands.pop_back(); //remove the empty right tensor
+ return generated;
+}
+
+
+bool generate_addition_pattern(const std::vector<numerics::TensorLeg> & pattern,
+                               std::string & symb_pattern,
+                               bool conjugated,
+                               const std::string & dest_name,
+                               const std::string & left_name)
+{
+ IndexModeMap mode_map;
+ auto generated = generate_addition_pattern(pattern,mode_map,conjugated,dest_name,left_name);
+ if(generated) symb_pattern = assemble_index_pattern(mode_map);
  //if(generated) std::cout << symb_pattern << std::endl; //debug
  return generated;
 }
@@ -281,7 +382,7 @@ bool generate_addition_pattern(const std::vector<numerics::TensorLeg> & pattern,
 
 /* Generates the trivial tensor addition pattern. */
 bool generate_addition_pattern(unsigned int tensor_rank,
-                               std::string & symb_pattern,
+                               IndexModeMap & mode_map,
                                bool conjugated,
                                const std::string & dest_name,
                                const std::string & left_name)
@@ -289,7 +390,20 @@ bool generate_addition_pattern(unsigned int tensor_rank,
  std::vector<numerics::TensorLeg> pattern(tensor_rank);
  unsigned int dim = 0;
  for(auto & leg: pattern) leg = numerics::TensorLeg(0,dim++);
- return generate_addition_pattern(pattern,symb_pattern,conjugated,dest_name,left_name);
+ return generate_addition_pattern(pattern,mode_map,conjugated,dest_name,left_name);
+}
+
+
+bool generate_addition_pattern(unsigned int tensor_rank,
+                               std::string & symb_pattern,
+                               bool conjugated,
+                               const std::string & dest_name,
+                               const std::string & left_name)
+{
+ IndexModeMap mode_map;
+ auto generated = generate_addition_pattern(tensor_rank,mode_map,conjugated,dest_name,left_name);
+ if(generated) symb_pattern = assemble_index_pattern(mode_map);
+ return generated;
 }
 
 } //namespace exatn
@@ -1,5 +1,5 @@
 /** ExaTN: Numerics: Symbolic tensor processing
-REVISION: 2020/06/25
+REVISION: 2020/09/26
 
 Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle)
@@ -28,6 +28,13 @@ Rationale:
     (a) <OutputTensor> = <InputTensor> * <InputTensor> * ... * <InputTensor>
     (b) <OutputTensor> += <InputTensor> * <InputTensor> * ... * <InputTensor>
     The number of tensors on the right-hand side is one or more.
+(c) The integer form of a symbolic index pattern (index mode map) stores the symbolic
+    tensors of the pattern (output tensor first) with their index labels being small
+    integers. Equal integer labels denote the same index. Canonical labels, produced by
+    the index pattern generators, are printed as u<k> (uncontracted, label 2k) and c<k>
+    (contracted, label 2k+1); other labels keep their names in the label table.
+    The integer form is the one stored in tensor operations, the string form
+    is assembled from it on demand.
 **/
 
 #ifndef EXATN_TENSOR_SYMBOL_HPP_
@@ -48,6 +55,50 @@ typedef struct{
  LegDirection direction; //index variance (leg direction)
 } IndexLabel;
 
+//Integer form of a symbolic index pattern (index mode map):
+struct IndexModeMap{
+
+ //Symbolic tensor of the index pattern:
+ struct Operand{
+  std::string name;                //tensor name
+  bool conjugated;                 //complex conjugation status
+  int separator;                   //number of indices preceding the "|" separator (-1: no separator)
+  std::vector<unsigned int> modes; //integer index labels of the tensor dimensions
+ };
+
+ std::vector<Operand> operands;        //symbolic tensors (element #0 is the output tensor)
+ std::vector<std::string> label_names; //label names (label --> name), empty for canonical labels
+
+ /** Returns TRUE if the index mode map is empty (no index pattern). **/
+ inline bool empty() const {return operands.empty();}
+
+ /** Clears the index mode map. **/
+ inline void clear() {operands.clear(); label_names.clear();}
+
+ /** Returns TRUE if the index labels are canonical. **/
+ inline bool isCanonical() const {return label_names.empty();}
+
+ /** Returns the printable name of an index label. **/
+ std::string getLabelName(unsigned int label) const;
+
+ /** Returns the canonical index label: u<number> or c<number>. **/
+ static inline unsigned int canonicalLabel(unsigned int number, bool contracted)
+ {
+  return ((number << 1) | (contracted ? 1U : 0U));
+ }
+
+ /** Returns TRUE if the canonical index label is a contracted index c<number>. **/
+ static inline bool isContractedLabel(unsigned int label) {return ((label & 1U) != 0);}
+
+ /** Returns the number of the canonical index label. **/
+ static inline unsigned int getLabelNumber(unsigned int label) {return (label >> 1);}
+
+ /** Converts a label name u<number> or c<number> into the canonical index label.
+     Returns FALSE if the label name is not in the canonical form. **/
+ static bool parseCanonicalLabel(const std::string & label_name,
+                                 unsigned int * label);
+};
+
 inline bool is_letter(const char & ch){
  return ((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z'));
 }
@@ -144,6 +195,16 @@ bool parse_tensor(const std::string & tensor,        //in: tensor as a string
 bool parse_tensor_network(const std::string & network,         //in: tensor network as a string
                           std::vector<std::string> & tensors); //out: parsed (symbolic) tensors
 
+/** Returns TRUE if the symbolic index pattern (symbolic tensor network) parses
+    into the integer form. Index labels are converted to the canonical form if
+    all of them are canonical, otherwise they are numbered in the order of their
+    first appearance while their names are kept in the label table. **/
+bool parse_index_pattern(const std::string & pattern,  //in: symbolic index pattern
+                         IndexModeMap & mode_map);     //out: integer form of the index pattern
+
+/** Assembles the symbolic index pattern from its integer form. **/
+std::string assemble_index_pattern(const IndexModeMap & mode_map);
+
 /** Assembles a symbolic indexed tensor specification from its parts. **/
 std::string assemble_symbolic_tensor(const std::string & tensor_name,         //in: tensor name
                                      const std::vector<IndexLabel> & indices, //in: tensor indices
@@ -170,6 +231,17 @@ bool generate_contraction_pattern(const std::vector<numerics::TensorLeg> & patte
                                   const std::string & left_name = "L",
                                   const std::string & right_name = "R");
 
+/** Generates the integer form of the symbolic tensor contraction pattern (see above). **/
+bool generate_contraction_pattern(const std::vector<numerics::TensorLeg> & pattern,
+                                  unsigned int left_tensor_rank,
+                                  unsigned int right_tensor_rank,
+                                  IndexModeMap & mode_map,
+                                  bool left_conjugated = false,
+                                  bool right_conjugated = false,
+                                  const std::string & dest_name = "D",
+                                  const std::string & left_name = "L",
+                                  const std::string & right_name = "R");
+
 /** Generates symbolic tensor addition pattern from the digital tensor addition pattern:
      pattern[0..m-1] describes connectivity of dimensions of the left tensor,
       where m is the rank of the left tensor.
@@ -181,6 +253,13 @@ bool generate_addition_pattern(const std::vector<numerics::TensorLeg> & pattern,
                                const std::string & dest_name = "D",
                                const std::string & left_name = "L");
 
+/** Generates the integer form of the symbolic tensor addition pattern (see above). **/
+bool generate_addition_pattern(const std::vector<numerics::TensorLeg> & pattern,
+                               IndexModeMap & mode_map,
+                               bool conjugated = false,
+                               const std::string & dest_name = "D",
+                               const std::string & left_name = "L");
+
 /** Generates the trivial tensor addition pattern. **/
 bool generate_addition_pattern(unsigned int tensor_rank,
                                std::string & symb_pattern,
@@ -188,6 +267,13 @@ bool generate_addition_pattern(unsigned int tensor_rank,
                                const std::string & dest_name = "D",
                                const std::string & left_name = "L");
 
+/** Generates the integer form of the trivial tensor addition pattern. **/
+bool generate_addition_pattern(unsigned int tensor_rank,
+                               IndexModeMap & mode_map,
+                               bool conjugated = false,
+                               const std::string & dest_name = "D",
+                               const std::string & left_name = "L");
+
 } //namespace exatn
 
 #endif //EXATN_TENSOR_SYMBOL_HPP_
@@ -1,14 +1,62 @@
 #include <gtest/gtest.h>
 #include "exatn.hpp"
+#include "flat_tensor_network.hpp"
+#include "sliced_execution_template.hpp"
+#include "environment_cache.hpp"
+#include "truncated_svd.hpp"
+#include "mps_zipper.hpp"
 
 #include <iostream>
+#include <fstream>
+#include <unordered_set>
 #include <utility>
+#include <algorithm>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
 
 #include <assert.h>
 
 using namespace exatn;
 using namespace exatn::numerics;
 
+/** Builds the MPS closure of a given number of sites (at least 2) with a 2-body Hamiltonian
+    applied to sites 0 and 1, for example (3 sites):
+    Z0() = T0(p0,k1) * T1(k1,p1,k2) * T2(k2,p2) * H0(p0,p1,q0,q1) * S0(q0,b1) * S1(b1,q1,b2) * S2(b2,p2) **/
+static TensorNetwork makeMPSClosure(DimExtent bond_dim,          //in: MPS bond dimension
+                                    unsigned int num_sites = 3) //in: number of MPS sites
+{
+ assert(num_sites >= 2);
+ std::map<std::string,std::shared_ptr<Tensor>> tensors{{"Z0",std::make_shared<Tensor>("Z0")},
+                                                       {"H0",std::make_shared<Tensor>("H0",TensorShape{2,2,2,2})}};
+ std::string ket, bra;
+ for(unsigned int site = 0; site < num_sites; ++site){
+  const auto n = std::to_string(site);
+  const auto phys = (site < 2) ? ("q" + n) : ("p" + n); //bra physical index (acted upon by the Hamiltonian)
+  std::vector<DimExtent> extents{2};
+  std::string ket_legs = "p" + n, bra_legs = phys;
+  if(site > 0){
+   extents.insert(extents.begin(),bond_dim);
+   ket_legs = "k" + n + "," + ket_legs;
+   bra_legs = "b" + n + "," + bra_legs;
+  }
+  if(site < num_sites - 1){
+   extents.emplace_back(bond_dim);
+   ket_legs += ",k" + std::to_string(site + 1);
+   bra_legs += ",b" + std::to_string(site + 1);
+  }
+  tensors["T" + n] = std::make_shared<Tensor>("T" + n,TensorShape(extents));
+  tensors["S" + n] = std::make_shared<Tensor>("S" + n,TensorShape(extents));
+  ket += " * T" + n + "(" + ket_legs + ")";
+  bra += " * S" + n + "(" + bra_legs + ")";
+ }
+ return TensorNetwork("{0,1} " + std::to_string(num_sites) + "-site MPS closure",
+                      "Z0() =" + ket.substr(2) + " * H0(p0,p1,q0,q1)" + bra,
+                      tensors);
+}
+
+
 TEST(NumericsTester, checkSimple)
 {
  {
@@ -130,6 +178,204 @@ TEST(NumericsTester, checkSharedTensorNetworkSymbolic)
 }
 
 
+TEST(NumericsTester, checkContractionSeqRefinement)
+{
+ //3-site MPS closure with 2-body Hamiltonian applied to sites 0 and 1:
+ auto network = makeMPSClosure(8);
+ ContrSeqRefinementInfo refinement_info;
+ double flops = network.determineContractionSequence("dummy",true,&refinement_info);
+ std::cout << "Refined FMA flop count: " << refinement_info.original_flops << " -> " << refinement_info.refined_flops
+           << " in " << refinement_info.time << " sec" << std::endl;
+ EXPECT_LE(refinement_info.refined_flops,refinement_info.original_flops);
+ EXPECT_EQ(flops,refinement_info.refined_flops);
+ EXPECT_EQ(network.exportContractionSequence().size(),6);
+}
+
+
+TEST(NumericsTester, checkContractionSeqTreewidth)
+{
+ //3-site MPS closure with 2-body Hamiltonian applied to sites 0 and 1:
+ auto network = makeMPSClosure(8);
+ ContractionSeqOptimizerTreewidth::resetTimeBudget(0.1);
+ double flops = network.determineContractionSequence("treewidth");
+ double width = ContractionSeqOptimizerTreewidth::getContractionWidth();
+ ContractionSeqOptimizerTreewidth::resetTimeBudget(ContractionSeqOptimizerTreewidth::DEFAULT_TIME_BUDGET);
+ std::cout << "Tree decomposition: FMA flop count = " << flops << "; Contraction width = " << width << std::endl;
+ EXPECT_GT(flops,0.0);
+ EXPECT_LE(width,8.0);
+ EXPECT_EQ(network.exportContractionSequence().size(),6);
+ //Trace legs contribute to the volume of the input tensor:
+ TensorNetwork traced("Traced","Z0(c) = A(a,a,b) * B(b,c)",
+                      std::map<std::string,std::shared_ptr<Tensor>>{
+                       {"Z0",std::make_shared<Tensor>("Z0",TensorShape{2})},
+                       {"A",std::make_shared<Tensor>("A",TensorShape{4,4,8})},
+                       {"B",std::make_shared<Tensor>("B",TensorShape{8,2})}
+                      }
+                     );
+ EXPECT_NEAR(traced.determineContractionSequence("treewidth"),4.0*8.0*2.0,1e-9);
+ //Trace legs of the traced tensor make it expensive to contract early:
+ TensorNetwork triangle("Triangle","Z0() = A(a,b,t,t) * B(b,c) * C(c,a)",
+                        std::map<std::string,std::shared_ptr<Tensor>>{
+                         {"Z0",std::make_shared<Tensor>("Z0")},
+                         {"A",std::make_shared<Tensor>("A",TensorShape{2,2,8,8})},
+                         {"B",std::make_shared<Tensor>("B",TensorShape{2,2})},
+                         {"C",std::make_shared<Tensor>("C",TensorShape{2,2})}
+                        }
+                       );
+ EXPECT_NEAR(triangle.determineContractionSequence("treewidth"),8.0+32.0,1e-9);
+ EXPECT_NEAR(ContractionSeqOptimizerTreewidth::getContractionWidth(),2.0,1e-9);
+ const auto & triangle_seq = triangle.exportContractionSequence();
+ EXPECT_EQ(triangle_seq.size(),2);
+ EXPECT_EQ(triangle_seq.back().result_id,0);
+ EXPECT_TRUE(triangle_seq.back().left_id == 1 || triangle_seq.back().right_id == 1); //traced tensor A is contracted last
+ //Circuit-like closed 2D grids of L x L tensors with bond dimension 2:
+ for(unsigned int L = 3; L <= 4; ++L){
+  std::map<std::string,std::shared_ptr<Tensor>> tensors{{"Z0",std::make_shared<Tensor>("Z0")}};
+  std::string spec;
+  for(unsigned int r = 0; r < L; ++r){
+   for(unsigned int c = 0; c < L; ++c){
+    const auto rc = std::to_string(r) + std::to_string(c);
+    std::string legs;
+    if(r > 0) legs += ",v" + std::to_string(r-1) + std::to_string(c);
+    if(c > 0) legs += ",h" + std::to_string(r) + std::to_string(c-1);
+    if(c < L - 1) legs += ",h" + rc;
+    if(r < L - 1) legs += ",v" + rc;
+    tensors["G" + rc] = std::make_shared<Tensor>("G" + rc,TensorShape(std::vector<DimExtent>(std::count(legs.cbegin(),legs.cend(),','),2)));
+    spec += " * G" + rc + "(" + legs.substr(1) + ")";
+   }
+  }
+  TensorNetwork grid("Grid","Z0() =" + spec.substr(2),tensors);
+  TensorNetwork greedy(grid);
+  ContractionSeqOptimizerTreewidth::resetTimeBudget(0.1);
+  flops = grid.determineContractionSequence("treewidth");
+  width = ContractionSeqOptimizerTreewidth::getContractionWidth();
+  ContractionSeqOptimizerTreewidth::resetTimeBudget(ContractionSeqOptimizerTreewidth::DEFAULT_TIME_BUDGET);
+  double greedy_flops = greedy.determineContractionSequence("greed");
+  std::cout << "Grid " << L << "x" << L << ": Tree decomposition: FMA flop count = " << flops
+            << "; Contraction width = " << width << "; Greedy FMA flop count = " << greedy_flops << std::endl;
+  EXPECT_NEAR(width,4.0,1e-9); //minimal contraction width of both grids (exhaustive search over contraction trees)
+  EXPECT_LE(flops,greedy_flops);
+  EXPECT_EQ(grid.exportContractionSequence().size(),L*L-1);
+ }
+}
+
+
+TEST(NumericsTester, checkContractionPlanCache)
+{
+ //3-site MPS closure with 2-body Hamiltonian applied to sites 0 and 1:
+ auto network = makeMPSClosure(4);
+ //Same tensor network with renamed tensors and indices listed in a different order:
+ TensorNetwork renamed("Renamed 3-site MPS closure",
+                       "R() = B2(x,y) * A1(u,v,w) * H(s,v,p,q) * B0(p,r) * A0(s,u) * B1(r,q,x) * A2(w,y)",
+                       std::map<std::string,std::shared_ptr<Tensor>>{
+                        {"R",std::make_shared<Tensor>("R")},
+                        {"A0",std::make_shared<Tensor>("A0",TensorShape{2,4})},
+                        {"A1",std::make_shared<Tensor>("A1",TensorShape{4,2,4})},
+                        {"A2",std::make_shared<Tensor>("A2",TensorShape{4,2})},
+                        {"H",std::make_shared<Tensor>("H",TensorShape{2,2,2,2})},
+                        {"B0",std::make_shared<Tensor>("B0",TensorShape{2,4})},
+                        {"B1",std::make_shared<Tensor>("B1",TensorShape{4,2,4})},
+                        {"B2",std::make_shared<Tensor>("B2",TensorShape{4,2})}
+                       }
+                      );
+ EXPECT_EQ(ContractionPlanCache::computeStructuralHash(network),ContractionPlanCache::computeStructuralHash(renamed));
+ double flops = network.determineContractionSequence("greed");
+ std::remove("exatn_contr_plans.test");
+ {
+  ContractionPlanCache plan_cache("exatn_contr_plans.test");
+  EXPECT_TRUE(plan_cache.isOpen());
+  EXPECT_TRUE(plan_cache.storePlan(network));
+  EXPECT_FALSE(plan_cache.storePlan(network)); //already stored
+ }
+ ContractionPlanCache plan_cache("exatn_contr_plans.test"); //reopen
+ EXPECT_TRUE(plan_cache.retrievePlan(renamed));
+ double cached_flops = 0.0;
+ EXPECT_EQ(renamed.exportContractionSequence(&cached_flops).size(),network.exportContractionSequence().size());
+ EXPECT_EQ(cached_flops,flops);
+ //Tensor networks which only differ in dimension extents must not share the contraction plan:
+ auto make_chain = [](DimExtent bond_dim){
+  return TensorNetwork("Chain","Z(a,d) = A(a,b) * B(b,c) * C(c,d)",
+                       std::map<std::string,std::shared_ptr<Tensor>>{
+                        {"Z",std::make_shared<Tensor>("Z",TensorShape{2,2})},
+                        {"A",std::make_shared<Tensor>("A",TensorShape(std::vector<DimExtent>{2,bond_dim}))},
+                        {"B",std::make_shared<Tensor>("B",TensorShape(std::vector<DimExtent>{bond_dim,bond_dim}))},
+                        {"C",std::make_shared<Tensor>("C",TensorShape(std::vector<DimExtent>{bond_dim,2}))}
+                       }
+                      );
+ };
+ auto chain64 = make_chain(64), chain65 = make_chain(65);
+ EXPECT_NE(ContractionPlanCache::computeStructuralHash(chain64),ContractionPlanCache::computeStructuralHash(chain65));
+ chain64.determineContractionSequence("greed");
+ EXPECT_TRUE(plan_cache.storePlan(chain64));
+ EXPECT_FALSE(plan_cache.retrievePlan(chain65));
+ //Canonical structure does not depend on the tensor ids (equivalent tensors in non-isomorphic rings):
+ auto make_rings = [](bool ring3_first){
+  const std::string ring3("A(a,b) * B(b,c) * C(c,a)"), ring4("D(d,e) * E(e,f) * F(f,g) * G(g,d)");
+  std::map<std::string,std::shared_ptr<Tensor>> tensors{{"Z",std::make_shared<Tensor>("Z")}};
+  for(const auto & name: {"A","B","C","D","E","F","G"}) tensors[name] = std::make_shared<Tensor>(name,TensorShape{2,2});
+  return TensorNetwork("Rings","Z() = " + (ring3_first ? (ring3 + " * " + ring4) : (ring4 + " * " + ring3)),tensors);
+ };
+ std::vector<std::uint64_t> structure1, structure2;
+ EXPECT_EQ(ContractionPlanCache::computeStructuralHash(make_rings(true),nullptr,&structure1),
+           ContractionPlanCache::computeStructuralHash(make_rings(false),nullptr,&structure2));
+ EXPECT_TRUE(structure1 == structure2);
+ //A corrupted record (zero length) must drop the cache instead of hanging the record scan:
+ {
+  std::fstream cache_file("exatn_contr_plans.test",std::ios::in|std::ios::out|std::ios::binary);
+  const std::uint64_t zero_length = 0;
+  cache_file.seekp(4*sizeof(std::uint64_t)); //first record right after the file header
+  cache_file.write(reinterpret_cast<const char*>(&zero_length),sizeof(zero_length));
+ }
+ ContractionPlanCache corrupted_cache("exatn_contr_plans.test");
+ EXPECT_TRUE(corrupted_cache.isOpen());
+ EXPECT_FALSE(corrupted_cache.retrievePlan(renamed));
+ EXPECT_FALSE(corrupted_cache.isOpen());
+ EXPECT_FALSE(plan_cache.storePlan(network));
+ EXPECT_FALSE(plan_cache.isOpen());
+ std::remove("exatn_contr_plans.test");
+}
+
+
+TEST(NumericsTester, checkContractionCostModel)
+{
+ //Synthetic calibration: Skinny GEMMs are slow, permutations cost one element per nanosecond:
+ ContractionCostModel cost_model;
+ for(unsigned int lm = 0; lm <= 12; lm += 4){
+  for(unsigned int ln = 0; ln <= 12; ln += 4){
+   for(unsigned int lk = 0; lk <= 12; lk += 4){
+    const double m = std::pow(2.0,lm), n = std::pow(2.0,ln), k = std::pow(2.0,lk);
+    const double efficiency = std::min(std::min(m,n),k) / 4096.0;
+    cost_model.appendGemmSample(m,n,k,(m*n*k)/(1e12*std::max(efficiency,1e-3)));
+   }
+  }
+ }
+ for(unsigned int rank = 2; rank <= 8; ++rank) cost_model.appendPermutationSample(rank,1e6,1e-3);
+ EXPECT_TRUE(cost_model.finalize());
+ EXPECT_GT(cost_model.predictGemmTime(16.0,4096.0,4096.0),cost_model.predictGemmTime(1024.0,1024.0,1024.0));
+ const char * tmp_dir = std::getenv("TMPDIR");
+ const std::string file_name = std::string((tmp_dir != nullptr) ? tmp_dir : "/tmp") + "/exatn_contraction_cost_model.test";
+ EXPECT_TRUE(cost_model.saveToFile(file_name));
+ auto loaded_model = std::make_shared<ContractionCostModel>();
+ EXPECT_TRUE(loaded_model->loadFromFile(file_name));
+ std::remove(file_name.c_str());
+ EXPECT_EQ(loaded_model->getPeakThroughput(),cost_model.getPeakThroughput());
+ std::vector<double> samples;
+ cost_model.packSamples(samples);
+ ContractionCostModel unpacked_model;
+ EXPECT_TRUE(unpacked_model.unpackSamples(samples));
+ EXPECT_EQ(unpacked_model.getPeakThroughput(),cost_model.getPeakThroughput());
+ //Contraction sequence optimization under the calibrated cost model:
+ auto network = makeMPSClosure(64); //3-site MPS closure
+ ContractionCostModel::activate(loaded_model);
+ double flops = network.determineContractionSequence("greed");
+ ContractionCostModel::deactivate();
+ std::cout << "FMA flop count under the calibrated cost model: " << flops << std::endl;
+ EXPECT_GT(flops,0.0);
+ EXPECT_EQ(network.exportContractionSequence().size(),6);
+ EXPECT_TRUE(ContractionCostModel::getActive() == nullptr);
+}
+
+
 TEST(NumericsTester, checkTensorExpansion)
 {
  //Building an MPS tensor network with 8 sites and max bond dimension of 6:
@@ -195,6 +441,910 @@ TEST(NumericsTester, checkTensorExpansion)
 }
 
 
+TEST(NumericsTester, checkTensorExpansionPlan)
+{
+ //Building an MPS tensor network with 8 sites and max bond dimension of 8:
+ auto & network_build_factory = *(numerics::NetworkBuildFactory::get());
+ auto builder = network_build_factory.createNetworkBuilderShared("MPS");
+ auto success = builder->setParameter("max_bond_dim",8); assert(success);
+ auto output_tensor = makeSharedTensor("Z0",std::vector<DimExtent>{2,2,2,2,2,2,2,2});
+ auto network = makeSharedTensorNetwork("TensorTrain",output_tensor,*builder);
+
+ //Hamiltonian with seven nearest-neighbor 2-body components:
+ TensorOperator ham("Hamiltonian");
+ for(unsigned int i = 0; i < 7; ++i){
+  ham.appendComponent(std::make_shared<Tensor>("H"+std::to_string(i),TensorShape{2,2,2,2}),
+                      {{i,2},{i+1,3}},{{i,0},{i+1,1}},std::complex<double>{1.0});
+ }
+
+ //Expectation value expansion <bra|ham|ket>:
+ TensorExpansion ket_vector;
+ ket_vector.appendComponent(network,std::complex<double>{1.0});
+ TensorExpansion oper_times_ket(ket_vector,ham);
+ TensorExpansion bra_vector(ket_vector);
+ bra_vector.conjugate();
+ TensorExpansion expectation(bra_vector,oper_times_ket);
+
+ //Combined evaluation plan with shared intermediates computed once:
+ TensorExpansionPlan plan(expectation,"greed");
+ std::cout << "Combined evaluation plan: FMA flop count = " << plan.getFMAFlops()
+           << "; Saved FMA flop count = " << plan.getSavedFMAFlops()
+           << " (" << plan.getNumSharedIntermediates() << " shared intermediates)" << std::endl;
+ double total_flops = 0.0;
+ for(auto component = expectation.begin(); component != expectation.end(); ++component){
+  double flops = 0.0;
+  component->network_->exportContractionSequence(&flops);
+  total_flops += flops;
+ }
+ EXPECT_GT(plan.getSavedFMAFlops(),0.0);
+ EXPECT_GT(plan.getNumSharedIntermediates(),0);
+ EXPECT_NEAR(plan.getFMAFlops() + plan.getSavedFMAFlops(),total_flops,1e-6*total_flops);
+ unsigned int num_created = 0, num_destroyed = 0;
+ std::unordered_set<std::string> intermediate_names; //intermediates of different components must have unique names
+ for(const auto & op: plan.getOperationList()){
+  if(op->getOpcode() == TensorOpCode::CREATE){
+   ++num_created;
+   intermediate_names.emplace(op->getTensorOperand(0)->getName());
+  }
+  if(op->getOpcode() == TensorOpCode::DESTROY) ++num_destroyed;
+ }
+ EXPECT_EQ(num_created,num_destroyed);
+ EXPECT_EQ(intermediate_names.size(),num_created);
+}
+
+
+TEST(NumericsTester, checkMPSZipper)
+{
+ //Building an MPS tensor network with 8 sites and max bond dimension of 16:
+ auto & network_build_factory = *(numerics::NetworkBuildFactory::get());
+ auto builder = network_build_factory.createNetworkBuilderShared("MPS");
+ auto success = builder->setParameter("max_bond_dim",16); assert(success);
+ auto output_tensor = makeSharedTensor("Z0",std::vector<DimExtent>{2,2,2,2,2,2,2,2});
+ auto network = makeSharedTensorNetwork("TensorTrain",output_tensor,*builder);
+
+ //Hamiltonian with seven nearest-neighbor 2-body components and eight 1-body components:
+ TensorOperator ham("Hamiltonian");
+ for(unsigned int i = 0; i < 7; ++i){
+  ham.appendComponent(std::make_shared<Tensor>("H"+std::to_string(i),TensorShape{2,2,2,2}),
+                      {{i,2},{i+1,3}},{{i,0},{i+1,1}},std::complex<double>{1.0});
+ }
+ for(unsigned int i = 0; i < 8; ++i){
+  ham.appendComponent(std::make_shared<Tensor>("U"+std::to_string(i),TensorShape{2,2}),
+                      {{i,1}},{{i,0}},std::complex<double>{1.0});
+ }
+
+ TensorExpansion ket_vector;
+ ket_vector.appendComponent(network,std::complex<double>{1.0});
+ TensorExpansion bra_vector(ket_vector);
+ bra_vector.conjugate();
+
+ //Zipper contraction sequences for the expectation value <bra|ham|ket>:
+ MPSZipper zipper(bra_vector,ket_vector,ham);
+ EXPECT_TRUE(zipper.isApplicable());
+ EXPECT_EQ(zipper.getNumSites(),8);
+ auto & expectation = zipper.getExpansion();
+ EXPECT_EQ(expectation.getNumComponents(),15);
+ for(auto component = expectation.begin(); component != expectation.end(); ++component){
+  const auto & contr_seq = component->network_->exportContractionSequence();
+  EXPECT_EQ(contr_seq.size(),component->network_->getNumTensors() - 1);
+  EXPECT_EQ(contr_seq.back().result_id,0);
+ }
+
+ //Generic contraction sequences for comparison:
+ TensorExpansion generic(bra_vector,ket_vector,ham);
+ double generic_flops = 0.0;
+ for(auto component = generic.begin(); component != generic.end(); ++component){
+  generic_flops += component->network_->determineContractionSequence("greed");
+ }
+ std::cout << "MPS zipper: FMA flop count = " << zipper.getFMAFlops()
+           << " versus " << generic_flops << " (greedy)" << std::endl;
+ EXPECT_LE(zipper.getFMAFlops(),generic_flops * (1.0 + 1e-6));
+
+ //The environments of the sites not acted upon by the operator are shared by all operator terms:
+ TensorExpansionPlan plan(expectation);
+ std::cout << "MPS zipper combined plan: FMA flop count = " << plan.getFMAFlops()
+           << "; Saved FMA flop count = " << plan.getSavedFMAFlops()
+           << " (" << plan.getNumSharedIntermediates() << " shared intermediates)" << std::endl;
+ EXPECT_GT(plan.getNumSharedIntermediates(),0);
+ EXPECT_NEAR(plan.getFMAFlops() + plan.getSavedFMAFlops(),zipper.getFMAFlops(),1e-6*zipper.getFMAFlops());
+ EXPECT_LT(plan.getFMAFlops(),0.5 * zipper.getFMAFlops());
+
+ //A periodic matrix product state (ring) is not supported:
+ std::string ring_spec = "Z1(i0,i1,i2,i3,i4,i5,i6,i7)+=";
+ std::map<std::string,std::shared_ptr<Tensor>> ring_tensors{{"Z1",makeSharedTensor("Z1",std::vector<DimExtent>{2,2,2,2,2,2,2,2})}};
+ for(unsigned int i = 0; i < 8; ++i){
+  const auto name = "R" + std::to_string(i);
+  ring_spec += name + "(j" + std::to_string((i + 7) % 8) + ",i" + std::to_string(i) + ",j" + std::to_string(i) + ")";
+  if(i < 7) ring_spec += "*";
+  ring_tensors.emplace(name,makeSharedTensor(name,TensorShape{4,2,4}));
+ }
+ TensorExpansion ring_ket;
+ ring_ket.appendComponent(makeSharedTensorNetwork("Ring",ring_spec,ring_tensors),std::complex<double>{1.0});
+ TensorExpansion ring_bra(ring_ket);
+ ring_bra.conjugate();
+ MPSZipper ring_zipper(ring_bra,ring_ket,ham);
+ EXPECT_FALSE(ring_zipper.isApplicable());
+ EXPECT_EQ(ring_zipper.getExpansion().getNumComponents(),15);
+ for(auto component = ring_zipper.getExpansion().begin(); component != ring_zipper.getExpansion().end(); ++component){
+  EXPECT_TRUE(component->network_->exportContractionSequence().empty());
+ }
+}
+
+
+TEST(NumericsTester, checkOperatorGrouping)
+{
+ //Heisenberg-like Hamiltonian: Three 2-body terms (XX, YY, ZZ) on each of seven bonds, eight 1-body terms,
+ //the YY terms are stored with the ket and bra legs swapped, site 0 carries two 1-body terms:
+ TensorOperator ham("Heisenberg");
+ for(unsigned int i = 0; i < 7; ++i){
+  const auto bond = std::to_string(i);
+  ham.appendComponent(std::make_shared<Tensor>("XX"+bond,TensorShape{2,2,2,2}),
+                      {{i,2},{i+1,3}},{{i,0},{i+1,1}},std::complex<double>{1.0});
+  ham.appendComponent(std::make_shared<Tensor>("YY"+bond,TensorShape{2,2,2,2}),
+                      {{i,0},{i+1,1}},{{i,2},{i+1,3}},std::complex<double>{0.5});
+  ham.appendComponent(std::make_shared<Tensor>("ZZ"+bond,TensorShape{2,2,2,2}),
+                      {{i+1,3},{i,2}},{{i+1,1},{i,0}},std::complex<double>{-1.0});
+ }
+ for(unsigned int i = 0; i < 8; ++i){
+  ham.appendComponent(std::make_shared<Tensor>("Z"+std::to_string(i),TensorShape{2,2}),
+                      {{i,1}},{{i,0}},std::complex<double>{0.25});
+ }
+ ham.appendComponent(std::make_shared<Tensor>("X0",TensorShape{2,2}),
+                     {{0,1}},{{0,0}},std::complex<double>{0.75});
+ EXPECT_EQ(ham.getNumComponents(),30);
+
+ std::vector<TensorOperator::ComponentGroup> groups;
+ auto grouped = ham.groupComponents(groups);
+ EXPECT_EQ(grouped.getNumComponents(),15);
+ EXPECT_EQ(groups.size(),8);
+ for(unsigned int i = 0; i < 7; ++i){ //bond groups
+  const auto & group = groups[i];
+  EXPECT_EQ(group.members.size(),3);
+  EXPECT_EQ(group.tensor->getRank(),4);
+  EXPECT_EQ(group.members[0].tensor->getName(),"XX"+std::to_string(i));
+  EXPECT_EQ(group.members[0].dims,(std::vector<unsigned int>{2,3,0,1}));
+  EXPECT_EQ(group.members[1].dims,(std::vector<unsigned int>{0,1,2,3}));
+  EXPECT_EQ(group.members[2].dims,(std::vector<unsigned int>{2,3,0,1}));
+  EXPECT_EQ(group.members[1].coefficient,std::complex<double>(0.5));
+  const auto & component = grouped.getComponent(i);
+  EXPECT_EQ(component.network->getTensor(1)->getName(),group.tensor->getName());
+  EXPECT_EQ(component.coefficient,std::complex<double>(1.0));
+  EXPECT_EQ(component.ket_legs[0].first,i);
+  EXPECT_EQ(component.ket_legs[1].first,i+1);
+ }
+ EXPECT_EQ(groups[7].members.size(),2); //two 1-body terms on site 0
+ EXPECT_EQ(groups[7].members[1].tensor->getName(),"X0");
+ EXPECT_EQ(groups[7].members[1].coefficient,std::complex<double>(0.75));
+ EXPECT_EQ(grouped.getComponent(7).network->getTensor(1)->getName(),groups[7].tensor->getName());
+ for(unsigned int i = 1; i < 8; ++i){ //remaining 1-body terms are kept as is
+  EXPECT_EQ(grouped.getComponent(7+i).network->getTensor(1)->getName(),"Z"+std::to_string(i));
+  EXPECT_EQ(grouped.getComponent(7+i).coefficient,std::complex<double>(0.25));
+ }
+}
+
+
+TEST(NumericsTester, checkTreeBuilder)
+{
+ //Building a binary tree tensor network with 8 output modes and max bond dimension of 4:
+ auto & network_build_factory = *(numerics::NetworkBuildFactory::get());
+ auto builder = network_build_factory.createNetworkBuilderShared("Tree");
+ auto success = builder->setParameter("max_bond_dim",4); assert(success);
+ success = builder->setParameter("arity",2); assert(success);
+ success = builder->setParameter("isometric",1); assert(success);
+ auto output_tensor = makeSharedTensor("Z0",std::vector<DimExtent>{2,2,2,2,2,2,2,2});
+ auto ttn = makeSharedTensorNetwork("TreeTensorNetwork",output_tensor,*builder);
+ EXPECT_TRUE(ttn->isValid());
+ EXPECT_EQ(ttn->getNumTensors(),7);
+ EXPECT_EQ(ttn->getTensor(1)->getRank(),2); //root
+ for(unsigned int id = 2; id <= 7; ++id){
+  const auto & extents = ttn->getTensor(id)->getDimExtents();
+  EXPECT_EQ(extents.size(),3);
+  EXPECT_EQ(extents.back(),4); //bond to the parent
+  EXPECT_FALSE(ttn->getTensor(id)->retrieveIsometries().empty());
+ }
+
+ //The norm <ttn|ttn> collapses down to the root tensors:
+ TensorNetwork bra(*ttn);
+ bra.conjugate();
+ TensorNetwork norm(*ttn);
+ std::vector<std::pair<unsigned int, unsigned int>> pairings;
+ for(unsigned int i = 0; i < 8; ++i) pairings.emplace_back(std::make_pair(i,i));
+ success = norm.appendTensorNetwork(std::move(bra),pairings); assert(success);
+ EXPECT_EQ(norm.getNumTensors(),14);
+ EXPECT_TRUE(norm.collapseIsometries());
+ EXPECT_EQ(norm.getNumTensors(),2);
+
+ //Strongly coupled distant modes (i, i+4) end up on the same tree tensor:
+ auto tree_builder = std::dynamic_pointer_cast<NetworkBuilderTree>(
+                      network_build_factory.createNetworkBuilderShared("Tree"));
+ success = tree_builder->setParameter("max_bond_dim",4); assert(success);
+ std::vector<std::pair<unsigned int, unsigned int>> edges;
+ std::vector<double> weights;
+ for(unsigned int i = 0; i < 7; ++i){edges.emplace_back(std::make_pair(i,i+1)); weights.emplace_back(1.0);}
+ for(unsigned int i = 0; i < 4; ++i){edges.emplace_back(std::make_pair(i,i+4)); weights.emplace_back(10.0);}
+ EXPECT_FALSE(tree_builder->setModeAffinity(edges,std::vector<double>{1.0}));
+ EXPECT_TRUE(tree_builder->setModeAffinity(edges,weights));
+ auto affine_ttn = makeSharedTensorNetwork("AffineTreeTensorNetwork",output_tensor,*tree_builder);
+ EXPECT_TRUE(affine_ttn->isValid());
+ const auto * output_legs = affine_ttn->getTensorConnections(0);
+ assert(output_legs != nullptr);
+ for(unsigned int i = 0; i < 4; ++i){
+  EXPECT_EQ((*output_legs)[i].getTensorId(),(*output_legs)[i+4].getTensorId());
+ }
+}
+
+
+TEST(NumericsTester, checkPEPSBuilder)
+{
+ //Building a PEPS tensor network on a 3x4 grid (automatic grid shape) with bond dimension of 3:
+ auto & network_build_factory = *(numerics::NetworkBuildFactory::get());
+ auto builder = network_build_factory.createNetworkBuilderShared("PEPS");
+ auto success = builder->setParameter("max_bond_dim",3); assert(success);
+ long long num_rows = -1;
+ success = builder->getParameter("num_rows",&num_rows); assert(success);
+ EXPECT_EQ(num_rows,0);
+ auto output_tensor = makeSharedTensor("Z0",std::vector<DimExtent>(12,2));
+ auto peps = makeSharedTensorNetwork("PEPS",output_tensor,*builder);
+ EXPECT_TRUE(peps->isValid());
+ EXPECT_EQ(peps->getNumTensors(),12);
+ const unsigned int num_cols = 4;
+ for(unsigned int site = 0; site < 12; ++site){
+  const unsigned int row = site / num_cols, col = site % num_cols;
+  const unsigned int num_neighbors = (row > 0) + (row < 2) + (col > 0) + (col < num_cols - 1);
+  const auto & extents = peps->getTensor(site + 1)->getDimExtents();
+  EXPECT_EQ(extents.size(),num_neighbors + 1);
+  EXPECT_EQ(extents[0],2);
+  for(unsigned int i = 1; i < extents.size(); ++i) EXPECT_EQ(extents[i],3);
+  //Physical leg first, then left, up, right, down bonds:
+  const auto * legs = peps->getTensorConnections(site + 1);
+  assert(legs != nullptr);
+  EXPECT_EQ((*legs)[0].getTensorId(),0);
+  EXPECT_EQ((*legs)[0].getDimensionId(),site);
+  unsigned int previous = 0;
+  for(unsigned int i = 1; i < legs->size(); ++i){
+   const unsigned int neighbor = (*legs)[i].getTensorId() - 1;
+   const unsigned int direction = (neighbor + 1 == site) ? 0 : (neighbor + num_cols == site) ? 1 : (neighbor == site + 1) ? 2 : 3;
+   if(direction == 3) EXPECT_EQ(neighbor,site + num_cols);
+   if(i > 1) EXPECT_GT(direction,previous);
+   previous = direction;
+  }
+ }
+
+ //Explicit number of rows:
+ success = builder->setParameter("num_rows",2); assert(success);
+ auto wide_peps = makeSharedTensorNetwork("WidePEPS",output_tensor,*builder);
+ EXPECT_TRUE(wide_peps->isValid());
+ EXPECT_EQ(wide_peps->getTensor(1)->getRank(),3);  //corner
+ EXPECT_EQ(wide_peps->getTensor(2)->getRank(),4);  //edge
+ EXPECT_EQ(wide_peps->getTensor(12)->getRank(),3); //corner
+}
+
+
+TEST(NumericsTester, checkBasisVectorIndexFixing)
+{
+ //Two-qubit circuit closed by the |0> basis vectors on input:
+ auto q0 = makeSharedTensor("Q0",TensorShape{2});
+ auto q1 = makeSharedTensor("Q1",TensorShape{2});
+ auto h = makeSharedTensor("H",TensorShape{2,2});
+ auto cnot = makeSharedTensor("CNOT",TensorShape{2,2,2,2});
+ auto z = makeSharedTensor("Z",TensorShape{2,2});
+ TensorNetwork circuit("Circuit","Z(a,b)+=Q0(i)*Q1(j)*H(k,i)*CNOT(a,b,k,j)",
+                       std::map<std::string,std::shared_ptr<Tensor>>{
+                        {"Z",z},{"Q0",q0},{"Q1",q1},{"H",h},{"CNOT",cnot}});
+ EXPECT_EQ(circuit.getNumTensors(),4);
+
+ //Fix the indices projected by the basis vectors:
+ auto projections = circuit.fixBasisVectorIndices(
+  [](const Tensor & tensor, DimOffset * position){
+   *position = 0;
+   return (tensor.getName() == "Q0" || tensor.getName() == "Q1");
+  }
+ );
+ EXPECT_EQ(projections.size(),2);
+ EXPECT_EQ(circuit.getNumTensors(),2);
+ EXPECT_EQ(circuit.getRank(),2);
+ EXPECT_TRUE(circuit.isValid());
+ for(const auto & projection: projections){
+  EXPECT_EQ(projection.fixed_dims.size(),1);
+  EXPECT_EQ(projection.projected->getRank(),projection.original->getRank() - 1);
+  if(projection.original->getName() == "H") EXPECT_EQ(projection.fixed_dims[0].first,1);
+  if(projection.original->getName() == "CNOT") EXPECT_EQ(projection.fixed_dims[0].first,3);
+ }
+ //The original tensors are not affected:
+ EXPECT_EQ(h->getRank(),2);
+ EXPECT_EQ(cnot->getRank(),4);
+}
+
+
+TEST(NumericsTester, checkNetworkSimplification)
+{
+ //Two-qubit circuit with two consecutive two-qubit gates:
+ auto q0 = makeSharedTensor("Q0",TensorShape{2});
+ auto q1 = makeSharedTensor("Q1",TensorShape{2});
+ auto h = makeSharedTensor("H",TensorShape{2,2});
+ auto cnot = makeSharedTensor("CNOT",TensorShape{2,2,2,2});
+ auto cz = makeSharedTensor("CZ",TensorShape{2,2,2,2});
+ auto z = makeSharedTensor("Z",TensorShape{2,2});
+ TensorNetwork circuit("Circuit","Z(a,b)+=Q0(i)*Q1(j)*H(k,i)*CNOT(l,m,k,j)*CZ(a,b,l,m)",
+                       std::map<std::string,std::shared_ptr<Tensor>>{
+                        {"Z",z},{"Q0",q0},{"Q1",q1},{"H",h},{"CNOT",cnot},{"CZ",cz}});
+ EXPECT_EQ(circuit.getNumTensors(),5);
+
+ //Simplify a copy of the tensor network:
+ TensorNetwork simplified(circuit);
+ std::list<ContrTriple> merges;
+ double flops = 0.0;
+ auto num_removed = simplified.simplify(merges,&flops);
+ EXPECT_EQ(num_removed,3);
+ EXPECT_EQ(merges.size(),3);
+ EXPECT_EQ(simplified.getNumTensors(),2);
+ EXPECT_TRUE(simplified.isValid());
+ EXPECT_GT(flops,0.0);
+
+ //Determine the contraction sequence of the original tensor network with simplification:
+ unsigned int num_simplified = 0;
+ circuit.determineContractionSequence("metis",false,nullptr,true,&num_simplified);
+ EXPECT_EQ(num_simplified,3);
+ const auto & contr_seq = circuit.exportContractionSequence();
+ EXPECT_EQ(contr_seq.size(),4);
+ EXPECT_EQ(contr_seq.back().result_id,0);
+ auto & op_list = circuit.getOperationList();
+ EXPECT_FALSE(op_list.empty());
+}
+
+
+TEST(NumericsTester, checkTensorNetworkCopyOnWrite)
+{
+ auto q0 = makeSharedTensor("Q0",TensorShape{2});
+ auto h = makeSharedTensor("H",TensorShape{2,2});
+ auto cnot = makeSharedTensor("CNOT",TensorShape{2,2,2,2});
+ auto z = makeSharedTensor("Z",TensorShape{2,2,2});
+ TensorNetwork circuit("Circuit","Z(a,b,c)+=Q0(i)*H(k,i)*CNOT(a,b,k,c)",
+                       std::map<std::string,std::shared_ptr<Tensor>>{
+                        {"Z",z},{"Q0",q0},{"H",h},{"CNOT",cnot}});
+
+ //Copies share the tensor connection storage until modified:
+ TensorNetwork clone(circuit);
+ EXPECT_EQ(clone.getTensorConnections(3),circuit.getTensorConnections(3));
+ std::vector<TensorNetwork> clones(8,circuit);
+ for(const auto & net: clones) EXPECT_EQ(net.getTensorConnections(2),circuit.getTensorConnections(2));
+
+ //Modification of a copy does not affect the original tensor network:
+ auto merged = clone.mergeTensors(1,2,4);
+ EXPECT_TRUE(merged);
+ EXPECT_EQ(clone.getNumTensors(),2);
+ EXPECT_TRUE(clone.isValid());
+ EXPECT_EQ(circuit.getNumTensors(),3);
+ EXPECT_TRUE(circuit.isValid());
+ EXPECT_TRUE(circuit.getTensorConnections(3) != clone.getTensorConnections(3));
+ EXPECT_EQ(circuit.getTensorConnections(3)->at(2).getTensorId(),2);
+ EXPECT_EQ(clone.getTensorConnections(3)->at(2).getTensorId(),4);
+
+ //Modification of the original tensor network does not affect its copies:
+ circuit.rename("Circuit2");
+ EXPECT_TRUE(circuit.getTensor(0)->getName() != "Z");
+ EXPECT_EQ(clones[0].getTensor(0)->getName(),"Z");
+ for(const auto & net: clones) EXPECT_EQ(net.getTensorConnections(2),clones[0].getTensorConnections(2));
+}
+
+
+TEST(NumericsTester, checkFlatTensorNetwork)
+{
+ //Build a closed 2D grid tensor network with 32x32 tensors:
+ const unsigned int L = 32;
+ const DimExtent d = 2;
+ auto site = [L](unsigned int i, unsigned int j){return 1 + i*L + j;};
+ auto leg_position = [L](unsigned int a, unsigned int b, unsigned int i, unsigned int j){ //leg of site (a,b) connected to site (i,j)
+  unsigned int pos = 0;
+  if(a > 0){if(i + 1 == a) return pos; ++pos;}     //up
+  if(b > 0){if(j + 1 == b) return pos; ++pos;}     //left
+  if(b < L - 1){if(j == b + 1) return pos; ++pos;} //right
+  return pos;                                      //down
+ };
+ auto time_start = exatn::Timer::timeInSecHR();
+ TensorNetwork grid("Grid",std::make_shared<Tensor>("Grid"),std::vector<TensorLeg>{});
+ for(unsigned int i = 0; i < L; ++i){
+  for(unsigned int j = 0; j < L; ++j){
+   std::vector<std::pair<unsigned int, unsigned int>> neighbors; //neighbor sites: up, left, right, down
+   if(i > 0) neighbors.emplace_back(std::make_pair(i-1,j));
+   if(j > 0) neighbors.emplace_back(std::make_pair(i,j-1));
+   if(j < L-1) neighbors.emplace_back(std::make_pair(i,j+1));
+   if(i < L-1) neighbors.emplace_back(std::make_pair(i+1,j));
+   std::vector<TensorLeg> legs;
+   for(const auto & neighbor: neighbors){
+    legs.emplace_back(TensorLeg(site(neighbor.first,neighbor.second),
+                                leg_position(neighbor.first,neighbor.second,i,j)));
+   }
+   auto placed = grid.placeTensor(site(i,j),
+                                  std::make_shared<Tensor>("T"+std::to_string(site(i,j)),
+                                                           TensorShape(std::vector<DimExtent>(legs.size(),d))),
+                                  legs,false,false);
+   EXPECT_TRUE(placed);
+  }
+ }
+ auto finalized = grid.finalize(true);
+ EXPECT_TRUE(finalized);
+ auto duration = exatn::Timer::timeInSecHR(time_start);
+ std::cout << "Tensor network construction (" << grid.getNumTensors() << " tensors): " << duration << " sec" << std::endl;
+
+ //Build the flat layout and compare the adjacency:
+ time_start = exatn::Timer::timeInSecHR();
+ FlatTensorNetwork flat(grid);
+ duration = exatn::Timer::timeInSecHR(time_start);
+ std::cout << "Flat layout construction: " << duration << " sec" << std::endl;
+ EXPECT_EQ(flat.getNumTensors(),grid.getNumTensors());
+ auto compare = [](TensorNetwork & network, const FlatTensorNetwork & flat_network){
+  bool identical = (network.getNumTensors() == flat_network.getNumTensors());
+  for(auto iter = network.cbegin(); identical && iter != network.cend(); ++iter){
+   if(iter->first != 0){
+    const auto adjacent = network.getAdjacentTensors(iter->first);
+    const auto flat_adjacent = flat_network.getAdjacentTensors(iter->first);
+    identical = (std::vector<unsigned int>(adjacent.cbegin(),adjacent.cend()) ==
+                 std::vector<unsigned int>(flat_adjacent.begin(),flat_adjacent.end()));
+    const auto & legs = iter->second.getTensorLegs();
+    const auto leg_ids = flat_network.getLegTensorIds(iter->first);
+    const auto leg_dims = flat_network.getLegDimensionIds(iter->first);
+    identical = identical && (legs.size() == leg_ids.size());
+    for(unsigned int i = 0; identical && i < legs.size(); ++i){
+     identical = (legs[i].getTensorId() == leg_ids[i] && legs[i].getDimensionId() == leg_dims[i]);
+    }
+    identical = identical && (static_cast<double>(iter->second.getTensor()->getVolume()) == flat_network.getVolume(iter->first));
+   }
+  }
+  return identical;
+ };
+ EXPECT_TRUE(compare(grid,flat));
+
+ //Merge horizontally adjacent pairs of tensors in both layouts:
+ TensorNetwork merged(grid);
+ unsigned int result_id = merged.getMaxTensorId();
+ time_start = exatn::Timer::timeInSecHR();
+ for(unsigned int i = 0; i < L; ++i){
+  for(unsigned int j = 0; j < L; j += 2){
+   auto success = merged.mergeTensors(site(i,j),site(i,j+1),++result_id);
+   EXPECT_TRUE(success);
+  }
+ }
+ duration = exatn::Timer::timeInSecHR(time_start);
+ std::cout << "Tensor network merges: " << duration << " sec" << std::endl;
+ result_id = grid.getMaxTensorId();
+ time_start = exatn::Timer::timeInSecHR();
+ for(unsigned int i = 0; i < L; ++i){
+  for(unsigned int j = 0; j < L; j += 2){
+   auto success = flat.mergeTensors(site(i,j),site(i,j+1),++result_id);
+   EXPECT_TRUE(success);
+  }
+ }
+ duration = exatn::Timer::timeInSecHR(time_start);
+ std::cout << "Flat layout merges: " << duration << " sec" << std::endl;
+ EXPECT_TRUE(compare(merged,flat));
+ EXPECT_EQ(flat.getContractionCost(L*L+1,L*L+2),merged.getContractionCost(L*L+1,L*L+2)); //two merged neighbors
+
+ //Determine the tensor contraction sequence and generate the tensor operation list:
+ time_start = exatn::Timer::timeInSecHR();
+ grid.determineContractionSequence("greed");
+ duration = exatn::Timer::timeInSecHR(time_start);
+ std::cout << "Tensor contraction sequence (greedy): " << duration << " sec" << std::endl;
+ time_start = exatn::Timer::timeInSecHR();
+ const auto & operations = grid.getOperationList("greed");
+ duration = exatn::Timer::timeInSecHR(time_start);
+ std::cout << "Tensor operation list generation (" << operations.size() << " operations): " << duration << " sec" << std::endl;
+ EXPECT_EQ(grid.exportContractionSequence().size(),grid.getNumTensors() - 1);
+}
+
+
+TEST(NumericsTester, checkIndexModeMap)
+{
+ //Parsing and assembling a symbolic index pattern:
+ IndexModeMap mode_map;
+ EXPECT_TRUE(parse_index_pattern("D(a,b)+=L(c,a)*R+(b,c)",mode_map));
+ EXPECT_EQ(mode_map.operands.size(),3);
+ EXPECT_FALSE(mode_map.isCanonical());
+ EXPECT_TRUE(mode_map.operands[2].conjugated);
+ EXPECT_EQ(mode_map.operands[1].modes[1],mode_map.operands[0].modes[0]);
+ EXPECT_EQ(assemble_index_pattern(mode_map),"D(a,b)+=L(c,a)*R+(b,c)");
+ EXPECT_TRUE(parse_index_pattern("D(u0,u1)+=L(c0,u0)*R(u1,c0)",mode_map));
+ EXPECT_TRUE(mode_map.isCanonical());
+ EXPECT_TRUE(IndexModeMap::isContractedLabel(mode_map.operands[1].modes[0]));
+
+ //Generated index patterns:
+ std::vector<TensorLeg> pattern{TensorLeg(2,1),TensorLeg(0,0),TensorLeg(0,1),TensorLeg(1,0)};
+ std::string symb_pattern;
+ EXPECT_TRUE(generate_contraction_pattern(pattern,2,2,symb_pattern));
+ EXPECT_TRUE(generate_contraction_pattern(pattern,2,2,mode_map));
+ EXPECT_EQ(symb_pattern,"D(u0,u1)+=L(c0,u0)*R(u1,c0)");
+ EXPECT_EQ(assemble_index_pattern(mode_map),symb_pattern);
+ EXPECT_TRUE(generate_addition_pattern(2,symb_pattern,true));
+ EXPECT_EQ(symb_pattern,"D(u0,u1)+=L+(u0,u1)");
+
+ //Reduced index pattern of a tensor operation:
+ auto op = TensorOpFactory::get()->createTensorOp(TensorOpCode::CONTRACT);
+ op->setTensorOperand(std::make_shared<Tensor>("D",TensorShape{2,1}));
+ op->setTensorOperand(std::make_shared<Tensor>("L",TensorShape{3,2}));
+ op->setTensorOperand(std::make_shared<Tensor>("R",TensorShape{1,3}));
+ op->setIndexPattern("D(a,b)+=L(c,a)*R(b,c)");
+ EXPECT_TRUE(op->isSet());
+ EXPECT_EQ(op->getIndexPattern(),"D(a,b)+=L(c,a)*R(b,c)");
+ EXPECT_EQ(op->getIndexPatternReduced(),"D(a)+=L(c,a)*R(c)");
+
+ //Universal index numeration of the tensor operation list:
+ auto network = makeMPSClosure(4);
+ network.determineContractionSequence("greed");
+ const auto & operations = network.getOperationList("greed",true);
+ unsigned int num_patterns = 0;
+ for(const auto & operation: operations){
+  if(operation->hasIndexPattern()){
+   const auto & modes = operation->getIndexModeMap();
+   EXPECT_TRUE(modes.isCanonical());
+   for(unsigned int i = 0; i < modes.operands.size(); ++i){
+    EXPECT_EQ(modes.operands[i].name,operation->getTensorOperand(i)->getName());
+   }
+   EXPECT_TRUE(parse_index_pattern(operation->getIndexPattern(),mode_map));
+   EXPECT_EQ(assemble_index_pattern(mode_map),operation->getIndexPattern());
+   ++num_patterns;
+  }
+ }
+ EXPECT_EQ(num_patterns,6);
+ EXPECT_TRUE(network.splitIndices({{"c0",2}}));
+ EXPECT_FALSE(network.splitIndices({{"x0",2}}));
+}
+
+
+TEST(NumericsTester, checkSlicedExecutionTemplate)
+{
+ //4-site MPS closure with bond dimension 16:
+ auto network = makeMPSClosure(16,4);
+ network.determineContractionSequence("greed");
+ const auto & operations = network.getOperationList("greed",true);
+ network.splitIndices(16);
+ const auto num_split_indices = network.getNumSplitIndices();
+ EXPECT_GT(num_split_indices,0);
+ std::vector<DimExtent> work_extents(num_split_indices);
+ for(unsigned int i = 0; i < num_split_indices; ++i) work_extents[i] = network.getSplitIndexInfo(i).second.size();
+ TensorRange work_range(work_extents);
+
+ //Instantiate the sliced execution template for all tensor sub-networks:
+ SlicedExecutionTemplate sliced_template(network,operations);
+ EXPECT_EQ(sliced_template.getNumOperations(),operations.size());
+ EXPECT_GT(sliced_template.getNumSlots(),0);
+ std::vector<std::shared_ptr<TensorOperation>> sliced_ops;
+ std::size_t num_sub_networks = 0, num_ops = 0;
+ auto time_start = exatn::Timer::timeInSecHR();
+ bool not_done = true;
+ while(not_done){
+  const auto last_op = sliced_template.instantiate(work_range,sliced_ops);
+  EXPECT_LT(last_op,sliced_ops.size());
+  std::unordered_set<const Tensor*> slices;
+  for(std::size_t i = 0; i < sliced_ops.size(); ++i){
+   const auto & op = sliced_ops[i];
+   if(op->getOpcode() == TensorOpCode::SLICE){
+    slices.emplace(op->getTensorOperand(0).get());
+    EXPECT_LE(op->getTensorOperand(0)->getVolume(),op->getTensorOperand(1)->getVolume());
+   }else if(op->getOpcode() == TensorOpCode::DESTROY){
+    auto erased = slices.erase(op->getTensorOperand(0).get());
+    if(i > last_op) EXPECT_EQ(erased,1); //only destruction of slices follows the last tensor operation
+   }else if(op->getOpcode() == TensorOpCode::CONTRACT){
+    EXPECT_LE(op->getTensorOperand(0)->getVolume(),16);
+   }
+  }
+  EXPECT_TRUE(slices.empty()); //each extracted slice is destroyed
+  num_ops += sliced_ops.size();
+  ++num_sub_networks;
+  not_done = work_range.next();
+ }
+ auto duration = exatn::Timer::timeInSecHR(time_start);
+ EXPECT_EQ(num_sub_networks,work_range.localVolume());
+ std::cout << "Sliced execution template: " << num_sub_networks << " sub-networks, "
+           << num_ops << " operations instantiated in " << duration << " sec" << std::endl;
+
+ //Tensor operations and slices are created once per template instance, not per tensor sub-network:
+ SlicedExecutionTemplate pooled_template(network,operations,false,2);
+ EXPECT_EQ(pooled_template.getPoolSize(),2);
+ EXPECT_TRUE(pooled_template.getPendingOperations().empty());
+ std::vector<std::vector<std::shared_ptr<TensorOperation>>> instances;
+ std::unordered_set<const TensorOperation*> op_objects;
+ std::unordered_set<const Tensor*> slice_objects;
+ std::unordered_set<std::string> slice_names;
+ work_range.reset();
+ num_sub_networks = 0;
+ not_done = true;
+ while(not_done){
+  if(num_sub_networks >= 2){ //the template instance instantiated two sub-networks ago is reused
+   const auto & pending = pooled_template.getPendingOperations();
+   EXPECT_EQ(pending.size(),instances[num_sub_networks % 2].size());
+  }
+  pooled_template.instantiate(work_range,sliced_ops);
+  if(num_sub_networks < 2){
+   instances.emplace_back(sliced_ops);
+  }else{
+   EXPECT_TRUE(sliced_ops == instances[num_sub_networks % 2]); //same tensor operation objects
+  }
+  for(const auto & op: sliced_ops){
+   op_objects.emplace(op.get());
+   for(unsigned int i = 0; i < op->getNumOperandsSet(); ++i){
+    const auto tensor = op->getTensorOperand(i);
+    if(tensor->getName().substr(0,2) == "_s"){
+     slice_objects.emplace(tensor.get());
+     slice_names.emplace(tensor->getName());
+    }
+   }
+  }
+  ++num_sub_networks;
+  not_done = work_range.next();
+ }
+ EXPECT_EQ(num_sub_networks,work_range.localVolume());
+ EXPECT_EQ(op_objects.size(),instances[0].size() + instances[1].size());
+ EXPECT_EQ(slice_objects.size(),2 * pooled_template.getNumSlots());
+ EXPECT_EQ(slice_names.size(),slice_objects.size());
+ EXPECT_EQ(slice_names.count("_s0_1"),1);
+}
+
+
+TEST(NumericsTester, checkEnvironmentCache)
+{
+ //8-site MPS overlap <S|T> with bond dimension 8:
+ const unsigned int num_sites = 8;
+ std::map<std::string,std::shared_ptr<Tensor>> tensors{{"Z0",std::make_shared<Tensor>("Z0")}};
+ std::string bra, ket;
+ std::vector<std::string> sites;
+ for(unsigned int i = 0; i < num_sites; ++i){
+  const auto site = std::to_string(i);
+  std::vector<DimExtent> extents;
+  std::string ket_legs, bra_legs;
+  if(i > 0){extents.emplace_back(8); ket_legs += "b" + std::to_string(i-1) + ","; bra_legs += "c" + std::to_string(i-1) + ",";}
+  extents.emplace_back(2); ket_legs += "p" + site; bra_legs += "p" + site;
+  if(i < num_sites - 1){extents.emplace_back(8); ket_legs += ",b" + site; bra_legs += ",c" + site;}
+  tensors.emplace(std::make_pair("T"+site,std::make_shared<Tensor>("T"+site,TensorShape(extents))));
+  tensors.emplace(std::make_pair("S"+site,std::make_shared<Tensor>("S"+site,TensorShape(extents))));
+  ket += " * T" + site + "(" + ket_legs + ")";
+  bra += " * S" + site + "+(" + bra_legs + ")";
+  sites.emplace_back("S"+site);
+ }
+ auto network = std::make_shared<TensorNetwork>("mps_overlap","Z0() =" + bra.substr(2) + ket,tensors);
+
+ //Sweep over all sites using the cached environments:
+ EnvironmentCache cache(network,sites);
+ EXPECT_EQ(cache.getNumSites(),num_sites);
+ EXPECT_EQ(cache.getEnvironmentTensors().size(),2*(num_sites-1));
+ double sweep_flops = 0.0, full_flops = 0.0;
+ for(unsigned int site = 0; site < num_sites; ++site){
+  EXPECT_EQ(cache.getSiteTensorIds(site).size(),2); //S[site] and T[site]
+  const auto ids = cache.getSiteTensorIds(site,true);
+  EXPECT_EQ(ids.size(),1);
+  auto gradient = cache.getGradientNetwork(site,ids[0]);
+  EXPECT_TRUE(gradient->isValid());
+  EXPECT_TRUE(gradient->getTensor(0)->isCongruentTo(*(network->getTensor(ids[0]))));
+  sweep_flops += gradient->determineContractionSequence("greed");
+  auto closure = cache.getClosureNetwork(site);
+  EXPECT_TRUE(closure->isValid());
+  EXPECT_EQ(closure->getRank(),0);
+  if(site + 1 < num_sites){
+   auto update = cache.getLeftUpdateNetwork(site);
+   EXPECT_TRUE(update->isValid());
+   EXPECT_EQ(update->getTensor(0),cache.getLeftEnvironment(site+1));
+   EXPECT_EQ(update->getRank(),2); //cut of two bonds
+   sweep_flops += update->determineContractionSequence("greed");
+  }
+  if(site > 0){
+   auto update = cache.getRightUpdateNetwork(site);
+   EXPECT_TRUE(update->isValid());
+   EXPECT_EQ(update->getTensor(0),cache.getRightEnvironment(site-1));
+  }
+  //Gradient via the derivative of the full tensor network:
+  TensorNetwork derivative(*network);
+  auto deleted = derivative.deleteTensor(ids[0]); EXPECT_TRUE(deleted);
+  full_flops += derivative.determineContractionSequence("greed");
+ }
+ std::cout << "Environment cache: FMA flops per sweep = " << sweep_flops
+           << " versus " << full_flops << " without caching" << std::endl;
+ EXPECT_LT(sweep_flops,full_flops);
+}
+
+TEST(NumericsTester, checkExpansionEnvironmentCache)
+{
+ //4-site MPS ket with bond dimension 4:
+ auto network = std::make_shared<TensorNetwork>("mps",
+                "Z0(p0,p1,p2,p3) = T0(p0,b0) * T1(b0,p1,b1) * T2(b1,p2,b2) * T3(b2,p3)",
+                std::map<std::string,std::shared_ptr<Tensor>>{
+                 {"Z0",std::make_shared<Tensor>("Z0",TensorShape{2,2,2,2})},
+                 {"T0",std::make_shared<Tensor>("T0",TensorShape{2,4})},
+                 {"T1",std::make_shared<Tensor>("T1",TensorShape{4,2,4})},
+                 {"T2",std::make_shared<Tensor>("T2",TensorShape{4,2,4})},
+                 {"T3",std::make_shared<Tensor>("T3",TensorShape{4,2})}
+                }
+               );
+ TensorExpansion ket;
+ auto appended = ket.appendComponent(network,{1.0,0.0}); EXPECT_TRUE(appended);
+ TensorExpansion bra(ket,false);
+ bra.conjugate();
+ //Two-term operator acting on sites 1 and 2:
+ TensorOperator op("Operator");
+ appended = op.appendComponent(std::make_shared<Tensor>("H1",TensorShape{2,2}),{{1,0}},{{1,1}},{1.0,0.0}); EXPECT_TRUE(appended);
+ appended = op.appendComponent(std::make_shared<Tensor>("H2",TensorShape{2,2}),{{2,0}},{{2,1}},{0.5,0.0}); EXPECT_TRUE(appended);
+ TensorExpansion functional(bra,ket,op); // <mps|op|mps>
+ EXPECT_EQ(functional.getNumComponents(),2);
+
+ //Cached environments of the functional:
+ const std::vector<std::string> sites{"T0","T1","T2","T3"};
+ ExpansionEnvironmentCache cache(functional,sites);
+ EXPECT_EQ(cache.getNumSites(),sites.size());
+ EXPECT_TRUE(cache.isSesquilinear());
+ EXPECT_EQ(cache.getEnvironmentTensors().size(),2*2*(sites.size()-1));
+ for(unsigned int site = 0; site < sites.size(); ++site){
+  auto gradient = cache.getGradientExpansion(site);
+  EXPECT_EQ(gradient.getNumComponents(),2);
+  EXPECT_EQ(gradient.getRank(),network->getTensor(site+1)->getRank());
+  auto closure = cache.getClosureExpansion(site);
+  EXPECT_EQ(closure.getNumComponents(),2);
+  EXPECT_EQ(closure.getRank(),0);
+  EXPECT_EQ(cache.getLeftUpdateNetworks(site).size(),(site + 1 < sites.size()) ? 2 : 0);
+  EXPECT_EQ(cache.getRightUpdateNetworks(site).size(),(site > 0) ? 2 : 0);
+ }
+
+ //A functional quadratic in the same (non-conjugated) tensor is not sesquilinear:
+ auto quadratic = std::make_shared<TensorNetwork>("quadratic",
+                  "Z0() = T0(a,b) * T0(b,a)",
+                  std::map<std::string,std::shared_ptr<Tensor>>{
+                   {"Z0",std::make_shared<Tensor>("Z0")},
+                   {"T0",std::make_shared<Tensor>("T0",TensorShape{4,4})}
+                  }
+                 );
+ TensorExpansion quadratic_functional;
+ appended = quadratic_functional.appendComponent(quadratic,{1.0,0.0}); EXPECT_TRUE(appended);
+ ExpansionEnvironmentCache quadratic_cache(quadratic_functional,{"T0"});
+ EXPECT_FALSE(quadratic_cache.isSesquilinear());
+}
+
+TEST(NumericsTester, checkTruncatedSVD)
+{
+ //Matrix A(200,150) = X(200,20) * diag(s) * Y(20,150) of rank 20 with geometrically decaying weights:
+ const std::size_t m = 200, n = 150, r = 20;
+ std::mt19937_64 generator(7);
+ std::normal_distribution<double> distribution(0.0,1.0);
+ std::vector<std::complex<double>> x(m*r), y(r*n), a(m*n,{0.0,0.0});
+ for(auto & elem: x) elem = std::complex<double>(distribution(generator),distribution(generator));
+ for(auto & elem: y) elem = std::complex<double>(distribution(generator),distribution(generator));
+ for(std::size_t k = 0; k < r; ++k){
+  const double weight = std::pow(0.7,k);
+  for(std::size_t j = 0; j < n; ++j){
+   for(std::size_t i = 0; i < m; ++i) a[j*m + i] += x[k*m + i] * weight * y[j*r + k];
+  }
+ }
+ //Relative squared Frobenius norm of A - U * S * VH:
+ auto residual = [&](const std::vector<std::complex<double>> & u,
+                     const std::vector<double> & s,
+                     const std::vector<std::complex<double>> & vh){
+  const std::size_t rank = s.size();
+  double norm = 0.0, error = 0.0;
+  for(std::size_t j = 0; j < n; ++j){
+   for(std::size_t i = 0; i < m; ++i){
+    std::complex<double> elem = a[j*m + i];
+    for(std::size_t k = 0; k < rank; ++k) elem -= u[k*m + i] * s[k] * vh[j*rank + k];
+    norm += std::norm(a[j*m + i]);
+    error += std::norm(elem);
+   }
+  }
+  return error / norm;
+ };
+
+ std::vector<std::complex<double>> u, vh, ur, vhr;
+ std::vector<double> s, sr;
+ double discarded = 0.0, discarded_rnd = 0.0;
+
+ //Full SVD truncated by the tolerance recovers the exact rank:
+ SVDTruncation truncation;
+ truncation.tolerance = 1e-12;
+ bool success = computeTruncatedSVD(m,n,a.data(),truncation,u,s,vh,&discarded); EXPECT_TRUE(success);
+ EXPECT_EQ(s.size(),r);
+ EXPECT_LE(discarded,1e-12);
+ EXPECT_LE(residual(u,s,vh),1e-12);
+ for(std::size_t k = 1; k < s.size(); ++k) EXPECT_LE(s[k],s[k-1]);
+
+ //Full SVD truncated by the max rank:
+ truncation.tolerance = 0.0;
+ truncation.max_rank = 5;
+ success = computeTruncatedSVD(m,n,a.data(),truncation,u,s,vh,&discarded); EXPECT_TRUE(success);
+ EXPECT_EQ(s.size(),5);
+ EXPECT_GT(discarded,0.0);
+ EXPECT_NEAR(residual(u,s,vh),discarded,1e-10);
+
+ //Randomized SVD with the same max rank is nearly optimal:
+ truncation.randomized = true;
+ success = computeTruncatedSVD(m,n,a.data(),truncation,ur,sr,vhr,&discarded_rnd); EXPECT_TRUE(success);
+ EXPECT_EQ(sr.size(),5);
+ EXPECT_NEAR(residual(ur,sr,vhr),discarded_rnd,1e-10);
+ EXPECT_LE(discarded_rnd,discarded * 1.01);
+ for(std::size_t k = 0; k < sr.size(); ++k) EXPECT_NEAR(sr[k],s[k],1e-6*s[0]);
+ //Left factor is isometric:
+ for(std::size_t k = 0; k < sr.size(); ++k){
+  for(std::size_t l = 0; l < sr.size(); ++l){
+   std::complex<double> dot{0.0,0.0};
+   for(std::size_t i = 0; i < m; ++i) dot += std::conj(ur[k*m + i]) * ur[l*m + i];
+   EXPECT_NEAR(std::abs(dot - ((k == l) ? 1.0 : 0.0)),0.0,1e-10);
+  }
+ }
+}
+
+TEST(NumericsTester, checkTwoSiteGateSVD)
+{
+ std::mt19937_64 generator(11);
+ std::normal_distribution<double> distribution(0.0,1.0);
+ auto random_tensor = [&](std::size_t volume){
+  std::vector<std::complex<double>> tensor(volume);
+  for(auto & elem: tensor) elem = std::complex<double>(distribution(generator),distribution(generator));
+  return tensor;
+ };
+ const std::size_t da = 3, dc = 5, dp = 2; //outer bond dimensions and physical dimension
+
+ //Exact (untruncated) case: L(a,i,b) * R(b,j,c) * G(i,j,k,l) --> L(a,k,b) * R(b,l,c):
+ {
+  const std::size_t db = 6;
+  auto left = random_tensor(da*dp*db), right = random_tensor(db*dp*dc), gate = random_tensor(dp*dp*dp*dp);
+  std::vector<std::complex<double>> theta(da*dp*dp*dc,{0.0,0.0}); //theta(a,k,l,c)
+  for(std::size_t c = 0; c < dc; ++c) for(std::size_t l = 0; l < dp; ++l) for(std::size_t k = 0; k < dp; ++k)
+   for(std::size_t a = 0; a < da; ++a) for(std::size_t j = 0; j < dp; ++j) for(std::size_t i = 0; i < dp; ++i)
+    for(std::size_t b = 0; b < db; ++b)
+     theta[a+da*(k+dp*(l+dp*c))] += left[a+da*(i+dp*b)] * right[b+db*(j+dp*c)] * gate[i+dp*(j+dp*(k+dp*l))];
+  SVDTruncation truncation;
+  truncation.absorb = SVDAbsorb::RIGHT;
+  std::size_t rank = 0;
+  double discarded = -1.0;
+  bool success = computeTwoSiteGateSVD(std::vector<unsigned int>{0,1,2},std::vector<DimExtent>{da,dp,db},left.data(),
+                                       std::vector<unsigned int>{2,3,4},std::vector<DimExtent>{db,dp,dc},right.data(),
+                                       std::vector<unsigned int>{1,3,5,6},gate.data(),truncation,&rank,&discarded);
+  EXPECT_TRUE(success);
+  EXPECT_EQ(rank,db);
+  EXPECT_NEAR(discarded,0.0,1e-12);
+  double error = 0.0;
+  for(std::size_t c = 0; c < dc; ++c) for(std::size_t l = 0; l < dp; ++l) for(std::size_t k = 0; k < dp; ++k)
+   for(std::size_t a = 0; a < da; ++a){
+    std::complex<double> elem = theta[a+da*(k+dp*(l+dp*c))];
+    for(std::size_t b = 0; b < db; ++b) elem -= left[a+da*(k+dp*b)] * right[b+db*(l+dp*c)];
+    error += std::norm(elem);
+   }
+  EXPECT_LE(error,1e-20);
+  //The left tensor is isometric (left-canonical):
+  for(std::size_t b0 = 0; b0 < db; ++b0){
+   for(std::size_t b1 = 0; b1 < db; ++b1){
+    std::complex<double> dot{0.0,0.0};
+    for(std::size_t ak = 0; ak < da*dp; ++ak) dot += std::conj(left[ak+da*dp*b0]) * left[ak+da*dp*b1];
+    EXPECT_NEAR(std::abs(dot - ((b0 == b1) ? 1.0 : 0.0)),0.0,1e-10);
+   }
+  }
+ }
+
+ //Truncated case with permuted legs: L(a,i,b) * R(j,c,b) * G(j,i,l,k) --> L(a,k,b) * R(l,c,b):
+ {
+  const std::size_t db = 4;
+  auto left = random_tensor(da*dp*db), right = random_tensor(dp*dc*db), gate = random_tensor(dp*dp*dp*dp);
+  std::vector<std::complex<double>> theta(da*dp*dp*dc,{0.0,0.0}); //theta(a,k,l,c)
+  for(std::size_t c = 0; c < dc; ++c) for(std::size_t l = 0; l < dp; ++l) for(std::size_t k = 0; k < dp; ++k)
+   for(std::size_t a = 0; a < da; ++a) for(std::size_t j = 0; j < dp; ++j) for(std::size_t i = 0; i < dp; ++i)
+    for(std::size_t b = 0; b < db; ++b)
+     theta[a+da*(k+dp*(l+dp*c))] += left[a+da*(i+dp*b)] * right[j+dp*(c+dc*b)] * gate[j+dp*(i+dp*(l+dp*k))];
+  double norm = 0.0;
+  for(const auto & elem: theta) norm += std::norm(elem);
+  SVDTruncation truncation;
+  truncation.absorb = SVDAbsorb::BOTH;
+  std::size_t rank = 0;
+  double discarded = -1.0;
+  bool success = computeTwoSiteGateSVD(std::vector<unsigned int>{0,1,2},std::vector<DimExtent>{da,dp,db},left.data(),
+                                       std::vector<unsigned int>{3,4,2},std::vector<DimExtent>{dp,dc,db},right.data(),
+                                       std::vector<unsigned int>{3,1,6,5},gate.data(),truncation,&rank,&discarded);
+  EXPECT_TRUE(success);
+  EXPECT_EQ(rank,db);
+  EXPECT_GT(discarded,0.0);
+  double error = 0.0;
+  for(std::size_t c = 0; c < dc; ++c) for(std::size_t l = 0; l < dp; ++l) for(std::size_t k = 0; k < dp; ++k)
+   for(std::size_t a = 0; a < da; ++a){
+    std::complex<double> elem = theta[a+da*(k+dp*(l+dp*c))];
+    for(std::size_t b = 0; b < db; ++b) elem -= left[a+da*(k+dp*b)] * right[l+dp*(c+dc*b)];
+    error += std::norm(elem);
+   }
+  EXPECT_NEAR(error/norm,discarded,1e-10);
+ }
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
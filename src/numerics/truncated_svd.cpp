@@ -0,0 +1,311 @@
+/** ExaTN::Numerics: Truncated (optionally randomized) SVD of a dense matrix
+REVISION: 2020/10/01
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+#include "truncated_svd.hpp"
+
+#include <Eigen/Dense>
+
+#include <type_traits>
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <cmath>
+
+namespace exatn{
+
+namespace numerics{
+
+namespace{
+
+const std::mt19937_64::result_type RANDOM_SEED = 1234567; //fixed seed for reproducibility
+
+template<typename NumericType>
+inline NumericType gaussian(std::mt19937_64 & generator,
+                            std::normal_distribution<double> & distribution,
+                            std::false_type) //real
+{
+ return static_cast<NumericType>(distribution(generator));
+}
+
+template<typename NumericType>
+inline NumericType gaussian(std::mt19937_64 & generator,
+                            std::normal_distribution<double> & distribution,
+                            std::true_type) //complex
+{
+ using RealType = typename NumericType::value_type;
+ const auto re = static_cast<RealType>(distribution(generator));
+ const auto im = static_cast<RealType>(distribution(generator));
+ return NumericType(re,im);
+}
+
+template<typename MatrixType>
+inline MatrixType orthonormalize(const MatrixType & matrix)
+{
+ Eigen::HouseholderQR<MatrixType> qr(matrix);
+ return qr.householderQ() * MatrixType::Identity(matrix.rows(),matrix.cols());
+}
+
+/** Maps each tensor element (in the storage order) onto its bond index value
+    and the offset over the remaining tensor dimensions (the first one is the fastest). **/
+inline std::size_t matricize(const std::vector<DimExtent> & extents,
+                             int bond,
+                             std::vector<std::pair<std::size_t,std::size_t>> & elements)
+{
+ std::size_t volume = 1, matrix_dim = 1;
+ std::vector<std::size_t> strides(extents.size(),0);
+ for(unsigned int i = 0; i < extents.size(); ++i){
+  volume *= extents[i];
+  if(static_cast<int>(i) != bond){strides[i] = matrix_dim; matrix_dim *= extents[i];}
+ }
+ elements.resize(volume);
+ std::vector<DimExtent> mlndx(extents.size(),0);
+ std::size_t offset = 0;
+ for(std::size_t elem = 0; elem < volume; ++elem){
+  elements[elem] = std::make_pair(offset,static_cast<std::size_t>(mlndx[bond]));
+  for(unsigned int i = 0; i < extents.size(); ++i){ //next multi-index
+   offset += strides[i];
+   if(++mlndx[i] < extents[i]) break;
+   offset -= strides[i] * mlndx[i];
+   mlndx[i] = 0;
+  }
+ }
+ return matrix_dim;
+}
+
+} //namespace
+
+
+template<typename NumericType>
+bool computeTruncatedSVD(std::size_t num_rows,
+                         std::size_t num_cols,
+                         const NumericType * matrix,
+                         const SVDTruncation & truncation,
+                         std::vector<NumericType> & left,
+                         std::vector<double> & singular_values,
+                         std::vector<NumericType> & right,
+                         double * discarded_weight)
+{
+ using Matrix = Eigen::Matrix<NumericType,Eigen::Dynamic,Eigen::Dynamic,Eigen::ColMajor>;
+ using IsComplex = std::integral_constant<bool,Eigen::NumTraits<NumericType>::IsComplex>;
+
+ if(num_rows == 0 || num_cols == 0 || matrix == nullptr || truncation.tolerance < 0.0){
+  std::cout << "#ERROR(exatn::numerics::computeTruncatedSVD): Invalid arguments!" << std::endl;
+  return false;
+ }
+ const Eigen::Map<const Matrix> a(matrix,num_rows,num_cols);
+ const std::size_t min_dim = std::min(num_rows,num_cols);
+ const std::size_t max_rank = (truncation.max_rank > 0) ? std::min(truncation.max_rank,min_dim) : min_dim;
+ const std::size_t sample_dim = max_rank + truncation.oversampling;
+ const double total_weight = static_cast<double>(a.squaredNorm());
+
+ //Compute the (approximate) SVD:
+ Matrix u, vh;
+ std::vector<double> s;
+ if(truncation.randomized && truncation.max_rank > 0 && sample_dim < min_dim){ //randomized range finder: O(MNK)
+  std::mt19937_64 generator(RANDOM_SEED);
+  std::normal_distribution<double> distribution(0.0,1.0);
+  Matrix g(num_cols,sample_dim);
+  for(std::size_t j = 0; j < sample_dim; ++j){
+   for(std::size_t i = 0; i < num_cols; ++i) g(i,j) = gaussian<NumericType>(generator,distribution,IsComplex());
+  }
+  Matrix q = orthonormalize<Matrix>(a * g);
+  for(unsigned int iter = 0; iter < truncation.power_iterations; ++iter){
+   q = orthonormalize<Matrix>(a.adjoint() * q);
+   q = orthonormalize<Matrix>(a * q);
+  }
+  const Matrix b = q.adjoint() * a;
+  Eigen::BDCSVD<Matrix> svd(b,Eigen::ComputeThinU|Eigen::ComputeThinV);
+  u = q * svd.matrixU();
+  vh = svd.matrixV().adjoint();
+  const auto & sv = svd.singularValues();
+  for(int i = 0; i < sv.size(); ++i) s.emplace_back(static_cast<double>(sv(i)));
+ }else{ //full SVD: O(MN*min(M,N))
+  Eigen::BDCSVD<Matrix> svd(a,Eigen::ComputeThinU|Eigen::ComputeThinV);
+  u = svd.matrixU();
+  vh = svd.matrixV().adjoint();
+  const auto & sv = svd.singularValues();
+  for(int i = 0; i < sv.size(); ++i) s.emplace_back(static_cast<double>(sv(i)));
+ }
+
+ //Determine the retained rank:
+ std::size_t rank = 0;
+ double retained_weight = 0.0;
+ while(rank < max_rank && rank < s.size()){
+  if(rank > 0 && (total_weight - retained_weight) <= truncation.tolerance * total_weight) break;
+  retained_weight += s[rank] * s[rank];
+  ++rank;
+ }
+ if(discarded_weight != nullptr){
+  *discarded_weight = (total_weight > 0.0) ? std::max(0.0,(total_weight - retained_weight) / total_weight) : 0.0;
+ }
+
+ //Extract the truncated SVD factors:
+ left.assign(u.data(),u.data() + num_rows * rank);
+ singular_values.assign(s.cbegin(),s.cbegin() + rank);
+ const Matrix vh_truncated = vh.topRows(rank);
+ right.assign(vh_truncated.data(),vh_truncated.data() + rank * num_cols);
+ return true;
+}
+
+
+template<typename NumericType>
+bool computeTwoSiteGateSVD(const std::vector<unsigned int> & left_modes,
+                           const std::vector<DimExtent> & left_extents,
+                           NumericType * left,
+                           const std::vector<unsigned int> & right_modes,
+                           const std::vector<DimExtent> & right_extents,
+                           NumericType * right,
+                           const std::vector<unsigned int> & gate_modes,
+                           const NumericType * gate,
+                           const SVDTruncation & truncation,
+                           std::size_t * achieved_rank,
+                           double * discarded_weight)
+{
+ using Matrix = Eigen::Matrix<NumericType,Eigen::Dynamic,Eigen::Dynamic,Eigen::ColMajor>;
+
+ //Identify the bond and the gate legs:
+ bool valid = (left != nullptr && right != nullptr && gate != nullptr && gate_modes.size() == 4
+               && left_extents.size() == left_modes.size() && right_extents.size() == right_modes.size()
+               && truncation.absorb != SVDAbsorb::NONE);
+ int left_bond = -1, right_bond = -1; //bond position in the left/right tensor
+ int left_leg = -1, right_leg = -1;   //position of the gate-contracted leg in the left/right tensor
+ int left_gate = -1, right_gate = -1; //position of the gate input leg contracted with the left/right tensor
+ for(unsigned int i = 0; valid && i < left_modes.size(); ++i){
+  for(unsigned int j = 0; valid && j < right_modes.size(); ++j){
+   if(left_modes[i] == right_modes[j]){
+    valid = (left_bond < 0);
+    left_bond = i; right_bond = j;
+   }
+  }
+ }
+ for(unsigned int g = 0; valid && g < 2; ++g){
+  auto left_pos = std::find(left_modes.cbegin(),left_modes.cend(),gate_modes[g]);
+  auto right_pos = std::find(right_modes.cbegin(),right_modes.cend(),gate_modes[g]);
+  if(left_pos != left_modes.cend() && left_gate < 0){
+   left_gate = g; left_leg = left_pos - left_modes.cbegin();
+  }else if(right_pos != right_modes.cend() && right_gate < 0){
+   right_gate = g; right_leg = right_pos - right_modes.cbegin();
+  }else{
+   valid = false;
+  }
+ }
+ valid = valid && (left_bond >= 0) && (left_gate >= 0) && (right_gate >= 0)
+               && (left_leg != left_bond) && (right_leg != right_bond)
+               && (left_extents[left_bond] == right_extents[right_bond]);
+ if(!valid){
+  std::cout << "#ERROR(exatn::numerics::computeTwoSiteGateSVD): Invalid arguments!" << std::endl;
+  return false;
+ }
+ const std::size_t bond_dim = left_extents[left_bond];
+ const std::size_t left_dim = left_extents[left_leg];
+ const std::size_t right_dim = right_extents[right_leg];
+ std::size_t gate_strides[4];
+ {
+  std::size_t gate_extents[4];
+  gate_extents[left_gate] = left_dim; gate_extents[left_gate+2] = left_dim;
+  gate_extents[right_gate] = right_dim; gate_extents[right_gate+2] = right_dim;
+  gate_strides[0] = 1;
+  for(unsigned int g = 1; g < 4; ++g) gate_strides[g] = gate_strides[g-1] * gate_extents[g-1];
+ }
+
+ //Matricize both tensors over their bond:
+ std::vector<std::pair<std::size_t,std::size_t>> left_elements, right_elements;
+ const std::size_t num_rows = matricize(left_extents,left_bond,left_elements);
+ const std::size_t num_cols = matricize(right_extents,right_bond,right_elements);
+ std::size_t row_stride = 1, col_stride = 1; //strides of the gate-contracted legs in the matricized tensors
+ for(int i = 0; i < left_leg; ++i) if(i != left_bond) row_stride *= left_extents[i];
+ for(int i = 0; i < right_leg; ++i) if(i != right_bond) col_stride *= right_extents[i];
+ Matrix left_matrix(num_rows,bond_dim), right_matrix(bond_dim,num_cols);
+ for(std::size_t elem = 0; elem < left_elements.size(); ++elem){
+  left_matrix(left_elements[elem].first,left_elements[elem].second) = left[elem];
+ }
+ for(std::size_t elem = 0; elem < right_elements.size(); ++elem){
+  right_matrix(right_elements[elem].second,right_elements[elem].first) = right[elem];
+ }
+
+ //Form the two-site tensor (theta) with the gate applied:
+ const Matrix product = left_matrix * right_matrix;
+ Matrix theta = Matrix::Zero(num_rows,num_cols);
+ for(std::size_t col = 0; col < num_cols; ++col){
+  const std::size_t j = (col / col_stride) % right_dim;
+  const std::size_t col_base = col - j * col_stride;
+  for(std::size_t row = 0; row < num_rows; ++row){
+   const std::size_t i = (row / row_stride) % left_dim;
+   const std::size_t row_base = row - i * row_stride;
+   const NumericType value = product(row,col);
+   const std::size_t gate_base = i * gate_strides[left_gate] + j * gate_strides[right_gate];
+   for(std::size_t l = 0; l < right_dim; ++l){
+    for(std::size_t k = 0; k < left_dim; ++k){
+     theta(row_base + k * row_stride,col_base + l * col_stride) +=
+      gate[gate_base + k * gate_strides[left_gate+2] + l * gate_strides[right_gate+2]] * value;
+    }
+   }
+  }
+ }
+
+ //Truncated SVD of the two-site tensor (the rank is limited by the bond dimension):
+ SVDTruncation bond_truncation(truncation);
+ bond_truncation.max_rank = (truncation.max_rank > 0) ? std::min(truncation.max_rank,bond_dim) : bond_dim;
+ std::vector<NumericType> u, vh;
+ std::vector<double> s;
+ bool done = computeTruncatedSVD(num_rows,num_cols,theta.data(),bond_truncation,u,s,vh,discarded_weight);
+ if(!done) return false;
+ const std::size_t rank = s.size();
+ for(std::size_t k = 0; k < rank; ++k){
+  const double sv = (truncation.absorb == SVDAbsorb::BOTH) ? std::sqrt(s[k]) : s[k];
+  if(truncation.absorb == SVDAbsorb::LEFT || truncation.absorb == SVDAbsorb::BOTH){
+   for(std::size_t i = 0; i < num_rows; ++i) u[k * num_rows + i] *= sv;
+  }
+  if(truncation.absorb == SVDAbsorb::RIGHT || truncation.absorb == SVDAbsorb::BOTH){
+   for(std::size_t j = 0; j < num_cols; ++j) vh[j * rank + k] *= sv;
+  }
+ }
+
+ //Write the updated tensors back in place (zero-filling the discarded part of the bond):
+ for(std::size_t elem = 0; elem < left_elements.size(); ++elem){
+  const auto & pos = left_elements[elem];
+  left[elem] = (pos.second < rank) ? u[pos.second * num_rows + pos.first] : NumericType(0.0);
+ }
+ for(std::size_t elem = 0; elem < right_elements.size(); ++elem){
+  const auto & pos = right_elements[elem];
+  right[elem] = (pos.second < rank) ? vh[pos.first * rank + pos.second] : NumericType(0.0);
+ }
+ if(achieved_rank != nullptr) *achieved_rank = rank;
+ return true;
+}
+
+
+template bool computeTruncatedSVD<float>(std::size_t, std::size_t, const float *, const SVDTruncation &,
+                                         std::vector<float> &, std::vector<double> &, std::vector<float> &, double *);
+template bool computeTruncatedSVD<double>(std::size_t, std::size_t, const double *, const SVDTruncation &,
+                                          std::vector<double> &, std::vector<double> &, std::vector<double> &, double *);
+template bool computeTruncatedSVD<std::complex<float>>(std::size_t, std::size_t, const std::complex<float> *, const SVDTruncation &,
+                                                       std::vector<std::complex<float>> &, std::vector<double> &,
+                                                       std::vector<std::complex<float>> &, double *);
+template bool computeTruncatedSVD<std::complex<double>>(std::size_t, std::size_t, const std::complex<double> *, const SVDTruncation &,
+                                                        std::vector<std::complex<double>> &, std::vector<double> &,
+                                                        std::vector<std::complex<double>> &, double *);
+
+template bool computeTwoSiteGateSVD<float>(const std::vector<unsigned int> &, const std::vector<DimExtent> &, float *,
+                                           const std::vector<unsigned int> &, const std::vector<DimExtent> &, float *,
+                                           const std::vector<unsigned int> &, const float *,
+                                           const SVDTruncation &, std::size_t *, double *);
+template bool computeTwoSiteGateSVD<double>(const std::vector<unsigned int> &, const std::vector<DimExtent> &, double *,
+                                            const std::vector<unsigned int> &, const std::vector<DimExtent> &, double *,
+                                            const std::vector<unsigned int> &, const double *,
+                                            const SVDTruncation &, std::size_t *, double *);
+template bool computeTwoSiteGateSVD<std::complex<float>>(const std::vector<unsigned int> &, const std::vector<DimExtent> &, std::complex<float> *,
+                                                         const std::vector<unsigned int> &, const std::vector<DimExtent> &, std::complex<float> *,
+                                                         const std::vector<unsigned int> &, const std::complex<float> *,
+                                                         const SVDTruncation &, std::size_t *, double *);
+template bool computeTwoSiteGateSVD<std::complex<double>>(const std::vector<unsigned int> &, const std::vector<DimExtent> &, std::complex<double> *,
+                                                          const std::vector<unsigned int> &, const std::vector<DimExtent> &, std::complex<double> *,
+                                                          const std::vector<unsigned int> &, const std::complex<double> *,
+                                                          const SVDTruncation &, std::size_t *, double *);
+
+} //namespace numerics
+
+} //namespace exatn
@@ -0,0 +1,97 @@
+/** ExaTN::Numerics: Truncated (optionally randomized) SVD of a dense matrix
+REVISION: 2020/10/01
+
+Copyright (C) 2018-2020 Dmitry I. Lyakh (Liakh)
+Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle) **/
+
+/** Rationale:
+ (a) The truncated SVD A = U * S * V^H of an M x N matrix retains at most the given
+     number of the largest singular values (max rank) and, within that limit, the smallest
+     number of singular values such that the discarded weight does not exceed the given
+     tolerance. The discarded weight is the sum of squares of the discarded singular values
+     relative to the squared Frobenius norm of the matrix, that is, the relative squared
+     Frobenius norm of the truncation error A - U * S * V^H.
+ (b) The full (divide-and-conquer) SVD costs O(M*N*min(M,N)). If the max rank K is much
+     smaller than min(M,N), the randomized range finder costs O(M*N*K) instead:
+     Y = A * G with a Gaussian random N x (K+P) matrix G (P is the oversampling),
+     a few power iterations Y = A * A^H * Y (each followed by re-orthonormalization)
+     sharpen the spectral decay, Q = orth(Y), followed by the small SVD of Q^H * A.
+     The discarded weight then also includes the part of A not captured by Q.
+ (c) All matrices are stored column-wise (the first index is the fastest), which
+     coincides with the tensor storage layout in ExaTN. The right factor is returned
+     as V^H (K x N), such that A ~ U * diag(S) * V^H.
+ (d) The fused two-site gate application contracts two neighboring tensors (connected
+     by a single bond) with a two-site gate into the two-site tensor (theta), computes
+     its truncated SVD and writes the two updated tensors back in place with the same
+     shapes, the retained rank being limited by the bond dimension (the remaining part
+     of the bond is zero-filled). The gate legs follow the ExaTN convention: The first
+     half of the gate legs is contracted with the tensors, the second half replaces
+     the contracted legs in place.
+**/
+
+#ifndef EXATN_NUMERICS_TRUNCATED_SVD_HPP_
+#define EXATN_NUMERICS_TRUNCATED_SVD_HPP_
+
+#include "tensor_basic.hpp"
+
+#include <vector>
+#include <complex>
+
+namespace exatn{
+
+namespace numerics{
+
+//Distribution of the singular values among the two SVD factors:
+enum class SVDAbsorb{
+ NONE,  //singular values are kept in a separate middle factor
+ LEFT,  //singular values are absorbed into the left factor
+ RIGHT, //singular values are absorbed into the right factor
+ BOTH   //square roots of the singular values are absorbed into both factors
+};
+
+//SVD truncation parameters:
+struct SVDTruncation{
+ std::size_t max_rank = 0;            //max number of retained singular values (0: unlimited)
+ double tolerance = 0.0;              //max discarded weight (relative squared Frobenius norm of the truncation error)
+ bool randomized = false;             //use the randomized range finder (only with a finite max rank)
+ unsigned int oversampling = 8;       //oversampling of the random subspace (randomized SVD)
+ unsigned int power_iterations = 2;   //number of power iterations (randomized SVD)
+ SVDAbsorb absorb = SVDAbsorb::RIGHT; //absorption of the singular values in the two-factor decomposition
+};
+
+
+/** Computes the truncated SVD of a dense column-wise stored matrix: A ~ U * diag(S) * VH.
+    At least one singular value is always retained. Returns FALSE on invalid arguments. **/
+template<typename NumericType>
+bool computeTruncatedSVD(std::size_t num_rows,                 //in: number of rows M
+                         std::size_t num_cols,                 //in: number of columns N
+                         const NumericType * matrix,           //in: matrix A (M x N, column-wise)
+                         const SVDTruncation & truncation,     //in: truncation parameters
+                         std::vector<NumericType> & left,      //out: left factor U (M x K, column-wise)
+                         std::vector<double> & singular_values, //out: retained singular values S (K, descending)
+                         std::vector<NumericType> & right,     //out: right factor VH (K x N, column-wise)
+                         double * discarded_weight = nullptr); //out: discarded weight (relative)
+
+/** Applies a two-site gate G(i,j,k,l) to two neighboring tensors L and R connected by a single bond,
+    for example, L(a,i,b) * R(b,j,c) * G(i,j,k,l) --> L(a,k,b) * R(b,l,c), followed by a truncated SVD
+    of the two-site tensor. The tensor index labels are integers (the same label denotes the same index).
+    The singular values are absorbed as specified by the truncation parameters (SVDAbsorb::NONE is invalid).
+    Returns FALSE on invalid arguments. **/
+template<typename NumericType>
+bool computeTwoSiteGateSVD(const std::vector<unsigned int> & left_modes,  //in: index labels of the left tensor
+                           const std::vector<DimExtent> & left_extents,   //in: dimension extents of the left tensor
+                           NumericType * left,                            //inout: left tensor (updated in place)
+                           const std::vector<unsigned int> & right_modes, //in: index labels of the right tensor
+                           const std::vector<DimExtent> & right_extents,  //in: dimension extents of the right tensor
+                           NumericType * right,                           //inout: right tensor (updated in place)
+                           const std::vector<unsigned int> & gate_modes,  //in: index labels of the gate tensor (rank 4)
+                           const NumericType * gate,                      //in: gate tensor
+                           const SVDTruncation & truncation,              //in: truncation parameters
+                           std::size_t * achieved_rank = nullptr,         //out: achieved (retained) rank
+                           double * discarded_weight = nullptr);          //out: discarded weight (relative)
+
+} //namespace numerics
+
+} //namespace exatn
+
+#endif //EXATN_NUMERICS_TRUNCATED_SVD_HPP_
@@ -128,6 +128,14 @@ int ExatensorNodeExecutor::execute(numerics::TensorOpAllreduce & op,
 }
 
 
+int ExatensorNodeExecutor::execute(numerics::TensorOpApplyGateSVD2 & op,
+                                   TensorOpExecHandle * exec_handle)
+{
+ //`Implement
+ return 0;
+}
+
+
 bool ExatensorNodeExecutor::sync(TensorOpExecHandle op_handle,
                                  int * error_code,
                                  bool wait)
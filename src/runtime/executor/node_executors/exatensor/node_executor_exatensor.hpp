@@ -61,6 +61,8 @@ public:
               TensorOpExecHandle * exec_handle) override;
   int execute(numerics::TensorOpAllreduce & op,
               TensorOpExecHandle * exec_handle) override;
+  int execute(numerics::TensorOpApplyGateSVD2 & op,
+              TensorOpExecHandle * exec_handle) override;
 
   bool sync(TensorOpExecHandle op_handle,
             int * error_code,
@@ -1,5 +1,5 @@
 /** ExaTN:: Tensor Runtime: Tensor graph node executor: Talsh
-REVISION: 2020/08/31
+REVISION: 2020/09/26
 
 Copyright (C) 2018-2020 Dmitry Lyakh, Tiffany Mintz, Alex McCaskey
 Copyright (C) 2018-2020 Oak Ridge National Laboratory (UT-Battelle)
@@ -519,15 +519,16 @@ int TalshNodeExecutor::execute(numerics::TensorOpAdd & op,
   assert(false);
  }
 
+ const auto pattern = op.getIndexPatternReduced(); //assembled once from the integer form
  auto error_code = tens0.accumulate((task_res.first)->second.get(),
-                                    op.getIndexPatternReduced(),
+                                    pattern,
                                     tens1,
                                     DEV_DEFAULT,DEV_DEFAULT,
                                     op.getScalar(0));
  if(error_code == DEVICE_UNABLE || error_code == TALSH_NOT_AVAILABLE || error_code == TALSH_NOT_IMPLEMENTED){
   (task_res.first)->second->clean();
   error_code = tens0.accumulate((task_res.first)->second.get(),
-                                op.getIndexPatternReduced(),
+                                pattern,
                                 tens1,
                                 DEV_HOST,0,
                                 op.getScalar(0));
@@ -590,8 +591,9 @@ int TalshNodeExecutor::execute(numerics::TensorOpContract & op,
  }
 
  //std::cout << "#DEBUG(exatn::runtime::node_executor_talsh): Tensor contraction " << op.getIndexPattern() << std::endl; //debug
+ const auto pattern = op.getIndexPatternReduced(); //assembled once from the integer form
  auto error_code = tens0.contractAccumulate((task_res.first)->second.get(),
-                                            op.getIndexPatternReduced(),
+                                            pattern,
                                             tens1,tens2,
                                             DEV_DEFAULT,DEV_DEFAULT,
                                             op.getScalar(0));
@@ -605,13 +607,13 @@ int TalshNodeExecutor::execute(numerics::TensorOpContract & op,
                             std::make_shared<talsh::TensorTask>()));
   if(synced){
    error_code = tens0.contractAccumulateXL((task_res.first)->second.get(),
-                                           op.getIndexPatternReduced(),
+                                           pattern,
                                            tens1,tens2,
                                            DEV_DEFAULT,DEV_DEFAULT,
                                            op.getScalar(0));
   }else{
    error_code = tens0.contractAccumulate((task_res.first)->second.get(),
-                                         op.getIndexPatternReduced(),
+                                         pattern,
                                          tens1,tens2,
                                          DEV_HOST,0,
                                          op.getScalar(0));
@@ -619,7 +621,7 @@ int TalshNodeExecutor::execute(numerics::TensorOpContract & op,
  }else if(error_code == TALSH_NOT_AVAILABLE || error_code == TALSH_NOT_IMPLEMENTED){
   (task_res.first)->second->clean();
   error_code = tens0.contractAccumulate((task_res.first)->second.get(),
-                                         op.getIndexPatternReduced(),
+                                         pattern,
                                          tens1,tens2,
                                          DEV_HOST,0,
                                          op.getScalar(0));
@@ -978,6 +980,98 @@ int TalshNodeExecutor::execute(numerics::TensorOpAllreduce & op,
 }
 
 
+int TalshNodeExecutor::execute(numerics::TensorOpApplyGateSVD2 & op,
+                               TensorOpExecHandle * exec_handle)
+{
+ assert(op.isSet());
+ if(!finishPrefetching(op)) return TRY_LATER;
+
+ const auto & tensor0 = *(op.getTensorOperand(0));
+ const auto tensor0_hash = tensor0.getTensorHash();
+ auto tens0_pos = tensors_.find(tensor0_hash);
+ if(tens0_pos == tensors_.end()){
+  std::cout << "#ERROR(exatn::runtime::node_executor_talsh): APPLY_GATE_SVD2: Tensor operand 0 not found: " << std::endl;
+  op.printIt();
+  assert(false);
+ }
+ tens0_pos->second.resetTensorShapeToReduced();
+ auto & tens0 = *(tens0_pos->second.talsh_tensor);
+
+ const auto & tensor1 = *(op.getTensorOperand(1));
+ const auto tensor1_hash = tensor1.getTensorHash();
+ auto tens1_pos = tensors_.find(tensor1_hash);
+ if(tens1_pos == tensors_.end()){
+  std::cout << "#ERROR(exatn::runtime::node_executor_talsh): APPLY_GATE_SVD2: Tensor operand 1 not found: " << std::endl;
+  op.printIt();
+  assert(false);
+ }
+ tens1_pos->second.resetTensorShapeToReduced();
+ auto & tens1 = *(tens1_pos->second.talsh_tensor);
+
+ const auto & tensor2 = *(op.getTensorOperand(2));
+ const auto tensor2_hash = tensor2.getTensorHash();
+ auto tens2_pos = tensors_.find(tensor2_hash);
+ if(tens2_pos == tensors_.end()){
+  std::cout << "#ERROR(exatn::runtime::node_executor_talsh): APPLY_GATE_SVD2: Tensor operand 2 not found: " << std::endl;
+  op.printIt();
+  assert(false);
+ }
+ tens2_pos->second.resetTensorShapeToReduced();
+ auto & tens2 = *(tens2_pos->second.talsh_tensor);
+
+ *exec_handle = op.getId();
+
+ //The fused operation is executed on Host synchronously (the tensor storage layout does not depend on the reduced shape):
+ bool synced = tens0.sync(DEV_HOST,0,nullptr,true)
+            && tens1.sync(DEV_HOST,0,nullptr,true)
+            && tens2.sync(DEV_HOST,0,nullptr,true); assert(synced);
+ const auto & mode_map = op.getIndexModeMap();
+ std::size_t achieved_rank = 0;
+ double discarded_weight = 0.0;
+ auto apply_gate = [&](auto * left, auto * right, auto * gate){
+  bool access_granted = tens0.getDataAccessHost(&left)
+                     && tens1.getDataAccessHost(&right)
+                     && tens2.getDataAccessHost(&gate);
+  if(!access_granted){
+   std::cout << "#ERROR(exatn::runtime::node_executor_talsh): APPLY_GATE_SVD2: Unable to get access to the tensor bodies!" << std::endl;
+   op.printIt();
+   assert(false);
+  }
+  return numerics::computeTwoSiteGateSVD(mode_map.operands[1].modes,tensor0.getDimExtents(),left,
+                                         mode_map.operands[2].modes,tensor1.getDimExtents(),right,
+                                         mode_map.operands[3].modes,gate,
+                                         op.getTruncation(),&achieved_rank,&discarded_weight);
+ };
+ bool done = false;
+ int tens_elem_type = tens0.getElementType();
+ if(op.operandIsConjugated(0) || op.operandIsConjugated(1) || op.operandIsConjugated(2)){
+  std::cout << "#ERROR(exatn::runtime::node_executor_talsh): APPLY_GATE_SVD2: Conjugated tensor operands are not supported!" << std::endl;
+  op.printIt();
+ }else if(tens1.getElementType() == tens_elem_type && tens2.getElementType() == tens_elem_type){
+  switch(tens_elem_type){
+   case(talsh::REAL32):
+    done = apply_gate((float*)nullptr,(float*)nullptr,(float*)nullptr); break;
+   case(talsh::REAL64):
+    done = apply_gate((double*)nullptr,(double*)nullptr,(double*)nullptr); break;
+   case(talsh::COMPLEX32):
+    done = apply_gate((std::complex<float>*)nullptr,(std::complex<float>*)nullptr,(std::complex<float>*)nullptr); break;
+   case(talsh::COMPLEX64):
+    done = apply_gate((std::complex<double>*)nullptr,(std::complex<double>*)nullptr,(std::complex<double>*)nullptr); break;
+   default:
+    std::cout << "#ERROR(exatn::runtime::node_executor_talsh): APPLY_GATE_SVD2: Unknown TAL-SH data kind: "
+              << tens_elem_type << std::endl;
+    op.printIt();
+    assert(false);
+  }
+ }else{
+  std::cout << "#ERROR(exatn::runtime::node_executor_talsh): APPLY_GATE_SVD2: Tensor operands have different data kinds!" << std::endl;
+  op.printIt();
+ }
+ op.setTruncationResult(achieved_rank,discarded_weight);
+ return (done ? TALSH_SUCCESS : TALSH_FAILURE);
+}
+
+
 bool TalshNodeExecutor::sync(TensorOpExecHandle op_handle,
                              int * error_code,
                              bool wait)
@@ -80,6 +80,8 @@ public:
                       TensorOpExecHandle * exec_handle) = 0;
   virtual int execute(numerics::TensorOpAllreduce & op,
                       TensorOpExecHandle * exec_handle) = 0;
+  virtual int execute(numerics::TensorOpApplyGateSVD2 & op,
+                      TensorOpExecHandle * exec_handle) = 0;
 
   /** Synchronizes the execution of a previously submitted tensor operation. **/
   virtual bool sync(TensorOpExecHandle op_handle,